@@ -53,6 +53,13 @@ typedef struct GS_CLIENT_T *GS_CLIENT;
 
 GS_CLIENT gs_new(const char *keydir);
 
+/**
+ * Create a client without loading the client certificate, e.g. while it's still being generated.
+ *
+ * It can fetch server info over HTTP, but can't pair or talk to paired hosts.
+ */
+GS_CLIENT gs_new_unpaired(const char *keydir);
+
 int gs_conf_init(const char *keydir);
 
 void gs_destroy(GS_CLIENT hnd);
@@ -54,6 +54,8 @@
 #include "set_error.h"
 #include "conf.h"
 
+static GS_CLIENT client_open_http(struct GS_CLIENT_T *hnd, const char *keydir);
+
 static int load_server_status(GS_CLIENT hnd, PSERVER_DATA server);
 
 static int resolve_ports(GS_CLIENT hnd, const char *address, uint16_t port, uint16_t *https_port);
@@ -685,15 +687,17 @@ GS_CLIENT gs_new(const char *keydir) {
         free(hnd);
         return NULL;
     }
+    return client_open_http(hnd, keydir);
+}
 
-    HTTP *http = http_create(keydir);
-    if (http == NULL) {
-        free(hnd);
-        return NULL;
-    }
-    hnd->http = http;
-    gs_set_timeout(hnd, 5);
-    return hnd;
+GS_CLIENT gs_new_unpaired(const char *keydir) {
+    struct GS_CLIENT_T *hnd = malloc(sizeof(struct GS_CLIENT_T));
+    memset(hnd, 0, sizeof(struct GS_CLIENT_T));
+    // Same ID as the one gs_conf_init writes
+    strncpy(hnd->unique_id, UNIQUE_ID_DEFAULT, UNIQUEID_CHARS);
+    mbedtls_x509_crt_init(&hnd->cert);
+    mbedtls_pk_init(&hnd->pk);
+    return client_open_http(hnd, keydir);
 }
 
 void gs_destroy(GS_CLIENT hnd) {
@@ -715,6 +719,22 @@ int gs_get_status(GS_CLIENT hnd, PSERVER_DATA server, const char *address, uint1
     return load_server_status(hnd, server);
 }
 
+/**
+ * Shared by both constructors, once the identity is set up. Frees the client if HTTP can't be set up.
+ */
+static GS_CLIENT client_open_http(struct GS_CLIENT_T *hnd, const char *keydir) {
+    HTTP *http = http_create(keydir);
+    if (http == NULL) {
+        mbedtls_pk_free(&hnd->pk);
+        mbedtls_x509_crt_free(&hnd->cert);
+        free(hnd);
+        return NULL;
+    }
+    hnd->http = http;
+    gs_set_timeout(hnd, 5);
+    return hnd;
+}
+
 static int load_server_status(GS_CLIENT hnd, PSERVER_DATA server) {
     int ret = GS_OK;
     if (server->extPort != 0 && server->httpsPort == 0) {
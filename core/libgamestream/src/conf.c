@@ -8,6 +8,7 @@
 #include "logging.h"
 
 #include <errno.h>
+#include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -47,6 +48,8 @@ static int load_cert(struct GS_CLIENT_T *hnd, const char *keydir);
 
 static int init_cert(const char *keydir);
 
+static bool file_exists(const char *path);
+
 int gs_conf_load(GS_CLIENT hnd, const char *keydir) {
     int ret = GS_OK;
     if ((ret = load_unique_id(hnd, keydir)) != GS_OK) {
@@ -128,6 +131,11 @@ int load_cert(struct GS_CLIENT_T *hnd, const char *keydir) {
     char key_path[PATH_MAX];
     snprintf(key_path, PATH_MAX, "%s%c%s", keydir, PATH_SEPARATOR, KEY_FILE_NAME);
 
+    // Not generated yet, or generation was interrupted
+    if (!file_exists(cert_path) || !file_exists(key_path)) {
+        return gs_set_error(GS_BAD_CONF, "Client certificate %s not found", cert_path);
+    }
+
     int ret;
     mbedtls_x509_crt_init(&hnd->cert);
     if ((ret = mbedtls_x509_crt_parse_file(&hnd->cert, cert_path)) != 0) {
@@ -201,3 +209,12 @@ int mkdirtree(const char *directory) {
 
     return 0;
 }
+
+static bool file_exists(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+    fclose(f);
+    return true;
+}
@@ -18,6 +18,7 @@
 #include "errors.h"
 #include "set_error.h"
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -29,6 +30,7 @@
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/md.h>
 #include <mbedtls/error.h>
+#include <mbedtls/platform_util.h>
 
 static const int NUM_BITS = 2048;
 static const int SERIAL = 0;
@@ -91,10 +93,35 @@ static int mkcert_generate_impl(mbedtls_pk_context *key, mbedtls_x509write_cert
     return ret;
 }
 
+static int write_file_atomic(const char *path, const char *content) {
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *f = fopen(tmp_path, "w");
+    if (f == NULL) {
+        return gs_set_error(GS_IO_ERROR, "Failed to open %s for writing", tmp_path);
+    }
+    size_t len = strlen(content);
+    bool written = fwrite(content, 1, len, f) == len;
+    written &= fflush(f) == 0;
+    written &= fclose(f) == 0;
+    if (!written) {
+        remove(tmp_path);
+        return gs_set_error(GS_IO_ERROR, "Failed to write %s", tmp_path);
+    }
+#if __WIN32
+    remove(path);
+#endif
+    if (rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        return gs_set_error(GS_IO_ERROR, "Failed to replace %s", path);
+    }
+    return GS_OK;
+}
+
 int mkcert_generate(const char *certFile, const char *keyFile) {
     int ret;
-    FILE *f;
     char buf[4096];
+    char key_pem[4096];
     const char *pers = "GameStream";
 
     mbedtls_pk_context key;
@@ -118,37 +145,29 @@ int mkcert_generate(const char *certFile, const char *keyFile) {
         goto finally;
     }
 
-    if ((ret = mbedtls_pk_write_key_pem(&key, (unsigned char *) buf, 4096)) != 0) {
+    if ((ret = mbedtls_pk_write_key_pem(&key, (unsigned char *) key_pem, sizeof(key_pem))) != 0) {
         mbedtls_strerror(ret, buf, 512);
         ret = gs_set_error(GS_FAILED, "mbedtls_pk_write_key_pem returned -0x%04x - %s", (unsigned int) -ret, buf);
         goto finally;
     }
 
-    f = fopen(keyFile, "w");
-    if (f == NULL) {
-        ret = gs_set_error(GS_IO_ERROR, "Failed to open keyFile %s for writing", keyFile);
-        goto finally;
-    }
-    fwrite(buf, strlen(buf), 1, f);
-    fflush(f);
-    fclose(f);
-
     if ((ret = mbedtls_x509write_crt_pem(&crt, (unsigned char *) buf, 4096, mbedtls_ctr_drbg_random, &ctr_drbg)) != 0) {
         mbedtls_strerror(ret, buf, 512);
         ret = gs_set_error(GS_FAILED, "mbedtls_x509write_crt_pem returned -0x%04x - %s", (unsigned int) -ret, buf);
         goto finally;
     }
 
-    f = fopen(certFile, "w");
-    if (f == NULL) {
-        ret = gs_set_error(GS_IO_ERROR, "Failed to open certFile %s for writing", certFile);
+    // Write key before certificate, so a certificate always has its key. If interrupted in between, the missing
+    // certificate makes it generated again.
+    if ((ret = write_file_atomic(keyFile, key_pem)) != GS_OK) {
+        goto finally;
+    }
+    if ((ret = write_file_atomic(certFile, buf)) != GS_OK) {
         goto finally;
     }
-    fwrite(buf, strlen(buf), 1, f);
-    fflush(f);
-    fclose(f);
 
     finally:
+    mbedtls_platform_zeroize(key_pem, sizeof(key_pem));
     mbedtls_pk_free(&key);
     mbedtls_x509write_crt_free(&crt);
     mbedtls_ctr_drbg_free(&ctr_drbg);
@@ -3,5 +3,8 @@
 echo "# Generated from https://github.com/gabomdq/SDL_GameControllerDB"
 echo "# Generated at $(date)"
 echo
+# Only Linux mappings apply to webOS. SDL lets a later mapping replace an earlier one with the same GUID, so keep the
+# last one of each.
 curl -sL 'https://github.com/gabomdq/SDL_GameControllerDB/raw/master/gamecontrollerdb.txt' |
-  sed -n 's/^\(.*\),platform:Linux,$/\1,platform:webOS,/p'
+  sed -n 's/^\(.*\),platform:Linux,$/\1,platform:webOS,/p' |
+  awk -F, '!($1 in line) { order[n++] = $1 } { line[$1] = $0 } END { for (i = 0; i < n; i++) print line[order[i]] }'
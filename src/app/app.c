@@ -12,11 +12,16 @@
 #include "logging_ext_sdl.h"
 #include "logging_ext_ss4s.h"
 #include "backend/backend_root.h"
+#include "backend/pcmanager.h"
 #include "stream/session.h"
+#include "stream/session_worker.h"
 #include "ui/root.h"
 #include "util/bus.h"
 #include "util/user_event.h"
 #include "util/i18n.h"
+#include "util/path.h"
+#include "util/init_graph.h"
+#include "input/input_gamepad_mapping.h"
 
 #include "ss4s_modules.h"
 #include "ss4s.h"
@@ -30,7 +35,63 @@ PCONFIGURATION app_configuration = NULL;
 
 static void quit_confirm_cb(lv_event_t *e);
 
-static void libs_init(app_t *app, int argc, char *argv[]);
+typedef struct app_init_ctx_t {
+    app_t *app;
+    int argc;
+    char **argv;
+    /* Read on the executor, added to the list on main thread */
+    pcmanager_known_hosts_t known_hosts;
+} app_init_ctx_t;
+
+static int init_os_info(app_init_ctx_t *ctx);
+
+static int init_ss4s_modules(app_init_ctx_t *ctx);
+
+static int init_known_hosts(app_init_ctx_t *ctx);
+
+static int init_known_hosts_add(app_init_ctx_t *ctx);
+
+static int init_fonts(app_init_ctx_t *ctx);
+
+static int init_ss4s(app_init_ctx_t *ctx);
+
+static int init_video(app_init_ctx_t *ctx);
+
+static int init_input(app_init_ctx_t *ctx);
+
+static int init_ui(app_init_ctx_t *ctx);
+
+static int init_ss4s_post(app_init_ctx_t *ctx);
+
+static void startup_trace_report(const startup_trace_t *trace);
+
+enum {
+    INIT_OS_INFO,
+    INIT_SS4S_MODULES,
+    INIT_KNOWN_HOSTS,
+    INIT_KNOWN_HOSTS_ADD,
+    INIT_FONTS,
+    INIT_SS4S,
+    INIT_VIDEO,
+    INIT_INPUT,
+    INIT_UI,
+    INIT_SS4S_POST,
+};
+
+static const init_step_t init_steps[] = {
+        [INIT_OS_INFO] = {"os_info_get", (init_step_fn) init_os_info, 0, false},
+        [INIT_SS4S_MODULES] = {"ss4s_modules", (init_step_fn) init_ss4s_modules, INIT_STEP_DEP(INIT_OS_INFO), false},
+        [INIT_KNOWN_HOSTS] = {"known_hosts_load", (init_step_fn) init_known_hosts, 0, false},
+        [INIT_KNOWN_HOSTS_ADD] = {"known_hosts_add", (init_step_fn) init_known_hosts_add,
+                                  INIT_STEP_DEP(INIT_KNOWN_HOSTS), true},
+        [INIT_FONTS] = {"font_resolve", (init_step_fn) init_fonts, 0, false},
+        [INIT_SS4S] = {"ss4s_init", (init_step_fn) init_ss4s, INIT_STEP_DEP(INIT_SS4S_MODULES), true},
+        // DO not init video subsystem before NDL/LGNC initialization
+        [INIT_VIDEO] = {"sdl_video", (init_step_fn) init_video, INIT_STEP_DEP(INIT_SS4S), true},
+        [INIT_INPUT] = {"input_init", (init_step_fn) init_input, INIT_STEP_DEP(INIT_VIDEO), true},
+        [INIT_UI] = {"ui_init", (init_step_fn) init_ui, INIT_STEP_DEP(INIT_VIDEO) | INIT_STEP_DEP(INIT_FONTS), true},
+        [INIT_SS4S_POST] = {"ss4s_post_init", (init_step_fn) init_ss4s_post, INIT_STEP_DEP(INIT_UI), true},
+};
 
 app_t *global = NULL;
 
@@ -38,12 +99,18 @@ app_t *global = NULL;
 int app_init(app_t *app, app_settings_loader *settings_loader, int argc, char *argv[]) {
     assert(settings_loader != NULL);
     memset(app, 0, sizeof(*app));
+    startup_trace_t *trace = &app->startup_trace;
+    startup_trace_init(trace);
+    startup_trace_begin(trace, "app_init");
     commons_logging_init("moonlight");
     SDL_LogSetOutputFunction(commons_sdl_log, NULL);
+    SS4S_SetLoggingFunction(commons_ss4s_logf);
     SDL_SetAssertionHandler(app_assertion_handler_abort, NULL);
     SDL_Init(0);
     commons_log_info("APP", "Start Moonlight. Version %s", APP_VERSION);
+    startup_trace_begin(trace, "settings_load");
     settings_loader(&app->settings);
+    startup_trace_end(trace);
     app->main_thread_id = SDL_ThreadID();
     app->running = true;
     app->focused = false;
@@ -51,49 +118,36 @@ int app_init(app_t *app, app_settings_loader *settings_loader, int argc, char *a
     app->embed_version.major = -1;
 #endif
     app_configuration = &app->settings;
-    if (os_info_get(&app->os_info) == 0) {
-        char *info_str = os_info_str(&app->os_info);
-        commons_log_info("APP", "System: %s", info_str);
-        free(info_str);
-    }
-    libs_init(app, argc, argv);
-
+    // setlocale isn't thread safe, so it's done before any other thread is started
+    startup_trace_begin(trace, "locale");
     app_init_locale();
+    startup_trace_end(trace);
+    // Key directory is known now, start generating client certificate while everything else initializes
+    backend_gs_conf_start(&app->backend);
+    startup_trace_begin(trace, "backend_init");
     backend_init(&app->backend, app);
+    startup_trace_end(trace);
+
+    app_init_ctx_t ctx = {.app = app, .argc = argc, .argv = argv};
+    int ret = init_graph_run(init_steps, sizeof(init_steps) / sizeof(init_step_t), app->backend.executor, &ctx,
+                             trace);
+    // Hosts read before a failed step are still added, so they're freed along with the list
+    pcmanager_add_known_hosts(pcmanager, &ctx.known_hosts);
+    startup_trace_end(trace);
+    return ret != 0 ? -1 : 0;
+}
 
-#if TARGET_WEBOS
-    SDL_SetHint(SDL_HINT_WEBOS_ACCESS_POLICY_KEYS_BACK, "true");
-    SDL_SetHint(SDL_HINT_WEBOS_ACCESS_POLICY_KEYS_EXIT, "true");
-    SDL_SetHint(SDL_HINT_WEBOS_CURSOR_SLEEP_TIME, "5000");
-    SDL_SetHint(SDL_HINT_WEBOS_CURSOR_FREQUENCY, "60");
-    SDL_SetHint(SDL_HINT_WEBOS_CURSOR_CALIBRATION_DISABLE, "true");
-    SDL_SetHint(SDL_HINT_WEBOS_HIDAPI_IGNORE_BLUETOOTH_DEVICES, "0x057e/0x0000");
-    if (app->settings.syskey_capture) {
-        SDL_SetHint(SDL_HINT_WEBOS_ACCESS_POLICY_KEYS_HOME, "true");
-        SDL_SetHint(SDL_HINT_WEBOS_ACCESS_POLICY_RIBBON, "false");
-    }
-#else
-    if (app->settings.syskey_capture) {
-        SDL_SetHint(SDL_HINT_GRAB_KEYBOARD, "1");
-    }
-#endif
-    // DO not init video subsystem before NDL/LGNC initialization
-    if (SDL_InitSubSystem(SDL_INIT_VIDEO) < 0) {
-        commons_log_fatal("APP", "Failed to initialize SDL video subsystem: %s", SDL_GetError());
-        return -1;
+void app_startup_finished(app_t *app) {
+    if (app->startup_finished) {
+        return;
     }
-    // This will occupy SDL_USEREVENT
-    SDL_RegisterEvents(1);
-    commons_log_info("APP", "UI locale: %s (%s)", i18n_locale(), locstr("[Localized Language]"));
-
-    app_input_init(&app->input, app);
-
-    app_ui_init(&app->ui, app);
-
-    global = app;
-
-    SS4S_PostInit(argc, argv);
-    return 0;
+    app->startup_finished = true;
+    startup_trace_t *trace = &app->startup_trace;
+    startup_trace_add(trace, "first_frame", 0, startup_trace_now_us(trace), 0);
+    startup_trace_report(trace);
+    // Deferred so they don't compete with the first frame
+    app_input_update_gamepad_mapping(&app->input);
+    pcmanager_auto_discovery_start(pcmanager);
 }
 
 void app_deinit(app_t *app) {
@@ -107,6 +161,7 @@ void app_deinit(app_t *app) {
     SDL_QuitSubSystem(SDL_INIT_VIDEO);
 
     backend_destroy(&app->backend);
+    session_worker_deinit();
 
     settings_save(&app->settings);
     settings_clear(&app->settings);
@@ -127,7 +182,12 @@ void app_deinit(app_t *app) {
 
 void app_run_loop(app_t *app) {
     app_process_events(app);
-    lv_task_handler();
+    if (app->power.streaming) {
+        // Nothing is shown while streaming with UI closed, timers catch up once it opens again
+        app->power.parked_loops++;
+    } else {
+        lv_task_handler();
+    }
     SDL_Delay(1);
 }
 
@@ -143,6 +203,10 @@ static int app_event_filter(void *userdata, SDL_Event *event) {
         }
         case SDL_APP_DIDENTERFOREGROUND: {
             lv_obj_invalidate(lv_scr_act());
+            // Network may have changed while in background
+            if (pcmanager != NULL) {
+                pcmanager_auto_discovery_rescan(pcmanager);
+            }
             break;
         }
         case SDL_WINDOWEVENT: {
@@ -292,6 +356,12 @@ bool app_is_decoder_valid(app_t *app) {
     return app->ss4s.selection.video_module != NULL && app->ss4s.selection.audio_module != NULL;
 }
 
+bool app_is_decoder_rfi_supported(const app_t *app) {
+    const char *video_module_id = SS4S_ModuleInfoGetId(app->ss4s.selection.video_module);
+    return video_module_id != NULL && (app->settings.rfi_unsupported == NULL ||
+                                       strcmp(app->settings.rfi_unsupported, video_module_id) != 0);
+}
+
 #if FEATURE_EMBEDDED_SHELL
 bool app_has_embedded(app_t *app) {
     return version_info_valid(&app->embed_version);
@@ -302,8 +372,18 @@ bool app_decoder_or_embedded_present(app_t *app) {
 }
 #endif
 
-static void libs_init(app_t *app, int argc, char *argv[]) {
-    SS4S_SetLoggingFunction(commons_ss4s_logf);
+static int init_os_info(app_init_ctx_t *ctx) {
+    app_t *app = ctx->app;
+    if (os_info_get(&app->os_info) == 0) {
+        char *info_str = os_info_str(&app->os_info);
+        commons_log_info("APP", "System: %s", info_str);
+        free(info_str);
+    }
+    return 0;
+}
+
+static int init_ss4s_modules(app_init_ctx_t *ctx) {
+    app_t *app = ctx->app;
     int errno;
     if ((errno = SS4S_ModulesList(&app->ss4s.modules, &app->os_info)) != 0) {
         commons_log_error("SS4S", "Can't load modules list: %s", strerror(errno));
@@ -328,20 +408,101 @@ static void libs_init(app_t *app, int argc, char *argv[]) {
         }
     }
 #endif
+    return 0;
+}
 
+static int init_known_hosts(app_init_ctx_t *ctx) {
+    // Only reads files, hosts are added to the list by init_known_hosts_add
+    pcmanager_load_known_hosts(pcmanager, &ctx->known_hosts);
+    return 0;
+}
+
+static int init_known_hosts_add(app_init_ctx_t *ctx) {
+    pcmanager_add_known_hosts(pcmanager, &ctx->known_hosts);
+    return 0;
+}
+
+static int init_fonts(app_init_ctx_t *ctx) {
+    // Failure is reported by app_font_init
+    app_font_resolve(&ctx->app->ui.fonts);
+    return 0;
+}
+
+static int init_ss4s(app_init_ctx_t *ctx) {
+    app_t *app = ctx->app;
     SS4S_Config ss4s_config = {
             .audioDriver = SS4S_ModuleInfoGetId(app->ss4s.selection.audio_module),
             .videoDriver = SS4S_ModuleInfoGetId(app->ss4s.selection.video_module),
     };
-    SS4S_Init(argc, argv, &ss4s_config);
+    SS4S_Init(ctx->argc, ctx->argv, &ss4s_config);
 
     SS4S_GetAudioCapabilitiesByCodecs(&app->ss4s.audio_cap, SS4S_AUDIO_PCM_S16LE | SS4S_AUDIO_OPUS);
     SS4S_GetVideoCapabilities(&app->ss4s.video_cap);
 
-
 #if FEATURE_INPUT_LIBCEC
+    startup_trace_begin(&app->startup_trace, "cec_init");
     cec_sdl_init(&app->cec, "Moonlight");
+    startup_trace_end(&app->startup_trace);
 #endif
+    return 0;
+}
+
+static int init_video(app_init_ctx_t *ctx) {
+    app_t *app = ctx->app;
+#if TARGET_WEBOS
+    SDL_SetHint(SDL_HINT_WEBOS_ACCESS_POLICY_KEYS_BACK, "true");
+    SDL_SetHint(SDL_HINT_WEBOS_ACCESS_POLICY_KEYS_EXIT, "true");
+    SDL_SetHint(SDL_HINT_WEBOS_CURSOR_SLEEP_TIME, "5000");
+    SDL_SetHint(SDL_HINT_WEBOS_CURSOR_FREQUENCY, "60");
+    SDL_SetHint(SDL_HINT_WEBOS_CURSOR_CALIBRATION_DISABLE, "true");
+    SDL_SetHint(SDL_HINT_WEBOS_HIDAPI_IGNORE_BLUETOOTH_DEVICES, "0x057e/0x0000");
+    if (app->settings.syskey_capture) {
+        SDL_SetHint(SDL_HINT_WEBOS_ACCESS_POLICY_KEYS_HOME, "true");
+        SDL_SetHint(SDL_HINT_WEBOS_ACCESS_POLICY_RIBBON, "false");
+    }
+#else
+    if (app->settings.syskey_capture) {
+        SDL_SetHint(SDL_HINT_GRAB_KEYBOARD, "1");
+    }
+#endif
+    if (SDL_InitSubSystem(SDL_INIT_VIDEO) < 0) {
+        commons_log_fatal("APP", "Failed to initialize SDL video subsystem: %s", SDL_GetError());
+        return -1;
+    }
+    // This will occupy SDL_USEREVENT
+    SDL_RegisterEvents(1);
+    return 0;
+}
+
+static int init_input(app_init_ctx_t *ctx) {
+    app_input_init(&ctx->app->input, ctx->app);
+    return 0;
+}
+
+static int init_ui(app_init_ctx_t *ctx) {
+    commons_log_info("APP", "UI locale: %s (%s)", i18n_locale(), locstr("[Localized Language]"));
+    app_ui_init(&ctx->app->ui, ctx->app);
+    global = ctx->app;
+    return 0;
+}
+
+static int init_ss4s_post(app_init_ctx_t *ctx) {
+    SS4S_PostInit(ctx->argc, ctx->argv);
+    return 0;
+}
+
+static void startup_trace_report(const startup_trace_t *trace) {
+    startup_trace_log(trace);
+    char *cache_dir = path_cache();
+    char *trace_path = path_join(cache_dir, "startup_trace.json");
+    int ret = startup_trace_write_json(trace, trace_path);
+    if (ret != 0) {
+        commons_log_warn("Startup", "Failed to write startup trace to %s: %s", trace_path, strerror(ret));
+    } else {
+        commons_log_debug("Startup", "Startup trace written to %s", trace_path);
+    }
+    free(trace_path);
+    free(cache_dir);
 }
 
 static void quit_confirm_cb(lv_event_t *e) {
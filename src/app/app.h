@@ -15,6 +15,8 @@
 #include "input/app_input.h"
 #include "backend/backend_root.h"
 #include "ui/root.h"
+#include "util/startup_trace.h"
+#include "app_power.h"
 
 #if FEATURE_INPUT_LIBCEC
 
@@ -35,6 +37,8 @@ typedef int (app_settings_loader)(app_settings_t *settings);
 
 typedef struct app_t {
     bool running, focused;
+    /* Launcher has rendered its first frame, and deferred startup work has started */
+    bool startup_finished;
     SDL_threadID main_thread_id;
     os_info_t os_info;
     app_settings_t settings;
@@ -55,12 +59,20 @@ typedef struct app_t {
 #endif
     app_wakelock_t *wakelock;
     session_t *session;
+    app_power_t power;
+    startup_trace_t startup_trace;
 } app_t;
 
 int app_init(app_t *app, app_settings_loader *settings_loader, int argc, char *argv[]);
 
 void app_deinit(app_t *app);
 
+/**
+ * Called once the first frame is rendered. Starts work that was deferred so it doesn't slow down startup, like
+ * controller db update and host discovery.
+ */
+void app_startup_finished(app_t *app);
+
 void app_run_loop(app_t *app);
 
 void app_process_events(app_t *app);
@@ -75,6 +87,11 @@ bool ui_render_queue_submit(void *data, unsigned int pts);
 
 bool app_is_decoder_valid(app_t *app);
 
+/**
+ * @return Whether selected video module can continue decoding after the host invalidated reference frames
+ */
+bool app_is_decoder_rfi_supported(const app_t *app);
+
 #if FEATURE_EMBEDDED_SHELL
 bool app_has_embedded(app_t *app);
 bool app_decoder_or_embedded_present(app_t *app);
@@ -83,8 +100,16 @@ bool app_decoder_or_embedded_present(app_t *app);
 #endif
 
 
+/**
+ * Create a client. While client certificate is still being generated, the client can only fetch server info.
+ */
 GS_CLIENT app_gs_client_new(app_t *app);
 
+/**
+ * Create a client with client certificate, waiting for it to be generated if needed. Use it for pairing.
+ */
+GS_CLIENT app_gs_client_new_with_cert(app_t *app);
+
 void app_set_mouse_grab(app_input_t *input, bool grab);
 
 bool app_get_mouse_relative();
@@ -0,0 +1,304 @@
+#include "app_power.h"
+#include "app.h"
+#include "backend/backend_root.h"
+
+#include <string.h>
+#include <time.h>
+
+#if __linux__
+
+#include <dirent.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#endif
+
+#include "logging.h"
+
+/* Nice value of background threads while streaming */
+#define BACKGROUND_NICE 10
+
+static void power_enter(app_t *app);
+
+static void power_leave(app_t *app);
+
+static void background_threads_lower(app_power_t *power);
+
+static void background_threads_restore(app_power_t *power);
+
+static Uint64 background_threads_cpu_ms();
+
+static unsigned int cpu_permille(Uint64 cpu_ms, Uint32 elapsed_ms);
+
+#if __linux__
+
+static bool background_thread_name(const char *name);
+
+static bool background_thread_lower(app_power_thread_t *thread);
+
+static bool thread_read_name(int tid, char *name, size_t size);
+
+static Uint64 thread_cpu_ms(int tid);
+
+static bool nice_restorable(int nice);
+
+#endif
+
+/* Threads doing launcher or setup work only. Session threads are left alone. */
+static const char *background_threads[] = {
+        BACKEND_EXECUTOR_NAME,
+        BACKEND_GS_CONF_THREAD_NAME,
+};
+
+void app_power_update(app_t *app) {
+    app_power_set_streaming(app, app->session != NULL && !app_ui_is_opened(&app->ui));
+}
+
+void app_power_set_streaming(app_t *app, bool streaming) {
+    app_power_t *power = &app->power;
+    if (power->streaming == streaming) {
+        return;
+    }
+    power->streaming = streaming;
+    if (streaming) {
+        power_enter(app);
+    } else {
+        power_leave(app);
+    }
+}
+
+Uint64 app_power_thread_cpu_us() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return (Uint64) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+#endif
+    return 0;
+}
+
+static void power_enter(app_t *app) {
+    app_power_t *power = &app->power;
+    power->start_ticks = SDL_GetTicks();
+    power->main_cpu_start_us = app_power_thread_cpu_us();
+    power->background_cpu_start_ms = background_threads_cpu_ms();
+    // Load since the mode was last left, or since the process started, is what the mode is compared against
+    Uint32 baseline_elapsed = power->start_ticks - power->baseline.ticks;
+    power->baseline.main_load = cpu_permille((power->main_cpu_start_us - power->baseline.main_cpu_us) / 1000,
+                                             baseline_elapsed);
+    power->baseline.background_load = cpu_permille(
+            power->background_cpu_start_ms - SDL_min(power->baseline.background_cpu_ms,
+                                                     power->background_cpu_start_ms), baseline_elapsed);
+    power->parked_loops = 0;
+    power->discovery_paused = pcmanager != NULL && pcmanager_auto_discovery_running(pcmanager);
+    if (power->discovery_paused) {
+        pcmanager_auto_discovery_stop(pcmanager);
+    }
+    background_threads_lower(power);
+    commons_log_info("Power", "Streaming power mode on. Discovery %s, %d background threads deprioritized",
+                     power->discovery_paused ? "paused" : "not running", (int) power->threads_count);
+}
+
+static void power_leave(app_t *app) {
+    app_power_t *power = &app->power;
+    power->baseline.ticks = SDL_GetTicks();
+    power->baseline.main_cpu_us = app_power_thread_cpu_us();
+    power->baseline.background_cpu_ms = background_threads_cpu_ms();
+    Uint32 elapsed = power->baseline.ticks - power->start_ticks;
+    Uint64 main_cpu_ms = (power->baseline.main_cpu_us - power->main_cpu_start_us) / 1000;
+    // Threads which have exited meanwhile are not counted anymore
+    Uint64 background_cpu_ms = power->baseline.background_cpu_ms -
+                               SDL_min(power->background_cpu_start_ms, power->baseline.background_cpu_ms);
+    int threads = (int) power->threads_count;
+    background_threads_restore(power);
+    // Discovery stays stopped if the app is quitting
+    if (power->discovery_paused && app->running) {
+        pcmanager_auto_discovery_start(pcmanager);
+    }
+    power->discovery_paused = false;
+    unsigned int main_load = cpu_permille(main_cpu_ms, elapsed);
+    unsigned int background_load = cpu_permille(background_cpu_ms, elapsed);
+    commons_log_info("Power", "Streaming power mode off after %u ms. Main thread: %u ms CPU, %u.%u%% load "
+                              "(%u.%u%% before, %u loops without lvgl). Background threads (%d deprioritized): %u ms "
+                              "CPU, %u.%u%% load (%u.%u%% before)", elapsed, (unsigned int) main_cpu_ms,
+                     main_load / 10, main_load % 10, power->baseline.main_load / 10, power->baseline.main_load % 10,
+                     power->parked_loops, threads, (unsigned int) background_cpu_ms, background_load / 10,
+                     background_load % 10, power->baseline.background_load / 10,
+                     power->baseline.background_load % 10);
+}
+
+static void background_threads_lower(app_power_t *power) {
+    power->threads_count = 0;
+#if __linux__
+    DIR *dir = opendir("/proc/self/task");
+    if (dir == NULL) {
+        return;
+    }
+    int batch = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && power->threads_count < APP_POWER_MAX_THREADS) {
+        int tid = (int) strtol(entry->d_name, NULL, 10);
+        char name[16];
+        if (tid <= 0 || !thread_read_name(tid, name, sizeof(name)) || !background_thread_name(name)) {
+            continue;
+        }
+        app_power_thread_t *thread = &power->threads[power->threads_count];
+        thread->tid = tid;
+        if (background_thread_lower(thread)) {
+            power->threads_count++;
+            batch += thread->batch ? 1 : 0;
+        }
+    }
+    closedir(dir);
+    if (batch > 0) {
+        commons_log_info("Power", "%d background threads switched to batch scheduling, not privileged to restore "
+                                  "their nice value", batch);
+    }
+#endif
+}
+
+static void background_threads_restore(app_power_t *power) {
+#if __linux__
+    for (size_t i = 0; i < power->threads_count; i++) {
+        const app_power_thread_t *thread = &power->threads[i];
+        char name[16];
+        // Thread has exited, and its ID may be reused by now
+        if (!thread_read_name(thread->tid, name, sizeof(name)) || !background_thread_name(name)) {
+            continue;
+        }
+        int ret;
+        if (thread->batch) {
+            struct sched_param param = {.sched_priority = 0};
+            ret = sched_setscheduler(thread->tid, SCHED_OTHER, &param);
+        } else {
+            ret = setpriority(PRIO_PROCESS, thread->tid, thread->nice);
+        }
+        if (ret != 0) {
+            commons_log_warn("Power", "Failed to restore priority of thread %d: %s", thread->tid, strerror(errno));
+        }
+    }
+#endif
+    power->threads_count = 0;
+}
+
+/**
+ * @return CPU time used so far by background threads which are still alive
+ */
+static Uint64 background_threads_cpu_ms() {
+    Uint64 cpu_ms = 0;
+#if __linux__
+    DIR *dir = opendir("/proc/self/task");
+    if (dir == NULL) {
+        return 0;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int tid = (int) strtol(entry->d_name, NULL, 10);
+        char name[16];
+        if (tid > 0 && thread_read_name(tid, name, sizeof(name)) && background_thread_name(name)) {
+            cpu_ms += thread_cpu_ms(tid);
+        }
+    }
+    closedir(dir);
+#endif
+    return cpu_ms;
+}
+
+/**
+ * @return CPU time per wall time, in 1/1000
+ */
+static unsigned int cpu_permille(Uint64 cpu_ms, Uint32 elapsed_ms) {
+    if (elapsed_ms == 0) {
+        return 0;
+    }
+    return (unsigned int) (cpu_ms * 1000 / elapsed_ms);
+}
+
+#if __linux__
+
+static bool background_thread_name(const char *name) {
+    for (size_t i = 0; i < sizeof(background_threads) / sizeof(const char *); i++) {
+        // Executor threads may have their index appended to the name
+        if (strncmp(name, background_threads[i], strlen(background_threads[i])) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Raise nice value of the thread. Unprivileged processes can't lower it back afterwards, so those threads are switched
+ * to SCHED_BATCH instead, which any thread may leave again.
+ *
+ * @return false if the thread is left as it was
+ */
+static bool background_thread_lower(app_power_thread_t *thread) {
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, thread->tid);
+    if (errno != 0 || nice >= BACKGROUND_NICE) {
+        return false;
+    }
+    thread->nice = nice;
+    thread->batch = !nice_restorable(nice);
+    if (thread->batch) {
+        if (sched_getscheduler(thread->tid) != SCHED_OTHER) {
+            return false;
+        }
+        struct sched_param param = {.sched_priority = 0};
+        return sched_setscheduler(thread->tid, SCHED_BATCH, &param) == 0;
+    }
+    return setpriority(PRIO_PROCESS, thread->tid, BACKGROUND_NICE) == 0;
+}
+
+static bool thread_read_name(int tid, char *name, size_t size) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", tid);
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        return false;
+    }
+    bool ok = fgets(name, (int) size, fp) != NULL;
+    fclose(fp);
+    if (ok) {
+        name[strcspn(name, "\n")] = '\0';
+    }
+    return ok;
+}
+
+static Uint64 thread_cpu_ms(int tid) {
+    char path[64], buf[512];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        return 0;
+    }
+    size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[len] = '\0';
+    // Thread name in parentheses may contain spaces, fields are counted from the closing one
+    const char *fields = strrchr(buf, ')');
+    unsigned long long utime = 0, stime = 0;
+    if (fields == NULL || sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime,
+                                 &stime) != 2) {
+        return 0;
+    }
+    return (utime + stime) * 1000 / sysconf(_SC_CLK_TCK);
+}
+
+static bool nice_restorable(int nice) {
+    if (geteuid() == 0) {
+        return true;
+    }
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NICE, &limit) != 0) {
+        return false;
+    }
+    // Unprivileged threads can only lower their nice value down to 20 - RLIMIT_NICE
+    return limit.rlim_cur == RLIM_INFINITY || 20 - (int) limit.rlim_cur <= nice;
+}
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file app_power.h
+ *
+ * Streaming power mode. While a session runs with the UI closed, launcher work is suspended so decoding and input
+ * have the CPU to themselves: host discovery is paused, lvgl timers are parked, and background threads (I/O
+ * executor, certificate generation) run at a lower priority. Everything is restored once the UI opens again or the
+ * session ends, and the CPU load meanwhile is logged next to the load before entering the mode.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <SDL_stdinc.h>
+
+#define APP_POWER_MAX_THREADS 16
+
+typedef struct app_t app_t;
+
+typedef struct app_power_thread_t {
+    int tid;
+    /* Nice value before lowering, restored on exit */
+    int nice;
+    /* Switched to batch scheduling instead of changing nice value, as that couldn't be restored */
+    bool batch;
+} app_power_thread_t;
+
+/**
+ * CPU load outside of streaming power mode, which the load in it is compared against
+ */
+typedef struct app_power_baseline_t {
+    /* Taken when power mode was last left, all zero means process start */
+    Uint32 ticks;
+    Uint64 main_cpu_us;
+    Uint64 background_cpu_ms;
+    /* CPU time per wall time in 1/1000, up to when power mode was entered */
+    unsigned int main_load, background_load;
+} app_power_baseline_t;
+
+typedef struct app_power_t {
+    bool streaming;
+    bool discovery_paused;
+    Uint32 start_ticks;
+    Uint64 main_cpu_start_us;
+    Uint64 background_cpu_start_ms;
+    app_power_baseline_t baseline;
+    /* Main loop iterations without lv_task_handler */
+    unsigned int parked_loops;
+    size_t threads_count;
+    app_power_thread_t threads[APP_POWER_MAX_THREADS];
+} app_power_t;
+
+/**
+ * Enter or leave streaming power mode, depending on whether a session runs with the UI closed. Call it whenever
+ * either of them changes. Main thread only.
+ */
+void app_power_update(app_t *app);
+
+/**
+ * Enter or leave streaming power mode regardless of session and UI state. Does nothing if already in that mode.
+ */
+void app_power_set_streaming(app_t *app, bool streaming);
+
+/**
+ * @return CPU time used by the calling thread, in microseconds. 0 if not supported on this platform.
+ */
+Uint64 app_power_thread_cpu_us();
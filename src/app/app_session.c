@@ -14,6 +14,7 @@ int app_session_begin(app_t *app, const uuidstr_t *uuid, const APP_LIST *gs_app)
         return -1;
     }
     app->session = session_create(app, app_configuration, node->server, gs_app);
+    app_power_update(app);
     return 0;
 }
 
@@ -23,4 +24,5 @@ void app_session_destroy(app_t *app) {
     }
     session_destroy(app->session);
     app->session = NULL;
+    app_power_update(app);
 }
\ No newline at end of file
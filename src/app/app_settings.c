@@ -67,9 +67,12 @@ void settings_initialize(app_settings_t *config, char *conf_dir) {
     config->rotate = 0;
     config->absmouse = true;
     config->virtual_mouse = false;
+    config->virtual_mouse_speed = 1200;
+    config->virtual_mouse_accel = 15;
     config->hdr = false;
     config->hevc = true;
     config->av1 = false;
+    config->rfi = true;
     config->stick_deadzone = 7;
 
     config->conf_dir = conf_dir;
@@ -111,6 +114,8 @@ bool settings_save(app_settings_t *config) {
     ini_write_section(fp, "input");
     ini_write_bool(fp, "absmouse", config->absmouse);
     ini_write_bool(fp, "virtual_mouse", config->virtual_mouse);
+    ini_write_int(fp, "virtual_mouse_speed", config->virtual_mouse_speed);
+    ini_write_int(fp, "virtual_mouse_accel", config->virtual_mouse_accel);
 #if FEATURE_INPUT_EVMOUSE
     ini_write_bool(fp, "hardware_mouse", config->hardware_mouse);
 #endif
@@ -123,6 +128,10 @@ bool settings_save(app_settings_t *config) {
     ini_write_bool(fp, "hdr", config->hdr);
     ini_write_bool(fp, "hevc", config->hevc);
     ini_write_bool(fp, "av1", config->av1);
+    ini_write_bool(fp, "rfi", config->rfi);
+    if (config->rfi_unsupported != NULL) {
+        ini_write_string(fp, "rfi_unsupported", config->rfi_unsupported);
+    }
 
     ini_write_section(fp, "audio");
     ini_write_string(fp, "backend", config->audio_backend);
@@ -146,6 +155,7 @@ void settings_clear(app_settings_t *config) {
     free_nullable(config->decoder);
     free_nullable(config->audio_backend);
     free_nullable(config->audio_device);
+    free_nullable(config->rfi_unsupported);
     free_nullable(config->language);
     free_nullable(config->ini_path);
     free_nullable(config->condb_path);
@@ -237,6 +247,8 @@ static int settings_parse(app_settings_t *config, const char *section, const cha
         config->hevc = INI_IS_TRUE(value);
     } else if (INI_NAME_MATCH("av1")) {
         config->av1 = INI_IS_TRUE(value);
+    } else if (INI_NAME_MATCH("rfi")) {
+        config->rfi = INI_IS_TRUE(value);
     } else if (INI_NAME_MATCH("hdr")) {
         config->hdr = INI_IS_TRUE(value);
     } else if (INI_NAME_MATCH("surround")) {
@@ -253,6 +265,20 @@ static int settings_parse(app_settings_t *config, const char *section, const cha
         config->absmouse = INI_IS_TRUE(value);
     } else if (INI_NAME_MATCH("virtual_mouse")) {
         config->virtual_mouse = INI_IS_TRUE(value);
+    } else if (INI_NAME_MATCH("virtual_mouse_speed")) {
+        set_int(&config->virtual_mouse_speed, value);
+        if (config->virtual_mouse_speed < 100) {
+            config->virtual_mouse_speed = 100;
+        } else if (config->virtual_mouse_speed > 5000) {
+            config->virtual_mouse_speed = 5000;
+        }
+    } else if (INI_NAME_MATCH("virtual_mouse_accel")) {
+        set_int(&config->virtual_mouse_accel, value);
+        if (config->virtual_mouse_accel < 5) {
+            config->virtual_mouse_accel = 5;
+        } else if (config->virtual_mouse_accel > 40) {
+            config->virtual_mouse_accel = 40;
+        }
     } else if (INI_NAME_MATCH("hardware_mouse")) {
 #if FEATURE_INPUT_EVMOUSE
         config->hardware_mouse = INI_IS_TRUE(value);
@@ -270,6 +296,8 @@ static int settings_parse(app_settings_t *config, const char *section, const cha
         config->syskey_capture = INI_IS_TRUE(value);
     } else if (INI_FULL_MATCH("video", "decoder")) {
         set_string(&config->decoder, value);
+    } else if (INI_FULL_MATCH("video", "rfi_unsupported")) {
+        set_string(&config->rfi_unsupported, value);
     } else if (INI_FULL_MATCH("audio", "backend")) {
         set_string(&config->audio_backend, value);
     } else if (INI_FULL_MATCH("audio", "device")) {
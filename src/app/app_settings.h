@@ -45,11 +45,16 @@ typedef struct app_settings_t {
     bool absmouse;
     bool hardware_mouse;
     bool virtual_mouse;
+    int virtual_mouse_speed;
+    int virtual_mouse_accel;
     bool swap_abxy;
     bool syskey_capture;
     bool hdr;
     bool hevc;
     bool av1;
+    bool rfi;
+    /* ID of the video module that failed to recover with RFI, it's not advertised again while using it */
+    char *rfi_unsupported;
     int stick_deadzone;
 
     char *conf_dir;
@@ -1,8 +1,10 @@
 #include "apploader.h"
+#include "apploader_cache.h"
 
 #include "app.h"
 #include "errors.h"
 #include "util/bus.h"
+#include "util/path.h"
 #include "lazy.h"
 #include "refcounter.h"
 
@@ -26,6 +28,12 @@ struct apploader_task_ctx_t {
     apploader_list_t *result;
     apploader_t *loader;
     const executor_task_t *task;
+    /* Show cached list before fetching from the host */
+    bool use_cache;
+    /* This is the cached list, and the host is still being asked */
+    bool cached;
+    uint32_t cache_hash;
+    uint32_t result_hash;
 };
 
 struct apploader_t {
@@ -34,10 +42,16 @@ struct apploader_t {
     uuidstr_t uuid;
     apploader_cb_t callback;
     lazy_t client;
+    lazy_t cache_dir;
     executor_t *executor;
     apploader_state_t state;
     const executor_task_t *task;
     void *userdata;
+    /* Hash of the app list on disk */
+    uint32_t cache_hash;
+    /* Hash of the list passed to data callback, only changed lists will be passed again */
+    uint32_t result_hash;
+    bool result_delivered;
 };
 
 static void apploader_unref(apploader_t *loader);
@@ -54,12 +68,17 @@ static int applist_name_comparator(apploader_item_t *p1, apploader_item_t *p2);
 
 static void task_callback(apploader_task_ctx_t *task);
 
+static void task_deliver_cached(apploader_task_ctx_t *task, const struct pclist_t *node, const char *cache_dir);
+
+static uint32_t apps_hash(const apploader_list_t *list);
+
 static apploader_list_t *apps_create(const struct pclist_t *node, PAPP_LIST ll);
 
 apploader_t *apploader_create(app_t *app, const uuidstr_t *uuid, const apploader_cb_t *cb, void *userdata) {
     apploader_t *loader = calloc(1, sizeof(apploader_t));
     refcounter_init(&loader->refcounter);
     lazy_init(&loader->client, (lazy_supplier) app_gs_client_new, app);
+    lazy_init(&loader->cache_dir, (lazy_supplier) path_cache, NULL);
     loader->app = app;
     loader->executor = app->backend.executor;
     loader->callback = *cb;
@@ -118,6 +137,10 @@ static void apploader_free(apploader_t *loader) {
     if (client != NULL) {
         gs_destroy(client);
     }
+    char *cache_dir = lazy_deinit(&loader->cache_dir);
+    if (cache_dir != NULL) {
+        free(cache_dir);
+    }
     refcounter_destroy(&loader->refcounter);
     free(loader);
 }
@@ -126,17 +149,25 @@ static apploader_task_ctx_t *task_create(apploader_t *loader) {
     apploader_task_ctx_t *task = calloc(1, sizeof(apploader_task_ctx_t));
     refcounter_ref(&loader->refcounter);
     task->loader = loader;
+    task->use_cache = !loader->result_delivered;
+    task->cache_hash = loader->cache_hash;
     return task;
 }
 
 static int task_run(apploader_task_ctx_t *task) {
     int ret = GS_OK;
     const char *error = NULL;
-    const pclist_t *node = pcmanager_node(pcmanager, &task->loader->uuid);
+    const pclist_snapshot_t *servers = pcmanager_servers_acquire(pcmanager);
+    const pclist_t *node = pcmanager_servers_find(servers, &task->loader->uuid);
     if (node == NULL) {
         ret = GS_ERROR;
         goto finish;
     }
+    const char *cache_dir = lazy_obtain(&task->loader->cache_dir);
+    if (task->use_cache && cache_dir != NULL) {
+        task_deliver_cached(task, node, cache_dir);
+    }
+    Uint32 fetch_start = SDL_GetTicks();
     PAPP_LIST ll = NULL;
     GS_CLIENT client = lazy_obtain(&task->loader->client);
     if ((ret = gs_applist(client, node->server, &ll)) != GS_OK) {
@@ -147,10 +178,19 @@ static int task_run(apploader_task_ctx_t *task) {
         ret = GS_ERROR;
         goto finish;
     }
+    uint32_t cache_hash = apploader_cache_hash(ll);
+    commons_log_info("AppLoader", "Fetched app list in %u ms, %s", SDL_GetTicks() - fetch_start,
+                     cache_hash == task->cache_hash ? "same as cached" : "changed");
+    if (cache_hash != task->cache_hash && cache_dir != NULL &&
+        apploader_cache_save(cache_dir, (const char *) &task->loader->uuid, ll, cache_hash) == 0) {
+        task->cache_hash = cache_hash;
+    }
     apploader_list_t *result = apps_create(node, ll);
     applist_free(ll, (applist_nodefree_fn) free);
     task->result = result;
+    task->result_hash = apps_hash(result);
     finish:
+    pcmanager_servers_release(servers);
     task->code = ret;
     task->error = error;
     return ret;
@@ -173,9 +213,21 @@ static void task_callback(apploader_task_ctx_t *task) {
     apploader_t *loader = task->loader;
     commons_log_debug("AppLoader", "[loader %p] task callback", loader);
     if (task->code == GS_OK) {
-        loader->state = APPLOADER_STATE_IDLE;
-        if (loader->callback.data != NULL) {
+        if (!task->cached) {
+            loader->state = APPLOADER_STATE_IDLE;
+        }
+        loader->cache_hash = task->cache_hash;
+        if (loader->result_delivered && loader->result_hash == task->result_hash) {
+            apploader_list_free(task->result);
+            if (!task->cached && loader->callback.unchanged != NULL) {
+                loader->callback.unchanged(loader->userdata);
+            }
+        } else if (loader->callback.data != NULL) {
+            loader->result_delivered = true;
+            loader->result_hash = task->result_hash;
             loader->callback.data(task->result, loader->userdata);
+        } else {
+            apploader_list_free(task->result);
         }
     } else {
         loader->state = APPLOADER_STATE_ERROR;
@@ -187,6 +239,44 @@ static void task_callback(apploader_task_ctx_t *task) {
     free(task);
 }
 
+/**
+ * Pass the list saved last time to the main thread, while the host is being asked for the current one.
+ */
+static void task_deliver_cached(apploader_task_ctx_t *task, const struct pclist_t *node, const char *cache_dir) {
+    apploader_t *loader = task->loader;
+    Uint32 load_start = SDL_GetTicks();
+    uint32_t hash = 0;
+    PAPP_LIST ll = apploader_cache_load(cache_dir, (const char *) &loader->uuid, &hash);
+    if (ll == NULL) {
+        return;
+    }
+    task->cache_hash = hash;
+    apploader_task_ctx_t *cached = task_create(loader);
+    cached->code = GS_OK;
+    cached->cached = true;
+    cached->cache_hash = hash;
+    cached->result = apps_create(node, ll);
+    cached->result_hash = apps_hash(cached->result);
+    applist_free(ll, (applist_nodefree_fn) free);
+    commons_log_info("AppLoader", "Loaded %d cached apps in %u ms", (int) cached->result->count,
+                     SDL_GetTicks() - load_start);
+    if (!app_bus_post(loader->app, (bus_actionfunc) task_callback, cached)) {
+        apploader_list_free(cached->result);
+        apploader_unref(loader);
+        free(cached);
+    }
+}
+
+static uint32_t apps_hash(const apploader_list_t *list) {
+    uint32_t hash = 0;
+    for (int i = 0; i < list->count; i++) {
+        const apploader_item_t *item = &list->items[i];
+        hash = hash * 31 + apploader_cache_hash(&item->base);
+        hash = hash * 31 + (item->fav ? 1 : 0) + (item->hidden ? 2 : 0);
+    }
+    return hash;
+}
+
 static apploader_list_t *apps_create(const struct pclist_t *node, PAPP_LIST ll) {
     int count = applist_len(ll);
     apploader_list_t *result = malloc(sizeof(apploader_list_t) + count * sizeof(apploader_item_t));
@@ -32,6 +32,11 @@ typedef struct apploader_cb_t {
     void (*data)(apploader_list_t *apps, void *userdata);
 
     void (*error)(int code, const char *error, void *userdata);
+
+    /**
+     * Host returned the same list as the one passed to data callback.
+     */
+    void (*unchanged)(void *userdata);
 } apploader_cb_t;
 
 typedef void (*apploader_cb)(apploader_t *loader, void *userdata);
@@ -0,0 +1,157 @@
+#include "apploader_cache.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL_stdinc.h>
+
+#include "util/path.h"
+#include "logging.h"
+
+#define CACHE_MAGIC "MLAL"
+#define CACHE_VERSION 1
+#define CACHE_MAX_APPS 65536
+
+static void hash_update(uint32_t *hash, const void *data, size_t len);
+
+static bool write_u32(FILE *fp, uint32_t value);
+
+static bool read_u32(FILE *fp, uint32_t *value);
+
+static char *cache_path(const char *cache_dir, const char *uuid);
+
+uint32_t apploader_cache_hash(const APP_LIST *list) {
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    for (const APP_LIST *cur = list; cur != NULL; cur = cur->next) {
+        unsigned char id[4] = {cur->id & 0xFF, (cur->id >> 8) & 0xFF, (cur->id >> 16) & 0xFF,
+                               (cur->id >> 24) & 0xFF};
+        hash_update(&hash, id, sizeof(id));
+        unsigned char hdr = cur->hdr != 0;
+        hash_update(&hash, &hdr, 1);
+        // Includes the terminator, so names can't run into the next item
+        const char *name = cur->name != NULL ? cur->name : "";
+        hash_update(&hash, name, strlen(name) + 1);
+    }
+    return hash;
+}
+
+int apploader_cache_save(const char *cache_dir, const char *uuid, const APP_LIST *list, uint32_t hash) {
+    char *path = cache_path(cache_dir, uuid);
+    size_t tmp_len = strlen(path) + 5;
+    char *tmp_path = malloc(tmp_len);
+    SDL_snprintf(tmp_path, tmp_len, "%s.tmp", path);
+    int ret = 0;
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        ret = errno;
+        goto finish;
+    }
+    uint32_t count = 0;
+    for (const APP_LIST *cur = list; cur != NULL; cur = cur->next) {
+        count++;
+    }
+    bool ok = fwrite(CACHE_MAGIC, 1, 4, fp) == 4 && write_u32(fp, CACHE_VERSION) && write_u32(fp, hash) &&
+              write_u32(fp, count);
+    for (const APP_LIST *cur = list; ok && cur != NULL; cur = cur->next) {
+        const char *name = cur->name != NULL ? cur->name : "";
+        uint32_t name_len = strlen(name);
+        ok = write_u32(fp, (uint32_t) cur->id) && write_u32(fp, cur->hdr != 0) && write_u32(fp, name_len) &&
+             fwrite(name, 1, name_len, fp) == name_len;
+    }
+    if (!ok) {
+        ret = errno != 0 ? errno : EIO;
+    }
+    if (fclose(fp) != 0 && ret == 0) {
+        ret = errno;
+    }
+    if (ret == 0 && rename(tmp_path, path) != 0) {
+        ret = errno;
+    }
+    finish:
+    if (ret != 0) {
+        commons_log_warn("AppLoader", "Failed to save app list cache of %s: %s", uuid, strerror(ret));
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    free(path);
+    return ret;
+}
+
+APP_LIST *apploader_cache_load(const char *cache_dir, const char *uuid, uint32_t *hash) {
+    char *path = cache_path(cache_dir, uuid);
+    FILE *fp = fopen(path, "rb");
+    free(path);
+    if (fp == NULL) {
+        return NULL;
+    }
+    APP_LIST *head = NULL, **tail = &head;
+    char magic[4];
+    uint32_t version = 0, saved_hash = 0, count = 0;
+    bool ok = fread(magic, 1, 4, fp) == 4 && memcmp(magic, CACHE_MAGIC, 4) == 0 && read_u32(fp, &version) &&
+              version == CACHE_VERSION && read_u32(fp, &saved_hash) && read_u32(fp, &count) &&
+              count <= CACHE_MAX_APPS;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        uint32_t id, hdr, name_len;
+        ok = read_u32(fp, &id) && read_u32(fp, &hdr) && read_u32(fp, &name_len) && name_len < 4096;
+        if (!ok) {
+            break;
+        }
+        APP_LIST *item = calloc(1, sizeof(APP_LIST));
+        item->id = (int) id;
+        item->hdr = (int) hdr;
+        item->name = calloc(name_len + 1, 1);
+        *tail = item;
+        tail = &item->next;
+        ok = fread(item->name, 1, name_len, fp) == name_len;
+    }
+    ok = ok && fgetc(fp) == EOF;
+    fclose(fp);
+    // The hash also tells whether the file is intact
+    if (!ok || apploader_cache_hash(head) != saved_hash) {
+        commons_log_warn("AppLoader", "Ignoring invalid app list cache of %s", uuid);
+        apploader_cache_free(head);
+        return NULL;
+    }
+    *hash = saved_hash;
+    return head;
+}
+
+void apploader_cache_free(APP_LIST *list) {
+    while (list != NULL) {
+        APP_LIST *next = list->next;
+        free(list->name);
+        free(list);
+        list = next;
+    }
+}
+
+static void hash_update(uint32_t *hash, const void *data, size_t len) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        *hash ^= bytes[i];
+        *hash *= 16777619u;
+    }
+}
+
+static bool write_u32(FILE *fp, uint32_t value) {
+    unsigned char bytes[4] = {value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24};
+    return fwrite(bytes, 1, sizeof(bytes), fp) == sizeof(bytes);
+}
+
+static bool read_u32(FILE *fp, uint32_t *value) {
+    unsigned char bytes[4];
+    if (fread(bytes, 1, sizeof(bytes), fp) != sizeof(bytes)) {
+        return false;
+    }
+    *value = (uint32_t) bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+    return true;
+}
+
+static char *cache_path(const char *cache_dir, const char *uuid) {
+    char name[64];
+    SDL_snprintf(name, sizeof(name), "applist-%s.bin", uuid);
+    return path_join(cache_dir, name);
+}
@@ -0,0 +1,32 @@
+/**
+ * @file apploader_cache.h
+ *
+ * App list of each host saved on disk, so it can be shown before the host responds.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "libgamestream/client.h"
+
+/**
+ * Hash of ids, names and HDR flags, used like an ETag to tell whether the list has changed.
+ */
+uint32_t apploader_cache_hash(const APP_LIST *list);
+
+/**
+ * @param hash Value of apploader_cache_hash(list)
+ * @return 0 on success
+ */
+int apploader_cache_save(const char *cache_dir, const char *uuid, const APP_LIST *list, uint32_t hash);
+
+/**
+ * @param hash Hash of the loaded list
+ * @return Cached app list, or NULL if not available or invalid. Should be freed with apploader_cache_free.
+ */
+APP_LIST *apploader_cache_load(const char *cache_dir, const char *uuid, uint32_t *hash);
+
+/**
+ * Free list nodes along with their names.
+ */
+void apploader_cache_free(APP_LIST *list);
@@ -5,25 +5,75 @@
 #include "errors.h"
 #include "app_error.h"
 
+static int gs_conf_worker(app_backend_t *backend);
+
+static void gs_conf_set_state(app_backend_t *backend, backend_gs_conf_state_t state);
+
+static GS_CLIENT gs_client_new(app_t *app, bool need_cert);
+
+void backend_gs_conf_start(app_backend_t *backend) {
+    backend->gs_client_mutex = SDL_CreateMutex();
+    backend->gs_conf_cond = SDL_CreateCond();
+    backend->gs_conf_state = BACKEND_GS_CONF_LOADING;
+    backend->gs_conf_thread = SDL_CreateThread((SDL_ThreadFunction) gs_conf_worker, BACKEND_GS_CONF_THREAD_NAME,
+                                                backend);
+    if (backend->gs_conf_thread == NULL) {
+        // Generate it synchronously when the first client is created
+        commons_log_warn("GameStream", "Failed to start client configuration thread: %s", SDL_GetError());
+        backend->gs_conf_state = BACKEND_GS_CONF_READY;
+    }
+}
+
+void backend_gs_conf_finish(app_backend_t *backend) {
+    if (backend->gs_conf_thread != NULL) {
+        SDL_WaitThread(backend->gs_conf_thread, NULL);
+        backend->gs_conf_thread = NULL;
+    }
+    SDL_DestroyCond(backend->gs_conf_cond);
+    SDL_DestroyMutex(backend->gs_client_mutex);
+}
+
 GS_CLIENT app_gs_client_new(app_t *app) {
+    return gs_client_new(app, false);
+}
+
+GS_CLIENT app_gs_client_new_with_cert(app_t *app) {
+    return gs_client_new(app, true);
+}
+
+static GS_CLIENT gs_client_new(app_t *app, bool need_cert) {
     if (SDL_ThreadID() == app->main_thread_id) {
         commons_log_fatal("APP", "%s MUST BE called from worker thread!", __FUNCTION__);
         abort();
     }
-    SDL_assert_release(app->backend.gs_client_mutex != NULL);
-    SDL_LockMutex(app->backend.gs_client_mutex);
+    app_backend_t *backend = &app->backend;
+    SDL_assert_release(backend->gs_client_mutex != NULL);
     SDL_assert_release(app_configuration != NULL);
-    GS_CLIENT client = gs_new(app_configuration->key_dir);
-    if (client == NULL && gs_get_error(NULL) == GS_BAD_CONF) {
-        if (gs_conf_init(app_configuration->key_dir) != GS_OK) {
-            const char *message = NULL;
-            gs_get_error(&message);
-            app_fatal_error("Failed to generate client info",
-                            "Please turn off and unplug to completely restart the TV.\n\n"
-                            "Details: %s", message);
-            app_halt(app);
-        } else {
-            client = gs_new(app_configuration->key_dir);
+    SDL_LockMutex(backend->gs_client_mutex);
+    while (backend->gs_conf_state == BACKEND_GS_CONF_LOADING ||
+           (need_cert && backend->gs_conf_state == BACKEND_GS_CONF_GENERATING)) {
+        SDL_CondWait(backend->gs_conf_cond, backend->gs_client_mutex);
+    }
+    GS_CLIENT client;
+    // There can't be any paired host without client certificate, so an unpaired client is enough for now. If
+    // generation has failed, it's retried when the certificate is actually needed.
+    if (backend->gs_conf_state == BACKEND_GS_CONF_GENERATING ||
+        (!need_cert && backend->gs_conf_state == BACKEND_GS_CONF_FAILED)) {
+        client = gs_new_unpaired(app_configuration->key_dir);
+    } else {
+        client = gs_new(app_configuration->key_dir);
+        if (client == NULL && gs_get_error(NULL) == GS_BAD_CONF) {
+            if (gs_conf_init(app_configuration->key_dir) != GS_OK) {
+                const char *message = NULL;
+                gs_get_error(&message);
+                app_fatal_error("Failed to generate client info",
+                                "Please turn off and unplug to completely restart the TV.\n\n"
+                                "Details: %s", message);
+                app_halt(app);
+            } else {
+                backend->gs_conf_state = BACKEND_GS_CONF_READY;
+                client = gs_new(app_configuration->key_dir);
+            }
         }
     }
     if (client == NULL) {
@@ -34,6 +84,44 @@ GS_CLIENT app_gs_client_new(app_t *app) {
                         "Details: %s", message);
         app_halt(app);
     }
-    SDL_UnlockMutex(app->backend.gs_client_mutex);
+    SDL_UnlockMutex(backend->gs_client_mutex);
     return client;
 }
+
+static int gs_conf_worker(app_backend_t *backend) {
+    const char *key_dir = app_configuration->key_dir;
+    SDL_LockMutex(backend->gs_client_mutex);
+    GS_CLIENT client = gs_new(key_dir);
+    bool generate = client == NULL && gs_get_error(NULL) == GS_BAD_CONF;
+    if (client != NULL) {
+        gs_destroy(client);
+    }
+    SDL_UnlockMutex(backend->gs_client_mutex);
+    if (!generate) {
+        // Other errors are reported when the client is actually needed
+        gs_conf_set_state(backend, BACKEND_GS_CONF_READY);
+        return 0;
+    }
+
+    gs_conf_set_state(backend, BACKEND_GS_CONF_GENERATING);
+    Uint32 start = SDL_GetTicks();
+    int ret = gs_conf_init(key_dir);
+    Uint32 elapsed = SDL_GetTicks() - start;
+    if (ret != GS_OK) {
+        const char *message = NULL;
+        gs_get_error(&message);
+        commons_log_error("GameStream", "Failed to generate client certificate after %u ms: %s", elapsed, message);
+        gs_conf_set_state(backend, BACKEND_GS_CONF_FAILED);
+        return ret;
+    }
+    commons_log_info("GameStream", "Generated client certificate in %u ms", elapsed);
+    gs_conf_set_state(backend, BACKEND_GS_CONF_READY);
+    return 0;
+}
+
+static void gs_conf_set_state(app_backend_t *backend, backend_gs_conf_state_t state) {
+    SDL_LockMutex(backend->gs_client_mutex);
+    backend->gs_conf_state = state;
+    SDL_CondBroadcast(backend->gs_conf_cond);
+    SDL_UnlockMutex(backend->gs_client_mutex);
+}
@@ -13,15 +13,18 @@ pcmanager_t *pcmanager;
 
 void backend_init(app_backend_t *backend, app_t *app) {
     backend->app = app;
-    backend->executor = executor_create("moonlight-io", 2 * SDL_min(3, SDL_GetCPUCount()));
-    backend->gs_client_mutex = SDL_CreateMutex();
+    startup_trace_begin(&app->startup_trace, "executor_create");
+    backend->executor = executor_create(BACKEND_EXECUTOR_NAME, 2 * SDL_min(3, SDL_GetCPUCount()));
+    startup_trace_end(&app->startup_trace);
+    startup_trace_begin(&app->startup_trace, "pcmanager_new");
     pcmanager = pcmanager_new(app, backend->executor);
+    startup_trace_end(&app->startup_trace);
 }
 
 void backend_destroy(app_backend_t *backend) {
     pcmanager_destroy(pcmanager);
-    SDL_DestroyMutex(backend->gs_client_mutex);
     executor_destroy(backend->executor);
+    backend_gs_conf_finish(backend);
 }
 
 bool backend_dispatch_userevent(app_backend_t *backend, int which, void *data1, void *data2) {
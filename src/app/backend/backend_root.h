@@ -6,12 +6,38 @@
 typedef struct app_t app_t;
 typedef struct executor_t executor_t;
 
+/* Names of backend threads, they do no work for the streaming session */
+#define BACKEND_EXECUTOR_NAME "moonlight-io"
+#define BACKEND_GS_CONF_THREAD_NAME "gs_conf"
+
+typedef enum backend_gs_conf_state_t {
+    BACKEND_GS_CONF_LOADING = 0,
+    /* Client certificate doesn't exist, and is being generated */
+    BACKEND_GS_CONF_GENERATING,
+    BACKEND_GS_CONF_READY,
+    BACKEND_GS_CONF_FAILED,
+} backend_gs_conf_state_t;
+
 typedef struct app_backend_t {
     app_t *app;
     executor_t *executor;
     SDL_mutex *gs_client_mutex;
+    SDL_Thread *gs_conf_thread;
+    SDL_cond *gs_conf_cond;
+    backend_gs_conf_state_t gs_conf_state;
 } app_backend_t;
 
+/**
+ * Check client configuration in background, and generate client certificate if it doesn't exist yet. Key generation
+ * can take seconds on slow devices, so call it as early as possible, before backend_init().
+ */
+void backend_gs_conf_start(app_backend_t *backend);
+
+/**
+ * Wait for the background check to finish, and release its resources.
+ */
+void backend_gs_conf_finish(app_backend_t *backend);
+
 void backend_init(app_backend_t *backend, app_t *app);
 
 void backend_destroy(app_backend_t *backend);
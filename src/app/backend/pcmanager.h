@@ -2,12 +2,15 @@
 
 #include <stdbool.h>
 
+#include <SDL_mutex.h>
+
 #include "backend/types.h"
 
 #include "libgamestream/client.h"
 #include "uuidstr.h"
 #include "sockaddr.h"
 #include "hostport.h"
+#include "executor.h"
 
 typedef struct app_t app_t;
 typedef struct pcmanager_t pcmanager_t;
@@ -16,12 +19,36 @@ typedef struct executor_t executor_t;
 
 typedef void (*pcmanager_callback_t)(int result, const char *error, const uuidstr_t *uuid, void *userdata);
 
+/**
+ * @param ready_ms Milliseconds from sending the magic packet until the host accepted connections, 0 if it never did
+ */
+typedef void (*pcmanager_wol_callback_t)(int result, const char *error, const uuidstr_t *uuid, Uint32 ready_ms,
+                                         void *userdata);
+
 typedef void(*pcmanager_listener_fn)(const uuidstr_t *uuid, void *userdata);
 
+/**
+ * Hosts changed in one batch. A host removed and added again in the same batch appears in both lists.
+ */
+typedef struct pcmanager_changes_t {
+    const uuidstr_t *removed;
+    size_t num_removed;
+    const uuidstr_t *added;
+    size_t num_added;
+    const uuidstr_t *updated;
+    size_t num_updated;
+} pcmanager_changes_t;
+
+typedef void(*pcmanager_changes_fn)(const pcmanager_changes_t *changes, void *userdata);
+
 typedef struct pcmanager_listener_t {
     pcmanager_listener_fn added;
     pcmanager_listener_fn updated;
     pcmanager_listener_fn removed;
+    /**
+     * Called once for each batch of changes. If set, callbacks above won't be called.
+     */
+    pcmanager_changes_fn changed;
 } pcmanager_listener_t;
 
 /**
@@ -30,6 +57,26 @@ typedef struct pcmanager_listener_t {
  */
 pcmanager_t *pcmanager_new(app_t *app, executor_t *executor);
 
+/**
+ * Known hosts read by pcmanager_load_known_hosts(), not in the list yet.
+ */
+typedef struct pcmanager_known_hosts_t {
+    pclist_t **nodes;
+    size_t count;
+} pcmanager_known_hosts_t;
+
+/**
+ * Read known hosts and their last known state. Doesn't touch the host list, so it can run on any thread.
+ */
+void pcmanager_load_known_hosts(pcmanager_t *manager, pcmanager_known_hosts_t *hosts);
+
+/**
+ * Add hosts read by pcmanager_load_known_hosts() to the list. Main thread only.
+ *
+ * @param hosts Nodes are owned by the list afterwards, and hosts is emptied
+ */
+void pcmanager_add_known_hosts(pcmanager_t *manager, pcmanager_known_hosts_t *hosts);
+
 /**
  * @brief Free all allocated memories, such as computer_list.
  * 
@@ -40,8 +87,30 @@ void pcmanager_auto_discovery_start(pcmanager_t *manager);
 
 void pcmanager_auto_discovery_stop(pcmanager_t *manager);
 
-const pclist_t *pcmanager_servers(pcmanager_t *manager);
+bool pcmanager_auto_discovery_running(pcmanager_t *manager);
 
+/**
+ * Make running discovery query at fast pace again. Thread safe.
+ */
+void pcmanager_auto_discovery_rescan(pcmanager_t *manager);
+
+/**
+ * Main thread only. The returned snapshot is replaced on next host change, so don't keep it.
+ */
+const pclist_snapshot_t *pcmanager_servers(pcmanager_t *manager);
+
+/**
+ * Get current hosts from any thread without blocking. Nodes in it stay valid until it's released.
+ */
+const pclist_snapshot_t *pcmanager_servers_acquire(pcmanager_t *manager);
+
+void pcmanager_servers_release(const pclist_snapshot_t *snapshot);
+
+const pclist_t *pcmanager_servers_find(const pclist_snapshot_t *snapshot, const uuidstr_t *uuid);
+
+/**
+ * Main thread only. Other threads should use pcmanager_servers_acquire() and pcmanager_servers_find().
+ */
 const pclist_t *pcmanager_node(pcmanager_t *manager, const uuidstr_t *uuid);
 
 const SERVER_STATE *pcmanager_state(pcmanager_t *manager, const uuidstr_t *uuid);
@@ -100,6 +169,21 @@ bool pcmanager_pair(pcmanager_t *manager, const uuidstr_t *uuid, char *pin, pcma
  */
 bool pcmanager_quitapp(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_callback_t callback, void *userdata);
 
+/**
+ * Quit application if requested, and fetch host information after a streaming session ends
+ * @param manager
+ * @param uuid
+ * @param quitapp
+ * @param done Posted when the task has finished or was cancelled, can be NULL
+ */
+void pcmanager_session_finished(pcmanager_t *manager, const uuidstr_t *uuid, bool quitapp, SDL_sem *done);
+
+/**
+ * Drop host update queued by the previous session if it hasn't started yet. App quit is not affected.
+ * @param manager
+ */
+void pcmanager_session_starting(pcmanager_t *manager);
+
 /**
  * Fetch host information
  * @param manager
@@ -111,14 +195,22 @@ void pcmanager_request_update(pcmanager_t *manager, const uuidstr_t *uuid, pcman
                               void *userdata);
 
 /**
- * Send Wake-on-LAN packet, and request host info update
+ * Refresh all known hosts at once. Hosts are probed with a TCP connection first, unreachable ones are marked offline
+ * without waiting for server info timeout, and server info is fetched only from reachable ones.
+ * @param manager
+ * @param exclude Host not to refresh (e.g. it's updated by someone else), can be NULL
+ */
+void pcmanager_refresh(pcmanager_t *manager, const uuidstr_t *exclude);
+
+/**
+ * Send Wake-on-LAN packet, wait until the host accepts connections, and fetch host info
  * @param manager
  * @param uuid
- * @param callback
+ * @param callback Called with time until the host got ready
  * @param userdata
  * @return
  */
-bool pcmanager_send_wol(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_callback_t callback,
+bool pcmanager_send_wol(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_wol_callback_t callback,
                         void *userdata);
 
 /* ------------------------------------------------------------------------------ */
@@ -49,6 +49,24 @@ void discovery_stop(discovery_t *discovery) {
     SDL_UnlockMutex(discovery->lock);
 }
 
+bool discovery_running(discovery_t *discovery) {
+    SDL_LockMutex(discovery->lock);
+    bool running = discovery->task != NULL;
+    SDL_UnlockMutex(discovery->lock);
+    return running;
+}
+
+void discovery_rescan(discovery_t *discovery) {
+    SDL_LockMutex(discovery->lock);
+    discovery_task_t *task = discovery->task;
+    if (task != NULL) {
+        SDL_LockMutex(task->lock);
+        task->rescan = true;
+        SDL_UnlockMutex(task->lock);
+    }
+    SDL_UnlockMutex(discovery->lock);
+}
+
 void discovery_discovered(struct discovery_t *discovery, const sockaddr_t *addr) {
     discovery_throttle_on_discovered(&discovery->throttle, addr, 10000);
 }
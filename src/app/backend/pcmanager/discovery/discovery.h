@@ -26,10 +26,19 @@ typedef void (*discovery_callback)(const sockaddr_t *addr, void *user_data);
 
 typedef struct discovery_throttle_host_t discovery_throttle_host_t;
 
+/* Number of expiry slots, each covers DISCOVERY_THROTTLE_TICK_MS */
+#define DISCOVERY_THROTTLE_WHEEL_SLOTS 256
+#define DISCOVERY_THROTTLE_TICK_MS 64
+
 typedef struct discovery_throttle_t {
     discovery_callback callback;
     void *user_data;
-    discovery_throttle_host_t *hosts;
+    /* Hosts indexed by address */
+    discovery_throttle_host_t **buckets;
+    size_t buckets_size, count;
+    /* Hosts by expiry time */
+    discovery_throttle_host_t *wheel[DISCOVERY_THROTTLE_WHEEL_SLOTS];
+    Uint32 wheel_tick;
     SDL_mutex *lock;
 } discovery_throttle_t;
 
@@ -45,4 +54,11 @@ void discovery_start(discovery_t *discovery);
 
 void discovery_stop(discovery_t *discovery);
 
+bool discovery_running(discovery_t *discovery);
+
+/**
+ * Ask running discovery to query at fast pace again, e.g. after network change.
+ */
+void discovery_rescan(discovery_t *discovery);
+
 void discovery_deinit(discovery_t *discovery);
@@ -1,185 +1,230 @@
-#include "backend/pcmanager.h"
-#include "backend/pcmanager/priv.h"
-#include "backend/pcmanager/worker/worker.h"
+#include "impl.h"
+#include "../inflight.h"
 
 #include <dns_sd.h>
-#include <SDL_thread.h>
-#include <sys/poll.h>
-#include <netdb.h>
 #include <arpa/inet.h>
-#include <errno.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "sockaddr.h"
 #include "logging.h"
 
-struct discovery_task_t {
-    pcmanager_t *manager;
-    SDL_mutex *lock;
-    SDL_Thread *thread;
-    bool stop;
-};
-
-static int discovery_worker(discovery_task_t *task);
-
-static bool discovery_stopped(discovery_task_t *task);
-
-static void browse_callback(
-        DNSServiceRef sdRef,
-        DNSServiceFlags flags,
-        uint32_t interfaceIndex,
-        DNSServiceErrorType errorCode,
-        const char *serviceName,
-        const char *regtype,
-        const char *replyDomain,
-        void *context
-);
-
-static void resolve_callback(
-        DNSServiceRef sdRef,
-        DNSServiceFlags flags,
-        uint32_t interfaceIndex,
-        DNSServiceErrorType errorCode,
-        const char *fullname,
-        const char *hosttarget,
-        uint16_t port,                  /* In network byte order */
-        uint16_t txtLen,
-        const unsigned char *txtRecord,
-        void *context
-);
-
-static void discovery_finalize(void *arg, int result);
-
-void pcmanager_auto_discovery_start(pcmanager_t *manager) {
-    pcmanager_lock(manager);
-    if (manager->discovery_task != NULL) {
-        pcmanager_unlock(manager);
-        return;
+/* Resolve and address lookup of one service should finish within this time, otherwise the responder is stale */
+#define RESOLVE_TIMEOUT 3000
+/* Upper bound of resolves in flight, in case of a flood of announcements */
+#define RESOLVE_MAX_INFLIGHT 32
+
+typedef struct dnssd_worker_t {
+    discovery_task_t *task;
+    discovery_inflight_t inflight;
+    DNSServiceRef browse;
+} dnssd_worker_t;
+
+typedef struct dnssd_op_t {
+    dnssd_worker_t *worker;
+    DNSServiceRef ref;
+    char *name;
+    /* In host byte order */
+    uint16_t port;
+    bool done;
+} dnssd_op_t;
+
+static bool discovery_is_stopped(discovery_task_t *task);
+
+static bool browse_start(dnssd_worker_t *worker);
+
+static bool browse_process(dnssd_worker_t *worker);
+
+static void browse_close(dnssd_worker_t *worker, bool timed_out);
+
+static void browse_callback(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                            DNSServiceErrorType errorCode, const char *serviceName, const char *regtype,
+                            const char *replyDomain, void *context);
+
+static void resolve_callback(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                             DNSServiceErrorType errorCode, const char *fullname, const char *hosttarget,
+                             uint16_t port, uint16_t txtLen, const unsigned char *txtRecord, void *context);
+
+static void addrinfo_callback(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                              DNSServiceErrorType errorCode, const char *hostname, const struct sockaddr *address,
+                              uint32_t ttl, void *context);
+
+static dnssd_op_t *op_new(dnssd_worker_t *worker, const char *name, uint16_t port);
+
+static void op_add(dnssd_op_t *op);
+
+static bool op_process(dnssd_op_t *op);
+
+static void op_close(dnssd_op_t *op, bool timed_out);
+
+int discovery_worker(discovery_task_t *task) {
+    dnssd_worker_t worker = {.task = task, .browse = NULL};
+    discovery_inflight_init(&worker.inflight);
+    commons_log_info("Discovery", "Start DNS-SD discovery");
+    int ret = 0;
+    while (!discovery_is_stopped(task)) {
+        if (worker.browse == NULL && !browse_start(&worker)) {
+            // Daemon may be restarting, try again later
+            SDL_Delay(5000);
+            continue;
+        }
+        // Wake up periodically to check whether discovery has been stopped
+        if (discovery_inflight_poll(&worker.inflight, 500) < 0) {
+            commons_log_error("Discovery", "poll failed");
+            ret = -1;
+            break;
+        }
     }
-    discovery_task_t *task = SDL_calloc(1, sizeof(discovery_task_t));
-    task->manager = manager;
-    task->lock = SDL_CreateMutex();
-    task->stop = false;
-    task->thread = SDL_CreateThread((SDL_ThreadFunction) discovery_worker, "discovery", task);
-    manager->discovery_task = task;
-    pcmanager_unlock(manager);
+    discovery_inflight_deinit(&worker.inflight);
+    commons_log_info("Discovery", "DNS-SD discovery stopped");
+    return ret;
 }
 
-void pcmanager_auto_discovery_stop(pcmanager_t *manager) {
-    pcmanager_lock(manager);
-    discovery_task_t *task = manager->discovery_task;
-    if (task == NULL) {
-        pcmanager_unlock(manager);
-        return;
+void discovery_worker_stop(discovery_task_t *task) {
+    SDL_LockMutex(task->lock);
+    task->stop = true;
+    SDL_UnlockMutex(task->lock);
+}
+
+static bool discovery_is_stopped(discovery_task_t *task) {
+    SDL_LockMutex(task->lock);
+    bool stop = task->stop;
+    SDL_UnlockMutex(task->lock);
+    return stop;
+}
+
+static bool browse_start(dnssd_worker_t *worker) {
+    DNSServiceErrorType err = DNSServiceBrowse(&worker->browse, 0, 0, "_nvstream._tcp", NULL, browse_callback,
+                                               worker);
+    if (err != kDNSServiceErr_NoError) {
+        commons_log_warn("Discovery", "DNSServiceBrowse failed: %d", err);
+        worker->browse = NULL;
+        return false;
     }
-    manager->discovery_task = NULL;
-    executor_submit(manager->executor, executor_noop, discovery_finalize, task);
-    pcmanager_unlock(manager);
+    discovery_inflight_add(&worker->inflight, DNSServiceRefSockFD(worker->browse), 0,
+                           (discovery_inflight_process_fn) browse_process,
+                           (discovery_inflight_close_fn) browse_close, worker);
+    return true;
+}
+
+static bool browse_process(dnssd_worker_t *worker) {
+    return DNSServiceProcessResult(worker->browse) != kDNSServiceErr_NoError;
 }
 
-static void browse_callback(
-        DNSServiceRef sdRef,
-        DNSServiceFlags flags,
-        uint32_t interfaceIndex,
-        DNSServiceErrorType errorCode,
-        const char *serviceName,
-        const char *regtype,
-        const char *replyDomain,
-        void *context
-) {
+static void browse_close(dnssd_worker_t *worker, bool timed_out) {
+    (void) timed_out;
+    DNSServiceRefDeallocate(worker->browse);
+    worker->browse = NULL;
+}
+
+static void browse_callback(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                            DNSServiceErrorType errorCode, const char *serviceName, const char *regtype,
+                            const char *replyDomain, void *context) {
     (void) sdRef;
-    (void) flags;
+    dnssd_worker_t *worker = context;
     if (errorCode != kDNSServiceErr_NoError) {
         commons_log_warn("Discovery", "Got error: %d", errorCode);
         return;
     }
-    DNSServiceRef dns;
-    if (DNSServiceResolve(&dns, 0, interfaceIndex, serviceName, regtype, replyDomain, resolve_callback, context) !=
+    if (!(flags & kDNSServiceFlagsAdd)) {
+        return;
+    }
+    if (worker->inflight.count >= RESOLVE_MAX_INFLIGHT) {
+        commons_log_warn("Discovery", "Too many pending resolves, ignoring %s", serviceName);
+        return;
+    }
+    dnssd_op_t *op = op_new(worker, serviceName, 0);
+    if (DNSServiceResolve(&op->ref, 0, interfaceIndex, serviceName, regtype, replyDomain, resolve_callback, op) !=
         kDNSServiceErr_NoError) {
         commons_log_warn("Discovery", "DNSServiceResolve failed");
+        op->ref = NULL;
+        op_close(op, false);
         return;
     }
-    DNSServiceProcessResult(dns);
-    DNSServiceRefDeallocate(dns);
+    op_add(op);
 }
 
-static void resolve_callback(
-        DNSServiceRef sdRef,
-        DNSServiceFlags flags,
-        uint32_t interfaceIndex,
-        DNSServiceErrorType errorCode,
-        const char *fullname,
-        const char *hosttarget,
-        uint16_t port,                  /* In network byte order */
-        uint16_t txtLen,
-        const unsigned char *txtRecord,
-        void *context
-) {
+static void resolve_callback(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                             DNSServiceErrorType errorCode, const char *fullname, const char *hosttarget,
+                             uint16_t port, uint16_t txtLen, const unsigned char *txtRecord, void *context) {
     (void) sdRef;
     (void) flags;
+    (void) fullname;
+    (void) txtLen;
+    (void) txtRecord;
+    dnssd_op_t *resolve = context;
+    resolve->done = true;
     if (errorCode != kDNSServiceErr_NoError) {
         commons_log_warn("Discovery", "DNSServiceResolve got error: %d", errorCode);
         return;
     }
-    struct hostent *host = gethostbyname2(hosttarget, AF_INET);
-    if (host == NULL) {
+    // Look up the address asynchronously as well, instead of blocking in gethostbyname
+    dnssd_op_t *op = op_new(resolve->worker, resolve->name, ntohs(port));
+    if (DNSServiceGetAddrInfo(&op->ref, 0, interfaceIndex, kDNSServiceProtocol_IPv4, hosttarget, addrinfo_callback,
+                              op) != kDNSServiceErr_NoError) {
+        commons_log_warn("Discovery", "DNSServiceGetAddrInfo failed");
+        op->ref = NULL;
+        op_close(op, false);
         return;
     }
-    if (host->h_length <= 0) {
+    op_add(op);
+}
+
+static void addrinfo_callback(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                              DNSServiceErrorType errorCode, const char *hostname, const struct sockaddr *address,
+                              uint32_t ttl, void *context) {
+    (void) sdRef;
+    (void) interfaceIndex;
+    (void) hostname;
+    (void) ttl;
+    dnssd_op_t *op = context;
+    if (errorCode != kDNSServiceErr_NoError) {
+        commons_log_warn("Discovery", "DNSServiceGetAddrInfo got error: %d", errorCode);
+        op->done = true;
         return;
     }
-    char buf[128];
-    const char *ip = inet_ntop(AF_INET, host->h_addr_list[0], buf, sizeof(buf));
-
-    discovery_task_t *task = context;
-    worker_context_t *ctx = worker_context_new(task->manager, NULL, NULL, NULL);
-    ctx->arg1 = strdup(ip);
-    pcmanager_worker_queue(task->manager, worker_host_discovered, ctx);
+    if (!(flags & kDNSServiceFlagsAdd) || address == NULL || address->sa_family != AF_INET) {
+        return;
+    }
+    op->done = true;
+    if (discovery_is_stopped(op->worker->task)) {
+        return;
+    }
+    sockaddr_t *addr = sockaddr_new();
+    sockaddr_set_ip(addr, AF_INET, &((const struct sockaddr_in *) address)->sin_addr);
+    sockaddr_set_port(addr, op->port);
+    discovery_discovered(op->worker->task->discovery, addr);
+    sockaddr_free(addr);
 }
 
-int discovery_worker(discovery_task_t *task) {
-    while (!discovery_stopped(task)) {
-        DNSServiceRef dns;
-        if (DNSServiceBrowse(&dns, 0, 0, "_nvstream._tcp", "", browse_callback, task) != kDNSServiceErr_NoError) {
-            commons_log_warn("Discovery", "DNSServiceBrowse failed");
-            return -1;
-        }
-        int mdnsfd = DNSServiceRefSockFD(dns);
-        struct pollfd fds = {
-                .fd = mdnsfd,
-                .events = POLLIN | POLLHUP
-        };
-        int ret = poll(&fds, 1, 3000);
-        if (ret <= 0 && errno != EINTR) {
-            DNSServiceRefDeallocate(dns);
-            continue;
-        }
+static dnssd_op_t *op_new(dnssd_worker_t *worker, const char *name, uint16_t port) {
+    dnssd_op_t *op = calloc(1, sizeof(dnssd_op_t));
+    op->worker = worker;
+    op->name = strdup(name);
+    op->port = port;
+    return op;
+}
 
-        if (fds.revents & (POLLIN | POLLHUP | POLLERR)) {
-            /* Invoke callback function */
-            if (DNSServiceProcessResult(dns) != kDNSServiceErr_NoError) {
-                DNSServiceRefDeallocate(dns);
-                continue;
-            }
-        }
-        DNSServiceRefDeallocate(dns);
-        sleep(5);
-    }
-    return 0;
+static void op_add(dnssd_op_t *op) {
+    discovery_inflight_add(&op->worker->inflight, DNSServiceRefSockFD(op->ref), RESOLVE_TIMEOUT,
+                           (discovery_inflight_process_fn) op_process, (discovery_inflight_close_fn) op_close, op);
 }
 
-static bool discovery_stopped(discovery_task_t *task) {
-    SDL_LockMutex(task->lock);
-    bool stop = task->stop;
-    SDL_UnlockMutex(task->lock);
-    return stop;
+static bool op_process(dnssd_op_t *op) {
+    if (DNSServiceProcessResult(op->ref) != kDNSServiceErr_NoError) {
+        return true;
+    }
+    return op->done;
 }
 
-static void discovery_finalize(void *arg, int result) {
-    (void) result;
-    discovery_task_t *task = arg;
-    SDL_LockMutex(task->lock);
-    task->stop = true;
-    SDL_UnlockMutex(task->lock);
-    SDL_WaitThread(task->thread, NULL);
-    SDL_DestroyMutex(task->lock);
-    free(task);
+static void op_close(dnssd_op_t *op, bool timed_out) {
+    if (timed_out) {
+        commons_log_warn("Discovery", "Resolving %s timed out", op->name);
+    }
+    if (op->ref != NULL) {
+        DNSServiceRefDeallocate(op->ref);
+    }
+    free(op->name);
+    free(op);
 }
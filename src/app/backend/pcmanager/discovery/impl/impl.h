@@ -27,6 +27,8 @@ typedef struct discovery_task_t {
     struct discovery_t *discovery;
     SDL_mutex *lock;
     bool stop;
+    /* Set when queries should go back to fast pace, cleared by the worker */
+    bool rescan;
 } discovery_task_t;
 
 int discovery_worker(discovery_task_t *task);
@@ -16,28 +16,49 @@
  *
  */
 #include "impl.h"
+#include "../schedule.h"
 
 #include <microdns/microdns.h>
+#include <SDL2/SDL_timer.h>
 #include "sockaddr.h"
 #include "logging.h"
 
-static void discovery_callback(discovery_task_t *task, int status, const struct rr_entry *entries);
+/* Queries are sent after 1 s, 2 s, 4 s... then once a minute until rescan is requested */
+#define QUERY_INITIAL_INTERVAL 1000
+#define QUERY_STEADY_INTERVAL 60000
+
+typedef struct microdns_worker_t {
+    discovery_task_t *task;
+    discovery_schedule_t schedule;
+} microdns_worker_t;
+
+static void discovery_callback(microdns_worker_t *worker, int status, const struct rr_entry *entries);
 
 static bool discovery_is_stopped(discovery_task_t *task);
 
+static bool listen_should_return(microdns_worker_t *worker);
+
 int discovery_worker(discovery_task_t *task) {
     int r;
     char err[128];
     static const char *const service_name[] = {"_nvstream._tcp.local"};
 
+    microdns_worker_t worker = {.task = task};
+    discovery_schedule_init(&worker.schedule, QUERY_INITIAL_INTERVAL, QUERY_STEADY_INTERVAL, SDL_GetTicks());
     struct mdns_ctx *ctx = NULL;
     if ((r = mdns_init(&ctx, NULL, MDNS_PORT)) < 0) {
         goto err;
     }
     commons_log_info("Discovery", "Start mDNS discovery");
-    if ((r = mdns_listen(ctx, service_name, 1, RR_PTR, 10, (mdns_stop_func) discovery_is_stopped,
-                         (mdns_listen_callback) discovery_callback, task)) < 0) {
-        goto err;
+    // mdns_listen sends the query right away, and then only at its fixed interval. Return from it whenever the next
+    // query is due, and listen again.
+    discovery_schedule_due(&worker.schedule, SDL_GetTicks());
+    while (!discovery_is_stopped(task)) {
+        if ((r = mdns_listen(ctx, service_name, 1, RR_PTR, QUERY_STEADY_INTERVAL / 1000 * 2,
+                             (mdns_stop_func) listen_should_return, (mdns_listen_callback) discovery_callback,
+                             &worker)) < 0) {
+            goto err;
+        }
     }
     err:
     if (r < 0) {
@@ -47,7 +68,8 @@ int discovery_worker(discovery_task_t *task) {
     if (ctx != NULL) {
         mdns_destroy(ctx);
     }
-    commons_log_info("Discovery", "mDNS discovery stopped");
+    commons_log_info("Discovery", "mDNS discovery stopped. Sent %u queries in %u wakeups", worker.schedule.queries,
+                     worker.schedule.wakeups);
     return r;
 }
 
@@ -57,8 +79,9 @@ void discovery_worker_stop(discovery_task_t *task) {
     SDL_UnlockMutex(task->lock);
 }
 
-void discovery_callback(discovery_task_t *task, int status, const struct rr_entry *entries) {
+void discovery_callback(microdns_worker_t *worker, int status, const struct rr_entry *entries) {
     char err[128];
+    discovery_task_t *task = worker->task;
 
     if (status < 0) {
         mdns_strerror(status, err, sizeof(err));
@@ -98,4 +121,24 @@ bool discovery_is_stopped(discovery_task_t *task) {
     bool stop = task->stop;
     SDL_UnlockMutex(task->lock);
     return stop;
+}
+
+/**
+ * Called by mdns_listen after each received packet, or receive timeout.
+ */
+bool listen_should_return(microdns_worker_t *worker) {
+    discovery_task_t *task = worker->task;
+    SDL_LockMutex(task->lock);
+    bool stop = task->stop;
+    bool rescan = task->rescan;
+    task->rescan = false;
+    SDL_UnlockMutex(task->lock);
+    if (stop) {
+        return true;
+    }
+    Uint32 now = SDL_GetTicks();
+    if (rescan) {
+        discovery_schedule_reset(&worker->schedule, now);
+    }
+    return discovery_schedule_due(&worker->schedule, now);
 }
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "inflight.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL_timer.h>
+
+struct discovery_inflight_op_t {
+    int fd;
+    Uint32 deadline;
+    bool has_deadline;
+    bool finished;
+    discovery_inflight_process_fn process;
+    discovery_inflight_close_fn close;
+    void *handle;
+};
+
+void discovery_inflight_init(discovery_inflight_t *inflight) {
+    inflight->ops = NULL;
+    inflight->count = 0;
+    inflight->capacity = 0;
+}
+
+void discovery_inflight_deinit(discovery_inflight_t *inflight) {
+    for (size_t i = 0; i < inflight->count; i++) {
+        discovery_inflight_op_t *op = &inflight->ops[i];
+        op->close(op->handle, false);
+    }
+    free(inflight->ops);
+    discovery_inflight_init(inflight);
+}
+
+void discovery_inflight_add(discovery_inflight_t *inflight, int fd, Uint32 timeout,
+                            discovery_inflight_process_fn process, discovery_inflight_close_fn close, void *handle) {
+    if (inflight->count == inflight->capacity) {
+        inflight->capacity = inflight->capacity == 0 ? 8 : inflight->capacity * 2;
+        inflight->ops = realloc(inflight->ops, inflight->capacity * sizeof(discovery_inflight_op_t));
+    }
+    discovery_inflight_op_t *op = &inflight->ops[inflight->count++];
+    op->fd = fd;
+    op->has_deadline = timeout != 0;
+    op->deadline = SDL_GetTicks() + timeout;
+    op->finished = false;
+    op->process = process;
+    op->close = close;
+    op->handle = handle;
+}
+
+int discovery_inflight_poll(discovery_inflight_t *inflight, int max_wait) {
+    size_t nfds = inflight->count;
+    int ret = 0;
+    struct pollfd *pfds = NULL;
+    if (nfds > 0) {
+        pfds = calloc(nfds, sizeof(struct pollfd));
+    }
+    int timeout = max_wait;
+    Uint32 now = SDL_GetTicks();
+    for (size_t i = 0; i < nfds; i++) {
+        const discovery_inflight_op_t *op = &inflight->ops[i];
+        pfds[i].fd = op->fd;
+        pfds[i].events = POLLIN;
+        if (op->has_deadline) {
+            int remaining = SDL_TICKS_PASSED(now, op->deadline) ? 0 : (int) (op->deadline - now);
+            timeout = SDL_min(timeout, remaining);
+        }
+    }
+    int ready = poll(pfds, nfds, timeout);
+    if (ready < 0 && errno != EINTR) {
+        ret = -1;
+        goto done;
+    }
+    // Process callbacks may add operations, so always index into the array
+    for (size_t i = 0; ready > 0 && i < nfds; i++) {
+        if (pfds[i].revents == 0) {
+            continue;
+        }
+        bool finished = true;
+        if (!(pfds[i].revents & (POLLERR | POLLNVAL))) {
+            finished = inflight->ops[i].process(inflight->ops[i].handle);
+        }
+        inflight->ops[i].finished = finished;
+    }
+
+    now = SDL_GetTicks();
+    size_t kept = 0;
+    for (size_t i = 0; i < inflight->count; i++) {
+        discovery_inflight_op_t op = inflight->ops[i];
+        bool expired = !op.finished && op.has_deadline && SDL_TICKS_PASSED(now, op.deadline);
+        if (op.finished || expired) {
+            op.close(op.handle, expired);
+            continue;
+        }
+        inflight->ops[kept++] = op;
+    }
+    inflight->count = kept;
+    ret = (int) kept;
+
+    done:
+    free(pfds);
+    return ret;
+}
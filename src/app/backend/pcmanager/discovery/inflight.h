@@ -0,0 +1,58 @@
+/**
+ * @file inflight.h
+ *
+ * Set of asynchronous operations waiting for data on their own sockets, driven by a single poll loop.
+ *
+ * Used by discovery backends, so one slow or stale responder doesn't delay others.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <SDL2/SDL_stdinc.h>
+
+/**
+ * Called when the socket of the operation is readable.
+ *
+ * @return true if the operation has finished
+ */
+typedef bool (*discovery_inflight_process_fn)(void *handle);
+
+/**
+ * Called exactly once when the operation is removed from the set.
+ *
+ * @param timed_out true if the operation didn't finish before its deadline
+ */
+typedef void (*discovery_inflight_close_fn)(void *handle, bool timed_out);
+
+typedef struct discovery_inflight_op_t discovery_inflight_op_t;
+
+typedef struct discovery_inflight_t {
+    discovery_inflight_op_t *ops;
+    size_t count, capacity;
+} discovery_inflight_t;
+
+void discovery_inflight_init(discovery_inflight_t *inflight);
+
+/**
+ * Close all pending operations, and release the set.
+ */
+void discovery_inflight_deinit(discovery_inflight_t *inflight);
+
+/**
+ * Add an operation. Can be called from process callbacks, new operations will be polled from next round.
+ *
+ * @param timeout Milliseconds from now until the operation is closed as timed out, 0 for no deadline
+ */
+void discovery_inflight_add(discovery_inflight_t *inflight, int fd, Uint32 timeout,
+                            discovery_inflight_process_fn process, discovery_inflight_close_fn close, void *handle);
+
+/**
+ * Wait until any socket is readable, or the earliest deadline is reached. Process readable operations, and close
+ * finished or expired ones.
+ *
+ * @param max_wait Maximum milliseconds to wait
+ * @return Number of operations still in flight, or -1 if polling failed
+ */
+int discovery_inflight_poll(discovery_inflight_t *inflight, int max_wait);
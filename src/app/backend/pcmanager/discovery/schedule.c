@@ -0,0 +1,35 @@
+#include "schedule.h"
+
+#include <SDL2/SDL_timer.h>
+
+void discovery_schedule_init(discovery_schedule_t *schedule, Uint32 initial_interval, Uint32 steady_interval,
+                             Uint32 now) {
+    schedule->initial_interval = initial_interval;
+    schedule->steady_interval = SDL_max(initial_interval, steady_interval);
+    schedule->wakeups = 0;
+    schedule->queries = 0;
+    discovery_schedule_reset(schedule, now);
+}
+
+bool discovery_schedule_due(discovery_schedule_t *schedule, Uint32 now) {
+    schedule->wakeups++;
+    if (!SDL_TICKS_PASSED(now, schedule->next_query)) {
+        return false;
+    }
+    schedule->queries++;
+    schedule->next_query = now + schedule->interval;
+    schedule->interval = SDL_min(schedule->interval * 2, schedule->steady_interval);
+    return true;
+}
+
+void discovery_schedule_reset(discovery_schedule_t *schedule, Uint32 now) {
+    schedule->interval = schedule->initial_interval;
+    schedule->next_query = now;
+}
+
+Uint32 discovery_schedule_remaining(const discovery_schedule_t *schedule, Uint32 now) {
+    if (SDL_TICKS_PASSED(now, schedule->next_query)) {
+        return 0;
+    }
+    return schedule->next_query - now;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file schedule.h
+ *
+ * Query schedule with exponential backoff. Queries are sent quickly after start (1 s, 2 s, 4 s...), then slow down to
+ * a steady interval, so idle discovery doesn't keep waking up the radio and CPU.
+ *
+ * All functions take the current time in milliseconds, so they can be driven by a mock clock.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include <SDL2/SDL_stdinc.h>
+
+typedef struct discovery_schedule_t {
+    Uint32 initial_interval, steady_interval;
+    Uint32 interval;
+    Uint32 next_query;
+    /* Number of times discovery_schedule_due() is called, and number of queries scheduled */
+    unsigned int wakeups, queries;
+} discovery_schedule_t;
+
+/**
+ * @param initial_interval Interval after the first query, doubled after each one
+ * @param steady_interval Maximum interval
+ * @param now First query will be due immediately
+ */
+void discovery_schedule_init(discovery_schedule_t *schedule, Uint32 initial_interval, Uint32 steady_interval,
+                             Uint32 now);
+
+/**
+ * Call it on each wakeup of the discovery loop.
+ *
+ * @return true if a query should be sent now. The next one is scheduled with increased interval.
+ */
+bool discovery_schedule_due(discovery_schedule_t *schedule, Uint32 now);
+
+/**
+ * Go back to fast queries, e.g. when network has changed or user asked to scan again. Next query will be due
+ * immediately.
+ */
+void discovery_schedule_reset(discovery_schedule_t *schedule, Uint32 now);
+
+/**
+ * @return Milliseconds until next query is due
+ */
+Uint32 discovery_schedule_remaining(const discovery_schedule_t *schedule, Uint32 now);
@@ -17,105 +17,187 @@
  */
 
 #include "throttle.h"
-#include <time.h>
+#include <stdlib.h>
+#include <string.h>
 #include <SDL2/SDL_timer.h>
 
 struct discovery_throttle_host_t {
     sockaddr_t *addr;
-    Uint32 ttl, last_discovered;
-    discovery_throttle_host_t *next;
-    discovery_throttle_host_t *prev;
+    Uint32 hash;
+    Uint32 expires;
+    discovery_throttle_host_t *bucket_next;
+    discovery_throttle_host_t *slot_next;
 };
 
-#define LINKEDLIST_IMPL
-#define LINKEDLIST_MODIFIER static
-#define LINKEDLIST_TYPE discovery_throttle_host_t
-#define LINKEDLIST_PREFIX throttle_hosts
-#define LINKEDLIST_DOUBLE 1
+static void throttle_advance(discovery_throttle_t *throttle, Uint32 now);
 
-#include "linked_list.h"
+static void throttle_sweep_slot(discovery_throttle_t *throttle, size_t slot, Uint32 now);
 
-#undef LINKEDLIST_DOUBLE
-#undef LINKEDLIST_TYPE
-#undef LINKEDLIST_PREFIX
+static discovery_throttle_host_t *throttle_find(const discovery_throttle_t *throttle, const sockaddr_t *addr,
+                                                Uint32 hash);
 
-static int throttle_hosts_compare_time(discovery_throttle_host_t *a, discovery_throttle_host_t *b);
+static void throttle_insert(discovery_throttle_t *throttle, discovery_throttle_host_t *host);
 
-static int throttle_hosts_find_addr(discovery_throttle_host_t *node, const void *addr);
+static void throttle_bucket_remove(discovery_throttle_t *throttle, discovery_throttle_host_t *host);
 
-static int throttle_hosts_find_not_expired(discovery_throttle_host_t *node, const void *now);
+static void throttle_rehash(discovery_throttle_t *throttle, size_t buckets_size);
 
-static void throttle_hosts_evict(discovery_throttle_host_t **head);
+static Uint32 throttle_addr_hash(const sockaddr_t *addr);
 
-static void throttle_host_free(discovery_throttle_host_t *node);
+static void throttle_host_free(discovery_throttle_host_t *host);
 
 void discovery_throttle_init(discovery_throttle_t *throttle, discovery_callback callback, void *user_data) {
     throttle->callback = callback;
     throttle->user_data = user_data;
-    throttle->hosts = NULL;
+    throttle->buckets = NULL;
+    throttle->buckets_size = 0;
+    throttle->count = 0;
+    memset(throttle->wheel, 0, sizeof(throttle->wheel));
+    throttle->wheel_tick = SDL_GetTicks() / DISCOVERY_THROTTLE_TICK_MS;
     throttle->lock = SDL_CreateMutex();
 }
 
 void discovery_throttle_deinit(discovery_throttle_t *throttle) {
     SDL_LockMutex(throttle->lock);
-    throttle_hosts_free(throttle->hosts, throttle_host_free);
+    for (size_t i = 0; i < throttle->buckets_size; i++) {
+        discovery_throttle_host_t *host = throttle->buckets[i];
+        while (host != NULL) {
+            discovery_throttle_host_t *next = host->bucket_next;
+            throttle_host_free(host);
+            host = next;
+        }
+    }
+    free(throttle->buckets);
+    throttle->buckets = NULL;
+    throttle->buckets_size = 0;
+    throttle->count = 0;
+    memset(throttle->wheel, 0, sizeof(throttle->wheel));
     SDL_UnlockMutex(throttle->lock);
     SDL_DestroyMutex(throttle->lock);
 }
 
 void discovery_throttle_on_discovered(discovery_throttle_t *throttle, const sockaddr_t *addr, Uint32 ttl) {
-    // Remove all expired hosts
+    Uint32 hash = throttle_addr_hash(addr);
     SDL_LockMutex(throttle->lock);
-    throttle_hosts_evict(&throttle->hosts);
-
-    // Find existing host
-    discovery_throttle_host_t *find = throttle_hosts_find_by(throttle->hosts, addr, throttle_hosts_find_addr);
+    Uint32 now = SDL_GetTicks();
+    // Remove all expired hosts
+    throttle_advance(throttle, now);
 
-    if (find != NULL) {
+    if (throttle_find(throttle, addr, hash) != NULL) {
         // Ignore existing host
         SDL_UnlockMutex(throttle->lock);
         return;
     }
 
-    discovery_throttle_host_t *node = throttle_hosts_new();
-    node->addr = sockaddr_clone(addr);
-    node->ttl = ttl;
-    node->last_discovered = SDL_GetTicks();
-    throttle->hosts = throttle_hosts_sortedinsert(throttle->hosts, node, throttle_hosts_compare_time);
+    discovery_throttle_host_t *host = calloc(1, sizeof(discovery_throttle_host_t));
+    host->addr = sockaddr_clone(addr);
+    host->hash = hash;
+    host->expires = now + ttl;
+    throttle_insert(throttle, host);
 
-    if (throttle->callback != NULL) {
-        throttle->callback(node->addr, throttle->user_data);
-    }
+    // Host may expire as soon as the lock is released, so hand over a copy
+    sockaddr_t *discovered = throttle->callback != NULL ? sockaddr_clone(addr) : NULL;
     SDL_UnlockMutex(throttle->lock);
+
+    if (discovered != NULL) {
+        throttle->callback(discovered, throttle->user_data);
+        sockaddr_free(discovered);
+    }
 }
 
-int throttle_hosts_compare_time(discovery_throttle_host_t *a, discovery_throttle_host_t *b) {
-    return (int) a->last_discovered - (int) b->last_discovered;
+static void throttle_advance(discovery_throttle_t *throttle, Uint32 now) {
+    Uint32 tick = now / DISCOVERY_THROTTLE_TICK_MS;
+    // Slot of current tick is visited again next time, as hosts in it may not have expired yet
+    Uint32 passed = SDL_min(tick - throttle->wheel_tick, DISCOVERY_THROTTLE_WHEEL_SLOTS - 1);
+    for (Uint32 i = 0; i <= passed; i++) {
+        throttle_sweep_slot(throttle, (tick - i) % DISCOVERY_THROTTLE_WHEEL_SLOTS, now);
+    }
+    throttle->wheel_tick = tick;
 }
 
-static int throttle_hosts_find_addr(discovery_throttle_host_t *node, const void *addr) {
-    return sockaddr_compare(node->addr, addr);
+static void throttle_sweep_slot(discovery_throttle_t *throttle, size_t slot, Uint32 now) {
+    discovery_throttle_host_t **cur = &throttle->wheel[slot];
+    while (*cur != NULL) {
+        discovery_throttle_host_t *host = *cur;
+        // Hosts living longer than a full turn of the wheel stay until a later visit
+        if (!SDL_TICKS_PASSED(now, host->expires)) {
+            cur = &host->slot_next;
+            continue;
+        }
+        *cur = host->slot_next;
+        throttle_bucket_remove(throttle, host);
+        throttle_host_free(host);
+    }
 }
 
-void throttle_hosts_evict(discovery_throttle_host_t **head) {
-    Uint32 now = SDL_GetTicks();
-    discovery_throttle_host_t *find = throttle_hosts_find_by(*head, &now, throttle_hosts_find_not_expired);
-    if (find != NULL) {
-        if (find->prev != NULL) {
-            find->prev->next = NULL;
+static discovery_throttle_host_t *throttle_find(const discovery_throttle_t *throttle, const sockaddr_t *addr,
+                                                Uint32 hash) {
+    if (throttle->buckets_size == 0) {
+        return NULL;
+    }
+    discovery_throttle_host_t *host = throttle->buckets[hash & (throttle->buckets_size - 1)];
+    for (; host != NULL; host = host->bucket_next) {
+        if (host->hash == hash && sockaddr_compare(host->addr, addr) == 0) {
+            return host;
         }
-        find->prev = NULL;
-        return;
     }
-    throttle_hosts_free(*head, NULL);
-    *head = find;
+    return NULL;
 }
 
-int throttle_hosts_find_not_expired(discovery_throttle_host_t *node, const void *now) {
-    return SDL_TICKS_PASSED(*(Uint32 *) now, node->last_discovered + node->ttl);
+static void throttle_insert(discovery_throttle_t *throttle, discovery_throttle_host_t *host) {
+    if ((throttle->count + 1) * 4 > throttle->buckets_size * 3) {
+        throttle_rehash(throttle, throttle->buckets_size == 0 ? 16 : throttle->buckets_size * 2);
+    }
+    size_t bucket = host->hash & (throttle->buckets_size - 1);
+    host->bucket_next = throttle->buckets[bucket];
+    throttle->buckets[bucket] = host;
+    size_t slot = (host->expires / DISCOVERY_THROTTLE_TICK_MS) % DISCOVERY_THROTTLE_WHEEL_SLOTS;
+    host->slot_next = throttle->wheel[slot];
+    throttle->wheel[slot] = host;
+    throttle->count++;
+}
+
+static void throttle_bucket_remove(discovery_throttle_t *throttle, discovery_throttle_host_t *host) {
+    discovery_throttle_host_t **cur = &throttle->buckets[host->hash & (throttle->buckets_size - 1)];
+    while (*cur != host) {
+        cur = &(*cur)->bucket_next;
+    }
+    *cur = host->bucket_next;
+    throttle->count--;
+}
+
+static void throttle_rehash(discovery_throttle_t *throttle, size_t buckets_size) {
+    discovery_throttle_host_t **buckets = calloc(buckets_size, sizeof(discovery_throttle_host_t *));
+    for (size_t i = 0; i < throttle->buckets_size; i++) {
+        discovery_throttle_host_t *host = throttle->buckets[i];
+        while (host != NULL) {
+            discovery_throttle_host_t *next = host->bucket_next;
+            size_t bucket = host->hash & (buckets_size - 1);
+            host->bucket_next = buckets[bucket];
+            buckets[bucket] = host;
+            host = next;
+        }
+    }
+    free(throttle->buckets);
+    throttle->buckets = buckets;
+    throttle->buckets_size = buckets_size;
+}
+
+static Uint32 throttle_addr_hash(const sockaddr_t *addr) {
+    char ip[64];
+    sockaddr_get_ip_str(addr, ip, sizeof(ip));
+    // FNV-1a
+    Uint32 hash = 2166136261u;
+    for (const char *c = ip; *c != '\0'; c++) {
+        hash = (hash ^ (unsigned char) *c) * 16777619u;
+    }
+    Uint16 port = sockaddr_get_port(addr);
+    hash = (hash ^ (port & 0xFF)) * 16777619u;
+    hash = (hash ^ (port >> 8)) * 16777619u;
+    return hash;
 }
 
-void throttle_host_free(discovery_throttle_host_t *node) {
-    sockaddr_free(node->addr);
-    free(node);
+static void throttle_host_free(discovery_throttle_host_t *host) {
+    sockaddr_free(host->addr);
+    free(host);
 }
@@ -57,11 +57,13 @@ void lan_host_status_update(pcmanager_t *manager, SERVER_DATA *server) {
 }
 
 void lan_host_offline(pcmanager_t *manager, const sockaddr_t *addr) {
-    pclist_t *existing = pclist_find_by_addr(manager, addr);
-    if (!existing) {
-        return;
+    char ip[64];
+    sockaddr_get_ip_str(addr, ip, sizeof(ip));
+    const pclist_snapshot_t *servers = pcmanager_servers_acquire(manager);
+    const pclist_t *existing = pcregistry_find_by_address(servers, ip);
+    if (existing != NULL) {
+        SERVER_STATE state = {.code = SERVER_STATE_OFFLINE};
+        pclist_upsert(manager, &existing->id, &state, NULL);
     }
-    pcmanager_lock(manager);
-    existing->state.code = SERVER_STATE_OFFLINE;
-    pcmanager_unlock(manager);
+    pcmanager_servers_release(servers);
 }
\ No newline at end of file
@@ -1,12 +1,14 @@
 #include "known_hosts.h"
 #include "priv.h"
 #include "pclist.h"
+#include "server_snapshot.h"
 #include "app.h"
 
 #include <ini.h>
 
 #include "ini_writer.h"
 #include "util/ini_ext.h"
+#include "util/nullable.h"
 #include "util/path.h"
 #include "app_settings.h"
 
@@ -27,12 +29,16 @@ static int known_hosts_handle(known_host_t **list, const char *section, const ch
 
 static int known_hosts_find_uuid(known_host_t *node, void *v);
 
-void pcmanager_load_known_hosts(pcmanager_t *manager) {
+void pcmanager_load_known_hosts(pcmanager_t *manager, pcmanager_known_hosts_t *loaded) {
     commons_log_info("PCManager", "Load unknown hosts");
     char *conf_file = path_join(manager->app->settings.conf_dir, CONF_NAME_HOSTS);
     known_host_t *hosts = known_hosts_parse(conf_file);
+    loaded->nodes = calloc(known_hosts_len(hosts), sizeof(pclist_t *));
+    loaded->count = 0;
 
     bool selected_set = false;
+    int restored = 0;
+    Uint32 load_start = SDL_GetTicks();
     for (known_host_t *cur = hosts; cur; cur = cur->next) {
         const char *mac = cur->mac, *hostname = cur->hostname;
         const hostport_t *address = cur->address;
@@ -44,14 +50,33 @@ void pcmanager_load_known_hosts(pcmanager_t *manager) {
             continue;
         }
 
-        PSERVER_DATA server = serverdata_new();
-        server->uuid = uuidstr_tostr(&cur->uuid);
+        char *uuid = uuidstr_tostr(&cur->uuid);
+        uint32_t snapshot_hash = 0;
+        PSERVER_DATA server = server_snapshot_load(manager->app->settings.conf_dir, uuid, &snapshot_hash);
+        bool from_snapshot = server != NULL;
+        if (from_snapshot) {
+            // Identity of the host comes from hosts.ini, which is the one edited by user
+            free_nullable((void *) server->uuid);
+            free_nullable((void *) server->mac);
+            free_nullable((void *) server->hostname);
+            free_nullable((void *) server->serverInfo.address);
+        } else {
+            server = serverdata_new();
+        }
+        server->uuid = uuid;
         server->mac = mac;
         server->hostname = hostname;
         server->serverInfo.address = strdup(hostport_get_hostname(address));
         server->extPort = hostport_get_port(address);
 
-        pclist_t *node = pclist_insert_known(manager, &cur->uuid, server);
+        pclist_t *node = pclist_node_new_known(&cur->uuid, server);
+        if (from_snapshot) {
+            // Last known server data is shown, but whether the host is there is unknown until it responds
+            node->state.code = SERVER_STATE_QUERYING;
+            node->stale = true;
+            server_snapshot_queue_set_saved(&manager->snapshots, uuid, snapshot_hash);
+            restored++;
+        }
 
         node->favs = cur->favs;
         cur->favs = NULL;
@@ -63,9 +88,20 @@ void pcmanager_load_known_hosts(pcmanager_t *manager) {
             node->selected = true;
             selected_set = true;
         }
+        loaded->nodes[loaded->count++] = node;
     }
     known_hosts_free(hosts, known_hosts_node_free);
     free(conf_file);
+    commons_log_info("PCManager", "%d hosts restored from snapshot in %u ms", restored, SDL_GetTicks() - load_start);
+}
+
+void pcmanager_add_known_hosts(pcmanager_t *manager, pcmanager_known_hosts_t *hosts) {
+    for (size_t i = 0; i < hosts->count; i++) {
+        pclist_insert_known(manager, hosts->nodes[i]);
+    }
+    free(hosts->nodes);
+    hosts->nodes = NULL;
+    hosts->count = 0;
 }
 
 void pcmanager_save_known_hosts(pcmanager_t *manager) {
@@ -75,7 +111,9 @@ void pcmanager_save_known_hosts(pcmanager_t *manager) {
     if (!fp) { return; }
 
     bool selected_set = false;
-    for (pclist_t *cur = manager->servers; cur != NULL; cur = cur->next) {
+    const pclist_snapshot_t *servers = pcregistry_peek(&manager->registry);
+    for (size_t i = 0; i < servers->count; i++) {
+        const pclist_t *cur = servers->nodes[i];
         if (!cur->server || !cur->known) {
             continue;
         }
@@ -25,28 +25,25 @@ typedef struct pcmanager_listener_list {
 
 static int pcmanager_callbacks_comparator(pcmanager_listener_list *p1, const void *p2);
 
-void pcmanager_listeners_notify(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_notify_type_t type) {
+void pcmanager_listeners_notify(pcmanager_t *manager, const pcmanager_changes_t *changes) {
     assert(manager != NULL);
     assert(SDL_ThreadID() == manager->thread_id);
     for (pcmanager_listener_list *cur = manager->listeners; cur != NULL;) {
         pcmanager_listener_list *next = cur->next;
         const pcmanager_listener_t *l = cur->listener;
-        pcmanager_listener_fn fn = NULL;
-        switch (type) {
-            case PCMANAGER_NOTIFY_ADDED:
-                fn = l->added;
-                break;
-            case PCMANAGER_NOTIFY_UPDATED:
-                fn = l->updated;
-                break;
-            case PCMANAGER_NOTIFY_REMOVED:
-                fn = l->removed;
-                break;
-            default:
-                break;
+        if (l->changed) {
+            l->changed(changes, cur->userdata);
+            cur = next;
+            continue;
         }
-        if (fn) {
-            fn(uuid, cur->userdata);
+        for (size_t i = 0; l->removed && i < changes->num_removed; i++) {
+            l->removed(&changes->removed[i], cur->userdata);
+        }
+        for (size_t i = 0; l->added && i < changes->num_added; i++) {
+            l->added(&changes->added[i], cur->userdata);
+        }
+        for (size_t i = 0; l->updated && i < changes->num_updated; i++) {
+            l->updated(&changes->updated[i], cur->userdata);
         }
         cur = next;
     }
@@ -2,4 +2,4 @@
 
 #include "../pcmanager.h"
 
-void pcmanager_listeners_notify(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_notify_type_t type);
\ No newline at end of file
+void pcmanager_listeners_notify(pcmanager_t *manager, const pcmanager_changes_t *changes);
\ No newline at end of file
@@ -2,21 +2,13 @@
 #include "priv.h"
 
 #include <assert.h>
+#include <string.h>
 #include <util/bus.h>
 
 #include "listeners.h"
-
-#define LINKEDLIST_IMPL
-#define LINKEDLIST_MODIFIER static
-#define LINKEDLIST_TYPE pclist_t
-#define LINKEDLIST_PREFIX pclist_ll
-#define LINKEDLIST_DOUBLE 1
-
-#include "linked_list.h"
-
-#undef LINKEDLIST_DOUBLE
-#undef LINKEDLIST_TYPE
-#undef LINKEDLIST_PREFIX
+#include "server_snapshot.h"
+#include "app.h"
+#include "logging.h"
 
 #define LINKEDLIST_IMPL
 #define LINKEDLIST_MODIFIER static
@@ -31,67 +23,62 @@
 #undef LINKEDLIST_TYPE
 #undef LINKEDLIST_PREFIX
 
-static void upsert_perform(pclist_update_context_t *context);
+static void updates_enqueue(pcmanager_t *manager, const uuidstr_t *uuid, bool remove, const SERVER_STATE *state,
+                            SERVER_DATA *server);
 
-static void remove_perform(pclist_update_context_t *context);
+static void updates_flush(pcmanager_t *manager);
 
-static void pclist_ll_nodefree(pclist_t *node);
+static void updates_apply(pcmanager_t *manager, pclist_update_t *items, size_t count);
 
-static int pclist_ll_compare_ip(pclist_t *other, const void *v);
+static void pclist_nodefree(pclist_t *node);
 
-static int pclist_ll_compare_address(pclist_t *other, const void *v);
-
-static int pclist_ll_compare_uuid(pclist_t *other, const void *v);
+static appid_list_t *appid_list_clone(const appid_list_t *list);
 
 static int appid_list_find_id(appid_list_t *other, const void *v);
 
-pclist_t *pclist_insert_known(pcmanager_t *manager, const uuidstr_t *id, SERVER_DATA *server) {
-    pclist_t *node = pclist_ll_new();
+pclist_t *pclist_node_new_known(const uuidstr_t *id, SERVER_DATA *server) {
+    pclist_t *node = calloc(1, sizeof(pclist_t));
     node->id = *id;
     node->state.code = SERVER_STATE_NONE;
     node->server = server;
     node->known = true;
-    manager->servers = pclist_ll_append(manager->servers, node);
     return node;
 }
 
+void pclist_insert_known(pcmanager_t *manager, pclist_t *node) {
+    pcregistry_add(&manager->registry, node);
+}
+
+void pclist_init(pcmanager_t *manager) {
+    pcregistry_init(&manager->registry);
+    manager->updates.lock = SDL_CreateMutex();
+    server_snapshot_queue_init(&manager->snapshots, manager->executor, manager->app->settings.conf_dir);
+}
+
 void pclist_upsert(pcmanager_t *manager, const uuidstr_t *uuid, const SERVER_STATE *state, SERVER_DATA *server) {
     assert(manager);
     assert(uuid);
-    pclist_update_context_t args = {
-            .manager = manager,
-            .uuid = *uuid,
-            .server = server,
-            .state = *state
-    };
-    if (SDL_ThreadID() == manager->thread_id) {
-        upsert_perform(&args);
-    } else {
-        app_bus_post_sync(manager->app, (bus_actionfunc) upsert_perform, &args);
-    }
+    updates_enqueue(manager, uuid, false, state, server);
 }
 
-/**
- * Thread safe.
- * @param manager
- * @param uuid
- */
 void pclist_remove(pcmanager_t *manager, const uuidstr_t *uuid) {
     assert(manager);
     assert(uuid);
-    pclist_update_context_t context = {
-            .uuid = *uuid,
-            .manager = manager,
-    };
-    if (SDL_ThreadID() == manager->thread_id) {
-        remove_perform(&context);
-    } else {
-        app_bus_post_sync(manager->app, (bus_actionfunc) remove_perform, &context);
-    }
+    updates_enqueue(manager, uuid, true, NULL, NULL);
 }
 
 void pclist_free(pcmanager_t *manager) {
-    pclist_ll_free(manager->servers, pclist_ll_nodefree);
+    // Changes posted after the bus stopped are dropped
+    pclist_update_queue_t *updates = &manager->updates;
+    for (size_t i = 0; i < updates->count; i++) {
+        if (updates->items[i].server != NULL) {
+            serverdata_free(updates->items[i].server);
+        }
+    }
+    free(updates->items);
+    SDL_DestroyMutex(updates->lock);
+    server_snapshot_queue_deinit(&manager->snapshots);
+    pcregistry_deinit(&manager->registry, (pcregistry_free_fn) pclist_nodefree);
 }
 
 
@@ -129,23 +116,45 @@ bool pclist_node_set_app_hidden(pclist_t *node, int appid, bool hidden) {
     return true;
 }
 
-void pclist_node_apply(pclist_t *node, const SERVER_STATE *state, SERVER_DATA *server) {
+void pclist_node_apply(pcmanager_t *manager, pclist_t *node, const SERVER_STATE *state, SERVER_DATA *server) {
     if (state != NULL && state->code != SERVER_STATE_NONE) {
         node->state = *state;
+        node->stale = false;
     }
     if (server != NULL) {
         if (node->server != server) {
-            if (node->server) {
-                serverdata_free(node->server);
-            }
             uuidstr_fromstr(&node->id, server->uuid);
+            // Older snapshots still have the original node, which shares this server
+            pcregistry_retire(&manager->registry, node->server, (pcregistry_free_fn) serverdata_free);
             node->server = server;
         }
         node->known |= server->paired;
     }
 }
 
-void pclist_ll_nodefree(pclist_t *node) {
+pclist_t *pclist_node_clone(const pclist_t *node) {
+    pclist_t *clone = malloc(sizeof(pclist_t));
+    *clone = *node;
+    clone->favs = appid_list_clone(node->favs);
+    clone->hidden = appid_list_clone(node->hidden);
+    return clone;
+}
+
+void pclist_node_replace(pcmanager_t *manager, pclist_t *node, pclist_t *clone) {
+    pcregistry_replace(&manager->registry, &node, &clone, 1, (pcregistry_free_fn) pclist_node_discard);
+}
+
+void pclist_node_discard(pclist_t *clone) {
+    if (clone->favs) {
+        appid_list_ll_free(clone->favs, (appid_list_ll_nodefree_fn) free);
+    }
+    if (clone->hidden) {
+        appid_list_ll_free(clone->hidden, (appid_list_ll_nodefree_fn) free);
+    }
+    free(clone);
+}
+
+static void pclist_nodefree(pclist_t *node) {
     if (node->server) {
         serverdata_free((PSERVER_DATA) node->server);
     }
@@ -159,79 +168,169 @@ void pclist_ll_nodefree(pclist_t *node) {
 }
 
 
-pclist_t *pclist_find_by_ip(pcmanager_t *manager, const char *ip) {
-    SDL_assert_release(ip != NULL);
-    pcmanager_lock(manager);
-    pclist_t *result = pclist_ll_find_by(manager->servers, ip, pclist_ll_compare_ip);
-    pcmanager_unlock(manager);
-    return result;
-}
-
-pclist_t *pclist_find_by_addr(pcmanager_t *manager, const sockaddr_t *addr) {
-    SDL_assert_release(addr != NULL);
-    pcmanager_lock(manager);
-    pclist_t *result = pclist_ll_find_by(manager->servers, addr, pclist_ll_compare_address);
-    pcmanager_unlock(manager);
-    return result;
-}
-
 pclist_t *pclist_find_by_uuid(pcmanager_t *manager, const uuidstr_t *uuid) {
     SDL_assert_release(uuid != NULL);
-    pcmanager_lock(manager);
-    pclist_t *result = pclist_ll_find_by(manager->servers, uuid, pclist_ll_compare_uuid);
-    pcmanager_unlock(manager);
-    return result;
+    // Snapshots are only replaced on main thread, so the latest one can be used without reference
+    return pcregistry_find_by_uuid(pcregistry_peek(&manager->registry), uuid);
 }
 
-static int pclist_ll_compare_ip(pclist_t *other, const void *v) {
-    SDL_assert_release(v);
-    SDL_assert_release(other);
-    SDL_assert_release(other->server);
-    SDL_assert_release(other->server->serverInfo.address);
-    return SDL_strcmp(other->server->serverInfo.address, (const char *) v);
+static int appid_list_find_id(appid_list_t *other, const void *v) {
+    return other->id - *((const int *) v);
 }
 
-static int pclist_ll_compare_address(pclist_t *other, const void *v) {
-    SDL_assert_release(v);
-    SDL_assert_release(other);
-    SDL_assert_release(other->server);
-    SDL_assert_release(other->server->serverInfo.address);
-    const sockaddr_t *addr = (const sockaddr_t *) v;
-    return 0;
+static appid_list_t *appid_list_clone(const appid_list_t *list) {
+    appid_list_t *clone = NULL;
+    for (const appid_list_t *cur = list; cur != NULL; cur = cur->next) {
+        appid_list_t *item = appid_list_ll_new();
+        item->id = cur->id;
+        clone = appid_list_ll_append(clone, item);
+    }
+    return clone;
 }
 
-static int pclist_ll_compare_uuid(pclist_t *other, const void *v) {
-    SDL_assert_release(v);
-    SDL_assert_release(other);
-    SDL_assert_release(other->server);
-    return !uuidstr_t_equals_t(&other->id, (const uuidstr_t *) v);
-}
+static void updates_enqueue(pcmanager_t *manager, const uuidstr_t *uuid, bool remove, const SERVER_STATE *state,
+                            SERVER_DATA *server) {
+    pclist_update_queue_t *updates = &manager->updates;
+    SDL_LockMutex(updates->lock);
+    pclist_update_t *item = NULL;
+    for (size_t i = 0; i < updates->count; i++) {
+        if (uuidstr_t_equals_t(&updates->items[i].uuid, uuid)) {
+            item = &updates->items[i];
+            updates->merged++;
+            break;
+        }
+    }
+    if (item == NULL) {
+        if (updates->count == updates->capacity) {
+            updates->capacity = updates->capacity > 0 ? updates->capacity * 2 : 8;
+            updates->items = realloc(updates->items, updates->capacity * sizeof(pclist_update_t));
+        }
+        item = &updates->items[updates->count++];
+        memset(item, 0, sizeof(pclist_update_t));
+        item->uuid = *uuid;
+    }
+    if (remove) {
+        // Anything queued before is discarded with the host
+        item->remove = true;
+        item->state.code = SERVER_STATE_NONE;
+        if (item->server != NULL) {
+            serverdata_free(item->server);
+            item->server = NULL;
+        }
+    } else {
+        if (state != NULL && state->code != SERVER_STATE_NONE) {
+            item->state = *state;
+        }
+        if (server != NULL && server != item->server) {
+            if (item->server != NULL) {
+                serverdata_free(item->server);
+            }
+            item->server = server;
+        }
+    }
+    bool post = !updates->flush_posted;
+    updates->flush_posted = true;
+    SDL_UnlockMutex(updates->lock);
 
-static int appid_list_find_id(appid_list_t *other, const void *v) {
-    return other->id - *((const int *) v);
+    if (SDL_ThreadID() == manager->thread_id) {
+        // Applied right away, along with changes queued before this one
+        updates_flush(manager);
+    } else if (post && !app_bus_post(manager->app, (bus_actionfunc) updates_flush, manager)) {
+        SDL_LockMutex(updates->lock);
+        updates->flush_posted = false;
+        SDL_UnlockMutex(updates->lock);
+    }
 }
 
-static void upsert_perform(pclist_update_context_t *context) {
-    pcmanager_t *manager = context->manager;
-    pcmanager_lock(manager);
-    pclist_t *node = pclist_ll_find_by(manager->servers, &context->uuid, pclist_ll_compare_uuid);
-    bool updated = node != NULL;
-    if (!node) {
-        node = pclist_ll_new();
-        manager->servers = pclist_ll_append(manager->servers, node);
+static void updates_flush(pcmanager_t *manager) {
+    pclist_update_queue_t *updates = &manager->updates;
+    SDL_LockMutex(updates->lock);
+    pclist_update_t *items = updates->items;
+    size_t count = updates->count;
+    int merged = updates->merged;
+    updates->items = NULL;
+    updates->count = 0;
+    updates->capacity = 0;
+    updates->merged = 0;
+    updates->flush_posted = false;
+    SDL_UnlockMutex(updates->lock);
+    if (count == 0) {
+        return;
     }
-    pclist_node_apply(node, &context->state, context->server);
-    pcmanager_unlock(manager);
-    pcmanager_listeners_notify(manager, &context->uuid, updated ? PCMANAGER_NOTIFY_UPDATED : PCMANAGER_NOTIFY_ADDED);
+    Uint32 start = SDL_GetTicks();
+    updates_apply(manager, items, count);
+    free(items);
+    commons_log_debug("PCManager", "Applied %d host changes (%d merged) in %u ms", (int) count, merged,
+                      SDL_GetTicks() - start);
 }
 
-static void remove_perform(pclist_update_context_t *context) {
-    pcmanager_t *manager = context->manager;
+static void updates_apply(pcmanager_t *manager, pclist_update_t *items, size_t count) {
+    uuidstr_t *removed = calloc(count * 3, sizeof(uuidstr_t)), *added = removed + count, *updated = added + count;
+    pcmanager_changes_t changes = {.removed = removed, .added = added, .updated = updated};
+    pclist_t **changed_nodes = calloc(count, sizeof(pclist_t *));
+    pclist_t **replaced_nodes = calloc(count, sizeof(pclist_t *)), **replacements = calloc(count, sizeof(pclist_t *));
+    size_t replaced = 0;
+    bool *was_stale = calloc(count, sizeof(bool));
+
     pcmanager_lock(manager);
-    pclist_t *node = pclist_ll_find_by(manager->servers, &context->uuid, pclist_ll_compare_uuid);
-    if (!node) { return; }
-    manager->servers = pclist_ll_remove(manager->servers, node);
+    for (size_t i = 0; i < count; i++) {
+        pclist_update_t *item = &items[i];
+        pclist_t *node = pclist_find_by_uuid(manager, &item->uuid);
+        if (item->remove && node != NULL) {
+            if (node->server != NULL && node->server->uuid != NULL) {
+                server_snapshot_queue_remove(&manager->snapshots, node->server->uuid);
+            }
+            // Node will be freed once snapshots containing it are released
+            pcregistry_remove(&manager->registry, node, (pcregistry_free_fn) pclist_nodefree);
+            removed[changes.num_removed++] = item->uuid;
+            node = NULL;
+        }
+        if (item->state.code == SERVER_STATE_NONE && item->server == NULL) {
+            continue;
+        }
+        // Published nodes are never modified, changes are made to a new node or a copy
+        pclist_t *changed;
+        if (node == NULL) {
+            changed = calloc(1, sizeof(pclist_t));
+            changed->id = item->uuid;
+        } else {
+            was_stale[i] = node->stale;
+            changed = pclist_node_clone(node);
+        }
+        pclist_node_apply(manager, changed, &item->state, item->server);
+        if (item->server != NULL && changed->known) {
+            // Only encoded here, the file is written on the executor
+            server_snapshot_queue_save(&manager->snapshots, changed->server);
+        }
+        if (node == NULL) {
+            pcregistry_add(&manager->registry, changed);
+            added[changes.num_added++] = item->uuid;
+        } else {
+            replaced_nodes[replaced] = node;
+            replacements[replaced++] = changed;
+            updated[changes.num_updated++] = item->uuid;
+        }
+        changed_nodes[i] = changed;
+    }
+    if (replaced > 0) {
+        // One snapshot for all updated hosts
+        pcregistry_replace(&manager->registry, replaced_nodes, replacements, replaced,
+                           (pcregistry_free_fn) pclist_node_discard);
+    }
     pcmanager_unlock(manager);
-    pcmanager_listeners_notify(manager, &context->uuid, PCMANAGER_NOTIFY_REMOVED);
-    pclist_ll_nodefree(node);
-}
\ No newline at end of file
+
+    // Nodes are only replaced on this thread, so it's fine to read them without lock
+    for (size_t i = 0; i < count; i++) {
+        const pclist_t *node = changed_nodes[i];
+        if (node != NULL && was_stale[i] && !node->stale) {
+            commons_log_info("PCManager", "Host %s revalidated at %u ms, state 0x%02x", (const char *) &node->id,
+                             SDL_GetTicks(), node->state.code);
+        }
+    }
+    pcmanager_listeners_notify(manager, &changes);
+    free(was_stale);
+    free(replacements);
+    free(replaced_nodes);
+    free(changed_nodes);
+    free(removed);
+}
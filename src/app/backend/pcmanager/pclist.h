@@ -1,33 +1,69 @@
 /**
  * @file pclist.h
  *
- * Thread safe list management
+ * Host list management. Hosts are modified on main thread, and published to other threads as snapshots
  */
 #pragma once
 
 #include "../pcmanager.h"
 
-pclist_t *pclist_insert_known(pcmanager_t *manager, const uuidstr_t *uuid, SERVER_DATA *server);
+void pclist_init(pcmanager_t *manager);
 
 /**
- * Update item in server list if exists. Otherwise insert.
- * @param manager
- * @param server
+ * New known host, not in the list yet. Fill it before pclist_insert_known(), as published nodes can't be changed.
+ *
+ * @param server Ownership is taken
+ */
+pclist_t *pclist_node_new_known(const uuidstr_t *uuid, SERVER_DATA *server);
+
+/**
+ * Main thread only.
+ */
+void pclist_insert_known(pcmanager_t *manager, pclist_t *node);
+
+/**
+ * Update item in server list if exists. Otherwise insert. Thread safe, and never blocks on main thread.
+ *
+ * Changes from other threads are queued and applied on main thread in one batch, and changes to the same host are
+ * merged. Changes from main thread are applied immediately.
+ *
+ * @param server Ownership is taken
  */
 void pclist_upsert(pcmanager_t *manager, const uuidstr_t *uuid, const SERVER_STATE *state, SERVER_DATA *server);
 
-void pclist_node_apply(pclist_t *node, const SERVER_STATE *state, SERVER_DATA *server);
+/**
+ * Main thread only, on a node not published yet. Replaced server data is freed when snapshots still referencing it
+ * are released.
+ */
+void pclist_node_apply(pcmanager_t *manager, pclist_t *node, const SERVER_STATE *state, SERVER_DATA *server);
+
+/**
+ * Copy of the node to be changed and then passed to pclist_node_replace(). Server data is shared with the original.
+ */
+pclist_t *pclist_node_clone(const pclist_t *node);
+
+/**
+ * Main thread only. Publish the changed copy in place of the node, which is freed once no snapshot holds it.
+ */
+void pclist_node_replace(pcmanager_t *manager, pclist_t *node, pclist_t *clone);
+
+/**
+ * Free a copy that wasn't published, leaving shared server data alone.
+ */
+void pclist_node_discard(pclist_t *clone);
 
 bool pclist_node_set_app_favorite(pclist_t *node, int appid, bool favorite);
 
 bool pclist_node_set_app_hidden(pclist_t *node, int appid, bool hidden);
 
+/**
+ * Thread safe. Queued like pclist_upsert().
+ */
 void pclist_remove(pcmanager_t *manager, const uuidstr_t *uuid);
 
 void pclist_free(pcmanager_t *manager);
 
+/**
+ * Main thread only. Other threads should look up in a snapshot from pcmanager_servers_acquire().
+ */
 pclist_t *pclist_find_by_uuid(pcmanager_t *manager, const uuidstr_t *uuid);
-
-pclist_t *pclist_find_by_ip(pcmanager_t *manager, const char *ip);
-
-pclist_t *pclist_find_by_addr(pcmanager_t *manager, const sockaddr_t *addr);
@@ -13,8 +13,8 @@ pcmanager_t *pcmanager_new(app_t *app, executor_t *executor) {
     manager->executor = executor;
     manager->thread_id = SDL_ThreadID();
     manager->lock = SDL_CreateMutex();
+    pclist_init(manager);
     discovery_init(&manager->discovery, (discovery_callback) pcmanager_lan_host_discovered, manager);
-    pcmanager_load_known_hosts(manager);
     return manager;
 }
 
@@ -36,6 +36,14 @@ void pcmanager_auto_discovery_stop(pcmanager_t *manager) {
     discovery_stop(&manager->discovery);
 }
 
+bool pcmanager_auto_discovery_running(pcmanager_t *manager) {
+    return discovery_running(&manager->discovery);
+}
+
+void pcmanager_auto_discovery_rescan(pcmanager_t *manager) {
+    discovery_rescan(&manager->discovery);
+}
+
 void pcmanager_lock(pcmanager_t *manager) {
     SDL_LockMutex(manager->lock);
 }
@@ -53,6 +61,17 @@ bool pcmanager_quitapp(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_ca
     return true;
 }
 
+void pcmanager_session_finished(pcmanager_t *manager, const uuidstr_t *uuid, bool quitapp, SDL_sem *done) {
+    worker_context_t *ctx = worker_context_new(manager, uuid, NULL, NULL);
+    ctx->done = done;
+    ctx->session_generation = SDL_AtomicGet(&manager->session_generation);
+    pcmanager_worker_queue(manager, quitapp ? worker_quit_app_and_update : worker_session_update, ctx);
+}
+
+void pcmanager_session_starting(pcmanager_t *manager) {
+    SDL_AtomicIncRef(&manager->session_generation);
+}
+
 void pcmanager_request_update(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_callback_t callback,
                               void *userdata) {
     commons_log_info("PcManager", "Requesting update for %s", (const char *) uuid);
@@ -66,7 +85,12 @@ void pcmanager_favorite_app(pcmanager_t *manager, const uuidstr_t *uuid, int app
     if (!node) {
         goto unlock;
     }
-    pclist_node_set_app_favorite(node, appid, favorite);
+    pclist_t *clone = pclist_node_clone(node);
+    if (pclist_node_set_app_favorite(clone, appid, favorite)) {
+        pclist_node_replace(manager, node, clone);
+    } else {
+        pclist_node_discard(clone);
+    }
     unlock:
     pcmanager_unlock(manager);
 }
@@ -77,7 +101,12 @@ void pcmanager_set_app_hidden(pcmanager_t *manager, const uuidstr_t *uuid, int a
     if (!node) {
         goto unlock;
     }
-    pclist_node_set_app_hidden(node, appid, hidden);
+    pclist_t *clone = pclist_node_clone(node);
+    if (pclist_node_set_app_hidden(clone, appid, hidden)) {
+        pclist_node_replace(manager, node, clone);
+    } else {
+        pclist_node_discard(clone);
+    }
     unlock:
     pcmanager_unlock(manager);
 }
@@ -89,9 +118,24 @@ bool pcmanager_select(pcmanager_t *manager, const uuidstr_t *uuid) {
         pcmanager_unlock(manager);
         return false;
     }
-    for (pclist_t *cur = pcmanager->servers; cur; cur = cur->next) {
-        cur->selected = node == cur;
+    const pclist_snapshot_t *servers = pcmanager_servers(manager);
+    pclist_t **changed = malloc(servers->count * sizeof(pclist_t *));
+    pclist_t **clones = malloc(servers->count * sizeof(pclist_t *));
+    size_t count = 0;
+    for (size_t i = 0; i < servers->count; i++) {
+        bool selected = node == servers->nodes[i];
+        if (servers->nodes[i]->selected == selected) {
+            continue;
+        }
+        changed[count] = servers->nodes[i];
+        clones[count] = pclist_node_clone(servers->nodes[i]);
+        clones[count++]->selected = selected;
+    }
+    if (count > 0) {
+        pcregistry_replace(&manager->registry, changed, clones, count, (pcregistry_free_fn) pclist_node_discard);
     }
+    free(clones);
+    free(changed);
     pcmanager_unlock(manager);
     return true;
 }
@@ -130,13 +174,18 @@ int pcmanager_node_current_app(const pclist_t *node) {
     return node->server->currentGame;
 }
 
-bool pcmanager_send_wol(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_callback_t callback,
-                        void *userdata) {
-    worker_context_t *ctx = worker_context_new(manager, uuid, callback, userdata);
-    pcmanager_worker_queue(manager, worker_wol, ctx);
-    return true;
+const pclist_snapshot_t *pcmanager_servers(pcmanager_t *manager) {
+    return pcregistry_peek(&manager->registry);
+}
+
+const pclist_snapshot_t *pcmanager_servers_acquire(pcmanager_t *manager) {
+    return pcregistry_acquire(&manager->registry);
+}
+
+void pcmanager_servers_release(const pclist_snapshot_t *snapshot) {
+    pcregistry_release(snapshot);
 }
 
-const pclist_t *pcmanager_servers(pcmanager_t *manager) {
-    return manager->servers;
+const pclist_t *pcmanager_servers_find(const pclist_snapshot_t *snapshot, const uuidstr_t *uuid) {
+    return pcregistry_find_by_uuid(snapshot, uuid);
 }
@@ -10,7 +10,8 @@ PSERVER_DATA serverdata_new() {
 
 static DISPLAY_MODE *display_mode_clone(const DISPLAY_MODE *mode) {
     if (mode == NULL) return NULL;
-    DISPLAY_MODE *result = SDL_malloc(sizeof(DISPLAY_MODE));
+    // Same allocator as libgamestream, which creates the rest of the list
+    DISPLAY_MODE *result = malloc(sizeof(DISPLAY_MODE));
     SDL_memcpy(result, mode, sizeof(DISPLAY_MODE));
     result->next = display_mode_clone(mode->next);
     return result;
@@ -44,7 +45,7 @@ void serverdata_free(PSERVER_DATA data) {
     while (mode) {
         PDISPLAY_MODE tmp = mode;
         mode = mode->next;
-        SDL_free(tmp);
+        free(tmp);
     }
     free_nullable((void *) data->uuid);
     free_nullable((void *) data->mac);
@@ -2,6 +2,8 @@
 
 #include "../pcmanager.h"
 #include "discovery/discovery.h"
+#include "registry.h"
+#include "server_snapshot.h"
 #include "executor.h"
 #include "uuidstr.h"
 #include <SDL.h>
@@ -10,27 +12,39 @@ typedef struct app_t app_t;
 typedef struct pcmanager_listener_list pcmanager_listener_list;
 typedef struct discovery_task_t discovery_task_t;
 
-typedef enum pcmanager_notify_type_t {
-    PCMANAGER_NOTIFY_ADDED,
-    PCMANAGER_NOTIFY_UPDATED,
-    PCMANAGER_NOTIFY_REMOVED,
-} pcmanager_notify_type_t;
-
-typedef struct {
-    pcmanager_t *manager;
+typedef struct pclist_update_t {
+    uuidstr_t uuid;
+    /* Host is removed before state and server (if any) are applied */
+    bool remove;
     SERVER_STATE state;
     SERVER_DATA *server;
-    uuidstr_t uuid;
-} pclist_update_context_t;
+} pclist_update_t;
+
+/**
+ * Host changes from other threads, applied on main thread in one batch. Changes to the same host are merged.
+ */
+typedef struct pclist_update_queue_t {
+    SDL_mutex *lock;
+    pclist_update_t *items;
+    size_t count, capacity;
+    /* Flush is posted to main thread and not started yet */
+    bool flush_posted;
+    /* Number of changes merged into an existing one since last flush */
+    int merged;
+} pclist_update_queue_t;
 
 struct pcmanager_t {
     app_t *app;
     SDL_threadID thread_id;
     executor_t *executor;
-    pclist_t *servers;
+    pcregistry_t registry;
+    pclist_update_queue_t updates;
+    server_snapshot_queue_t snapshots;
     SDL_mutex *lock;
     pcmanager_listener_list *listeners;
     discovery_t discovery;
+    /* Incremented when a session starts, so host update queued by the previous one can be dropped */
+    SDL_atomic_t session_generation;
 };
 
 void serverdata_free(PSERVER_DATA data);
@@ -43,8 +57,6 @@ void pcmanager_lock(pcmanager_t *manager);
 
 void pcmanager_unlock(pcmanager_t *manager);
 
-void pcmanager_load_known_hosts(pcmanager_t *manager);
-
 void pcmanager_save_known_hosts(pcmanager_t *manager);
 
 void pcmanager_lan_host_discovered(const sockaddr_t *addr, pcmanager_t *manager);
\ No newline at end of file
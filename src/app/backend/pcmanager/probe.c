@@ -0,0 +1,166 @@
+#include "probe.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <SDL_stdinc.h>
+#include <SDL_timer.h>
+
+static int probe_resolve(const host_probe_t *probe, struct addrinfo **addrs);
+
+static int probe_connect(struct addrinfo **next, int *fd);
+
+static void probe_finish(host_probe_t *probe, int *fd, int error, uint32_t start);
+
+int host_probe_run(host_probe_t *probes, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t start = SDL_GetTicks();
+    int *fds = malloc(count * sizeof(int));
+    struct pollfd *pfds = malloc(count * sizeof(struct pollfd));
+    // Resolved addresses of each host, and the next one to try if connecting to the current one fails
+    struct addrinfo **addrs = calloc(count, sizeof(struct addrinfo *));
+    struct addrinfo **next = calloc(count, sizeof(struct addrinfo *));
+    size_t pending = 0;
+    for (size_t i = 0; i < count; i++) {
+        fds[i] = -1;
+        int error = probe_resolve(&probes[i], &addrs[i]);
+        if (error == 0) {
+            next[i] = addrs[i];
+            error = probe_connect(&next[i], &fds[i]);
+        }
+        if (error != EINPROGRESS) {
+            probe_finish(&probes[i], &fds[i], error, start);
+        } else {
+            pending++;
+        }
+    }
+    while (pending > 0) {
+        uint32_t now = SDL_GetTicks() - start;
+        int timeout = -1;
+        nfds_t nfds = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (fds[i] < 0) {
+                continue;
+            }
+            if (now >= probes[i].deadline) {
+                probe_finish(&probes[i], &fds[i], ETIMEDOUT, start);
+                pending--;
+                continue;
+            }
+            int remaining = (int) (probes[i].deadline - now);
+            timeout = timeout < 0 ? remaining : SDL_min(timeout, remaining);
+            pfds[nfds].fd = fds[i];
+            pfds[nfds].events = POLLOUT;
+            pfds[nfds].revents = 0;
+            nfds++;
+        }
+        if (nfds == 0) {
+            break;
+        }
+        int ready = poll(pfds, nfds, timeout);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        for (nfds_t j = 0; ready > 0 && j < nfds; j++) {
+            if (pfds[j].revents == 0) {
+                continue;
+            }
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if (getsockopt(pfds[j].fd, SOL_SOCKET, SO_ERROR, &error, &len) != 0) {
+                error = errno;
+            }
+            for (size_t i = 0; i < count; i++) {
+                if (fds[i] != pfds[j].fd) {
+                    continue;
+                }
+                if (error != 0 && next[i] != NULL) {
+                    // Host name may resolve to addresses of both families, and only one of them is listening
+                    close(fds[i]);
+                    fds[i] = -1;
+                    error = probe_connect(&next[i], &fds[i]);
+                    if (error == EINPROGRESS) {
+                        break;
+                    }
+                }
+                probe_finish(&probes[i], &fds[i], error, start);
+                pending--;
+                break;
+            }
+        }
+    }
+    int reachable = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (fds[i] >= 0) {
+            probe_finish(&probes[i], &fds[i], EINTR, start);
+        }
+        reachable += probes[i].error == 0;
+        if (addrs[i] != NULL) {
+            freeaddrinfo(addrs[i]);
+        }
+    }
+    free(next);
+    free(addrs);
+    free(pfds);
+    free(fds);
+    return reachable;
+}
+
+static int probe_resolve(const host_probe_t *probe, struct addrinfo **addrs) {
+    char port[8];
+    snprintf(port, sizeof(port), "%u", probe->port);
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_flags = AI_NUMERICSERV};
+    if (getaddrinfo(probe->host, port, &hints, addrs) != 0 || *addrs == NULL) {
+        *addrs = NULL;
+        return EHOSTUNREACH;
+    }
+    return 0;
+}
+
+/**
+ * Start connecting to the first address from next that doesn't fail right away.
+ *
+ * @return EINPROGRESS if connection is pending, otherwise the result of the last address tried
+ */
+static int probe_connect(struct addrinfo **next, int *fd) {
+    int error = EHOSTUNREACH;
+    while (*next != NULL) {
+        const struct addrinfo *ai = *next;
+        *next = ai->ai_next;
+        error = 0;
+        *fd = socket(ai->ai_family, SOCK_STREAM, 0);
+        if (*fd < 0) {
+            error = errno;
+        } else if (fcntl(*fd, F_SETFL, fcntl(*fd, F_GETFL, 0) | O_NONBLOCK) != 0) {
+            error = errno;
+        } else if (connect(*fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            error = errno;
+        }
+        if (error == 0 || error == EINPROGRESS) {
+            break;
+        }
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    return error;
+}
+
+static void probe_finish(host_probe_t *probe, int *fd, int error, uint32_t start) {
+    probe->error = error;
+    probe->elapsed = SDL_GetTicks() - start;
+    if (*fd >= 0) {
+        close(*fd);
+        *fd = -1;
+    }
+}
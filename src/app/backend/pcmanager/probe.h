@@ -0,0 +1,34 @@
+/**
+ * @file probe.h
+ *
+ * Cheap reachability check of hosts, by opening TCP connections to all of them at once.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* HTTP port of GameStream hosts, used when the host doesn't have a custom one */
+#define HOST_PROBE_DEFAULT_PORT 47989
+
+typedef struct host_probe_t {
+    /* Numeric address or host name */
+    const char *host;
+    uint16_t port;
+    /* Milliseconds since start of the probe, after which the host is considered unreachable */
+    uint32_t deadline;
+
+    /* 0 if the port accepted the connection, otherwise errno of the failure. ETIMEDOUT if deadline has passed. */
+    int error;
+    /* Milliseconds until the result is known */
+    uint32_t elapsed;
+} host_probe_t;
+
+/**
+ * Probe all hosts concurrently, and return when all results are known.
+ *
+ * Host names are resolved before connecting, so they count against the deadline.
+ *
+ * @return Number of reachable hosts
+ */
+int host_probe_run(host_probe_t *probes, size_t count);
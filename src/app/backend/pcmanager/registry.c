@@ -0,0 +1,247 @@
+#include "registry.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_EMPTY (-1)
+
+struct pcregistry_retired_t {
+    void *ptr;
+    pcregistry_free_fn free_fn;
+    struct pcregistry_retired_t *next;
+};
+
+struct pcregistry_snapshot_t {
+    pclist_snapshot_t base;
+    SDL_atomic_t refs;
+    /* Newer snapshot, referenced so it can't be freed before this one */
+    struct pcregistry_snapshot_t *next;
+    /* Items reachable from this snapshot (and older ones) but not newer ones */
+    pcregistry_retired_t *retired;
+    /* Open addressing tables of node indices, capacity is a power of 2 */
+    size_t index_capacity;
+    int *uuid_index;
+    int *address_index;
+};
+
+static pcregistry_snapshot_t *snapshot_new(pclist_t *const *nodes, size_t count);
+
+static void snapshot_free(pcregistry_snapshot_t *snapshot);
+
+static void snapshot_swap(pcregistry_t *registry, pcregistry_snapshot_t *snapshot);
+
+static void index_insert(int *index, size_t capacity, uint32_t hash, int value);
+
+static uint32_t hash_str(const char *str);
+
+void pcregistry_init(pcregistry_t *registry) {
+    memset(registry, 0, sizeof(pcregistry_t));
+    registry->current = snapshot_new(NULL, 0);
+}
+
+void pcregistry_deinit(pcregistry_t *registry, pcregistry_free_fn node_free) {
+    pcregistry_snapshot_t *current = registry->current;
+    for (size_t i = 0; i < current->base.count; i++) {
+        pcregistry_retire(registry, current->base.nodes[i], node_free);
+    }
+    // Hand the retired items to current snapshot, so they are freed with it
+    current->retired = registry->retired;
+    registry->retired = NULL;
+    registry->current = NULL;
+    assert(SDL_AtomicGet(&current->refs) == 1);
+    pcregistry_release(&current->base);
+}
+
+const pclist_snapshot_t *pcregistry_acquire(pcregistry_t *registry) {
+    // A writer waits for readers entered in previous epoch before dropping its reference, so the loaded snapshot can't
+    // be freed before it's referenced here. The epoch is checked again, so the slot can't belong to an older epoch.
+    int epoch, slot;
+    for (;;) {
+        epoch = SDL_AtomicGet(&registry->epoch);
+        slot = epoch & 1;
+        SDL_AtomicIncRef(&registry->entering[slot]);
+        if (SDL_AtomicGet(&registry->epoch) == epoch) {
+            break;
+        }
+        SDL_AtomicDecRef(&registry->entering[slot]);
+    }
+    pcregistry_snapshot_t *snapshot = SDL_AtomicGetPtr((void **) &registry->current);
+    SDL_AtomicIncRef(&snapshot->refs);
+    SDL_AtomicDecRef(&registry->entering[slot]);
+    return &snapshot->base;
+}
+
+void pcregistry_release(const pclist_snapshot_t *snapshot) {
+    pcregistry_snapshot_t *cur = (pcregistry_snapshot_t *) snapshot;
+    while (cur != NULL && SDL_AtomicDecRef(&cur->refs)) {
+        pcregistry_snapshot_t *next = cur->next;
+        snapshot_free(cur);
+        cur = next;
+    }
+}
+
+pclist_t *pcregistry_find_by_uuid(const pclist_snapshot_t *snapshot, const uuidstr_t *uuid) {
+    const pcregistry_snapshot_t *s = (const pcregistry_snapshot_t *) snapshot;
+    size_t mask = s->index_capacity - 1;
+    for (size_t i = hash_str((const char *) uuid) & mask;; i = (i + 1) & mask) {
+        int value = s->uuid_index[i];
+        if (value == INDEX_EMPTY) {
+            return NULL;
+        }
+        pclist_t *node = snapshot->nodes[value];
+        if (uuidstr_t_equals_t(&node->id, uuid)) {
+            return node;
+        }
+    }
+}
+
+pclist_t *pcregistry_find_by_address(const pclist_snapshot_t *snapshot, const char *address) {
+    const pcregistry_snapshot_t *s = (const pcregistry_snapshot_t *) snapshot;
+    size_t mask = s->index_capacity - 1;
+    for (size_t i = hash_str(address) & mask;; i = (i + 1) & mask) {
+        int value = s->address_index[i];
+        if (value == INDEX_EMPTY) {
+            return NULL;
+        }
+        pclist_t *node = snapshot->nodes[value];
+        const SERVER_DATA *server = node->server;
+        if (server != NULL && server->serverInfo.address != NULL && strcmp(server->serverInfo.address, address) == 0) {
+            return node;
+        }
+    }
+}
+
+void pcregistry_add(pcregistry_t *registry, pclist_t *node) {
+    const pclist_snapshot_t *current = &registry->current->base;
+    pclist_t **nodes = malloc((current->count + 1) * sizeof(pclist_t *));
+    memcpy(nodes, current->nodes, current->count * sizeof(pclist_t *));
+    nodes[current->count] = node;
+    snapshot_swap(registry, snapshot_new(nodes, current->count + 1));
+    free(nodes);
+}
+
+void pcregistry_remove(pcregistry_t *registry, pclist_t *node, pcregistry_free_fn node_free) {
+    const pclist_snapshot_t *current = &registry->current->base;
+    pclist_t **nodes = malloc((current->count + 1) * sizeof(pclist_t *));
+    size_t count = 0;
+    for (size_t i = 0; i < current->count; i++) {
+        if (current->nodes[i] != node) {
+            nodes[count++] = current->nodes[i];
+        }
+    }
+    pcregistry_retire(registry, node, node_free);
+    snapshot_swap(registry, snapshot_new(nodes, count));
+    free(nodes);
+}
+
+void pcregistry_retire(pcregistry_t *registry, void *ptr, pcregistry_free_fn free_fn) {
+    if (ptr == NULL) {
+        return;
+    }
+    pcregistry_retired_t *item = malloc(sizeof(pcregistry_retired_t));
+    item->ptr = ptr;
+    item->free_fn = free_fn;
+    item->next = registry->retired;
+    registry->retired = item;
+}
+
+void pcregistry_replace(pcregistry_t *registry, pclist_t *const *old_nodes, pclist_t *const *new_nodes, size_t count,
+                        pcregistry_free_fn node_free) {
+    const pclist_snapshot_t *current = &registry->current->base;
+    pclist_t **nodes = malloc((current->count + 1) * sizeof(pclist_t *));
+    memcpy(nodes, current->nodes, current->count * sizeof(pclist_t *));
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = 0; j < current->count; j++) {
+            if (nodes[j] == old_nodes[i]) {
+                nodes[j] = new_nodes[i];
+                pcregistry_retire(registry, old_nodes[i], node_free);
+                break;
+            }
+        }
+    }
+    snapshot_swap(registry, snapshot_new(nodes, current->count));
+    free(nodes);
+}
+
+const pclist_snapshot_t *pcregistry_peek(const pcregistry_t *registry) {
+    return &registry->current->base;
+}
+
+static pcregistry_snapshot_t *snapshot_new(pclist_t *const *nodes, size_t count) {
+    pcregistry_snapshot_t *snapshot = calloc(1, sizeof(pcregistry_snapshot_t));
+    SDL_AtomicSet(&snapshot->refs, 1);
+    snapshot->base.count = count;
+    snapshot->base.nodes = malloc((count + 1) * sizeof(pclist_t *));
+    if (count > 0) {
+        memcpy(snapshot->base.nodes, nodes, count * sizeof(pclist_t *));
+    }
+    // Keep load factor under 1/2
+    size_t capacity = 8;
+    while (capacity < count * 2) {
+        capacity <<= 1;
+    }
+    snapshot->index_capacity = capacity;
+    snapshot->uuid_index = malloc(capacity * sizeof(int));
+    snapshot->address_index = malloc(capacity * sizeof(int));
+    for (size_t i = 0; i < capacity; i++) {
+        snapshot->uuid_index[i] = INDEX_EMPTY;
+        snapshot->address_index[i] = INDEX_EMPTY;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const pclist_t *node = nodes[i];
+        index_insert(snapshot->uuid_index, capacity, hash_str((const char *) &node->id), (int) i);
+        if (node->server != NULL && node->server->serverInfo.address != NULL) {
+            index_insert(snapshot->address_index, capacity, hash_str(node->server->serverInfo.address), (int) i);
+        }
+    }
+    return snapshot;
+}
+
+static void snapshot_free(pcregistry_snapshot_t *snapshot) {
+    for (pcregistry_retired_t *cur = snapshot->retired; cur != NULL;) {
+        pcregistry_retired_t *next = cur->next;
+        cur->free_fn(cur->ptr);
+        free(cur);
+        cur = next;
+    }
+    free(snapshot->uuid_index);
+    free(snapshot->address_index);
+    free(snapshot->base.nodes);
+    free(snapshot);
+}
+
+static void snapshot_swap(pcregistry_t *registry, pcregistry_snapshot_t *snapshot) {
+    pcregistry_snapshot_t *old = registry->current;
+    old->retired = registry->retired;
+    registry->retired = NULL;
+    old->next = snapshot;
+    SDL_AtomicIncRef(&snapshot->refs);
+    SDL_AtomicSetPtr((void **) &registry->current, snapshot);
+
+    // Readers entering from now on are counted in the other slot, and will see the new snapshot
+    int slot = SDL_AtomicAdd(&registry->epoch, 1) & 1;
+    while (SDL_AtomicGet(&registry->entering[slot]) != 0) {
+        SDL_CPUPauseInstruction();
+    }
+    pcregistry_release(&old->base);
+}
+
+static void index_insert(int *index, size_t capacity, uint32_t hash, int value) {
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+    while (index[i] != INDEX_EMPTY) {
+        i = (i + 1) & mask;
+    }
+    index[i] = value;
+}
+
+static uint32_t hash_str(const char *str) {
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *) str; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
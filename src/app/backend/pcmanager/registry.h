@@ -0,0 +1,82 @@
+/**
+ * @file registry.h
+ *
+ * Host registry published as immutable, reference counted snapshots.
+ *
+ * Readers on any thread acquire the latest snapshot without blocking, and can use nodes in it until it's released.
+ * Writers must be serialized (in pcmanager they run on the main thread). Published nodes are never modified: a writer
+ * changes a copy and replaces the node with it. Each change publishes a new snapshot, and nodes or server data taken
+ * out of it are freed once no older snapshot is held by anyone.
+ */
+#pragma once
+
+#include <stddef.h>
+
+#include <SDL_atomic.h>
+
+#include "backend/types.h"
+
+typedef void (*pcregistry_free_fn)(void *ptr);
+
+typedef struct pcregistry_snapshot_t pcregistry_snapshot_t;
+typedef struct pcregistry_retired_t pcregistry_retired_t;
+
+typedef struct pcregistry_t {
+    /* Latest snapshot, the registry holds one reference to it */
+    pcregistry_snapshot_t *current;
+    SDL_atomic_t epoch;
+    /* Readers between loading current snapshot and referencing it, counted by epoch parity */
+    SDL_atomic_t entering[2];
+    /* Items retired since last publish */
+    pcregistry_retired_t *retired;
+} pcregistry_t;
+
+void pcregistry_init(pcregistry_t *registry);
+
+/**
+ * Release the registry. All snapshots acquired from it should be released before.
+ *
+ * @param node_free Called for each node still in the registry
+ */
+void pcregistry_deinit(pcregistry_t *registry, pcregistry_free_fn node_free);
+
+/**
+ * Lock-free on the reader side, and safe to call from any thread.
+ *
+ * @return Latest snapshot, never NULL. Release it with pcregistry_release().
+ */
+const pclist_snapshot_t *pcregistry_acquire(pcregistry_t *registry);
+
+void pcregistry_release(const pclist_snapshot_t *snapshot);
+
+pclist_t *pcregistry_find_by_uuid(const pclist_snapshot_t *snapshot, const uuidstr_t *uuid);
+
+pclist_t *pcregistry_find_by_address(const pclist_snapshot_t *snapshot, const char *address);
+
+/**
+ * Publish a new snapshot with the node appended.
+ */
+void pcregistry_add(pcregistry_t *registry, pclist_t *node);
+
+/**
+ * Publish a new snapshot without the node. It will be freed when no snapshot containing it is held anymore.
+ */
+void pcregistry_remove(pcregistry_t *registry, pclist_t *node, pcregistry_free_fn node_free);
+
+/**
+ * Free ptr when snapshots before next publish are all released. Use it for data replaced in nodes, as readers of
+ * older snapshots may still be using it.
+ */
+void pcregistry_retire(pcregistry_t *registry, void *ptr, pcregistry_free_fn free_fn);
+
+/**
+ * Publish one snapshot with each of old_nodes swapped for the new node at the same index. Old nodes are retired with
+ * node_free, as readers of older snapshots may still be using them.
+ */
+void pcregistry_replace(pcregistry_t *registry, pclist_t *const *old_nodes, pclist_t *const *new_nodes, size_t count,
+                        pcregistry_free_fn node_free);
+
+/**
+ * Writer side only. Returns latest snapshot without taking a reference.
+ */
+const pclist_snapshot_t *pcregistry_peek(const pcregistry_t *registry);
@@ -0,0 +1,524 @@
+#include "server_snapshot.h"
+#include "priv.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/path.h"
+#include "logging.h"
+
+#define SNAPSHOT_MAGIC "MLSV"
+#define SNAPSHOT_VERSION 1
+/* Larger files can't be a snapshot */
+#define SNAPSHOT_MAX_SIZE 65536
+#define SNAPSHOT_MAX_MODES 256
+#define SNAPSHOT_NULL_STRING 0xFFFF
+
+#define FLAG_PAIRED 0x01
+#define FLAG_SUPPORTS_4K 0x02
+#define FLAG_SUPPORTS_HDR 0x04
+#define FLAG_UNSUPPORTED 0x08
+#define FLAG_IS_GFE 0x10
+
+typedef struct snapshot_writer_t {
+    unsigned char *buf;
+    size_t len, cap;
+} snapshot_writer_t;
+
+typedef struct snapshot_reader_t {
+    const unsigned char *buf;
+    size_t len, pos;
+    bool error;
+} snapshot_reader_t;
+
+static int snapshot_write_file(const char *conf_dir, const char *uuid, const unsigned char *buf, size_t len);
+
+static void queue_enqueue(server_snapshot_queue_t *queue, const char *uuid, unsigned char *buf, size_t len,
+                          uint32_t hash);
+
+static server_snapshot_saved_t *queue_saved_find(server_snapshot_queue_t *queue, const char *uuid);
+
+static void queue_saved_set(server_snapshot_queue_t *queue, const char *uuid, bool saved, uint32_t hash);
+
+static bool queue_write_next(server_snapshot_queue_t *queue);
+
+static void queue_write_all(server_snapshot_queue_t *queue);
+
+static int queue_write_task(server_snapshot_queue_t *queue);
+
+static void queue_write_finished(server_snapshot_queue_t *queue, int result);
+
+static void write_bytes(snapshot_writer_t *writer, const void *data, size_t len);
+
+static void write_u8(snapshot_writer_t *writer, uint8_t value);
+
+static void write_u16(snapshot_writer_t *writer, uint16_t value);
+
+static void write_u32(snapshot_writer_t *writer, uint32_t value);
+
+static void write_string(snapshot_writer_t *writer, const char *value);
+
+static const unsigned char *read_bytes(snapshot_reader_t *reader, size_t len);
+
+static uint8_t read_u8(snapshot_reader_t *reader);
+
+static uint16_t read_u16(snapshot_reader_t *reader);
+
+static uint32_t read_u32(snapshot_reader_t *reader);
+
+static char *read_string(snapshot_reader_t *reader);
+
+static uint32_t snapshot_checksum(const unsigned char *buf, size_t len);
+
+static char *snapshot_path(const char *conf_dir, const char *uuid);
+
+int server_snapshot_encode(const SERVER_DATA *server, unsigned char **buf, size_t *len, uint32_t *hash) {
+    snapshot_writer_t writer = {.buf = NULL};
+    write_bytes(&writer, SNAPSHOT_MAGIC, 4);
+    write_u16(&writer, SNAPSHOT_VERSION);
+    write_string(&writer, server->uuid);
+    write_string(&writer, server->mac);
+    write_string(&writer, server->hostname);
+    write_string(&writer, server->gpuType);
+    write_string(&writer, server->gsVersion);
+    write_string(&writer, server->serverInfo.address);
+    write_string(&writer, server->serverInfo.serverInfoAppVersion);
+    write_string(&writer, server->serverInfo.serverInfoGfeVersion);
+    write_u16(&writer, server->httpsPort);
+    write_u16(&writer, server->extPort);
+    uint8_t flags = 0;
+    flags |= server->paired ? FLAG_PAIRED : 0;
+    flags |= server->supports4K ? FLAG_SUPPORTS_4K : 0;
+    flags |= server->supportsHdr ? FLAG_SUPPORTS_HDR : 0;
+    flags |= server->unsupported ? FLAG_UNSUPPORTED : 0;
+    flags |= server->isGfe ? FLAG_IS_GFE : 0;
+    write_u8(&writer, flags);
+    write_u32(&writer, (uint32_t) server->currentGame);
+    write_u32(&writer, (uint32_t) server->serverMajorVersion);
+    write_u32(&writer, (uint32_t) server->serverInfo.serverCodecModeSupport);
+    uint16_t mode_count = 0;
+    for (const DISPLAY_MODE *mode = server->modes; mode != NULL && mode_count < SNAPSHOT_MAX_MODES; mode = mode->next) {
+        mode_count++;
+    }
+    write_u16(&writer, mode_count);
+    const DISPLAY_MODE *mode = server->modes;
+    for (int i = 0; i < mode_count; i++, mode = mode->next) {
+        write_u32(&writer, mode->width);
+        write_u32(&writer, mode->height);
+        write_u32(&writer, mode->refresh);
+    }
+    uint32_t checksum = snapshot_checksum(writer.buf, writer.len);
+    write_u32(&writer, checksum);
+    if (writer.buf == NULL) {
+        return ENOMEM;
+    }
+    *buf = writer.buf;
+    *len = writer.len;
+    if (hash != NULL) {
+        *hash = checksum;
+    }
+    return 0;
+}
+
+SERVER_DATA *server_snapshot_decode(const unsigned char *buf, size_t len) {
+    if (len < 10 || memcmp(buf, SNAPSHOT_MAGIC, 4) != 0) {
+        return NULL;
+    }
+    snapshot_reader_t reader = {.buf = buf, .len = len - 4};
+    read_bytes(&reader, 4);
+    if (read_u16(&reader) != SNAPSHOT_VERSION) {
+        return NULL;
+    }
+    snapshot_reader_t trailer = {.buf = buf, .len = len, .pos = len - 4};
+    if (read_u32(&trailer) != snapshot_checksum(buf, len - 4)) {
+        return NULL;
+    }
+    SERVER_DATA *server = serverdata_new();
+    server->uuid = read_string(&reader);
+    server->mac = read_string(&reader);
+    server->hostname = read_string(&reader);
+    server->gpuType = read_string(&reader);
+    server->gsVersion = read_string(&reader);
+    server->serverInfo.address = read_string(&reader);
+    server->serverInfo.serverInfoAppVersion = read_string(&reader);
+    server->serverInfo.serverInfoGfeVersion = read_string(&reader);
+    server->httpsPort = read_u16(&reader);
+    server->extPort = read_u16(&reader);
+    uint8_t flags = read_u8(&reader);
+    server->paired = flags & FLAG_PAIRED;
+    server->supports4K = flags & FLAG_SUPPORTS_4K;
+    server->supportsHdr = flags & FLAG_SUPPORTS_HDR;
+    server->unsupported = flags & FLAG_UNSUPPORTED;
+    server->isGfe = flags & FLAG_IS_GFE;
+    server->currentGame = (int) read_u32(&reader);
+    server->serverMajorVersion = (int) read_u32(&reader);
+    server->serverInfo.serverCodecModeSupport = (int) read_u32(&reader);
+    uint16_t mode_count = read_u16(&reader);
+    PDISPLAY_MODE *tail = &server->modes;
+    for (int i = 0; i < mode_count && !reader.error; i++) {
+        PDISPLAY_MODE mode = calloc(1, sizeof(DISPLAY_MODE));
+        mode->width = read_u32(&reader);
+        mode->height = read_u32(&reader);
+        mode->refresh = read_u32(&reader);
+        *tail = mode;
+        tail = &mode->next;
+    }
+    if (reader.error || reader.pos != reader.len || server->uuid == NULL || server->serverInfo.address == NULL) {
+        serverdata_free(server);
+        return NULL;
+    }
+    return server;
+}
+
+int server_snapshot_save(const char *conf_dir, const SERVER_DATA *server, uint32_t *hash) {
+    if (server->uuid == NULL) {
+        return EINVAL;
+    }
+    unsigned char *buf = NULL;
+    size_t len = 0;
+    uint32_t checksum = 0;
+    int ret = server_snapshot_encode(server, &buf, &len, &checksum);
+    if (ret != 0) {
+        return ret;
+    }
+    if (hash != NULL && *hash == checksum) {
+        free(buf);
+        return 0;
+    }
+    ret = snapshot_write_file(conf_dir, server->uuid, buf, len);
+    if (ret == 0 && hash != NULL) {
+        *hash = checksum;
+    }
+    free(buf);
+    return ret;
+}
+
+SERVER_DATA *server_snapshot_load(const char *conf_dir, const char *uuid, uint32_t *hash) {
+    char *path = snapshot_path(conf_dir, uuid);
+    FILE *fp = fopen(path, "rb");
+    free(path);
+    if (fp == NULL) {
+        return NULL;
+    }
+    unsigned char *buf = malloc(SNAPSHOT_MAX_SIZE);
+    size_t len = fread(buf, 1, SNAPSHOT_MAX_SIZE, fp);
+    bool truncated = !feof(fp);
+    fclose(fp);
+    SERVER_DATA *server = truncated ? NULL : server_snapshot_decode(buf, len);
+    if (server == NULL) {
+        commons_log_warn("PCManager", "Ignoring invalid snapshot of %s", uuid);
+    } else if (strcmp(server->uuid, uuid) != 0) {
+        commons_log_warn("PCManager", "Ignoring snapshot of %s, it belongs to %s", uuid, server->uuid);
+        serverdata_free(server);
+        server = NULL;
+    } else if (hash != NULL) {
+        *hash = snapshot_checksum(buf, len - 4);
+    }
+    free(buf);
+    return server;
+}
+
+void server_snapshot_remove(const char *conf_dir, const char *uuid) {
+    char *path = snapshot_path(conf_dir, uuid);
+    remove(path);
+    free(path);
+}
+
+void server_snapshot_queue_init(server_snapshot_queue_t *queue, executor_t *executor, const char *conf_dir) {
+    memset(queue, 0, sizeof(*queue));
+    queue->lock = SDL_CreateMutex();
+    queue->idle = SDL_CreateCond();
+    queue->executor = executor;
+    queue->conf_dir = conf_dir;
+}
+
+void server_snapshot_queue_deinit(server_snapshot_queue_t *queue) {
+    SDL_LockMutex(queue->lock);
+    while (queue->writing) {
+        SDL_CondWait(queue->idle, queue->lock);
+    }
+    SDL_UnlockMutex(queue->lock);
+    queue_write_all(queue);
+    free(queue->items);
+    for (size_t i = 0; i < queue->saved_count; i++) {
+        free(queue->saved[i].uuid);
+    }
+    free(queue->saved);
+    SDL_DestroyCond(queue->idle);
+    SDL_DestroyMutex(queue->lock);
+}
+
+void server_snapshot_queue_save(server_snapshot_queue_t *queue, const SERVER_DATA *server) {
+    if (server->uuid == NULL) {
+        return;
+    }
+    unsigned char *buf = NULL;
+    size_t len = 0;
+    uint32_t checksum = 0;
+    if (server_snapshot_encode(server, &buf, &len, &checksum) != 0) {
+        return;
+    }
+    queue_enqueue(queue, server->uuid, buf, len, checksum);
+}
+
+void server_snapshot_queue_set_saved(server_snapshot_queue_t *queue, const char *uuid, uint32_t hash) {
+    SDL_LockMutex(queue->lock);
+    queue_saved_set(queue, uuid, true, hash);
+    SDL_UnlockMutex(queue->lock);
+}
+
+void server_snapshot_queue_remove(server_snapshot_queue_t *queue, const char *uuid) {
+    queue_enqueue(queue, uuid, NULL, 0, 0);
+}
+
+static void write_bytes(snapshot_writer_t *writer, const void *data, size_t len) {
+    if (writer->len + len > writer->cap) {
+        size_t cap = SDL_max(writer->cap * 2, writer->len + len + 256);
+        unsigned char *buf = realloc(writer->buf, cap);
+        if (buf == NULL) {
+            free(writer->buf);
+            *writer = (snapshot_writer_t) {.buf = NULL};
+            return;
+        }
+        writer->buf = buf;
+        writer->cap = cap;
+    }
+    memcpy(writer->buf + writer->len, data, len);
+    writer->len += len;
+}
+
+static void write_u8(snapshot_writer_t *writer, uint8_t value) {
+    write_bytes(writer, &value, 1);
+}
+
+static void write_u16(snapshot_writer_t *writer, uint16_t value) {
+    unsigned char bytes[2] = {value & 0xFF, value >> 8};
+    write_bytes(writer, bytes, sizeof(bytes));
+}
+
+static void write_u32(snapshot_writer_t *writer, uint32_t value) {
+    unsigned char bytes[4] = {value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24};
+    write_bytes(writer, bytes, sizeof(bytes));
+}
+
+static void write_string(snapshot_writer_t *writer, const char *value) {
+    if (value == NULL) {
+        write_u16(writer, SNAPSHOT_NULL_STRING);
+        return;
+    }
+    size_t len = SDL_min(strlen(value), SNAPSHOT_NULL_STRING - 1);
+    write_u16(writer, (uint16_t) len);
+    write_bytes(writer, value, len);
+}
+
+static const unsigned char *read_bytes(snapshot_reader_t *reader, size_t len) {
+    if (reader->error || reader->len - reader->pos < len) {
+        reader->error = true;
+        return NULL;
+    }
+    const unsigned char *data = reader->buf + reader->pos;
+    reader->pos += len;
+    return data;
+}
+
+static uint8_t read_u8(snapshot_reader_t *reader) {
+    const unsigned char *data = read_bytes(reader, 1);
+    return data != NULL ? data[0] : 0;
+}
+
+static uint16_t read_u16(snapshot_reader_t *reader) {
+    const unsigned char *data = read_bytes(reader, 2);
+    return data != NULL ? (uint16_t) (data[0] | data[1] << 8) : 0;
+}
+
+static uint32_t read_u32(snapshot_reader_t *reader) {
+    const unsigned char *data = read_bytes(reader, 4);
+    if (data == NULL) {
+        return 0;
+    }
+    return (uint32_t) data[0] | (uint32_t) data[1] << 8 | (uint32_t) data[2] << 16 | (uint32_t) data[3] << 24;
+}
+
+static char *read_string(snapshot_reader_t *reader) {
+    uint16_t len = read_u16(reader);
+    if (len == SNAPSHOT_NULL_STRING) {
+        return NULL;
+    }
+    const unsigned char *data = read_bytes(reader, len);
+    if (data == NULL) {
+        return NULL;
+    }
+    return strndup((const char *) data, len);
+}
+
+/* FNV-1a */
+static uint32_t snapshot_checksum(const unsigned char *buf, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= buf[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int snapshot_write_file(const char *conf_dir, const char *uuid, const unsigned char *buf, size_t len) {
+    int ret = 0;
+    char *path = snapshot_path(conf_dir, uuid);
+    size_t tmp_len = strlen(path) + 5;
+    char *tmp_path = malloc(tmp_len);
+    SDL_snprintf(tmp_path, tmp_len, "%s.tmp", path);
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        ret = errno;
+    } else {
+        if (fwrite(buf, 1, len, fp) != len) {
+            ret = errno;
+        }
+        if (fclose(fp) != 0 && ret == 0) {
+            ret = errno;
+        }
+        if (ret == 0 && rename(tmp_path, path) != 0) {
+            ret = errno;
+        }
+    }
+    if (ret != 0) {
+        commons_log_warn("PCManager", "Failed to save snapshot of %s: %s", uuid, strerror(ret));
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    free(path);
+    return ret;
+}
+
+static void queue_enqueue(server_snapshot_queue_t *queue, const char *uuid, unsigned char *buf, size_t len,
+                          uint32_t hash) {
+    SDL_LockMutex(queue->lock);
+    server_snapshot_write_t *item = NULL;
+    for (size_t i = 0; i < queue->count; i++) {
+        if (strcmp(queue->items[i].uuid, uuid) == 0) {
+            item = &queue->items[i];
+            break;
+        }
+    }
+    if (buf != NULL) {
+        const server_snapshot_saved_t *saved = queue_saved_find(queue, uuid);
+        bool same_as_queued = item != NULL && item->buf != NULL && item->hash == hash;
+        bool same_as_saved = item == NULL && saved != NULL && saved->hash == hash;
+        if (same_as_queued || same_as_saved) {
+            SDL_UnlockMutex(queue->lock);
+            free(buf);
+            return;
+        }
+    }
+    if (item != NULL) {
+        // Not written yet, the newer change replaces it
+        free(item->buf);
+    } else {
+        if (queue->count == queue->capacity) {
+            queue->capacity = queue->capacity ? queue->capacity * 2 : 4;
+            queue->items = realloc(queue->items, queue->capacity * sizeof(server_snapshot_write_t));
+        }
+        item = &queue->items[queue->count++];
+        item->uuid = strdup(uuid);
+    }
+    item->buf = buf;
+    item->len = len;
+    item->hash = hash;
+    bool submit = !queue->writing;
+    queue->writing = true;
+    SDL_UnlockMutex(queue->lock);
+    if (submit) {
+        executor_submit(queue->executor, (executor_action_cb) queue_write_task,
+                        (executor_cleanup_cb) queue_write_finished, queue);
+    }
+}
+
+/**
+ * @return false if nothing is left to write
+ */
+static bool queue_write_next(server_snapshot_queue_t *queue) {
+    SDL_LockMutex(queue->lock);
+    if (queue->count == 0) {
+        SDL_UnlockMutex(queue->lock);
+        return false;
+    }
+    server_snapshot_write_t item = queue->items[0];
+    queue->count--;
+    memmove(queue->items, queue->items + 1, queue->count * sizeof(server_snapshot_write_t));
+    SDL_UnlockMutex(queue->lock);
+    bool saved = false;
+    if (item.buf != NULL) {
+        saved = snapshot_write_file(queue->conf_dir, item.uuid, item.buf, item.len) == 0;
+    } else {
+        server_snapshot_remove(queue->conf_dir, item.uuid);
+    }
+    SDL_LockMutex(queue->lock);
+    queue_saved_set(queue, item.uuid, saved, item.hash);
+    SDL_UnlockMutex(queue->lock);
+    free(item.buf);
+    free(item.uuid);
+    return true;
+}
+
+static void queue_write_all(server_snapshot_queue_t *queue) {
+    while (queue_write_next(queue)) {
+    }
+}
+
+static int queue_write_task(server_snapshot_queue_t *queue) {
+    queue_write_all(queue);
+    return 0;
+}
+
+static void queue_write_finished(server_snapshot_queue_t *queue, int result) {
+    SDL_LockMutex(queue->lock);
+    // Writes queued after the task ran out of work still need a task
+    bool resubmit = queue->count > 0 && result != ECANCELED;
+    queue->writing = resubmit;
+    SDL_CondBroadcast(queue->idle);
+    SDL_UnlockMutex(queue->lock);
+    if (resubmit) {
+        executor_submit(queue->executor, (executor_action_cb) queue_write_task,
+                        (executor_cleanup_cb) queue_write_finished, queue);
+    }
+}
+
+static server_snapshot_saved_t *queue_saved_find(server_snapshot_queue_t *queue, const char *uuid) {
+    for (size_t i = 0; i < queue->saved_count; i++) {
+        if (strcmp(queue->saved[i].uuid, uuid) == 0) {
+            return &queue->saved[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @param saved false if the snapshot on disk is unknown, removed or failed to write
+ */
+static void queue_saved_set(server_snapshot_queue_t *queue, const char *uuid, bool saved, uint32_t hash) {
+    server_snapshot_saved_t *item = queue_saved_find(queue, uuid);
+    if (!saved) {
+        if (item != NULL) {
+            free(item->uuid);
+            *item = queue->saved[--queue->saved_count];
+        }
+        return;
+    }
+    if (item == NULL) {
+        if (queue->saved_count == queue->saved_capacity) {
+            queue->saved_capacity = queue->saved_capacity ? queue->saved_capacity * 2 : 4;
+            queue->saved = realloc(queue->saved, queue->saved_capacity * sizeof(server_snapshot_saved_t));
+        }
+        item = &queue->saved[queue->saved_count++];
+        item->uuid = strdup(uuid);
+    }
+    item->hash = hash;
+}
+
+static char *snapshot_path(const char *conf_dir, const char *uuid) {
+    char name[64];
+    SDL_snprintf(name, sizeof(name), "server-%s.bin", uuid);
+    return path_join(conf_dir, name);
+}
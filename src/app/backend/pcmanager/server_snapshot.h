@@ -0,0 +1,96 @@
+/**
+ * @file server_snapshot.h
+ *
+ * Last known SERVER_DATA of each host, so the launcher can show hosts before they answer.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL_mutex.h>
+
+#include "libgamestream/client.h"
+#include "executor.h"
+
+typedef struct server_snapshot_write_t {
+    char *uuid;
+    /* NULL to remove the snapshot */
+    unsigned char *buf;
+    size_t len;
+    uint32_t hash;
+} server_snapshot_write_t;
+
+typedef struct server_snapshot_saved_t {
+    char *uuid;
+    /* Checksum of the snapshot on disk */
+    uint32_t hash;
+} server_snapshot_saved_t;
+
+/**
+ * Snapshot writes done on the executor, so the main thread doesn't wait for the disk. One task writes them in queued
+ * order, and only the latest change of each host is kept.
+ */
+typedef struct server_snapshot_queue_t {
+    SDL_mutex *lock;
+    SDL_cond *idle;
+    executor_t *executor;
+    const char *conf_dir;
+    server_snapshot_write_t *items;
+    size_t count, capacity;
+    /* Only updated after a successful write, so a failed one is tried again on the next change */
+    server_snapshot_saved_t *saved;
+    size_t saved_count, saved_capacity;
+    /* Write task is submitted and hasn't finished yet */
+    bool writing;
+} server_snapshot_queue_t;
+
+/**
+ * Serialize server info into a compact binary blob.
+ *
+ * @param buf Allocated buffer, to be freed by caller
+ * @param hash Checksum of the content, used to tell whether the snapshot has changed
+ * @return 0 on success
+ */
+int server_snapshot_encode(const SERVER_DATA *server, unsigned char **buf, size_t *len, uint32_t *hash);
+
+/**
+ * @return Decoded server info, or NULL if the data is truncated, corrupted or from another version
+ */
+SERVER_DATA *server_snapshot_decode(const unsigned char *buf, size_t len);
+
+/**
+ * Write the snapshot of the host, unless its content is the same as the last saved one.
+ *
+ * @param hash Checksum of the last saved snapshot, will be updated after writing
+ * @return 0 if saved or not changed
+ */
+int server_snapshot_save(const char *conf_dir, const SERVER_DATA *server, uint32_t *hash);
+
+/**
+ * @return Saved server info of the host, or NULL if not available
+ */
+SERVER_DATA *server_snapshot_load(const char *conf_dir, const char *uuid, uint32_t *hash);
+
+void server_snapshot_remove(const char *conf_dir, const char *uuid);
+
+void server_snapshot_queue_init(server_snapshot_queue_t *queue, executor_t *executor, const char *conf_dir);
+
+/**
+ * Wait for queued writes to finish. Writes left behind by a cancelled task are done on the calling thread.
+ */
+void server_snapshot_queue_deinit(server_snapshot_queue_t *queue);
+
+/**
+ * Encode the snapshot on the calling thread, and queue writing it if its content differs from the one on disk and the
+ * one already queued.
+ */
+void server_snapshot_queue_save(server_snapshot_queue_t *queue, const SERVER_DATA *server);
+
+/**
+ * Record checksum of a snapshot loaded from disk, so unchanged content isn't written again.
+ */
+void server_snapshot_queue_set_saved(server_snapshot_queue_t *queue, const char *uuid, uint32_t hash);
+
+void server_snapshot_queue_remove(server_snapshot_queue_t *queue, const char *uuid);
@@ -9,12 +9,15 @@
 
 int worker_pairing(worker_context_t *context) {
     pcmanager_t *manager = context->manager;
-    const pclist_t *node = pcmanager_node(manager, &context->uuid);
+    const pclist_snapshot_t *servers = pcmanager_servers_acquire(manager);
+    const pclist_t *node = pcmanager_servers_find(servers, &context->uuid);
     if (node == NULL) {
+        pcmanager_servers_release(servers);
         return ENOENT;
     }
-    GS_CLIENT client = app_gs_client_new(context->app);
+    GS_CLIENT client = app_gs_client_new_with_cert(context->app);
     PSERVER_DATA server = serverdata_clone(node->server);
+    pcmanager_servers_release(servers);
     gs_set_timeout(client, 60);
     int ret = gs_pair(client, server, context->arg1);
     gs_destroy(client);
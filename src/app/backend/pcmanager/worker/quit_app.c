@@ -3,23 +3,41 @@
 #include "backend/pcmanager/priv.h"
 #include "app.h"
 #include "errors.h"
+#include "logging.h"
 
 int worker_quit_app(worker_context_t *context) {
-    GS_CLIENT client = app_gs_client_new(context->app);
-    pclist_t *node = pclist_find_by_uuid(context->manager, &context->uuid);
+    const pclist_snapshot_t *servers = pcmanager_servers_acquire(context->manager);
+    const pclist_t *node = pcmanager_servers_find(servers, &context->uuid);
     if (node == NULL) {
+        pcmanager_servers_release(servers);
         return GS_ERROR;
     }
-    int ret = gs_quit_app(client, node->server);
-    pcmanager_unlock(context->manager);
+    GS_CLIENT client = app_gs_client_new(context->app);
+    // Quit clears current game of the server, so it's done on a copy and published with upsert
+    PSERVER_DATA server = serverdata_clone(node->server);
+    pcmanager_servers_release(servers);
+    int ret = gs_quit_app(client, server);
+    gs_destroy(client);
     if (ret == GS_OK) {
         SERVER_STATE state = {.code = SERVER_STATE_AVAILABLE};
-        pclist_upsert(context->manager, &context->uuid, &state, node->server);
+        pclist_upsert(context->manager, &context->uuid, &state, server);
     } else {
         const char *gs_error = NULL;
         gs_get_error(&gs_error);
         context->error = gs_error != NULL ? strdup(gs_error) : NULL;
+        serverdata_free(server);
     }
     return ret;
 }
 
+int worker_quit_app_and_update(worker_context_t *context) {
+    int ret = worker_quit_app(context);
+    if (ret != GS_OK) {
+        commons_log_warn("PcManager", "Failed to quit app: %s", context->error != NULL ? context->error : "unknown");
+        // Host update sets its own error
+        free(context->error);
+        context->error = NULL;
+    }
+    // Update even if quit failed, to reflect what's really running on the host
+    return worker_host_update(context);
+}
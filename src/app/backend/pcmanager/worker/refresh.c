@@ -0,0 +1,118 @@
+#include "worker.h"
+#include "backend/pcmanager/priv.h"
+#include "backend/pcmanager/pclist.h"
+#include "backend/pcmanager/probe.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL_atomic.h>
+#include <SDL_timer.h>
+
+#include "logging.h"
+
+/* Hosts not accepting TCP connection within this time are considered offline */
+#define REFRESH_PROBE_DEADLINE 1500
+
+typedef struct refresh_t {
+    Uint32 start;
+    SDL_atomic_t total;
+    SDL_atomic_t reachable;
+    /* Host updates still running, plus the coordinator itself. Released on main thread, or by cancelled tasks on
+     * the executor. */
+    SDL_atomic_t remaining;
+} refresh_t;
+
+static void refresh_queue(pcmanager_t *manager, worker_action action, worker_context_t *context);
+
+static void refresh_finalize(worker_context_t *context, int result);
+
+static void refresh_done(int result, const char *error, const uuidstr_t *uuid, void *userdata);
+
+static void refresh_release(refresh_t *refresh);
+
+int worker_refresh_all(worker_context_t *context) {
+    pcmanager_t *manager = context->manager;
+    refresh_t *refresh = context->userdata;
+    const uuidstr_t *exclude = uuidstr_is_empty(&context->uuid) ? NULL : &context->uuid;
+
+    const pclist_snapshot_t *servers = pcmanager_servers_acquire(manager);
+    uuidstr_t *uuids = calloc(servers->count, sizeof(uuidstr_t));
+    host_probe_t *probes = calloc(servers->count, sizeof(host_probe_t));
+    size_t count = 0;
+    for (size_t i = 0; i < servers->count; i++) {
+        const pclist_t *node = servers->nodes[i];
+        if (exclude != NULL && uuidstr_t_equals_t(&node->id, exclude)) {
+            continue;
+        }
+        const SERVER_DATA *server = node->server;
+        uuids[count] = node->id;
+        probes[count].host = strdup(server->serverInfo.address);
+        probes[count].port = server->extPort != 0 ? server->extPort : HOST_PROBE_DEFAULT_PORT;
+        probes[count].deadline = REFRESH_PROBE_DEADLINE;
+        count++;
+    }
+    pcmanager_servers_release(servers);
+
+    int reachable = host_probe_run(probes, count);
+    SDL_AtomicSet(&refresh->total, (int) count);
+    SDL_AtomicSet(&refresh->reachable, reachable);
+    SDL_AtomicAdd(&refresh->remaining, reachable);
+
+    for (size_t i = 0; i < count; i++) {
+        if (probes[i].error == 0) {
+            worker_context_t *ctx = worker_context_new(manager, &uuids[i], refresh_done, refresh);
+            refresh_queue(manager, worker_host_update, ctx);
+        } else {
+            commons_log_debug("PCManager", "Host %s:%u unreachable (errno=%d) after %u ms", probes[i].host,
+                              probes[i].port, probes[i].error, probes[i].elapsed);
+            SERVER_STATE state = {.code = SERVER_STATE_OFFLINE};
+            pclist_upsert(manager, &uuids[i], &state, NULL);
+        }
+        free((void *) probes[i].host);
+    }
+    free(probes);
+    free(uuids);
+    return 0;
+}
+
+void pcmanager_refresh(pcmanager_t *manager, const uuidstr_t *exclude) {
+    refresh_t *refresh = calloc(1, sizeof(refresh_t));
+    refresh->start = SDL_GetTicks();
+    SDL_AtomicSet(&refresh->remaining, 1);
+    worker_context_t *ctx = worker_context_new(manager, exclude, refresh_done, refresh);
+    refresh_queue(manager, worker_refresh_all, ctx);
+}
+
+/**
+ * Like pcmanager_worker_queue(), but cancelled tasks, which get no callback, still release the refresh.
+ */
+static void refresh_queue(pcmanager_t *manager, worker_action action, worker_context_t *context) {
+    executor_submit(manager->executor, (executor_action_cb) action, (executor_cleanup_cb) refresh_finalize,
+                    context);
+}
+
+static void refresh_finalize(worker_context_t *context, int result) {
+    refresh_t *refresh = context->userdata;
+    worker_context_finalize(context, result);
+    if (result == ECANCELED) {
+        refresh_release(refresh);
+    }
+}
+
+static void refresh_done(int result, const char *error, const uuidstr_t *uuid, void *userdata) {
+    (void) result;
+    (void) error;
+    (void) uuid;
+    refresh_release(userdata);
+}
+
+static void refresh_release(refresh_t *refresh) {
+    if (!SDL_AtomicDecRef(&refresh->remaining)) {
+        return;
+    }
+    commons_log_info("PCManager", "Refreshed %d hosts, %d reachable, in %u ms", SDL_AtomicGet(&refresh->total),
+                     SDL_AtomicGet(&refresh->reachable), SDL_GetTicks() - refresh->start);
+    free(refresh);
+}
@@ -30,6 +30,9 @@ void worker_context_finalize(worker_context_t *context, int result) {
     if (context->error != NULL) {
         free(context->error);
     }
+    if (context->done != NULL) {
+        SDL_SemPost(context->done);
+    }
     free(context);
 }
 
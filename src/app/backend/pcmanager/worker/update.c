@@ -3,6 +3,7 @@
 #include "backend/pcmanager/pclist.h"
 
 #include <assert.h>
+#include <errno.h>
 
 #include "errors.h"
 #include "util/bus.h"
@@ -11,11 +12,23 @@
 #include "ui/fatal_error.h"
 
 int worker_host_update(worker_context_t *context) {
-    const pclist_t *node = pcmanager_node(context->manager, &context->uuid);
+    const pclist_snapshot_t *servers = pcmanager_servers_acquire(context->manager);
+    const pclist_t *node = pcmanager_servers_find(servers, &context->uuid);
     if (node == NULL) {
+        pcmanager_servers_release(servers);
         return GS_FAILED;
     }
-    return pcmanager_update_by_host(context, node->server->serverInfo.address, node->server->extPort, true);
+    int ret = pcmanager_update_by_host(context, node->server->serverInfo.address, node->server->extPort, true);
+    pcmanager_servers_release(servers);
+    return ret;
+}
+
+int worker_session_update(worker_context_t *context) {
+    // Another session has started since, it will be updated after that one instead
+    if (SDL_AtomicGet(&context->manager->session_generation) != context->session_generation) {
+        return ECANCELED;
+    }
+    return worker_host_update(context);
 }
 
 int pcmanager_update_by_host(worker_context_t *context, const char *ip, uint16_t port, bool force) {
@@ -1,35 +1,114 @@
 #include "worker.h"
 #include "app.h"
 #include "logging.h"
+#include "errors.h"
 #include "../pclist.h"
 #include "../priv.h"
+#include "../probe.h"
 
 #include "wol.h"
 
 #include <errno.h>
 #include <SDL.h>
 
+/* Give up if the host doesn't accept connections within this time */
+#define WOL_TIMEOUT 30000
+/* Magic packet may be lost, or the host may be still going to sleep */
+#define WOL_RESEND_INTERVAL 5000
+#define WOL_PROBE_INTERVAL 250
+#define WOL_PROBE_DEADLINE 500
+
+typedef struct wol_request_t {
+    pcmanager_wol_callback_t callback;
+    void *userdata;
+    Uint32 ready_ms;
+} wol_request_t;
+
+static void wol_finalize(worker_context_t *context, int result);
+
+static void wol_done(int result, const char *error, const uuidstr_t *uuid, void *userdata);
+
+bool pcmanager_send_wol(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_wol_callback_t callback,
+                        void *userdata) {
+    wol_request_t *request = SDL_calloc(1, sizeof(wol_request_t));
+    request->callback = callback;
+    request->userdata = userdata;
+    worker_context_t *ctx = worker_context_new(manager, uuid, wol_done, request);
+    executor_submit(manager->executor, (executor_action_cb) worker_wol, (executor_cleanup_cb) wol_finalize, ctx);
+    return true;
+}
+
 int worker_wol(worker_context_t *context) {
-    const pclist_t *node = pcmanager_node(context->manager, &context->uuid);
+    wol_request_t *request = context->userdata;
+    const pclist_snapshot_t *servers = pcmanager_servers_acquire(context->manager);
+    const pclist_t *node = pcmanager_servers_find(servers, &context->uuid);
     if (node == NULL) {
-        pcmanager_unlock(context->manager);
+        pcmanager_servers_release(servers);
         return ENOENT;
     }
-    SERVER_DATA *server = node->server;
-    wol_broadcast(server->mac);
-    Uint32 timeout = SDL_GetTicks() + 15000;
-    GS_CLIENT gs = app_gs_client_new(context->app);
-    int ret;
-    while (!SDL_TICKS_PASSED(SDL_GetTicks(), timeout)) {
-        PSERVER_DATA tmpserver = serverdata_new();
-        ret = gs_get_status(gs, tmpserver, strdup(server->serverInfo.address), server->extPort, false);
-        serverdata_free(tmpserver);
-        commons_log_debug("WoL", "gs_get_status returned %d, errno=%d", (int) ret, errno);
-        if (ret == 0 || errno == ECONNREFUSED) {
+    // Waking up takes a while, don't hold the snapshot for it
+    char *mac = node->server->mac != NULL ? SDL_strdup(node->server->mac) : NULL;
+    char *address = SDL_strdup(node->server->serverInfo.address);
+    uint16_t port = node->server->extPort;
+    pcmanager_servers_release(servers);
+
+    Uint32 start = SDL_GetTicks(), last_sent = start;
+    if (mac != NULL) {
+        wol_broadcast(mac);
+    }
+    // Cheap TCP connect probes, serverinfo is fetched only once the port accepts connections
+    bool ready = false;
+    int probes = 0;
+    while (!SDL_TICKS_PASSED(SDL_GetTicks(), start + WOL_TIMEOUT)) {
+        host_probe_t probe = {
+                .host = address,
+                .port = port != 0 ? port : HOST_PROBE_DEFAULT_PORT,
+                .deadline = WOL_PROBE_DEADLINE,
+        };
+        probes++;
+        if (host_probe_run(&probe, 1) == 1) {
+            ready = true;
             break;
         }
-        SDL_Delay(3000);
+        Uint32 now = SDL_GetTicks();
+        // Connection refused means the host is already awake, and only waiting for GameStream to start
+        if (mac != NULL && probe.error != ECONNREFUSED && SDL_TICKS_PASSED(now, last_sent + WOL_RESEND_INTERVAL)) {
+            wol_broadcast(mac);
+            last_sent = now;
+        }
+        if (probe.elapsed < WOL_PROBE_INTERVAL) {
+            SDL_Delay(WOL_PROBE_INTERVAL - probe.elapsed);
+        }
+    }
+    int ret;
+    if (ready) {
+        request->ready_ms = SDL_GetTicks() - start;
+        commons_log_info("WoL", "Host %s ready after %u ms, %d probes", address, request->ready_ms, probes);
+        ret = pcmanager_update_by_host(context, address, port, true);
+    } else {
+        commons_log_warn("WoL", "Host %s not ready after %d ms", address, WOL_TIMEOUT);
+        ret = GS_IO_ERROR;
     }
-    gs_destroy(gs);
+    SDL_free(address);
+    SDL_free(mac);
     return ret;
 }
+
+/**
+ * Cancelled requests get no callback, so they're freed here.
+ */
+static void wol_finalize(worker_context_t *context, int result) {
+    wol_request_t *request = context->userdata;
+    worker_context_finalize(context, result);
+    if (result == ECANCELED) {
+        SDL_free(request);
+    }
+}
+
+static void wol_done(int result, const char *error, const uuidstr_t *uuid, void *userdata) {
+    wol_request_t *request = userdata;
+    if (request->callback != NULL) {
+        request->callback(result, error, uuid, request->ready_ms, request->userdata);
+    }
+    SDL_free(request);
+}
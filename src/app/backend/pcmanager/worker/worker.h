@@ -2,6 +2,8 @@
 
 #include "backend/pcmanager.h"
 
+#include <SDL_mutex.h>
+
 typedef struct app_t app_t;
 typedef struct worker_context_t {
     app_t *app;
@@ -14,6 +16,10 @@ typedef struct worker_context_t {
 
     pcmanager_callback_t callback;
     void *userdata;
+    /* Posted once the context is finalized, whether the task has run or not */
+    SDL_sem *done;
+    /* Session generation of the manager when the task was queued */
+    int session_generation;
 } worker_context_t;
 
 typedef int (*worker_action)(worker_context_t *context);
@@ -22,12 +28,18 @@ int worker_pairing(worker_context_t *context);
 
 int worker_quit_app(worker_context_t *context);
 
+int worker_quit_app_and_update(worker_context_t *context);
+
 int worker_wol(worker_context_t *context);
 
 int worker_add_by_host(worker_context_t *context);
 
 int worker_host_update(worker_context_t *context);
 
+int worker_session_update(worker_context_t *context);
+
+int worker_refresh_all(worker_context_t *context);
+
 worker_context_t *worker_context_new(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_callback_t callback,
                                      void *userdata);
 
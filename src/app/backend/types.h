@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+
 #include "libgamestream/client.h"
 #include "uuidstr.h"
 
@@ -39,11 +41,19 @@ typedef struct pclist_t {
     uuidstr_t id;
     bool known, selected;
     SERVER_STATE state;
+    /* Server info is restored from snapshot, and the host hasn't responded yet */
+    bool stale;
     /* DO NOT HOLD reference to this field*/
     SERVER_DATA *server;
     appid_list_t *favs;
     appid_list_t *hidden;
-    struct pclist_t *prev;
-    struct pclist_t *next;
 } pclist_t;
 
+/**
+ * Immutable view of known hosts. Nodes in it stay valid until the snapshot is released.
+ */
+typedef struct pclist_snapshot_t {
+    size_t count;
+    pclist_t **nodes;
+} pclist_snapshot_t;
+
@@ -6,13 +6,17 @@
 #include "lvgl/lv_sdl_drv_input.h"
 
 void app_input_init(app_input_t *input, app_t *app) {
+    const char *mapping_file = NULL;
     if (app->settings.condb_path != NULL) {
         app_input_copy_initial_gamepad_mapping(&app->settings);
+        mapping_file = app_input_prepare_gamepad_mapping(input, &app->settings);
 #if SDL_VERSION_ATLEAST(2, 0, 10)
-        SDL_SetHint(SDL_HINT_GAMECONTROLLERCONFIG_FILE, app->settings.condb_path);
+        SDL_SetHint(SDL_HINT_GAMECONTROLLERCONFIG_FILE, mapping_file);
 #endif
     }
+    startup_trace_begin(&app->startup_trace, "sdl_gamecontroller");
     SDL_InitSubSystem(SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER);
+    startup_trace_end(&app->startup_trace);
     input->max_num_gamepads = 4;
     input->gamepads_count = 0;
     for (int i = 0; i < input->max_num_gamepads; i++) {
@@ -26,9 +30,11 @@ void app_input_init(app_input_t *input, app_t *app) {
         commons_log_warn("Input", "Failed to create blank cursor: %s", SDL_GetError());
     }
 #if !SDL_VERSION_ATLEAST(2, 0, 10)
-    SDL_GameControllerAddMappingsFromFile(app->settings.condb_path);
+    SDL_GameControllerAddMappingsFromFile(mapping_file);
 #endif
+    startup_trace_begin(&app->startup_trace, "gamecontrollerdb");
     app_input_init_gamepad_mapping(input, app->backend.executor, &app->settings);
+    startup_trace_end(&app->startup_trace);
 }
 
 void app_input_deinit(app_input_t *input) {
@@ -40,6 +40,8 @@ typedef struct app_gamepad_state_t {
 
 typedef struct app_input_t {
     commons_gcdb_updater_t gcdb_updater;
+    /* Platform filtered mappings actually loaded into SDL, NULL if the cache couldn't be written */
+    char *gcdb_cache_path;
     SDL_Surface *blank_cursor_surface;
     size_t max_num_gamepads;
     app_gamepad_state_t gamepads[16];
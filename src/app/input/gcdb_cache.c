@@ -0,0 +1,269 @@
+#include "gcdb_cache.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+
+#define CACHE_HEADER "# moonlight gcdb cache"
+#define CACHE_VERSION 1
+/* gamecontrollerdb.txt is a few hundreds of KB, don't read anything unreasonably large */
+#define SOURCE_MAX_SIZE (16 * 1024 * 1024)
+
+typedef struct source_t {
+    char *data;
+    size_t size;
+} source_t;
+
+typedef struct mapping_t {
+    const char *line;
+    size_t len, guid_len;
+    uint32_t guid_hash;
+    bool removed;
+} mapping_t;
+
+typedef struct mappings_t {
+    mapping_t *items;
+    size_t count, capacity;
+    /* Open addressing, indices of items plus one, 0 means empty */
+    size_t *table;
+    size_t table_size;
+} mappings_t;
+
+static char *read_source(const char *path, size_t *size);
+
+static uint32_t hash_update(uint32_t hash, const void *data, size_t len);
+
+static bool cache_up_to_date(const char *cache_path, uint32_t hash);
+
+static void mappings_parse(mappings_t *mappings, const source_t *source, const char *platform,
+                           gcdb_cache_stats_t *stats);
+
+static void mappings_add(mappings_t *mappings, const char *line, size_t len, size_t guid_len,
+                         gcdb_cache_stats_t *stats);
+
+static int mappings_write(const mappings_t *mappings, const char *cache_path, uint32_t hash,
+                          gcdb_cache_stats_t *stats);
+
+static bool line_platform_matches(const char *line, size_t len, const char *platform);
+
+int gcdb_cache_update(const char *cache_path, const char *const *sources, size_t count, const char *platform,
+                      gcdb_cache_stats_t *stats) {
+    gcdb_cache_stats_t local_stats;
+    if (stats == NULL) {
+        stats = &local_stats;
+    }
+    memset(stats, 0, sizeof(*stats));
+    source_t *loaded = calloc(count, sizeof(source_t));
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    unsigned char version = CACHE_VERSION;
+    hash = hash_update(hash, &version, 1);
+    hash = hash_update(hash, platform, strlen(platform) + 1);
+    for (size_t i = 0; i < count; i++) {
+        if (sources[i] != NULL) {
+            loaded[i].data = read_source(sources[i], &loaded[i].size);
+        }
+        // Size is included, so moving content between files is a change
+        uint32_t size = loaded[i].data != NULL ? (uint32_t) loaded[i].size : UINT32_MAX;
+        hash = hash_update(hash, &size, sizeof(size));
+        if (loaded[i].data != NULL) {
+            hash = hash_update(hash, loaded[i].data, loaded[i].size);
+            stats->source_bytes += loaded[i].size;
+        }
+    }
+
+    int ret = 0;
+    if (!cache_up_to_date(cache_path, hash)) {
+        mappings_t mappings = {.table_size = 4096};
+        mappings.table = calloc(mappings.table_size, sizeof(size_t));
+        for (size_t i = 0; i < count; i++) {
+            if (loaded[i].data != NULL) {
+                mappings_parse(&mappings, &loaded[i], platform, stats);
+            }
+        }
+        ret = mappings_write(&mappings, cache_path, hash, stats) == 0 ? 1 : -1;
+        free(mappings.items);
+        free(mappings.table);
+    }
+    for (size_t i = 0; i < count; i++) {
+        free(loaded[i].data);
+    }
+    free(loaded);
+    return ret;
+}
+
+static char *read_source(const char *path, size_t *size) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    char *data = NULL;
+    long len;
+    if (fseek(fp, 0, SEEK_END) != 0 || (len = ftell(fp)) < 0 || len > SOURCE_MAX_SIZE ||
+        fseek(fp, 0, SEEK_SET) != 0) {
+        goto finish;
+    }
+    data = malloc(len + 1);
+    if (fread(data, 1, len, fp) != (size_t) len) {
+        free(data);
+        data = NULL;
+        goto finish;
+    }
+    data[len] = '\0';
+    *size = (size_t) len;
+    finish:
+    fclose(fp);
+    return data;
+}
+
+static uint32_t hash_update(uint32_t hash, const void *data, size_t len) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool cache_up_to_date(const char *cache_path, uint32_t hash) {
+    FILE *fp = fopen(cache_path, "r");
+    if (fp == NULL) {
+        return false;
+    }
+    char line[64], expected[64];
+    snprintf(expected, sizeof(expected), CACHE_HEADER " %08x\n", hash);
+    bool matches = fgets(line, sizeof(line), fp) != NULL && strcmp(line, expected) == 0;
+    fclose(fp);
+    return matches;
+}
+
+static void mappings_parse(mappings_t *mappings, const source_t *source, const char *platform,
+                           gcdb_cache_stats_t *stats) {
+    const char *end = source->data + source->size;
+    for (const char *line = source->data; line < end;) {
+        const char *eol = memchr(line, '\n', end - line);
+        if (eol == NULL) {
+            eol = end;
+        }
+        size_t len = eol - line;
+        if (len > 0 && line[len - 1] == '\r') {
+            len--;
+        }
+        const char *comma = memchr(line, ',', len);
+        if (len > 0 && line[0] != '#' && comma != NULL) {
+            stats->lines++;
+            if (line_platform_matches(line, len, platform)) {
+                mappings_add(mappings, line, len, comma - line, stats);
+            }
+        }
+        line = eol + 1;
+    }
+}
+
+static void mappings_add(mappings_t *mappings, const char *line, size_t len, size_t guid_len,
+                         gcdb_cache_stats_t *stats) {
+    uint32_t guid_hash = hash_update(2166136261u, line, guid_len);
+    size_t mask = mappings->table_size - 1;
+    size_t slot = guid_hash & mask;
+    for (; mappings->table[slot] != 0; slot = (slot + 1) & mask) {
+        mapping_t *existing = &mappings->items[mappings->table[slot] - 1];
+        if (existing->guid_hash == guid_hash && existing->guid_len == guid_len &&
+            memcmp(existing->line, line, guid_len) == 0) {
+            // SDL lets later mappings replace earlier ones, so keep the last one
+            existing->removed = true;
+            stats->duplicates++;
+            break;
+        }
+    }
+    if (mappings->count == mappings->capacity) {
+        mappings->capacity = mappings->capacity == 0 ? 256 : mappings->capacity * 2;
+        mappings->items = realloc(mappings->items, mappings->capacity * sizeof(mapping_t));
+    }
+    mappings->items[mappings->count] = (mapping_t) {
+            .line = line, .len = len, .guid_len = guid_len, .guid_hash = guid_hash, .removed = false,
+    };
+    mappings->table[slot] = ++mappings->count;
+    if (mappings->count * 2 < mappings->table_size) {
+        return;
+    }
+    // Keep load factor under one half
+    free(mappings->table);
+    mappings->table_size *= 2;
+    mappings->table = calloc(mappings->table_size, sizeof(size_t));
+    mask = mappings->table_size - 1;
+    for (size_t i = 0; i < mappings->count; i++) {
+        if (mappings->items[i].removed) {
+            continue;
+        }
+        for (slot = mappings->items[i].guid_hash & mask; mappings->table[slot] != 0; slot = (slot + 1) & mask) {
+        }
+        mappings->table[slot] = i + 1;
+    }
+}
+
+static int mappings_write(const mappings_t *mappings, const char *cache_path, uint32_t hash,
+                          gcdb_cache_stats_t *stats) {
+    size_t tmp_len = strlen(cache_path) + 5;
+    char *tmp_path = malloc(tmp_len);
+    snprintf(tmp_path, tmp_len, "%s.tmp", cache_path);
+    int ret = 0;
+    FILE *fp = fopen(tmp_path, "w");
+    if (fp == NULL) {
+        ret = errno;
+        goto finish;
+    }
+    int header_len = fprintf(fp, CACHE_HEADER " %08x\n", hash);
+    bool ok = header_len > 0;
+    stats->cache_bytes = ok ? header_len : 0;
+    for (size_t i = 0; ok && i < mappings->count; i++) {
+        const mapping_t *mapping = &mappings->items[i];
+        if (mapping->removed) {
+            continue;
+        }
+        ok = fwrite(mapping->line, 1, mapping->len, fp) == mapping->len && fputc('\n', fp) != EOF;
+        stats->kept++;
+        stats->cache_bytes += mapping->len + 1;
+    }
+    if (!ok) {
+        ret = errno != 0 ? errno : EIO;
+    }
+    if (fclose(fp) != 0 && ret == 0) {
+        ret = errno;
+    }
+    if (ret == 0 && rename(tmp_path, cache_path) != 0) {
+        ret = errno;
+    }
+    finish:
+    if (ret != 0) {
+        commons_log_warn("Input", "Failed to write gamepad mapping cache: %s", strerror(ret));
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    return ret;
+}
+
+static bool line_platform_matches(const char *line, size_t len, const char *platform) {
+    static const char key[] = "platform:";
+    const size_t key_len = sizeof(key) - 1;
+    for (const char *p = line; p + key_len <= line + len; p++) {
+        p = memchr(p, 'p', line + len - p);
+        if (p == NULL || p + key_len > line + len) {
+            break;
+        }
+        if ((p == line || p[-1] != ',') || memcmp(p, key, key_len) != 0) {
+            continue;
+        }
+        const char *value = p + key_len;
+        const char *value_end = memchr(value, ',', line + len - value);
+        if (value_end == NULL) {
+            value_end = line + len;
+        }
+        return (size_t) (value_end - value) == strlen(platform) && memcmp(value, platform, value_end - value) == 0;
+    }
+    // Mappings without platform apply to any platform
+    return true;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file gcdb_cache.h
+ *
+ * Gamepad mappings of the current platform only, merged from gamecontrollerdb files.
+ *
+ * gamecontrollerdb.txt has mappings for every platform SDL supports, and SDL parses all of them even though only one
+ * platform applies. The cache keeps lines for the given platform (and lines without platform), with one line per
+ * GUID, so only those are handed to SDL. It's a valid gamecontrollerdb file itself.
+ *
+ * The first line of the cache records a hash of the source contents, so it's rebuilt only when a source changes.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct gcdb_cache_stats_t {
+    /* Mapping lines in all sources, and lines kept in the cache */
+    size_t lines, kept;
+    /* Lines replaced by a later line with the same GUID */
+    size_t duplicates;
+    size_t source_bytes, cache_bytes;
+} gcdb_cache_stats_t;
+
+/**
+ * @param sources Source files in the order SDL should see them, later mappings override earlier ones with the same
+ *                GUID. NULL entries and missing files are skipped.
+ * @param platform Platform name as in "platform:" field
+ * @param stats Optional, filled when the cache is rebuilt
+ * @return 0 if the cache was up to date, 1 if it was rebuilt, or -1 on error
+ */
+int gcdb_cache_update(const char *cache_path, const char *const *sources, size_t count, const char *platform,
+                      gcdb_cache_stats_t *stats);
@@ -4,11 +4,14 @@
 #include "app_settings.h"
 #include "executor.h"
 #include "gamecontrollerdb_updater.h"
+#include "gcdb_cache.h"
 #include "util/user_event.h"
 #include "util/path.h"
 #include "copyfile.h"
 #include "logging.h"
 
+#include <SDL_timer.h>
+
 
 static void gcdb_updated(commons_gcdb_status_t result, void *context);
 
@@ -16,6 +19,8 @@ static char *gamecontrollerdb_builtin_path();
 
 static char *gamecontrollerdb_extra_path();
 
+static bool gamecontrollerdb_cache_update(const char *condb_path, const char *cache_path);
+
 void app_input_init_gamepad_mapping(app_input_t *input, executor_t *executor, const app_settings_t *settings) {
     input->gcdb_updater.callback = gcdb_updated;
     input->gcdb_updater.path = settings->condb_path;
@@ -23,18 +28,24 @@ void app_input_init_gamepad_mapping(app_input_t *input, executor_t *executor, co
 #ifdef GAMECONTROLLERDB_PLATFORM_USE
     input->gcdb_updater.platform_use = GAMECONTROLLERDB_PLATFORM_USE;
 #endif
-    char *condb_extra = gamecontrollerdb_extra_path();
+    // Extra mappings are already in the cache
+    char *condb_extra = input->gcdb_cache_path == NULL ? gamecontrollerdb_extra_path() : NULL;
     if (condb_extra != NULL) {
         int num_mapping = SDL_GameControllerAddMappingsFromRW(SDL_RWFromFile(condb_extra, "r"), SDL_TRUE);
         free(condb_extra);
         commons_log_debug("Input", "Added %d gamepad mapping from extra controller db", num_mapping);
     }
     commons_gcdb_updater_init(&input->gcdb_updater, executor);
+}
+
+void app_input_update_gamepad_mapping(app_input_t *input) {
     commons_gcdb_updater_update(&input->gcdb_updater);
 }
 
 void app_input_deinit_gamepad_mapping(app_input_t *input) {
     commons_gcdb_updater_deinit(&input->gcdb_updater);
+    free(input->gcdb_cache_path);
+    input->gcdb_cache_path = NULL;
 }
 
 void app_input_copy_initial_gamepad_mapping(const app_settings_t *settings) {
@@ -52,10 +63,26 @@ void app_input_copy_initial_gamepad_mapping(const app_settings_t *settings) {
     free(builtin_path);
 }
 
+const char *app_input_prepare_gamepad_mapping(app_input_t *input, const app_settings_t *settings) {
+    char *cache_dir = path_cache();
+    char *cache_path = path_join(cache_dir, "gamecontrollerdb_cache.txt");
+    free(cache_dir);
+    if (!gamecontrollerdb_cache_update(settings->condb_path, cache_path)) {
+        free(cache_path);
+        return settings->condb_path;
+    }
+    input->gcdb_cache_path = cache_path;
+    return cache_path;
+}
+
 void app_input_reload_gamepad_mapping(app_input_t *input) {
-    int num_mapping = SDL_GameControllerAddMappingsFromRW(SDL_RWFromFile(input->gcdb_updater.path, "r"),
-                                                          SDL_TRUE);
-    commons_log_debug("Input", "Added %d gamepad mapping", num_mapping);
+    const char *mapping_file = input->gcdb_updater.path;
+    if (input->gcdb_cache_path != NULL && gamecontrollerdb_cache_update(mapping_file, input->gcdb_cache_path)) {
+        mapping_file = input->gcdb_cache_path;
+    }
+    Uint32 start = SDL_GetTicks();
+    int num_mapping = SDL_GameControllerAddMappingsFromRW(SDL_RWFromFile(mapping_file, "r"), SDL_TRUE);
+    commons_log_debug("Input", "Added %d gamepad mapping in %u ms", num_mapping, SDL_GetTicks() - start);
 }
 
 static void gcdb_updated(commons_gcdb_status_t result, void *context) {
@@ -91,4 +118,26 @@ static char *gamecontrollerdb_extra_path() {
         return NULL;
     }
     return condb;
+}
+
+static bool gamecontrollerdb_cache_update(const char *condb_path, const char *cache_path) {
+    char *condb_extra = gamecontrollerdb_extra_path();
+    // Same order as they were added before, so extra mappings override downloaded ones
+    const char *sources[] = {condb_path, condb_extra};
+    gcdb_cache_stats_t stats;
+    Uint32 start = SDL_GetTicks();
+    int ret = gcdb_cache_update(cache_path, sources, 2, GAMECONTROLLERDB_PLATFORM, &stats);
+    Uint32 elapsed = SDL_GetTicks() - start;
+    free(condb_extra);
+    if (ret < 0) {
+        return false;
+    }
+    if (ret > 0) {
+        commons_log_info("Input", "Gamepad mapping cache rebuilt in %u ms: kept %zu of %zu mappings "
+                                  "(%zu duplicates), %zu of %zu bytes", elapsed, stats.kept, stats.lines,
+                         stats.duplicates, stats.cache_bytes, stats.source_bytes);
+    } else {
+        commons_log_debug("Input", "Gamepad mapping cache is up to date, checked in %u ms", elapsed);
+    }
+    return true;
 }
\ No newline at end of file
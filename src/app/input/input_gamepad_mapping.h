@@ -9,6 +9,18 @@ void app_input_init_gamepad_mapping(app_input_t *input, executor_t *executor, co
 
 void app_input_deinit_gamepad_mapping(app_input_t *input);
 
+/**
+ * Check for a newer controller db in background. Mappings are reloaded when it's updated.
+ */
+void app_input_update_gamepad_mapping(app_input_t *input);
+
 void app_input_copy_initial_gamepad_mapping(const app_settings_t *settings);
 
+/**
+ * Update the platform filtered mapping cache.
+ *
+ * @return Mapping file SDL should load, either the cache or the full controller db
+ */
+const char *app_input_prepare_gamepad_mapping(app_input_t *input, const app_settings_t *settings);
+
 void app_input_reload_gamepad_mapping(app_input_t *input);
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "audio_decoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+
+static void decode_and_output(audio_decoder_t *decoder, const unsigned char *data, int length, int fec,
+                              audio_decoder_output_fn output, void *userdata);
+
+static bool packet_has_lbrr(const unsigned char *data, int length, bool self_delimited);
+
+static int packet_read_size(const unsigned char *data, int length, int *size);
+
+int audio_decoder_init(audio_decoder_t *decoder, const OPUS_MULTISTREAM_CONFIGURATION *config) {
+    memset(decoder, 0, sizeof(*decoder));
+    int rc;
+    decoder->decoder = opus_multistream_decoder_create(config->sampleRate, config->channelCount, config->streams,
+                                                       config->coupledStreams, config->mapping, &rc);
+    if (rc != OPUS_OK) {
+        return rc;
+    }
+    decoder->streams = config->streams;
+    decoder->frame_size = config->samplesPerFrame;
+    decoder->channels = config->channelCount;
+    decoder->pcm = calloc(decoder->frame_size, decoder->channels * sizeof(int16_t));
+    return 0;
+}
+
+void audio_decoder_deinit(audio_decoder_t *decoder) {
+    if (decoder->decoder == NULL) {
+        return;
+    }
+    if (decoder->stats.lost_frames > 0) {
+        commons_log_info("Audio", "Audio decoder: %u frames decoded, %u lost, %u concealed, %u recovered with FEC",
+                         decoder->stats.decoded_frames, decoder->stats.lost_frames, decoder->stats.concealed_frames,
+                         decoder->stats.fec_frames);
+    }
+    opus_multistream_decoder_destroy(decoder->decoder);
+    decoder->decoder = NULL;
+    free(decoder->pcm);
+    decoder->pcm = NULL;
+}
+
+void audio_decoder_feed(audio_decoder_t *decoder, const unsigned char *data, int length,
+                        audio_decoder_output_fn output, void *userdata) {
+    if (data == NULL || length <= 0) {
+        decoder->stats.lost_frames++;
+        if (decoder->pending_loss) {
+            // Two losses in a row, the previous one can't be rebuilt from FEC
+            decode_and_output(decoder, NULL, 0, 0, output, userdata);
+            decoder->stats.concealed_frames++;
+        }
+        decoder->pending_loss = true;
+        return;
+    }
+    if (decoder->pending_loss) {
+        // All streams but the last one are self-delimited. Only the first one is checked, FEC is set per encoder.
+        if (packet_has_lbrr(data, length, decoder->streams > 1)) {
+            decode_and_output(decoder, data, length, 1, output, userdata);
+            decoder->stats.fec_frames++;
+        } else {
+            decode_and_output(decoder, NULL, 0, 0, output, userdata);
+            decoder->stats.concealed_frames++;
+        }
+        decoder->pending_loss = false;
+    }
+    decode_and_output(decoder, data, length, 0, output, userdata);
+    decoder->stats.decoded_frames++;
+}
+
+int audio_decoder_frame_bytes(const audio_decoder_t *decoder) {
+    return decoder->frame_size * decoder->channels * (int) sizeof(int16_t);
+}
+
+static void decode_and_output(audio_decoder_t *decoder, const unsigned char *data, int length, int fec,
+                              audio_decoder_output_fn output, void *userdata) {
+    int samples = opus_multistream_decode(decoder->decoder, data, length, decoder->pcm, decoder->frame_size, fec);
+    if (samples < 0) {
+        decoder->stats.decode_errors++;
+        commons_log_warn("Audio", "Opus decode error: %s", opus_strerror(samples));
+        return;
+    }
+    output(decoder->pcm, samples, userdata);
+}
+
+/**
+ * Same as opus_packet_has_lbrr() of libopus 1.5, which older versions don't have. Also parses self-delimited packets
+ * (RFC 6716, Appendix B), as used for all streams of a multistream packet but the last one.
+ */
+static bool packet_has_lbrr(const unsigned char *data, int length, bool self_delimited) {
+    if (length < 1 || (data[0] & 0x80)) {
+        // CELT only packets have no LBRR frames
+        return false;
+    }
+    int pos = 1, frame_size, n;
+    switch (data[0] & 0x3) {
+        case 0:
+        case 1: {
+            int count = (data[0] & 0x3) + 1;
+            if (self_delimited) {
+                if ((n = packet_read_size(data + pos, length - pos, &frame_size)) < 0) {
+                    return false;
+                }
+                pos += n;
+            } else {
+                frame_size = (length - pos) / count;
+            }
+            break;
+        }
+        case 2: {
+            if ((n = packet_read_size(data + pos, length - pos, &frame_size)) < 0) {
+                return false;
+            }
+            pos += n;
+            if (self_delimited) {
+                int last_size;
+                if ((n = packet_read_size(data + pos, length - pos, &last_size)) < 0) {
+                    return false;
+                }
+                pos += n;
+            }
+            break;
+        }
+        default: {
+            if (pos >= length) {
+                return false;
+            }
+            int flags = data[pos++], count = flags & 0x3f, padding = 0;
+            if (count == 0) {
+                return false;
+            }
+            if (flags & 0x40) {
+                int value;
+                do {
+                    if (pos >= length) {
+                        return false;
+                    }
+                    value = data[pos++];
+                    padding += value == 255 ? 254 : value;
+                } while (value == 255);
+            }
+            int sizes = (flags & 0x80) ? count - 1 : 0;
+            if (self_delimited) {
+                sizes++;
+            }
+            frame_size = -1;
+            for (int i = 0; i < sizes; i++) {
+                int size;
+                if ((n = packet_read_size(data + pos, length - pos, &size)) < 0) {
+                    return false;
+                }
+                pos += n;
+                if (frame_size < 0) {
+                    frame_size = size;
+                }
+            }
+            if (frame_size < 0) {
+                frame_size = (length - pos - padding) / count;
+            }
+            break;
+        }
+    }
+    if (frame_size <= 0 || pos >= length) {
+        return false;
+    }
+    // LBRR flags are the first bits of the first SILK frame, one per 20 ms frame, and per channel
+    int frame_ms = opus_packet_get_samples_per_frame(data, 48000) / 48;
+    int silk_frames = frame_ms > 20 ? frame_ms / 20 : 1;
+    unsigned char first = data[pos];
+    bool lbrr = (first >> (7 - silk_frames)) & 0x1;
+    if (opus_packet_get_nb_channels(data) == 2) {
+        lbrr = lbrr || ((first >> (6 - 2 * silk_frames)) & 0x1);
+    }
+    return lbrr;
+}
+
+static int packet_read_size(const unsigned char *data, int length, int *size) {
+    if (length < 1) {
+        return -1;
+    }
+    if (data[0] < 252) {
+        *size = data[0];
+        return 1;
+    }
+    if (length < 2) {
+        return -1;
+    }
+    *size = 4 * data[1] + data[0];
+    return 2;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <Limelight.h>
+#include <opus_multistream.h>
+
+/**
+ * Opus decoder with loss concealment.
+ *
+ * moonlight-common-c detects lost packets by RTP sequence number, and reports each of them as an empty sample. A
+ * lost frame is held back until the next packet arrives, so it can be rebuilt from the in-band FEC data of that
+ * packet. If the next packet is lost as well, or carries no FEC (LBRR) data, packet loss concealment is used.
+ */
+typedef struct audio_decoder_t {
+    OpusMSDecoder *decoder;
+    int streams;
+    int frame_size;
+    int channels;
+    int16_t *pcm;
+    /* A lost frame waiting for the next packet */
+    bool pending_loss;
+    struct {
+        uint32_t decoded_frames;
+        uint32_t lost_frames;
+        /* Lost frames filled with packet loss concealment */
+        uint32_t concealed_frames;
+        /* Lost frames rebuilt from FEC data of the next packet */
+        uint32_t fec_frames;
+        uint32_t decode_errors;
+    } stats;
+} audio_decoder_t;
+
+typedef void (*audio_decoder_output_fn)(const int16_t *pcm, int samples, void *userdata);
+
+int audio_decoder_init(audio_decoder_t *decoder, const OPUS_MULTISTREAM_CONFIGURATION *config);
+
+void audio_decoder_deinit(audio_decoder_t *decoder);
+
+/**
+ * Decode one packet, and write decoded frames to output.
+ *
+ * @param data Packet data, or NULL if the packet was lost
+ */
+void audio_decoder_feed(audio_decoder_t *decoder, const unsigned char *data, int length,
+                        audio_decoder_output_fn output, void *userdata);
+
+/**
+ * Frame size in bytes
+ */
+int audio_decoder_frame_bytes(const audio_decoder_t *decoder);
@@ -0,0 +1,211 @@
+#include "audio_jitter_buffer.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JB_CAPACITY 64
+#define JB_MIN_TARGET 1
+#define JB_MAX_TARGET 40
+#define JB_INITIAL_TARGET 2
+/* Windows without underrun before target is lowered */
+#define JB_CLEAN_WINDOWS 10
+
+static int16_t *frame_at(audio_jitter_buffer_t *buffer, int index);
+
+static int output_silence(audio_jitter_buffer_t *buffer, int16_t *out);
+
+static void window_end(audio_jitter_buffer_t *buffer, uint64_t now_us);
+
+static void window_reset(audio_jitter_buffer_t *buffer, uint64_t now_us);
+
+static void stretch(const int16_t *in, int in_samples, int16_t *out, int out_samples, int channels);
+
+int audio_jitter_buffer_init(audio_jitter_buffer_t *buffer, int sample_rate, int channels, int frame_size) {
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->frames = calloc(JB_CAPACITY * frame_size * channels, sizeof(int16_t));
+    buffer->frame_samples = calloc(JB_CAPACITY, sizeof(int));
+    if (buffer->frames == NULL || buffer->frame_samples == NULL) {
+        audio_jitter_buffer_deinit(buffer);
+        return ENOMEM;
+    }
+    buffer->lock = SDL_CreateMutex();
+    buffer->sample_rate = sample_rate;
+    buffer->channels = channels;
+    buffer->frame_size = frame_size;
+    buffer->capacity = JB_CAPACITY;
+    buffer->target = JB_INITIAL_TARGET;
+    buffer->buffering = true;
+    buffer->window.min_level = INT_MAX;
+    return 0;
+}
+
+void audio_jitter_buffer_deinit(audio_jitter_buffer_t *buffer) {
+    if (buffer->lock != NULL) {
+        SDL_DestroyMutex(buffer->lock);
+        buffer->lock = NULL;
+    }
+    free(buffer->frames);
+    buffer->frames = NULL;
+    free(buffer->frame_samples);
+    buffer->frame_samples = NULL;
+}
+
+void audio_jitter_buffer_push(audio_jitter_buffer_t *buffer, const int16_t *pcm, int samples, uint64_t now_us) {
+    if (samples <= 0) {
+        return;
+    }
+    if (samples > buffer->frame_size) {
+        samples = buffer->frame_size;
+    }
+    SDL_LockMutex(buffer->lock);
+    if (buffer->count == buffer->capacity) {
+        // Drop the oldest frame, latency is already way too high
+        buffer->head = (buffer->head + 1) % buffer->capacity;
+        buffer->count--;
+        buffer->stats.overflows++;
+    }
+    int index = (buffer->head + buffer->count) % buffer->capacity;
+    memcpy(frame_at(buffer, index), pcm, samples * buffer->channels * sizeof(int16_t));
+    buffer->frame_samples[index] = samples;
+    buffer->count++;
+    if (buffer->window.start_us == 0) {
+        window_reset(buffer, now_us);
+    }
+    buffer->window.pushed_samples += samples;
+    SDL_UnlockMutex(buffer->lock);
+}
+
+int audio_jitter_buffer_pull(audio_jitter_buffer_t *buffer, int16_t *out, uint64_t now_us) {
+    SDL_LockMutex(buffer->lock);
+    if (buffer->buffering) {
+        if (buffer->count <= buffer->target) {
+            int samples = output_silence(buffer, out);
+            SDL_UnlockMutex(buffer->lock);
+            return samples;
+        }
+        buffer->buffering = false;
+    }
+    if (buffer->count == 0) {
+        buffer->stats.underruns++;
+        if (buffer->target < JB_MAX_TARGET) {
+            buffer->target++;
+        }
+        buffer->buffering = true;
+        buffer->pending_adjust = 0;
+        buffer->window.clean_windows = 0;
+        buffer->window.min_level = INT_MAX;
+        buffer->window.pulls = 0;
+        int samples = output_silence(buffer, out);
+        SDL_UnlockMutex(buffer->lock);
+        return samples;
+    }
+    const int16_t *frame = frame_at(buffer, buffer->head);
+    int in_samples = buffer->frame_samples[buffer->head];
+    buffer->head = (buffer->head + 1) % buffer->capacity;
+    buffer->count--;
+    if (buffer->count < buffer->window.min_level) {
+        buffer->window.min_level = buffer->count;
+    }
+
+    int out_samples = in_samples;
+    if (buffer->pending_adjust != 0) {
+        int max_step = buffer->frame_size / 32;
+        int step = buffer->pending_adjust > 0 ? SDL_min(buffer->pending_adjust, max_step)
+                                              : SDL_max(buffer->pending_adjust, -max_step);
+        out_samples += step;
+        buffer->pending_adjust -= step;
+        buffer->stats.stretched_frames++;
+    }
+    if (out_samples == in_samples) {
+        memcpy(out, frame, in_samples * buffer->channels * sizeof(int16_t));
+    } else {
+        stretch(frame, in_samples, out, out_samples, buffer->channels);
+    }
+
+    if (++buffer->window.pulls >= buffer->sample_rate / buffer->frame_size) {
+        window_end(buffer, now_us);
+    }
+    SDL_UnlockMutex(buffer->lock);
+    return out_samples;
+}
+
+float audio_jitter_buffer_queued_ms(audio_jitter_buffer_t *buffer) {
+    SDL_LockMutex(buffer->lock);
+    int samples = 0;
+    for (int i = 0; i < buffer->count; i++) {
+        samples += buffer->frame_samples[(buffer->head + i) % buffer->capacity];
+    }
+    SDL_UnlockMutex(buffer->lock);
+    return (float) samples * 1000.0f / (float) buffer->sample_rate;
+}
+
+float audio_jitter_buffer_target_ms(audio_jitter_buffer_t *buffer) {
+    SDL_LockMutex(buffer->lock);
+    int target = buffer->target;
+    SDL_UnlockMutex(buffer->lock);
+    return (float) (target * buffer->frame_size) * 1000.0f / (float) buffer->sample_rate;
+}
+
+void audio_jitter_buffer_get_stats(audio_jitter_buffer_t *buffer, audio_jitter_buffer_stats_t *stats) {
+    SDL_LockMutex(buffer->lock);
+    *stats = buffer->stats;
+    SDL_UnlockMutex(buffer->lock);
+}
+
+static int16_t *frame_at(audio_jitter_buffer_t *buffer, int index) {
+    return &buffer->frames[index * buffer->frame_size * buffer->channels];
+}
+
+static int output_silence(audio_jitter_buffer_t *buffer, int16_t *out) {
+    memset(out, 0, buffer->frame_size * buffer->channels * sizeof(int16_t));
+    return buffer->frame_size;
+}
+
+static void window_end(audio_jitter_buffer_t *buffer, uint64_t now_us) {
+    // Keep the lowest queue level of the window at target. Anything above it is latency we don't need, anything below
+    // it means we came close to underrun.
+    int error = buffer->window.min_level - buffer->target;
+    buffer->pending_adjust = -error * buffer->frame_size;
+
+    if (++buffer->window.clean_windows >= JB_CLEAN_WINDOWS && buffer->target > JB_MIN_TARGET) {
+        buffer->target--;
+        buffer->window.clean_windows = 0;
+    }
+
+    uint64_t elapsed_us = now_us - buffer->window.start_us;
+    if (elapsed_us > 0) {
+        double arrival_rate = (double) buffer->window.pushed_samples * 1000000.0 / (double) elapsed_us;
+        float ppm = (float) ((arrival_rate / buffer->sample_rate - 1.0) * 1000000.0);
+        // Arrival of a single window is noisy, smooth it over time
+        buffer->stats.drift_ppm = buffer->stats.drift_ppm * 0.95f + ppm * 0.05f;
+    }
+    window_reset(buffer, now_us);
+}
+
+static void window_reset(audio_jitter_buffer_t *buffer, uint64_t now_us) {
+    buffer->window.min_level = INT_MAX;
+    buffer->window.pulls = 0;
+    buffer->window.start_us = now_us;
+    buffer->window.pushed_samples = 0;
+}
+
+static void stretch(const int16_t *in, int in_samples, int16_t *out, int out_samples, int channels) {
+    if (in_samples == 1 || out_samples == 1) {
+        for (int i = 0; i < out_samples; i++) {
+            memcpy(&out[i * channels], in, channels * sizeof(int16_t));
+        }
+        return;
+    }
+    // Linear interpolation, good enough for a couple of percent of stretch
+    for (int i = 0; i < out_samples; i++) {
+        int64_t pos = (int64_t) i * (in_samples - 1) * 65536 / (out_samples - 1);
+        int index = (int) (pos >> 16), frac = (int) (pos & 0xFFFF);
+        int next = index + 1 < in_samples ? index + 1 : index;
+        for (int ch = 0; ch < channels; ch++) {
+            int a = in[index * channels + ch], b = in[next * channels + ch];
+            out[i * channels + ch] = (int16_t) (a + (((b - a) * frac) >> 16));
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL_mutex.h>
+
+typedef struct audio_jitter_buffer_stats_t {
+    uint32_t underruns;
+    uint32_t overflows;
+    uint32_t stretched_frames;
+    /* Clock drift of the incoming stream, positive when host sends faster than nominal rate */
+    float drift_ppm;
+} audio_jitter_buffer_stats_t;
+
+/**
+ * Adaptive jitter buffer for decoded PCM frames.
+ *
+ * Network thread pushes decoded frames, and playout pulls one frame every time the previous output has been played.
+ * The buffer aims for the smallest queue that doesn't underrun: the target grows by one frame on underrun, and
+ * shrinks after a while without underruns. When the queue stays above target, frames are time-compressed a little
+ * until the excess is gone, which also absorbs clock drift between host and client.
+ */
+typedef struct audio_jitter_buffer_t {
+    SDL_mutex *lock;
+    int sample_rate;
+    int channels;
+    int frame_size;
+    int capacity;
+    int16_t *frames;
+    int *frame_samples;
+    int head, count;
+    /* Output silence until the queue refills to target */
+    bool buffering;
+    int target;
+    /* Samples to add (positive) or remove (negative) from output with time-stretch */
+    int pending_adjust;
+    struct {
+        int min_level;
+        int pulls;
+        int clean_windows;
+        uint64_t start_us;
+        uint64_t pushed_samples;
+    } window;
+    audio_jitter_buffer_stats_t stats;
+} audio_jitter_buffer_t;
+
+int audio_jitter_buffer_init(audio_jitter_buffer_t *buffer, int sample_rate, int channels, int frame_size);
+
+void audio_jitter_buffer_deinit(audio_jitter_buffer_t *buffer);
+
+void audio_jitter_buffer_push(audio_jitter_buffer_t *buffer, const int16_t *pcm, int samples, uint64_t now_us);
+
+/**
+ * Pull next output frame.
+ *
+ * @param out Buffer large enough for (frame_size + frame_size / 16) samples of all channels
+ * @return Number of samples written to out. Playout should pull again after this many samples have been played.
+ */
+int audio_jitter_buffer_pull(audio_jitter_buffer_t *buffer, int16_t *out, uint64_t now_us);
+
+/**
+ * @return Audio currently queued, in milliseconds
+ */
+float audio_jitter_buffer_queued_ms(audio_jitter_buffer_t *buffer);
+
+float audio_jitter_buffer_target_ms(audio_jitter_buffer_t *buffer);
+
+/**
+ * Copy statistics while playout may still be pulling from another thread.
+ */
+void audio_jitter_buffer_get_stats(audio_jitter_buffer_t *buffer, audio_jitter_buffer_stats_t *stats);
@@ -7,24 +7,41 @@
 #include "stream/connection/session_connection.h"
 #include "stream/session_priv.h"
 #include "logging.h"
+#include "audio_decoder.h"
+#include "audio_jitter_buffer.h"
+#include "util/perf_counter.h"
 
 #define SAMPLES_PER_FRAME  240
+/* Give up catching up with the playout schedule if we're late by this much */
+#define PLAYOUT_MAX_LATE_US 100000
+/* Frames kept fed ahead of the playout clock, so the backend never drains between two wakeups */
+#define PLAYOUT_LEAD_FRAMES 2
 
 static session_t *session = NULL;
 static SS4S_Player *player = NULL;
-static OpusMSDecoder *decoder = NULL;
+static audio_decoder_t decoder;
+static bool use_decoder = false;
+static audio_jitter_buffer_t jitter_buffer;
+static SDL_Thread *playout_thread = NULL;
+static SDL_atomic_t playout_running;
+static SDL_sem *playout_wake = NULL;
 static unsigned char *buffer = NULL;
-static int frame_size = 0, unit_size = 0;
 
 AUDIO_INFO audio_stream_info;
+AUDIO_STATS audio_summary_stats;
 
 static size_t opus_head_serialize(const OPUS_MULTISTREAM_CONFIGURATION *config, unsigned char *data);
 
+static void aud_feed_decoded(const int16_t *pcm, int samples, void *userdata);
+
+static int aud_playout_worker(void *arg);
+
 static int aud_init(int audioConfiguration, const POPUS_MULTISTREAM_CONFIGURATION opusConfig, void *context,
                     int arFlags) {
     (void) audioConfiguration;
     (void) arFlags;
     memset(&audio_stream_info, 0, sizeof(audio_stream_info));
+    memset(&audio_summary_stats, 0, sizeof(audio_summary_stats));
     session = context;
     player = session->player;
     SS4S_AudioCodec codec = SS4S_AUDIO_PCM_S16LE;
@@ -38,36 +55,59 @@ static int aud_init(int audioConfiguration, const POPUS_MULTISTREAM_CONFIGURATIO
     };
     if (session->audio_cap.codecs & SS4S_AUDIO_OPUS && SS4S_GetAudioPreferredCodecs(&info) & SS4S_AUDIO_OPUS) {
         codec = SS4S_AUDIO_OPUS;
-        decoder = NULL;
+        use_decoder = false;
         buffer = calloc(1024, sizeof(unsigned char));
         assert(buffer != NULL);
         codecDataLen = opus_head_serialize(opusConfig, buffer);
     } else {
-        int rc;
-        decoder = opus_multistream_decoder_create(opusConfig->sampleRate, opusConfig->channelCount, opusConfig->streams,
-                                                  opusConfig->coupledStreams, opusConfig->mapping, &rc);
+        int rc = audio_decoder_init(&decoder, opusConfig);
+        if (rc != 0) {
+            return rc;
+        }
+        rc = audio_jitter_buffer_init(&jitter_buffer, opusConfig->sampleRate, opusConfig->channelCount,
+                                      decoder.frame_size);
         if (rc != 0) {
+            audio_decoder_deinit(&decoder);
             return rc;
         }
-        frame_size = opusConfig->samplesPerFrame;
-        unit_size = (int) (opusConfig->channelCount * sizeof(int16_t));
-        buffer = calloc(unit_size, frame_size);
+        use_decoder = true;
     }
     audio_stream_info.format = SS4S_AudioCodecName(codec);
     info.codec = codec;
     info.codecData = buffer;
     info.codecDataLen = codecDataLen;
-    return SS4S_PlayerAudioOpen(player, &info);
+    int open_span = session_profile_begin(&session->profile, "Open audio");
+    int ret = SS4S_PlayerAudioOpen(player, &info);
+    session_profile_end(&session->profile, open_span);
+    if (ret == 0 && use_decoder) {
+        SDL_AtomicSet(&playout_running, 1);
+        playout_wake = SDL_CreateSemaphore(0);
+        playout_thread = SDL_CreateThread(aud_playout_worker, "audio_playout", NULL);
+    }
+    return ret;
 }
 
 static void aud_cleanup() {
+    if (playout_thread != NULL) {
+        SDL_AtomicSet(&playout_running, 0);
+        SDL_SemPost(playout_wake);
+        SDL_WaitThread(playout_thread, NULL);
+        playout_thread = NULL;
+        SDL_DestroySemaphore(playout_wake);
+        playout_wake = NULL;
+    }
     if (player != NULL) {
         SS4S_PlayerAudioClose(player);
         player = NULL;
     }
-    if (decoder != NULL) {
-        opus_multistream_decoder_destroy(decoder);
-        decoder = NULL;
+    if (use_decoder) {
+        audio_jitter_buffer_stats_t stats;
+        audio_jitter_buffer_get_stats(&jitter_buffer, &stats);
+        commons_log_info("Audio", "Jitter buffer: %u underruns, %u overflows, %u stretched frames, drift %.0f ppm",
+                         stats.underruns, stats.overflows, stats.stretched_frames, stats.drift_ppm);
+        audio_jitter_buffer_deinit(&jitter_buffer);
+        audio_decoder_deinit(&decoder);
+        use_decoder = false;
     }
     if (buffer != NULL) {
         free(buffer);
@@ -77,15 +117,89 @@ static void aud_cleanup() {
 }
 
 static void aud_feed(char *sampleData, int sampleLength) {
-    if (decoder != NULL) {
-        int decode_len = opus_multistream_decode(decoder, (unsigned char *) sampleData, sampleLength,
-                                                 (opus_int16 *) buffer, frame_size, 0);
-        SS4S_PlayerAudioFeed(player, buffer, unit_size * decode_len);
+    if (use_decoder) {
+        audio_decoder_feed(&decoder, (const unsigned char *) sampleData, sampleLength, aud_feed_decoded, NULL);
+        audio_summary_stats.lostFrames = decoder.stats.lost_frames;
+        audio_summary_stats.concealedFrames = decoder.stats.concealed_frames;
+        audio_summary_stats.fecFrames = decoder.stats.fec_frames;
+        audio_summary_stats.queuedMs = audio_jitter_buffer_queued_ms(&jitter_buffer);
+        audio_summary_stats.targetMs = audio_jitter_buffer_target_ms(&jitter_buffer);
+        audio_jitter_buffer_stats_t stats;
+        audio_jitter_buffer_get_stats(&jitter_buffer, &stats);
+        audio_summary_stats.underruns = stats.underruns;
+        audio_summary_stats.driftPpm = stats.drift_ppm;
+    } else if (sampleData == NULL || sampleLength <= 0) {
+        // Backend decodes Opus by itself, and there is no way to ask it to conceal the lost frame
+        audio_summary_stats.lostFrames++;
     } else {
         SS4S_PlayerAudioFeed(player, (unsigned char *) sampleData, sampleLength);
     }
 }
 
+static void aud_feed_decoded(const int16_t *pcm, int samples, void *userdata) {
+    (void) userdata;
+    audio_jitter_buffer_push(&jitter_buffer, pcm, samples, perf_counter_now_us());
+}
+
+/**
+ * Pulls frames from jitter buffer at the pace the audio device consumes them, so network jitter doesn't reach it.
+ *
+ * SS4S has neither a pull callback nor a queued-bytes query for audio, so device consumption is observed through the
+ * feed call instead. The schedule starts on the performance counter, keeping the backend PLAYOUT_LEAD_FRAMES ahead.
+ * Whenever the backend pushes back, by blocking until the device has made room or by refusing a frame, the time it
+ * held us back is time the device didn't play, and the schedule moves by that much. A device running slower than the
+ * counter therefore paces the pulls, instead of having its queue grow.
+ */
+static int aud_playout_worker(void *arg) {
+    (void) arg;
+    int frame_size = jitter_buffer.frame_size, channels = jitter_buffer.channels;
+    int sample_rate = jitter_buffer.sample_rate;
+    int16_t *pcm = calloc((frame_size + frame_size / 16) * channels, sizeof(int16_t));
+    assert(pcm != NULL);
+    uint64_t frame_us = (uint64_t) frame_size * 1000000 / sample_rate;
+    uint64_t start_us = perf_counter_now_us(), fed_samples = 0;
+    // Frame the backend refused last time, fed again before pulling a new one
+    int held_samples = 0;
+    while (SDL_AtomicGet(&playout_running)) {
+        uint64_t now_us = perf_counter_now_us();
+        uint64_t played_samples = now_us > start_us ? (now_us - start_us) * sample_rate / 1000000 : 0;
+        uint64_t lead_samples = (uint64_t) PLAYOUT_LEAD_FRAMES * frame_size;
+        if (fed_samples > played_samples + lead_samples) {
+            uint64_t wait_samples = fed_samples - played_samples - lead_samples;
+            // Round up, waking early would only spin until the next frame is due
+            Uint32 wait_ms = (Uint32) ((wait_samples * 1000 + sample_rate - 1) / sample_rate);
+            SDL_SemWaitTimeout(playout_wake, wait_ms);
+            continue;
+        }
+        if (played_samples > fed_samples + (uint64_t) PLAYOUT_MAX_LATE_US * sample_rate / 1000000) {
+            // Backend has been starved for a while, restart the schedule instead of bursting to catch up
+            start_us = now_us;
+            fed_samples = 0;
+        }
+        int samples = held_samples;
+        if (samples == 0) {
+            samples = audio_jitter_buffer_pull(&jitter_buffer, pcm, now_us);
+        }
+        SS4S_AudioFeedResult result = SS4S_PlayerAudioFeed(player, (const unsigned char *) pcm,
+                                                           samples * channels * (int) sizeof(int16_t));
+        if (result == SS4S_AUDIO_FEED_OK) {
+            held_samples = 0;
+            fed_samples += samples;
+        } else {
+            // Device has no room for it yet, give it one frame to play some out
+            held_samples = samples;
+            SDL_SemWaitTimeout(playout_wake, (Uint32) ((frame_us + 999) / 1000));
+        }
+        uint64_t held_back_us = perf_counter_now_us() - now_us;
+        if (held_samples != 0 || held_back_us > frame_us / 2) {
+            // The device wasn't consuming while we waited on it, follow its pace rather than the counter's
+            start_us += held_back_us;
+        }
+    }
+    free(pcm);
+    return 0;
+}
+
 static size_t opus_head_serialize(const OPUS_MULTISTREAM_CONFIGURATION *config, unsigned char *data) {
     unsigned char *ptr = data;
     // 1. Magic Signature:
@@ -8,6 +8,7 @@
 #include "stream/session_priv.h"
 
 static session_t *current_session = NULL;
+static int stage_spans[STAGE_MAX];
 
 static void connection_terminated(int errorCode) {
     if (errorCode == ML_ERROR_GRACEFUL_TERMINATION) {
@@ -41,6 +42,18 @@ static void connection_status_update(int status) {
     }
 }
 
+static void connection_stage_starting(int stage) {
+    stage_spans[stage] = session_profile_begin(&current_session->profile, LiGetStageName(stage));
+}
+
+static void connection_stage_complete(int stage) {
+    session_profile_end(&current_session->profile, stage_spans[stage]);
+}
+
+static void connection_started() {
+    session_profile_mark(&current_session->profile, "Connection started");
+}
+
 static void connection_stage_failed(int stage, int errorCode) {
     const char *stageName = LiGetStageName(stage);
     commons_log_error("Session", "Connection failed at stage %d (%s), errorCode = %d (%s)", stage, stageName, errorCode,
@@ -72,10 +85,10 @@ static void connection_set_hdr(bool hdrEnabled) {
 }
 
 CONNECTION_LISTENER_CALLBACKS connection_callbacks = {
-        .stageStarting = NULL,
-        .stageComplete = NULL,
+        .stageStarting = connection_stage_starting,
+        .stageComplete = connection_stage_complete,
         .stageFailed = connection_stage_failed,
-        .connectionStarted = NULL,
+        .connectionStarted = connection_started,
         .connectionTerminated = connection_terminated,
         .logMessage = connection_log_message,
         .rumble = connection_rumble,
@@ -89,6 +102,9 @@ CONNECTION_LISTENER_CALLBACKS connection_callbacks = {
 
 CONNECTION_LISTENER_CALLBACKS *session_connection_callbacks_prepare(session_t *session) {
     current_session = session;
+    for (int i = 0; i < STAGE_MAX; i++) {
+        stage_spans[i] = -1;
+    }
     return &connection_callbacks;
 }
 
@@ -20,6 +20,10 @@
 #include "stream/session.h"
 #include "stream/session_priv.h"
 #include "session_evmouse.h"
+#include "session_virt_mouse.h"
+#include "session_input_record.h"
+
+#include "logging.h"
 
 void session_input_init(stream_input_t *input, session_t *session, app_input_t *app_input,
                         const session_config_t *config) {
@@ -28,6 +32,16 @@ void session_input_init(stream_input_t *input, session_t *session, app_input_t *
     input->view_only = config->view_only;
     input->stick_deadzone = config->stick_deadzone;
     input->no_sdl_mouse = config->hardware_mouse;
+    session_input_vmouse_init(&input->vmouse, config->vmouse_speed, config->vmouse_accel);
+    input->keys_lock = SDL_CreateMutex();
+    session_input_keys_reset(&input->keys);
+    const char *record_path = SDL_getenv("MOONLIGHT_INPUT_RECORD");
+    if (record_path != NULL && record_path[0] != '\0') {
+        input->recorder = session_input_recorder_open(record_path);
+        if (input->recorder == NULL) {
+            commons_log_warn("Input", "Failed to open input recording %s", record_path);
+        }
+    }
 #if FEATURE_INPUT_EVMOUSE
     if (!config->view_only && config->hardware_mouse) {
         session_evmouse_init(&input->evmouse, session);
@@ -36,6 +50,12 @@ void session_input_init(stream_input_t *input, session_t *session, app_input_t *
 }
 
 void session_input_deinit(stream_input_t *input) {
+    session_input_vmouse_deinit(&input->vmouse);
+    SDL_DestroyMutex(input->keys_lock);
+    if (input->recorder != NULL) {
+        session_input_recorder_close(input->recorder);
+        input->recorder = NULL;
+    }
 #if FEATURE_INPUT_EVMOUSE
     const session_config_t *config = &input->session->config;
     if (!config->view_only && config->hardware_mouse) {
@@ -45,6 +65,7 @@ void session_input_deinit(stream_input_t *input) {
 }
 
 void session_input_interrupt(stream_input_t *input) {
+    stream_input_release_keys(input);
 #if FEATURE_INPUT_EVMOUSE
     const session_config_t *config = &input->session->config;
     if (!config->view_only && config->hardware_mouse) {
@@ -84,4 +105,66 @@ void session_input_screen_keyboard_closed(stream_input_t *input) {
         session_evmouse_enable(&input->evmouse);
     }
 #endif
-}
\ No newline at end of file
+}
+
+stream_input_handler_t stream_input_dispatch_event(stream_input_t *input, const SDL_Event *event) {
+    switch (event->type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP: {
+            stream_input_handle_key(input, &event->key);
+            return STREAM_INPUT_HANDLER_KEY;
+        }
+        case SDL_CONTROLLERAXISMOTION: {
+            stream_input_handle_caxis(input, &event->caxis);
+            return STREAM_INPUT_HANDLER_CAXIS;
+        }
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP: {
+            stream_input_handle_cbutton(input, &event->cbutton);
+            return STREAM_INPUT_HANDLER_CBUTTON;
+        }
+        case SDL_CONTROLLERSENSORUPDATE: {
+            stream_input_handle_csensor(input, &event->csensor);
+            return STREAM_INPUT_HANDLER_CSENSOR;
+        }
+        case SDL_CONTROLLERTOUCHPADDOWN:
+        case SDL_CONTROLLERTOUCHPADMOTION:
+        case SDL_CONTROLLERTOUCHPADUP: {
+            stream_input_handle_ctouchpad(input, &event->ctouchpad);
+            return STREAM_INPUT_HANDLER_CTOUCHPAD;
+        }
+        case SDL_CONTROLLERDEVICEADDED: {
+            stream_input_handle_cdevice(input, &event->cdevice);
+            return STREAM_INPUT_HANDLER_CDEVICE;
+        }
+        case SDL_MOUSEMOTION: {
+            stream_input_handle_mmotion(input, &event->motion, false);
+            return STREAM_INPUT_HANDLER_MMOTION;
+        }
+        case SDL_MOUSEWHEEL: {
+            if (!input->view_only && !input->no_sdl_mouse) {
+                stream_input_handle_mwheel(input, &event->wheel);
+            }
+            return STREAM_INPUT_HANDLER_MWHEEL;
+        }
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP: {
+            if (!input->view_only && !input->no_sdl_mouse) {
+                stream_input_handle_mbutton(input, &event->button);
+            }
+            return STREAM_INPUT_HANDLER_MBUTTON;
+        }
+        case SDL_TEXTINPUT: {
+            stream_input_handle_text(input, &event->text);
+            return STREAM_INPUT_HANDLER_TEXT;
+        }
+        case SDL_FINGERDOWN:
+        case SDL_FINGERUP:
+        case SDL_FINGERMOTION: {
+            stream_input_handle_touch(input, &event->tfinger);
+            return STREAM_INPUT_HANDLER_TOUCH;
+        }
+        default:
+            return STREAM_INPUT_HANDLER_NONE;
+    }
+}
@@ -3,10 +3,12 @@
 #include <stdbool.h>
 #include <Limelight.h>
 #include <SDL_events.h>
+#include <SDL_mutex.h>
 #include <SDL_timer.h>
 
 #include "config.h"
 #include "input/input_gamepad.h"
+#include "session_keys.h"
 
 #if FEATURE_INPUT_EVMOUSE
 
@@ -15,19 +17,55 @@
 #endif
 
 typedef struct app_input_t app_input_t;
+typedef struct session_input_recorder_t session_input_recorder_t;
 typedef struct session_config_t session_config_t;
 typedef struct session_t session_t;
 
 typedef struct session_input_vmouse_t {
     struct {
         bool active;
-        short x, y;
+        /* Stick vector after the acceleration curve, in range [-1, 1] */
+        float x, y;
         bool l, r;
         bool modifier;
     } state;
+    struct {
+        float speed;
+        float accel;
+    } curve;
+    /* Sub-pixel (and sub-unit scroll) movement not sent yet */
+    struct {
+        double x, y;
+        double scroll_x, scroll_y;
+    } remainder;
+    struct {
+        uint32_t ticks;
+        uint32_t motion_events;
+        uint32_t scroll_events;
+        Uint64 tick_time;
+        Uint64 active_since;
+        Uint64 active_time;
+    } stats;
+    Uint64 last_tick;
     SDL_TimerID timer_id;
 } session_input_vmouse_t;
 
+typedef enum stream_input_handler_t {
+    STREAM_INPUT_HANDLER_KEY,
+    STREAM_INPUT_HANDLER_TEXT,
+    STREAM_INPUT_HANDLER_CBUTTON,
+    STREAM_INPUT_HANDLER_CAXIS,
+    STREAM_INPUT_HANDLER_CSENSOR,
+    STREAM_INPUT_HANDLER_CTOUCHPAD,
+    STREAM_INPUT_HANDLER_CDEVICE,
+    STREAM_INPUT_HANDLER_MMOTION,
+    STREAM_INPUT_HANDLER_MWHEEL,
+    STREAM_INPUT_HANDLER_MBUTTON,
+    STREAM_INPUT_HANDLER_TOUCH,
+    STREAM_INPUT_HANDLER_COUNT,
+    STREAM_INPUT_HANDLER_NONE = -1,
+} stream_input_handler_t;
+
 typedef struct stream_input_t {
     session_t *session;
     app_input_t *input;
@@ -35,9 +73,14 @@ typedef struct stream_input_t {
     bool view_only, no_sdl_mouse;
     uint8_t stick_deadzone;
     session_input_vmouse_t vmouse;
+    /* Keys are released by session_interrupt(), which may run on connection or decoder threads */
+    SDL_mutex *keys_lock;
+    session_input_keys_t keys;
 #if FEATURE_INPUT_EVMOUSE
     session_evmouse_t evmouse;
 #endif
+    /* Non-null when input recording was requested with MOONLIGHT_INPUT_RECORD */
+    session_input_recorder_t *recorder;
 } stream_input_t;
 
 void session_input_init(stream_input_t *input, session_t *session, app_input_t *app_input,
@@ -55,10 +98,21 @@ void session_input_screen_keyboard_opened(stream_input_t *input);
 
 void session_input_screen_keyboard_closed(stream_input_t *input);
 
+/**
+ * Pass the event to the matching stream_input_handle_* function.
+ * @return Handler the event was passed to, or STREAM_INPUT_HANDLER_NONE if the event is not for streaming
+ */
+stream_input_handler_t stream_input_dispatch_event(stream_input_t *input, const SDL_Event *event);
+
 void stream_input_send_gamepad_arrive(const stream_input_t *input, app_gamepad_state_t *gamepad);
 
 void stream_input_handle_key(stream_input_t *input, const SDL_KeyboardEvent *event);
 
+/**
+ * Send key up events for all keys still held down, so they won't get stuck on the host.
+ */
+void stream_input_release_keys(stream_input_t *input);
+
 void stream_input_handle_text(stream_input_t *input, const SDL_TextInputEvent *event);
 
 void stream_input_handle_cbutton(stream_input_t *input, const SDL_ControllerButtonEvent *event);
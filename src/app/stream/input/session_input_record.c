@@ -0,0 +1,263 @@
+#include "session_input_record.h"
+#include "input/app_input.h"
+#include "util/perf_counter.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "logging.h"
+
+#define RECORD_MAGIC "MLIR"
+#define RECORD_VERSION 2
+
+struct session_input_recorder_t {
+    FILE *fp;
+    Uint64 last_counter;
+    uint32_t events;
+};
+
+typedef struct record_header_t {
+    uint32_t delta_us;
+    uint32_t type;
+    uint16_t size;
+} record_header_t;
+
+static size_t event_payload_size(uint32_t type);
+
+static bool event_is_controller(uint32_t type);
+
+static void replay_attach_gamepad(app_input_t *input, SDL_JoystickID instance_id);
+
+static uint64_t thread_cpu_ns();
+
+static bool write_header(FILE *fp, const record_header_t *header);
+
+static bool read_header(FILE *fp, record_header_t *header);
+
+static const char *handler_names[STREAM_INPUT_HANDLER_COUNT] = {
+        "key", "text", "cbutton", "caxis", "csensor", "ctouchpad", "cdevice", "mmotion", "mwheel", "mbutton", "touch",
+};
+
+session_input_recorder_t *session_input_recorder_open(const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    const uint8_t header[8] = {RECORD_MAGIC[0], RECORD_MAGIC[1], RECORD_MAGIC[2], RECORD_MAGIC[3], RECORD_VERSION};
+    if (fwrite(header, sizeof(header), 1, fp) != 1) {
+        fclose(fp);
+        return NULL;
+    }
+    session_input_recorder_t *recorder = SDL_calloc(1, sizeof(session_input_recorder_t));
+    recorder->fp = fp;
+    recorder->last_counter = SDL_GetPerformanceCounter();
+    commons_log_info("Input", "Recording input events to %s", path);
+    return recorder;
+}
+
+void session_input_recorder_write(session_input_recorder_t *recorder, const SDL_Event *event) {
+    size_t size = event_payload_size(event->type);
+    if (size == 0) {
+        return;
+    }
+    SDL_Event copy;
+    if (event->type == SDL_CONTROLLERDEVICEADDED) {
+        // Device index means nothing on replay, other controller events refer to the joystick instance ID
+        SDL_JoystickID instance_id = SDL_JoystickGetDeviceInstanceID(event->cdevice.which);
+        if (instance_id >= 0) {
+            copy = *event;
+            copy.cdevice.which = instance_id;
+            event = &copy;
+        }
+    }
+    Uint64 now = SDL_GetPerformanceCounter();
+    record_header_t header = {
+            .delta_us = (uint32_t) SDL_min(perf_counter_to_us(now - recorder->last_counter), UINT32_MAX),
+            .type = event->type,
+            .size = (uint16_t) size,
+    };
+    recorder->last_counter = now;
+    if (!write_header(recorder->fp, &header) || fwrite(event, size, 1, recorder->fp) != 1) {
+        commons_log_warn("Input", "Failed to write input recording: %s", strerror(errno));
+        return;
+    }
+    recorder->events++;
+}
+
+void session_input_recorder_close(session_input_recorder_t *recorder) {
+    commons_log_info("Input", "Input recording finished, %u events recorded", recorder->events);
+    fclose(recorder->fp);
+    SDL_free(recorder);
+}
+
+int session_input_replay(stream_input_t *input, const char *path, bool realtime, session_input_replay_stats_t *stats) {
+    SDL_memset(stats, 0, sizeof(*stats));
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return errno;
+    }
+    uint8_t file_header[8];
+    if (fread(file_header, sizeof(file_header), 1, fp) != 1 || memcmp(file_header, RECORD_MAGIC, 4) != 0 ||
+        file_header[4] != RECORD_VERSION) {
+        fclose(fp);
+        return EINVAL;
+    }
+    int ret = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    uint64_t scheduled_us = 0;
+    record_header_t header;
+    while (read_header(fp, &header)) {
+        SDL_Event event;
+        SDL_zero(event);
+        if (header.size > sizeof(SDL_Event) || fread(&event, header.size, 1, fp) != 1) {
+            ret = EINVAL;
+            break;
+        }
+        event.type = header.type;
+        scheduled_us += header.delta_us;
+        if (realtime) {
+            uint64_t now_us = perf_counter_to_us(SDL_GetPerformanceCounter() - start);
+            if (now_us + 1000 < scheduled_us) {
+                SDL_Delay((Uint32) ((scheduled_us - now_us) / 1000));
+            }
+            while ((now_us = perf_counter_to_us(SDL_GetPerformanceCounter() - start)) < scheduled_us) {
+                // Spin for the remaining sub-millisecond part
+            }
+            uint64_t late_us = now_us - scheduled_us;
+            stats->jitter_total_us += late_us;
+            stats->jitter_max_us = SDL_max(stats->jitter_max_us, late_us);
+        }
+        if (event_is_controller(header.type)) {
+            // Recorded as instance ID for all controller events, including SDL_CONTROLLERDEVICEADDED
+            replay_attach_gamepad(input->input, event.cdevice.which);
+        }
+        uint64_t cpu_start = thread_cpu_ns();
+        stream_input_handler_t handler = stream_input_dispatch_event(input, &event);
+        uint64_t cpu_used = thread_cpu_ns() - cpu_start;
+        if (handler == STREAM_INPUT_HANDLER_NONE) {
+            stats->skipped++;
+            continue;
+        }
+        session_input_replay_handler_stats_t *handler_stats = &stats->handlers[handler];
+        handler_stats->events++;
+        handler_stats->total_ns += cpu_used;
+        handler_stats->max_ns = SDL_max(handler_stats->max_ns, cpu_used);
+        stats->events++;
+    }
+    stats->elapsed_us = perf_counter_to_us(SDL_GetPerformanceCounter() - start);
+    fclose(fp);
+    return ret;
+}
+
+void session_input_replay_stats_log(const session_input_replay_stats_t *stats) {
+    commons_log_info("Input", "Replayed %u events (%u skipped) in %.3f ms", stats->events, stats->skipped,
+                     (double) stats->elapsed_us / 1000.0);
+    for (int i = 0; i < STREAM_INPUT_HANDLER_COUNT; i++) {
+        const session_input_replay_handler_stats_t *handler = &stats->handlers[i];
+        if (handler->events == 0) {
+            continue;
+        }
+        commons_log_info("Input", "  %-10s %6u events, avg %8.2f us, max %8.2f us", handler_names[i],
+                         handler->events, (double) handler->total_ns / handler->events / 1000.0,
+                         (double) handler->max_ns / 1000.0);
+    }
+    if (stats->jitter_total_us > 0 && stats->events > 0) {
+        commons_log_info("Input", "  timing jitter avg %.2f us, max %llu us",
+                         (double) stats->jitter_total_us / stats->events, (unsigned long long) stats->jitter_max_us);
+    }
+}
+
+const char *stream_input_handler_name(stream_input_handler_t handler) {
+    if (handler < 0 || handler >= STREAM_INPUT_HANDLER_COUNT) {
+        return NULL;
+    }
+    return handler_names[handler];
+}
+
+static size_t event_payload_size(uint32_t type) {
+    switch (type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            return sizeof(SDL_KeyboardEvent);
+        case SDL_TEXTINPUT:
+            return sizeof(SDL_TextInputEvent);
+        case SDL_CONTROLLERAXISMOTION:
+            return sizeof(SDL_ControllerAxisEvent);
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP:
+            return sizeof(SDL_ControllerButtonEvent);
+        case SDL_CONTROLLERSENSORUPDATE:
+            return sizeof(SDL_ControllerSensorEvent);
+        case SDL_CONTROLLERTOUCHPADDOWN:
+        case SDL_CONTROLLERTOUCHPADMOTION:
+        case SDL_CONTROLLERTOUCHPADUP:
+            return sizeof(SDL_ControllerTouchpadEvent);
+        case SDL_CONTROLLERDEVICEADDED:
+            return sizeof(SDL_ControllerDeviceEvent);
+        case SDL_MOUSEMOTION:
+            return sizeof(SDL_MouseMotionEvent);
+        case SDL_MOUSEWHEEL:
+            return sizeof(SDL_MouseWheelEvent);
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            return sizeof(SDL_MouseButtonEvent);
+        case SDL_FINGERDOWN:
+        case SDL_FINGERUP:
+        case SDL_FINGERMOTION:
+            return sizeof(SDL_TouchFingerEvent);
+        default:
+            return 0;
+    }
+}
+
+static bool event_is_controller(uint32_t type) {
+    return type >= SDL_CONTROLLERAXISMOTION && type <= SDL_CONTROLLERSENSORUPDATE;
+}
+
+static void replay_attach_gamepad(app_input_t *input, SDL_JoystickID instance_id) {
+    if (app_input_gamepad_state_by_instance_id(input, instance_id) != NULL) {
+        return;
+    }
+    size_t index;
+    for (index = 0; index < input->max_num_gamepads; index++) {
+        if (input->gamepads[index].instance_id == -1) {
+            break;
+        }
+    }
+    if (index >= sizeof(input->gamepads) / sizeof(app_gamepad_state_t)) {
+        return;
+    }
+    if (index == input->max_num_gamepads) {
+        input->max_num_gamepads++;
+    }
+    app_gamepad_state_t *state = &input->gamepads[index];
+    SDL_memset(state, 0, sizeof(app_gamepad_state_t));
+    state->instance_id = instance_id;
+    state->gs_id = (short) index;
+    input->activeGamepadMask |= (short) (1 << index);
+    input->gamepads_count++;
+}
+
+static uint64_t thread_cpu_ns() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+#endif
+    return perf_counter_now_us() * 1000ULL;
+}
+
+static bool write_header(FILE *fp, const record_header_t *header) {
+    return fwrite(&header->delta_us, sizeof(header->delta_us), 1, fp) == 1 &&
+           fwrite(&header->type, sizeof(header->type), 1, fp) == 1 &&
+           fwrite(&header->size, sizeof(header->size), 1, fp) == 1;
+}
+
+static bool read_header(FILE *fp, record_header_t *header) {
+    return fread(&header->delta_us, sizeof(header->delta_us), 1, fp) == 1 &&
+           fread(&header->type, sizeof(header->type), 1, fp) == 1 &&
+           fread(&header->size, sizeof(header->size), 1, fp) == 1;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL_events.h>
+
+#include "session_input.h"
+
+/**
+ * Input recording file layout:
+ *
+ * Header: "MLIR", 1 byte version, 3 bytes reserved.
+ * Records: u32 microseconds since previous record, u32 SDL event type, u16 payload size, payload.
+ *
+ * Payload is the event struct matching the type, in host byte order. Recordings are meant to be replayed
+ * on the same architecture they were recorded on.
+ */
+
+typedef struct session_input_recorder_t session_input_recorder_t;
+
+typedef struct session_input_replay_handler_stats_t {
+    uint32_t events;
+    /* CPU time spent in the handler, in nanoseconds */
+    uint64_t total_ns;
+    uint64_t max_ns;
+} session_input_replay_handler_stats_t;
+
+typedef struct session_input_replay_stats_t {
+    session_input_replay_handler_stats_t handlers[STREAM_INPUT_HANDLER_COUNT];
+    uint32_t events;
+    uint32_t skipped;
+    /* Wall time of the whole replay */
+    uint64_t elapsed_us;
+    /* Lateness of each event compared to its recorded time, only available for realtime replay */
+    uint64_t jitter_total_us;
+    uint64_t jitter_max_us;
+} session_input_replay_stats_t;
+
+session_input_recorder_t *session_input_recorder_open(const char *path);
+
+void session_input_recorder_write(session_input_recorder_t *recorder, const SDL_Event *event);
+
+void session_input_recorder_close(session_input_recorder_t *recorder);
+
+/**
+ * Feed recorded events to stream_input_dispatch_event.
+ *
+ * Controller events for unknown instance IDs will get a detached gamepad slot, so gamepad handlers work without
+ * a real controller.
+ *
+ * @param realtime Keep recorded event intervals and measure timing jitter, otherwise replay as fast as possible
+ * @return 0 on success, or errno
+ */
+int session_input_replay(stream_input_t *input, const char *path, bool realtime, session_input_replay_stats_t *stats);
+
+void session_input_replay_stats_log(const session_input_replay_stats_t *stats);
+
+const char *stream_input_handler_name(stream_input_handler_t handler);
@@ -41,38 +41,15 @@ static struct SpecialKeyCombo m_SpecialKeyCombos[KeyComboMax] = {
 
 enum KeyCombo _pending_key_combo = KeyComboMax;
 
-struct KeysDown {
-    short keyCode;
-    struct KeysDown *prev;
-    struct KeysDown *next;
-};
-
-static struct KeysDown *_pressed_keys;
-
-#define LINKEDLIST_IMPL
-
-// Linked list functions for KeysDown
-#define LINKEDLIST_TYPE struct KeysDown
-#define LINKEDLIST_PREFIX keys
-#define LINKEDLIST_DOUBLE 1
-
-#include "linked_list.h"
-
-#undef LINKEDLIST_TYPE
-#undef LINKEDLIST_PREFIX
-#undef LINKEDLIST_DOUBLE
-
-static int keydown_count = 0;
-
 #if TARGET_WEBOS
 
 bool stream_input_webos_intercept_remote_keys(stream_input_t *input, const SDL_KeyboardEvent *event, short *keyCode);
 
 #endif
 
-static int keys_code_comparator(struct KeysDown *p, const void *fv) {
-    return p->keyCode - *((short *) fv);
-}
+static void release_key(short keyCode, void *userdata);
+
+static bool handle_key_locked(stream_input_t *input, const SDL_KeyboardEvent *event, short keyCode);
 
 static bool isSystemKeyCaptureActive() {
     return app_configuration->syskey_capture;
@@ -80,7 +57,7 @@ static bool isSystemKeyCaptureActive() {
 
 void performPendingSpecialKeyCombo(stream_input_t *input) {
     // The caller must ensure all keys are up
-    SDL_assert_release(keys_len(_pressed_keys) == 0);
+    SDL_assert_release(input->keys.count == 0);
 
     switch (_pending_key_combo) {
         case KeyComboQuit:
@@ -132,6 +109,31 @@ void stream_input_handle_key(stream_input_t *input, const SDL_KeyboardEvent *eve
         return;
     }
 #endif
+    // Keys can be released by session_interrupt on other threads meanwhile
+    SDL_LockMutex(input->keys_lock);
+    bool combo_ready = handle_key_locked(input, event, keyCode);
+    SDL_UnlockMutex(input->keys_lock);
+    if (!combo_ready) {
+        return;
+    }
+    int keys;
+    const Uint8 *keyState = SDL_GetKeyboardState(&keys);
+
+    // Make sure all client keys are up before we process the special key combo
+    for (int i = 0; i < keys; i++) {
+        if (keyState[i] == SDL_PRESSED) {
+            return;
+        }
+    }
+
+    // If we made it this far, no keys are pressed. Done without the lock, as it may interrupt the session.
+    performPendingSpecialKeyCombo(input);
+}
+
+/**
+ * @return true if a special key combo is pending, and all keys sent to the host are up
+ */
+static bool handle_key_locked(stream_input_t *input, const SDL_KeyboardEvent *event, short keyCode) {
     char modifiers;
 
     // Check for our special key combos
@@ -171,13 +173,13 @@ void stream_input_handle_key(stream_input_t *input, const SDL_KeyboardEvent *eve
 
     if (event->state == SDL_PRESSED && _pending_key_combo != KeyComboMax) {
         // Ignore further key presses until the special combo is raised
-        return;
+        return false;
     }
 
     if (event->repeat) {
         // Ignore repeat key down events
         SDL_assert_release(event->state == SDL_PRESSED);
-        return;
+        return false;
     }
 
     // Set modifier flags
@@ -333,13 +335,13 @@ void stream_input_handle_key(stream_input_t *input, const SDL_KeyboardEvent *eve
                 break;
             case SDL_SCANCODE_LGUI:
                 if (!isSystemKeyCaptureActive()) {
-                    return;
+                    return false;
                 }
                 keyCode = VK_LWIN;
                 break;
             case SDL_SCANCODE_RGUI:
                 if (!isSystemKeyCaptureActive()) {
-                    return;
+                    return false;
                 }
                 keyCode = VK_RWIN;
                 break;
@@ -405,54 +407,31 @@ void stream_input_handle_key(stream_input_t *input, const SDL_KeyboardEvent *eve
                     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                                 "Unhandled button event: scancode: %d, keycode: %d",
                                 event->keysym.scancode, event->keysym.sym);
-                    return;
+                    return false;
                 }
         }
     }
 
     // Track the key state, so we always know which keys are down
     if (event->state == SDL_PRESSED) {
-        struct KeysDown *node = keys_new();
-        node->keyCode = keyCode;
-        _pressed_keys = keys_append(_pressed_keys, node);
+        session_input_keys_press(&input->keys, keyCode);
     } else {
-        struct KeysDown *node = keys_find_by(_pressed_keys, &keyCode, &keys_code_comparator);
-        if (node) {
-            _pressed_keys = keys_remove(_pressed_keys, node);
-            free(node);
-        }
+        session_input_keys_release(&input->keys, keyCode);
     }
 
     if (!input->view_only) {
-        if (event->state == SDL_PRESSED) {
-            keydown_count++;
-        } else if (event->state == SDL_RELEASED) {
-            keydown_count--;
-        }
         LiSendKeyboardEvent(0x8000 | keyCode,
                             event->state == SDL_PRESSED ? KEY_ACTION_DOWN : KEY_ACTION_UP,
                             modifiers);
     }
 
-    if (_pending_key_combo != KeyComboMax && keys_len(_pressed_keys) == 0) {
-        int keys;
-        const Uint8 *keyState = SDL_GetKeyboardState(&keys);
-
-        // Make sure all client keys are up before we process the special key combo
-        for (int i = 0; i < keys; i++) {
-            if (keyState[i] == SDL_PRESSED) {
-                return;
-            }
-        }
-
-        // If we made it this far, no keys are pressed
-        performPendingSpecialKeyCombo(input);
-    }
+    return _pending_key_combo != KeyComboMax && input->keys.count == 0;
 }
 
 void stream_input_handle_text(stream_input_t *input, const SDL_TextInputEvent *event) {
-    if (keydown_count) {
-        commons_log_verbose("Input", "Ignoring duplicated text input %s. Pressed keys: %d", event->text, keydown_count);
+    if (!input->view_only && input->keys.count) {
+        commons_log_verbose("Input", "Ignoring duplicated text input %s. Pressed keys: %d", event->text,
+                            input->keys.count);
         return;
     }
     size_t len = strlen(event->text);
@@ -460,4 +439,19 @@ void stream_input_handle_text(stream_input_t *input, const SDL_TextInputEvent *e
         return;
     }
     LiSendUtf8TextEvent(event->text, len);
-}
\ No newline at end of file
+}
+
+void stream_input_release_keys(stream_input_t *input) {
+    SDL_LockMutex(input->keys_lock);
+    if (input->keys.peak > 0) {
+        commons_log_info("Input", "Keyboard rollover peak: %d keys", input->keys.peak);
+    }
+    session_input_keys_release_all(&input->keys, input->view_only ? NULL : release_key, NULL);
+    _pending_key_combo = KeyComboMax;
+    SDL_UnlockMutex(input->keys_lock);
+}
+
+static void release_key(short keyCode, void *userdata) {
+    (void) userdata;
+    LiSendKeyboardEvent((short) (0x8000 | keyCode), KEY_ACTION_UP, 0);
+}
@@ -0,0 +1,51 @@
+#include "session_keys.h"
+
+#include <string.h>
+
+#define KEY_VALID(code) ((code) >= 0 && (code) < SESSION_KEYS_MAX)
+#define KEY_WORD(code) ((code) >> 5)
+#define KEY_MASK(code) (1U << ((code) & 31))
+
+void session_input_keys_reset(session_input_keys_t *keys) {
+    memset(keys, 0, sizeof(*keys));
+}
+
+bool session_input_keys_press(session_input_keys_t *keys, short keyCode) {
+    if (!KEY_VALID(keyCode) || keys->bits[KEY_WORD(keyCode)] & KEY_MASK(keyCode)) {
+        return false;
+    }
+    keys->bits[KEY_WORD(keyCode)] |= KEY_MASK(keyCode);
+    keys->count++;
+    if (keys->count > keys->peak) {
+        keys->peak = keys->count;
+    }
+    return true;
+}
+
+bool session_input_keys_release(session_input_keys_t *keys, short keyCode) {
+    if (!KEY_VALID(keyCode) || !(keys->bits[KEY_WORD(keyCode)] & KEY_MASK(keyCode))) {
+        return false;
+    }
+    keys->bits[KEY_WORD(keyCode)] &= ~KEY_MASK(keyCode);
+    keys->count--;
+    return true;
+}
+
+bool session_input_keys_is_down(const session_input_keys_t *keys, short keyCode) {
+    return KEY_VALID(keyCode) && (keys->bits[KEY_WORD(keyCode)] & KEY_MASK(keyCode)) != 0;
+}
+
+void session_input_keys_release_all(session_input_keys_t *keys, session_input_keys_fn fn, void *userdata) {
+    for (int word = 0; word < SESSION_KEYS_MAX / 32 && keys->count > 0; word++) {
+        uint32_t bits = keys->bits[word];
+        keys->bits[word] = 0;
+        while (bits) {
+            int bit = __builtin_ctz(bits);
+            bits &= bits - 1;
+            keys->count--;
+            if (fn != NULL) {
+                fn((short) (word * 32 + bit), userdata);
+            }
+        }
+    }
+}
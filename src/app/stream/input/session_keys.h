@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Virtual key codes are 8-bit */
+#define SESSION_KEYS_MAX 256
+
+/**
+ * Set of pressed keys, indexed by virtual key code. All operations are O(1) and don't allocate.
+ */
+typedef struct session_input_keys_t {
+    uint32_t bits[SESSION_KEYS_MAX / 32];
+    /* Number of keys currently down */
+    uint16_t count;
+    /* Largest number of keys that were down at the same time */
+    uint16_t peak;
+} session_input_keys_t;
+
+typedef void (*session_input_keys_fn)(short keyCode, void *userdata);
+
+void session_input_keys_reset(session_input_keys_t *keys);
+
+/**
+ * @return false if the key was already down
+ */
+bool session_input_keys_press(session_input_keys_t *keys, short keyCode);
+
+/**
+ * @return false if the key wasn't down
+ */
+bool session_input_keys_release(session_input_keys_t *keys, short keyCode);
+
+bool session_input_keys_is_down(const session_input_keys_t *keys, short keyCode);
+
+/**
+ * Release all keys, calling fn for every key that was down.
+ */
+void session_input_keys_release_all(session_input_keys_t *keys, session_input_keys_fn fn, void *userdata);
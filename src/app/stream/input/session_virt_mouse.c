@@ -3,10 +3,44 @@
 
 #include <SDL_stdinc.h>
 
-static short calc_mouse_movement(short axis);
+#include "logging.h"
+
+/* Fixed tick interval. Speed is computed from the real elapsed time, so timer jitter won't change cursor speed */
+#define VMOUSE_TICK_INTERVAL_MS 4
+/* Ignore stalls longer than this, so the cursor won't jump after the timer thread got starved */
+#define VMOUSE_MAX_TICK_DELTA 0.05
+#define VMOUSE_STICK_THRESHOLD 4096
+#define VMOUSE_STICK_MAX 32767
+/* Scroll speed in high resolution units (120 per notch) per second at full stick deflection */
+#define VMOUSE_SCROLL_SPEED (120 * 16.0)
+
+static void vmouse_start(session_input_vmouse_t *vmouse);
+
+static void vmouse_stop(session_input_vmouse_t *vmouse);
 
 static Uint32 vmouse_timer_callback(Uint32 interval, void *param);
 
+static short take_whole_units(double *remainder);
+
+void session_input_vmouse_init(session_input_vmouse_t *vmouse, float speed, float accel) {
+    SDL_memset(vmouse, 0, sizeof(*vmouse));
+    vmouse->curve.speed = speed;
+    vmouse->curve.accel = accel;
+}
+
+void session_input_vmouse_deinit(session_input_vmouse_t *vmouse) {
+    vmouse_stop(vmouse);
+    if (vmouse->stats.ticks == 0) {
+        return;
+    }
+    double active_secs = (double) vmouse->stats.active_time / (double) SDL_GetPerformanceFrequency();
+    double tick_us = (double) vmouse->stats.tick_time * 1000000.0 / (double) SDL_GetPerformanceFrequency();
+    commons_log_info("Session", "Virtual mouse: %u ticks in %.2f s, %u motion events (%.1f/s), "
+                                "%u scroll events, %.2f us per tick", vmouse->stats.ticks, active_secs,
+                     vmouse->stats.motion_events, active_secs > 0 ? vmouse->stats.motion_events / active_secs : 0,
+                     vmouse->stats.scroll_events, tick_us / vmouse->stats.ticks);
+}
+
 void session_input_set_vmouse_active(session_input_vmouse_t *vmouse, bool active) {
     vmouse->state.active = active;
     if (!active) {
@@ -20,15 +54,23 @@ bool session_input_is_vmouse_active(session_input_vmouse_t *vmouse) {
 }
 
 void vmouse_set_vector(session_input_vmouse_t *vmouse, short x, short y) {
-    vmouse->state.x = calc_mouse_movement(x);
-    vmouse->state.y = calc_mouse_movement((short) -SDL_max(y, -32767));
-    if (vmouse->state.x || vmouse->state.y) {
-        if (!vmouse->timer_id) {
-            vmouse->timer_id = SDL_AddTimer(0, vmouse_timer_callback, vmouse);
-        }
-    } else if (vmouse->timer_id) {
-        SDL_RemoveTimer(vmouse->timer_id);
-        vmouse->timer_id = 0;
+    // Apply the curve on the vector magnitude, so diagonal movement has the same speed as straight movement
+    double fx = SDL_max(x, -VMOUSE_STICK_MAX), fy = -SDL_max(y, -VMOUSE_STICK_MAX);
+    double magnitude = SDL_sqrt(fx * fx + fy * fy);
+    if (magnitude < VMOUSE_STICK_THRESHOLD) {
+        vmouse->state.x = 0;
+        vmouse->state.y = 0;
+    } else {
+        double normalized = (SDL_min(magnitude, VMOUSE_STICK_MAX) - VMOUSE_STICK_THRESHOLD) /
+                            (VMOUSE_STICK_MAX - VMOUSE_STICK_THRESHOLD);
+        double scale = SDL_pow(normalized, vmouse->curve.accel) / magnitude;
+        vmouse->state.x = (float) (fx * scale);
+        vmouse->state.y = (float) (fy * scale);
+    }
+    if (vmouse->state.x != 0 || vmouse->state.y != 0) {
+        vmouse_start(vmouse);
+    } else {
+        vmouse_stop(vmouse);
     }
 }
 
@@ -49,29 +91,68 @@ void vmouse_set_modifier(session_input_vmouse_t *vmouse, bool v) {
     vmouse->state.modifier = v;
 }
 
+static void vmouse_start(session_input_vmouse_t *vmouse) {
+    if (vmouse->timer_id) {
+        return;
+    }
+    vmouse->last_tick = SDL_GetPerformanceCounter();
+    vmouse->stats.active_since = vmouse->last_tick;
+    vmouse->timer_id = SDL_AddTimer(VMOUSE_TICK_INTERVAL_MS, vmouse_timer_callback, vmouse);
+}
+
+static void vmouse_stop(session_input_vmouse_t *vmouse) {
+    if (!vmouse->timer_id) {
+        return;
+    }
+    SDL_RemoveTimer(vmouse->timer_id);
+    vmouse->timer_id = 0;
+    vmouse->stats.active_time += SDL_GetPerformanceCounter() - vmouse->stats.active_since;
+    SDL_memset(&vmouse->remainder, 0, sizeof(vmouse->remainder));
+}
+
 static Uint32 vmouse_timer_callback(Uint32 interval, void *param) {
-    (void) interval;
     session_input_vmouse_t *vmouse = param;
-    if (!vmouse->state.active || (!vmouse->state.x && !vmouse->state.y)) {
+    float x = vmouse->state.x, y = vmouse->state.y;
+    if (!vmouse->state.active || (x == 0 && y == 0)) {
         return 0;
     }
-    short speed = 4;
-    double speed_divider = 32 - SDL_max(0, SDL_min(speed, 16));
-    double x = vmouse->state.x / speed_divider;
-    double y = vmouse->state.y / speed_divider;
-    double abs_x = SDL_fabs(x), abs_y = SDL_fabs(y);
+    Uint64 now = SDL_GetPerformanceCounter();
+    double delta = SDL_min((double) (now - vmouse->last_tick) / (double) SDL_GetPerformanceFrequency(),
+                           VMOUSE_MAX_TICK_DELTA);
+    vmouse->last_tick = now;
     if (vmouse->state.modifier) {
-        abs_y /= 20.0;
-        LiSendHighResScrollEvent((short) (abs_y > 1 ? -y : -y / abs_y));
+        vmouse->remainder.scroll_x += x * VMOUSE_SCROLL_SPEED * delta;
+        vmouse->remainder.scroll_y -= y * VMOUSE_SCROLL_SPEED * delta;
+        short scroll_y = take_whole_units(&vmouse->remainder.scroll_y);
+        short scroll_x = take_whole_units(&vmouse->remainder.scroll_x);
+        if (scroll_y != 0) {
+            LiSendHighResScrollEvent(scroll_y);
+            vmouse->stats.scroll_events++;
+        }
+        if (scroll_x != 0) {
+            LiSendHighResHScrollEvent(scroll_x);
+            vmouse->stats.scroll_events++;
+        }
     } else {
-        LiSendMouseMoveEvent((short) (abs_x > 1 ? x : x / abs_x), (short) (abs_y > 1 ? y : y / abs_y));
+        vmouse->remainder.x += x * vmouse->curve.speed * delta;
+        vmouse->remainder.y += y * vmouse->curve.speed * delta;
+        short dx = take_whole_units(&vmouse->remainder.x);
+        short dy = take_whole_units(&vmouse->remainder.y);
+        if (dx != 0 || dy != 0) {
+            LiSendMouseMoveEvent(dx, dy);
+            vmouse->stats.motion_events++;
+        }
     }
-    return SDL_max(5, SDL_min(5 / SDL_max(abs_x, abs_y), 20));
+    vmouse->stats.ticks++;
+    vmouse->stats.tick_time += SDL_GetPerformanceCounter() - now;
+    return interval;
 }
 
-static short calc_mouse_movement(short axis) {
-    short abs_axis = (short) (axis > 0 ? axis : -axis);
-    short threshold = 4096;
-    if (abs_axis < threshold) { return 0; }
-    return (short) (SDL_sqrt(abs_axis - threshold) * (axis > 0 ? 1 : -1));
-}
\ No newline at end of file
+/**
+ * Take the integral part out of the accumulated value, and leave the fraction for next tick.
+ */
+static short take_whole_units(double *remainder) {
+    double whole = *remainder < 0 ? -SDL_floor(-*remainder) : SDL_floor(*remainder);
+    *remainder -= whole;
+    return (short) SDL_max(-32767, SDL_min(whole, 32767));
+}
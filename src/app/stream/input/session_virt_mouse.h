@@ -4,6 +4,14 @@
 
 typedef struct session_input_vmouse_t session_input_vmouse_t;
 
+/**
+ * @param speed Cursor speed in pixels per second at full stick deflection
+ * @param accel Exponent of the acceleration curve. 1 is linear, larger values give finer control on small deflection
+ */
+void session_input_vmouse_init(session_input_vmouse_t *vmouse, float speed, float accel);
+
+void session_input_vmouse_deinit(session_input_vmouse_t *vmouse);
+
 void session_input_set_vmouse_active(session_input_vmouse_t *vmouse, bool active);
 
 bool session_input_is_vmouse_active(session_input_vmouse_t *vmouse);
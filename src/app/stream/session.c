@@ -34,6 +34,8 @@ static void populate_hdr_info_vui(SS4S_VideoHDRInfo *info, const STREAM_CONFIGUR
 session_t *session_create(app_t *app, const CONFIGURATION *config, const SERVER_DATA *server, const APP_LIST *gs_app) {
     session_t *session = malloc(sizeof(session_t));
     SDL_memset(session, 0, sizeof(session_t));
+    // This is called right after the app is clicked, so it's the origin of startup profile
+    session_profile_init(&session->profile);
     session_config_init(app, &session->config, server, config);
     session->app = app;
     session->display_width = app->ui.width;
@@ -87,10 +89,15 @@ void session_destroy(session_t *session) {
     SDL_DestroyCond(session->cond);
     SDL_DestroyMutex(session->mutex);
     SDL_DestroyMutex(session->state_lock);
+    session_profile_deinit(&session->profile);
     free(session->app_name);
     free(session);
 }
 
+size_t session_startup_summary(session_t *session, char *buf, size_t len) {
+    return session_profile_format(&session->profile, buf, len);
+}
+
 void session_interrupt(session_t *session, bool quitapp, streaming_interrupt_reason_t reason) {
     if (!session) {
         return;
@@ -103,6 +110,7 @@ void session_interrupt(session_t *session, bool quitapp, streaming_interrupt_rea
     session_input_interrupt(&session->input);
     session->quitapp = quitapp;
     session->interrupted = true;
+    session->interrupted_at = SDL_max(SDL_GetTicks(), 1);
 #if FEATURE_EMBEDDED_SHELL
     if (session->embed && session->embed_process) {
         embed_interrupt(session->embed_process);
@@ -251,10 +259,13 @@ void session_config_init(app_t *app, session_config_t *config, const SERVER_DATA
                          const CONFIGURATION *app_config) {
     config->stream = app_config->stream;
     config->vmouse = app_config->virtual_mouse;
+    config->vmouse_speed = (uint16_t) SDL_max(100, SDL_min(app_config->virtual_mouse_speed, 5000));
+    config->vmouse_accel = (float) SDL_max(5, SDL_min(app_config->virtual_mouse_accel, 40)) / 10.0f;
     config->hardware_mouse = app_config->hardware_mouse;
     config->local_audio = app_config->localaudio;
     config->view_only = app_config->viewonly;
     config->sops = app_config->sops;
+    config->rfi = app_config->rfi && app_is_decoder_rfi_supported(app);
     if (app_config->stick_deadzone < 0) {
         config->stick_deadzone = 0;
     } else if (app_config->stick_deadzone > 100) {
@@ -38,6 +38,12 @@ typedef struct VIDEO_STATS {
     float decodedFps;
     float avgDecoderLatency;
     uint32_t rtt, rttVariance;
+    /* Frame loss recoveries since the session started */
+    uint32_t rfiRecoveries;
+    uint32_t idrRecoveries;
+    /* Time from the last good frame before the loss to the first good frame after it */
+    uint32_t totalRecoveryTime;
+    uint32_t maxRecoveryTime;
 } VIDEO_STATS;
 
 typedef struct VIDEO_INFO {
@@ -52,6 +58,17 @@ typedef struct AUDIO_INFO {
     const char *format;
 } AUDIO_INFO;
 
+typedef struct AUDIO_STATS {
+    uint32_t lostFrames;
+    uint32_t concealedFrames;
+    uint32_t fecFrames;
+    /* Jitter buffer, only available when audio is decoded by us */
+    float queuedMs;
+    float targetMs;
+    uint32_t underruns;
+    float driftPpm;
+} AUDIO_STATS;
+
 typedef struct session_config_t {
     STREAM_CONFIGURATION stream;
     bool sops;
@@ -59,7 +76,13 @@ typedef struct session_config_t {
     bool local_audio;
     bool hardware_mouse;
     bool vmouse;
+    /* Virtual mouse speed in pixels per second at full stick deflection */
+    uint16_t vmouse_speed;
+    /* Exponent of the virtual mouse acceleration curve */
+    float vmouse_accel;
     uint8_t stick_deadzone;
+    /* Recover from frame loss with reference frame invalidation instead of IDR frames, for H.264 and HEVC */
+    bool rfi;
 } session_config_t;
 
 extern int streaming_errno;
@@ -75,6 +98,11 @@ void session_destroy(session_t *session);
 
 void session_interrupt(session_t *session, bool quitapp, streaming_interrupt_reason_t reason);
 
+/**
+ * Time spent on each startup stage, from the app being clicked to the first frame.
+ */
+size_t session_startup_summary(session_t *session, char *buf, size_t len);
+
 bool session_start_input(session_t *session);
 
 void session_stop_input(session_t *session);
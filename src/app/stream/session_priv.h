@@ -7,6 +7,7 @@
 #include "app_settings.h"
 #include "stream/input/session_input.h"
 #include "stream/session.h"
+#include "stream/session_profile.h"
 #include "embed_wrapper.h"
 
 typedef struct app_t app_t;
@@ -26,6 +27,8 @@ struct session_t {
     int app_id;
     char *app_name;
     bool interrupted;
+    /* SDL_GetTicks when interrupted, to measure time to return to launcher */
+    Uint32 interrupted_at;
     bool quitapp;
 #if FEATURE_EMBEDDED_SHELL
     bool embed;
@@ -37,6 +40,7 @@ struct session_t {
     SDL_mutex *mutex;
     SDL_Thread *thread;
     SS4S_Player *player;
+    session_profile_t profile;
 };
 
 void session_set_state(session_t *session, STREAMING_STATE state);
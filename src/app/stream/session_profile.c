@@ -0,0 +1,248 @@
+#include "session_profile.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <SDL_stdinc.h>
+#include <SDL_timer.h>
+
+#include "util/path.h"
+#include "logging.h"
+
+#define HISTORY_LINE_MAX 1024
+
+static uint32_t profile_now_ms(const session_profile_t *profile);
+
+static char *history_path(const char *conf_dir, const char *uuid);
+
+static int history_read_lines(const char *path, char lines[][HISTORY_LINE_MAX], int max);
+
+void session_profile_init(session_profile_t *profile) {
+    memset(profile, 0, sizeof(*profile));
+    profile->lock = SDL_CreateMutex();
+    profile->origin = SDL_GetPerformanceCounter();
+}
+
+void session_profile_deinit(session_profile_t *profile) {
+    if (profile->lock != NULL) {
+        SDL_DestroyMutex(profile->lock);
+        profile->lock = NULL;
+    }
+}
+
+int session_profile_begin(session_profile_t *profile, const char *name) {
+    uint32_t now = profile_now_ms(profile);
+    SDL_LockMutex(profile->lock);
+    int span = -1;
+    if (profile->count < SESSION_PROFILE_MAX_SPANS) {
+        span = profile->count++;
+        profile->spans[span] = (session_profile_span_t) {.name = name, .start_ms = now, .end_ms = now};
+    }
+    SDL_UnlockMutex(profile->lock);
+    return span;
+}
+
+void session_profile_end(session_profile_t *profile, int span) {
+    if (span < 0) {
+        return;
+    }
+    uint32_t now = profile_now_ms(profile);
+    SDL_LockMutex(profile->lock);
+    if (span < profile->count) {
+        profile->spans[span].end_ms = now;
+        profile->spans[span].finished = true;
+    }
+    SDL_UnlockMutex(profile->lock);
+}
+
+void session_profile_mark(session_profile_t *profile, const char *name) {
+    int span = session_profile_begin(profile, name);
+    if (span < 0) {
+        return;
+    }
+    SDL_LockMutex(profile->lock);
+    profile->spans[span].finished = true;
+    profile->spans[span].mark = true;
+    SDL_UnlockMutex(profile->lock);
+}
+
+void session_profile_first_frame(session_profile_t *profile) {
+    uint32_t now = profile_now_ms(profile);
+    SDL_LockMutex(profile->lock);
+    if (profile->first_frame_ms == 0) {
+        profile->first_frame_ms = SDL_max(now, 1);
+    }
+    SDL_UnlockMutex(profile->lock);
+}
+
+bool session_profile_complete(session_profile_t *profile) {
+    SDL_LockMutex(profile->lock);
+    bool complete = profile->first_frame_ms > 0;
+    SDL_UnlockMutex(profile->lock);
+    return complete;
+}
+
+void session_profile_log(session_profile_t *profile) {
+    SDL_LockMutex(profile->lock);
+    commons_log_info("Session", "Startup profile, first frame at %u ms:", profile->first_frame_ms);
+    for (int i = 0; i < profile->count; i++) {
+        const session_profile_span_t *span = &profile->spans[i];
+        if (!span->finished) {
+            commons_log_info("Session", "  %-24s %6u ms  (not finished)", span->name, span->start_ms);
+            continue;
+        } else if (span->mark) {
+            commons_log_info("Session", "  %-24s %6u ms", span->name, span->start_ms);
+            continue;
+        }
+        commons_log_info("Session", "  %-24s %6u ms  +%u ms", span->name, span->start_ms,
+                         span->end_ms - span->start_ms);
+    }
+    if (profile->history.count > 0) {
+        commons_log_info("Session", "Previous %d launches: avg %u ms, best %u ms", profile->history.count,
+                         profile->history.avg_total_ms, profile->history.min_total_ms);
+    }
+    SDL_UnlockMutex(profile->lock);
+}
+
+size_t session_profile_format(session_profile_t *profile, char *buf, size_t len) {
+    SDL_LockMutex(profile->lock);
+    size_t pos = 0;
+    if (profile->first_frame_ms > 0) {
+        pos += SDL_snprintf(buf, len, "%u ms", profile->first_frame_ms);
+    } else {
+        pos += SDL_snprintf(buf, len, "in progress");
+    }
+    if (profile->history.count > 0 && pos < len) {
+        pos += SDL_snprintf(buf + pos, len - pos, " (avg %u ms)", profile->history.avg_total_ms);
+    }
+    for (int i = 0; i < profile->count && pos < len; i++) {
+        const session_profile_span_t *span = &profile->spans[i];
+        if (!span->finished) {
+            continue;
+        } else if (span->mark) {
+            pos += SDL_snprintf(buf + pos, len - pos, "\n%s: at %u ms", span->name, span->start_ms);
+        } else {
+            pos += SDL_snprintf(buf + pos, len - pos, "\n%s: %u ms", span->name, span->end_ms - span->start_ms);
+        }
+    }
+    SDL_UnlockMutex(profile->lock);
+    return SDL_min(pos, len > 0 ? len - 1 : 0);
+}
+
+int session_profile_history_load(session_profile_t *profile, const char *conf_dir, const char *uuid) {
+    char *path = history_path(conf_dir, uuid);
+    char (*lines)[HISTORY_LINE_MAX] = calloc(SESSION_PROFILE_HISTORY_SIZE, HISTORY_LINE_MAX);
+    int count = history_read_lines(path, lines, SESSION_PROFILE_HISTORY_SIZE);
+    free(path);
+    if (count < 0) {
+        free(lines);
+        return errno;
+    }
+    uint64_t sum = 0;
+    uint32_t min = UINT32_MAX;
+    int valid = 0;
+    for (int i = 0; i < count; i++) {
+        unsigned long long timestamp;
+        unsigned int total;
+        if (sscanf(lines[i], "%llu\t%u", &timestamp, &total) != 2 || total == 0) {
+            continue;
+        }
+        sum += total;
+        min = SDL_min(min, total);
+        valid++;
+    }
+    free(lines);
+    SDL_LockMutex(profile->lock);
+    profile->history.count = valid;
+    profile->history.avg_total_ms = valid > 0 ? (uint32_t) (sum / valid) : 0;
+    profile->history.min_total_ms = valid > 0 ? min : 0;
+    SDL_UnlockMutex(profile->lock);
+    return 0;
+}
+
+int session_profile_history_save(session_profile_t *profile, const char *conf_dir, const char *uuid) {
+    char *path = history_path(conf_dir, uuid);
+    char (*lines)[HISTORY_LINE_MAX] = calloc(SESSION_PROFILE_HISTORY_SIZE, HISTORY_LINE_MAX);
+    int count = history_read_lines(path, lines, SESSION_PROFILE_HISTORY_SIZE - 1);
+    if (count < 0) {
+        count = 0;
+    }
+
+    char *line = lines[count++];
+    SDL_LockMutex(profile->lock);
+    size_t pos = SDL_snprintf(line, HISTORY_LINE_MAX, "%llu\t%u", (unsigned long long) time(NULL),
+                              profile->first_frame_ms);
+    for (int i = 0; i < profile->count && pos < HISTORY_LINE_MAX; i++) {
+        const session_profile_span_t *span = &profile->spans[i];
+        if (!span->finished) {
+            continue;
+        }
+        pos += SDL_snprintf(line + pos, HISTORY_LINE_MAX - pos, "\t%s=%u+%u", span->name, span->start_ms,
+                            span->end_ms - span->start_ms);
+    }
+    SDL_UnlockMutex(profile->lock);
+
+    size_t tmp_len = strlen(path) + 5;
+    char *tmp_path = malloc(tmp_len);
+    SDL_snprintf(tmp_path, tmp_len, "%s.tmp", path);
+    int ret = 0;
+    FILE *fp = fopen(tmp_path, "w");
+    if (fp == NULL) {
+        ret = errno;
+    } else {
+        for (int i = 0; i < count; i++) {
+            fprintf(fp, "%s\n", lines[i]);
+        }
+        if (fclose(fp) != 0 || rename(tmp_path, path) != 0) {
+            ret = errno;
+        }
+    }
+    if (ret != 0) {
+        commons_log_warn("Session", "Failed to save startup history to %s: %s", path, strerror(ret));
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    free(lines);
+    free(path);
+    return ret;
+}
+
+static uint32_t profile_now_ms(const session_profile_t *profile) {
+    return (uint32_t) ((SDL_GetPerformanceCounter() - profile->origin) * 1000 / SDL_GetPerformanceFrequency());
+}
+
+static char *history_path(const char *conf_dir, const char *uuid) {
+    char name[64];
+    SDL_snprintf(name, sizeof(name), "startup-%s.log", uuid);
+    return path_join(conf_dir, name);
+}
+
+/**
+ * Read the last max lines of the file.
+ *
+ * @return Number of lines read, or -1 if the file can't be opened
+ */
+static int history_read_lines(const char *path, char lines[][HISTORY_LINE_MAX], int max) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    int count = 0;
+    char line[HISTORY_LINE_MAX];
+    while (max > 0 && fgets(line, sizeof(line), fp) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0') {
+            continue;
+        }
+        if (count == max) {
+            memmove(lines[0], lines[1], (size_t) (max - 1) * HISTORY_LINE_MAX);
+            count--;
+        }
+        memcpy(lines[count++], line, HISTORY_LINE_MAX);
+    }
+    fclose(fp);
+    return count;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL_mutex.h>
+
+#define SESSION_PROFILE_MAX_SPANS 32
+/* Number of launches kept in history file of each host */
+#define SESSION_PROFILE_HISTORY_SIZE 20
+
+/**
+ * Timestamps of session startup stages, from the click on an app to the first frame fed to the decoder.
+ *
+ * Spans can be nested or overlapped, and can be recorded from any thread. All times are relative to the origin,
+ * in milliseconds.
+ */
+typedef struct session_profile_span_t {
+    const char *name;
+    uint32_t start_ms;
+    uint32_t end_ms;
+    bool finished;
+    /* Point in time rather than a span */
+    bool mark;
+} session_profile_span_t;
+
+typedef struct session_profile_t {
+    SDL_mutex *lock;
+    uint64_t origin;
+    session_profile_span_t spans[SESSION_PROFILE_MAX_SPANS];
+    int count;
+    /* Time of the first frame fed to the decoder, 0 if not yet */
+    uint32_t first_frame_ms;
+    struct {
+        int count;
+        uint32_t avg_total_ms;
+        uint32_t min_total_ms;
+    } history;
+} session_profile_t;
+
+void session_profile_init(session_profile_t *profile);
+
+void session_profile_deinit(session_profile_t *profile);
+
+/**
+ * @param name Must be a string that stays valid for the whole session
+ * @return Span index to be passed to session_profile_end, or -1 if there are too many spans
+ */
+int session_profile_begin(session_profile_t *profile, const char *name);
+
+void session_profile_end(session_profile_t *profile, int span);
+
+void session_profile_mark(session_profile_t *profile, const char *name);
+
+void session_profile_first_frame(session_profile_t *profile);
+
+bool session_profile_complete(session_profile_t *profile);
+
+void session_profile_log(session_profile_t *profile);
+
+/**
+ * Breakdown of spans, one per line, for the streaming overlay.
+ */
+size_t session_profile_format(session_profile_t *profile, char *buf, size_t len);
+
+/**
+ * Load previous launches of the host, for comparison.
+ */
+int session_profile_history_load(session_profile_t *profile, const char *conf_dir, const char *uuid);
+
+/**
+ * Append this launch to history of the host, and drop the oldest ones exceeding SESSION_PROFILE_HISTORY_SIZE.
+ */
+int session_profile_history_save(session_profile_t *profile, const char *conf_dir, const char *uuid);
@@ -10,7 +10,13 @@
 #include "stream/audio/session_audio.h"
 #include "stream/video/session_video.h"
 #include "app_session.h"
-#include "backend/pcmanager/worker/worker.h"
+
+/* Posted when app quit of the previous session, which runs after the UI has returned to launcher, is done */
+static SDL_sem *teardown_done = NULL;
+
+static int session_player_prepare(session_t *session);
+
+static void session_wait_previous_teardown();
 
 int session_worker(session_t *session) {
     app_t *app = session->app;
@@ -27,6 +33,15 @@ int session_worker(session_t *session) {
     }
 #endif
 
+    session_wait_previous_teardown();
+
+    // Player doesn't depend on the launch result, so open it while waiting for the host
+    SDL_Thread *prepare_thread = SDL_CreateThread((SDL_ThreadFunction) session_player_prepare, "session_prep",
+                                                  session);
+    if (prepare_thread == NULL) {
+        session_player_prepare(session);
+    }
+
     commons_log_info("Session", "Launch app %d...", appId);
     GS_CLIENT client = app_gs_client_new(app);
     gs_set_timeout(client, 30);
@@ -37,8 +52,13 @@ int session_worker(session_t *session) {
         surround_params = "642014523";
     }
 #endif
+    int launch_span = session_profile_begin(&session->profile, "Launch app");
     int ret = gs_start_app(client, server, &session->config.stream, appId, server->isGfe, session->config.sops,
                            session->config.local_audio, app_input_gamepads_mask(&app->input), surround_params);
+    session_profile_end(&session->profile, launch_span);
+    if (prepare_thread != NULL) {
+        SDL_WaitThread(prepare_thread, NULL);
+    }
     if (ret != GS_OK) {
         session_set_state(session, STREAMING_ERROR);
         const char *gs_error = NULL;
@@ -57,14 +77,22 @@ int session_worker(session_t *session) {
     commons_log_info("Session", "Audio %d channels",
                      CHANNEL_COUNT_FROM_AUDIO_CONFIGURATION(session->config.stream.audioConfiguration));
 
-    session->player = SS4S_PlayerOpen();
-    SS4S_PlayerSetWaitAudioVideoReady(session->player, true);
-    SS4S_PlayerSetViewportSize(session->player, app->ui.width, app->ui.height);
-    SS4S_PlayerSetUserdata(session->player, app);
+    if (session->player == NULL) {
+        session_set_state(session, STREAMING_ERROR);
+        streaming_error(session, GS_WRONG_STATE, "Failed to open player.");
+        commons_log_error("Session", "Failed to open player");
+        // App has been launched already, don't leave it running on the host
+        if (gs_quit_app(client, server) != GS_OK) {
+            commons_log_warn("Session", "Failed to quit app after player error");
+        }
+        goto thread_cleanup;
+    }
 
+    int connection_span = session_profile_begin(&session->profile, "Start connection");
     int startResult = LiStartConnection(&server->serverInfo, &session->config.stream,
                                         session_connection_callbacks_prepare(session),
-                                        &ss4s_dec_callbacks, &ss4s_aud_callbacks, session, 0, session, 0);
+                                        session_video_callbacks_prepare(session), &ss4s_aud_callbacks, session, 0, session, 0);
+    session_profile_end(&session->profile, connection_span);
     if (startResult != 0) {
         session_set_state(session, STREAMING_ERROR);
         switch (startResult) {
@@ -101,19 +129,24 @@ int session_worker(session_t *session) {
     SDL_UnlockMutex(session->mutex);
     bus_pushevent(USER_STREAM_CLOSE, NULL, NULL);
 
+    if (session_profile_complete(&session->profile)) {
+        session_profile_history_save(&session->profile, app->settings.conf_dir, server->uuid);
+    }
+
     session_set_state(session, STREAMING_DISCONNECTING);
     LiStopConnection();
 
+    // Release decoders now, talking to the host can take a while and should not keep the user waiting
+    SS4S_PlayerClose(session->player);
+    session->player = NULL;
+
     if (session->quitapp) {
         commons_log_info("Session", "Sending app quit request ...");
-        gs_quit_app(client, server);
+        teardown_done = SDL_CreateSemaphore(0);
     }
-    worker_context_t update_ctx = {
-            .app = app,
-            .manager = pcmanager,
-    };
-    uuidstr_fromstr(&update_ctx.uuid, server->uuid);
-    pcmanager_update_by_host(&update_ctx, server->serverInfo.address, server->extPort, true);
+    uuidstr_t uuid;
+    uuidstr_fromstr(&uuid, server->uuid);
+    pcmanager_session_finished(pcmanager, &uuid, session->quitapp, teardown_done);
 
     // Don't always reset status as error state should be kept
     session_set_state(session, STREAMING_NONE);
@@ -123,7 +156,51 @@ int session_worker(session_t *session) {
         SS4S_PlayerClose(session->player);
     }
     gs_destroy(client);
+    if (session->interrupted_at != 0) {
+        commons_log_info("Session", "Returning to launcher %u ms after interrupted",
+                         SDL_GetTicks() - session->interrupted_at);
+    }
     bus_pushevent(USER_STREAM_FINISHED, NULL, NULL);
     app_bus_post(app, (bus_actionfunc) app_session_destroy, app);
     return 0;
+}
+
+void session_worker_deinit() {
+    // Executor has been destroyed, so the task holding the semaphore has been finalized
+    if (teardown_done != NULL) {
+        SDL_DestroySemaphore(teardown_done);
+        teardown_done = NULL;
+    }
+}
+
+/**
+ * Runs in parallel with the launch request.
+ */
+static int session_player_prepare(session_t *session) {
+    app_t *app = session->app;
+    session_profile_history_load(&session->profile, app->settings.conf_dir, session->server->uuid);
+    int player_span = session_profile_begin(&session->profile, "Open player");
+    SS4S_Player *player = SS4S_PlayerOpen();
+    if (player != NULL) {
+        SS4S_PlayerSetWaitAudioVideoReady(player, true);
+        SS4S_PlayerSetViewportSize(player, app->ui.width, app->ui.height);
+        SS4S_PlayerSetUserdata(player, app);
+    }
+    session_profile_end(&session->profile, player_span);
+    session->player = player;
+    return 0;
+}
+
+/**
+ * App quit of the previous session has to be done before launching again. Host update alone is dropped if it hasn't
+ * started yet, as it would only compete with the launch.
+ */
+static void session_wait_previous_teardown() {
+    pcmanager_session_starting(pcmanager);
+    if (teardown_done == NULL) {
+        return;
+    }
+    SDL_SemWait(teardown_done);
+    SDL_DestroySemaphore(teardown_done);
+    teardown_done = NULL;
 }
\ No newline at end of file
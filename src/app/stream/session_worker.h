@@ -4,4 +4,9 @@ typedef struct session_t session_t;
 
 int session_worker(session_t *session);
 
-int session_worker_embedded(session_t *session);
\ No newline at end of file
+int session_worker_embedded(session_t *session);
+
+/**
+ * Release resources kept between sessions. Must be called after the backend executor is destroyed.
+ */
+void session_worker_deinit();
\ No newline at end of file
@@ -19,6 +19,8 @@
 
 // 2MB decode size should be fairly enough for everything
 #define DECODER_BUFFER_SIZE (2048 * 1024)
+// Stop trusting reference frame invalidation if the decoder still asks for keyframes after this many recoveries
+#define RFI_MAX_FAILURES 3
 
 static session_t *session = NULL;
 static SS4S_Player *player = NULL;
@@ -26,6 +28,19 @@ static unsigned char *buffer = NULL;
 static int lastFrameNumber;
 static struct VIDEO_STATS vdec_temp_stats;
 static int vdec_stream_format = 0;
+static bool vdec_first_frame_fed = false;
+static struct {
+    /* Host will invalidate lost frames, so we can continue without an IDR frame */
+    bool rfi;
+    uint32_t rfi_failures;
+    /* Frames in this range were lost, waiting for the first good frame after them */
+    bool pending;
+    bool pending_idr;
+    int first_invalid, last_invalid;
+    uint64_t last_good_ms;
+    uint32_t rfi_recoveries, idr_recoveries;
+    uint32_t total_time, max_time;
+} vdec_recovery;
 VIDEO_STATS vdec_summary_stats;
 VIDEO_INFO vdec_stream_info;
 
@@ -37,6 +52,14 @@ static int vdec_delegate_submit(PDECODE_UNIT decodeUnit);
 
 static void vdec_stat_submit(const struct VIDEO_STATS *src, unsigned long now);
 
+static void vdec_recovery_frames_lost(int first, int last);
+
+static void vdec_recovery_frame_fed(PDECODE_UNIT decodeUnit);
+
+static void vdec_recovery_keyframe_requested();
+
+static void vdec_rfi_unsupported(app_t *app);
+
 static void stream_info_parse_size(PDECODE_UNIT decodeUnit, struct VIDEO_INFO *info);
 
 DECODER_RENDERER_CALLBACKS ss4s_dec_callbacks = {
@@ -46,6 +69,15 @@ DECODER_RENDERER_CALLBACKS ss4s_dec_callbacks = {
         .capabilities = CAPABILITY_DIRECT_SUBMIT,
 };
 
+DECODER_RENDERER_CALLBACKS *session_video_callbacks_prepare(session_t *session) {
+    ss4s_dec_callbacks.capabilities = CAPABILITY_DIRECT_SUBMIT;
+    if (session->config.rfi) {
+        ss4s_dec_callbacks.capabilities |= CAPABILITY_REFERENCE_FRAME_INVALIDATION_AVC |
+                                           CAPABILITY_REFERENCE_FRAME_INVALIDATION_HEVC;
+    }
+    return &ss4s_dec_callbacks;
+}
+
 static const char *video_format_name(int videoFormat) {
     switch (videoFormat) {
         case VIDEO_FORMAT_H264:
@@ -74,6 +106,11 @@ int vdec_delegate_setup(int videoFormat, int width, int height, int redrawRate,
     vdec_stream_format = videoFormat;
     vdec_stream_info.format = video_format_name(videoFormat);
     lastFrameNumber = 0;
+    memset(&vdec_recovery, 0, sizeof(vdec_recovery));
+    vdec_recovery.rfi = (ss4s_dec_callbacks.capabilities & CAPABILITY_REFERENCE_FRAME_INVALIDATION_AVC &&
+                         videoFormat & VIDEO_FORMAT_MASK_H264) ||
+                        (ss4s_dec_callbacks.capabilities & CAPABILITY_REFERENCE_FRAME_INVALIDATION_HEVC &&
+                         videoFormat & VIDEO_FORMAT_MASK_H265);
     SS4S_VideoInfo info = {
             .width = width,
             .height = height,
@@ -103,7 +140,11 @@ int vdec_delegate_setup(int videoFormat, int width, int height, int redrawRate,
         app_bus_post_sync(app, (bus_actionfunc) app_ui_close, &app->ui);
     }
 
-    switch (SS4S_PlayerVideoOpen(player, &info)) {
+    vdec_first_frame_fed = false;
+    int open_span = session_profile_begin(&session->profile, "Open video decoder");
+    int open_result = SS4S_PlayerVideoOpen(player, &info);
+    session_profile_end(&session->profile, open_span);
+    switch (open_result) {
         case SS4S_VIDEO_OPEN_OK: {
             return 0;
         }
@@ -116,6 +157,12 @@ int vdec_delegate_setup(int videoFormat, int width, int height, int redrawRate,
 
 void vdec_delegate_cleanup() {
     assert(player != NULL);
+    if (vdec_recovery.rfi_recoveries || vdec_recovery.idr_recoveries) {
+        commons_log_info("Session", "Frame loss recovered %u times by RFI, %u times by IDR, avg %u ms, max %u ms",
+                         vdec_recovery.rfi_recoveries, vdec_recovery.idr_recoveries,
+                         vdec_recovery.total_time / (vdec_recovery.rfi_recoveries + vdec_recovery.idr_recoveries),
+                         vdec_recovery.max_time);
+    }
     free(buffer);
     SS4S_PlayerVideoClose(player);
     session = NULL;
@@ -133,6 +180,9 @@ int vdec_delegate_submit(PDECODE_UNIT decodeUnit) {
         // Any frame number greater than m_LastFrameNumber + 1 represents a dropped frame
         vdec_temp_stats.networkDroppedFrames += decodeUnit->frameNumber - (lastFrameNumber + 1);
         vdec_temp_stats.totalFrames += decodeUnit->frameNumber - (lastFrameNumber + 1);
+        if (decodeUnit->frameNumber > lastFrameNumber + 1) {
+            vdec_recovery_frames_lost(lastFrameNumber + 1, decodeUnit->frameNumber - 1);
+        }
         lastFrameNumber = decodeUnit->frameNumber;
     }
     // Flip stats windows roughly every second
@@ -150,6 +200,10 @@ int vdec_delegate_submit(PDECODE_UNIT decodeUnit) {
     vdec_temp_stats.totalCaptureLatency += decodeUnit->frameHostProcessingLatency;
     vdec_temp_stats.totalReassemblyTime += decodeUnit->enqueueTimeMs - decodeUnit->receiveTimeMs;
     vdec_stream_info.has_host_latency |= decodeUnit->frameHostProcessingLatency > 0;
+    if (vdec_recovery.pending_idr && decodeUnit->frameType != FRAME_TYPE_IDR) {
+        // Decoder can't continue from here, don't bother feeding it
+        return DR_NEED_IDR;
+    }
     size_t length = 0;
     for (PLENTRY entry = decodeUnit->bufferList; entry != NULL; entry = entry->next) {
         memcpy(buffer + length, entry->data, entry->length);
@@ -166,8 +220,15 @@ int vdec_delegate_submit(PDECODE_UNIT decodeUnit) {
         }
         vdec_temp_stats.totalSubmitTime += LiGetMillis() - decodeUnit->enqueueTimeMs;
         vdec_temp_stats.submittedFrames++;
+        vdec_recovery_frame_fed(decodeUnit);
+        if (!vdec_first_frame_fed) {
+            vdec_first_frame_fed = true;
+            session_profile_first_frame(&session->profile);
+            session_profile_log(&session->profile);
+        }
         return DR_OK;
     } else if (result == SS4S_VIDEO_FEED_REQUEST_KEYFRAME) {
+        vdec_recovery_keyframe_requested();
         return DR_NEED_IDR;
     } else {
         commons_log_error("Session", "Video feed error %d", result);
@@ -185,6 +246,10 @@ void vdec_stat_submit(const struct VIDEO_STATS *src, unsigned long now) {
     dst->receivedFps = (float) dst->receivedFrames / ((float) delta / 1000);
     dst->decodedFps = (float) dst->submittedFrames / ((float) delta / 1000);
     LiGetEstimatedRttInfo(&dst->rtt, &dst->rttVariance);
+    dst->rfiRecoveries = vdec_recovery.rfi_recoveries;
+    dst->idrRecoveries = vdec_recovery.idr_recoveries;
+    dst->totalRecoveryTime = vdec_recovery.total_time;
+    dst->maxRecoveryTime = vdec_recovery.max_time;
     if (!streaming_stats_shown()) {
         return;
     }
@@ -198,6 +263,55 @@ void vdec_stat_submit(const struct VIDEO_STATS *src, unsigned long now) {
     app_bus_post(session->app, (bus_actionfunc) streaming_refresh_stats, NULL);
 }
 
+/**
+ * With RFI, moonlight-common-c asks the host to invalidate the lost frames, and the next frame we get only refers
+ * to frames before them. Otherwise, it asks for an IDR frame, and drops everything until it arrives.
+ */
+static void vdec_recovery_frames_lost(int first, int last) {
+    commons_log_debug("Session", "Frames %d-%d lost", first, last);
+    if (!vdec_recovery.pending) {
+        vdec_recovery.pending = true;
+        vdec_recovery.first_invalid = first;
+    }
+    vdec_recovery.last_invalid = last;
+    vdec_recovery.pending_idr |= !vdec_recovery.rfi;
+}
+
+static void vdec_recovery_frame_fed(PDECODE_UNIT decodeUnit) {
+    if (vdec_recovery.pending && (!vdec_recovery.pending_idr || decodeUnit->frameType == FRAME_TYPE_IDR)) {
+        uint32_t elapsed = vdec_recovery.last_good_ms ? (uint32_t) (decodeUnit->receiveTimeMs -
+                                                                    vdec_recovery.last_good_ms) : 0;
+        if (vdec_recovery.pending_idr) {
+            vdec_recovery.idr_recoveries++;
+        } else {
+            vdec_recovery.rfi_recoveries++;
+        }
+        vdec_recovery.total_time += elapsed;
+        vdec_recovery.max_time = SDL_max(vdec_recovery.max_time, elapsed);
+        commons_log_debug("Session", "Recovered from loss of frames %d-%d by %s in %u ms",
+                          vdec_recovery.first_invalid, vdec_recovery.last_invalid,
+                          vdec_recovery.pending_idr ? "IDR" : "RFI", elapsed);
+        vdec_recovery.pending = false;
+        vdec_recovery.pending_idr = false;
+    }
+    vdec_recovery.last_good_ms = decodeUnit->receiveTimeMs;
+}
+
+static void vdec_recovery_keyframe_requested() {
+    if (vdec_recovery.pending && !vdec_recovery.pending_idr && vdec_recovery.rfi &&
+        ++vdec_recovery.rfi_failures >= RFI_MAX_FAILURES) {
+        commons_log_warn("Session", "Decoder can't recover from invalidated frames, falling back to IDR frames");
+        vdec_recovery.rfi = false;
+        // Host was told we support RFI when the connection started, that can't be changed until the next session
+        app_bus_post(session->app, (bus_actionfunc) vdec_rfi_unsupported, session->app);
+    }
+    if (!vdec_recovery.pending) {
+        vdec_recovery.pending = true;
+        vdec_recovery.first_invalid = vdec_recovery.last_invalid = lastFrameNumber;
+    }
+    vdec_recovery.pending_idr = true;
+}
+
 void stream_info_parse_size(PDECODE_UNIT decodeUnit, struct VIDEO_INFO *info) {
     if (decodeUnit->frameType != FRAME_TYPE_IDR) { return; }
     for (PLENTRY entry = decodeUnit->bufferList; entry != NULL; entry = entry->next) {
@@ -215,4 +329,9 @@ void stream_info_parse_size(PDECODE_UNIT decodeUnit, struct VIDEO_INFO *info) {
         info->height = dimension.height;
         return;
     }
-}
\ No newline at end of file
+}
+
+static void vdec_rfi_unsupported(app_t *app) {
+    free(app->settings.rfi_unsupported);
+    app->settings.rfi_unsupported = strdup(SS4S_ModuleInfoGetId(app->ss4s.selection.video_module));
+}
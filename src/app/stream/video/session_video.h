@@ -5,6 +5,14 @@
 extern struct VIDEO_STATS vdec_summary_stats;
 extern struct VIDEO_INFO vdec_stream_info;
 extern struct AUDIO_INFO audio_stream_info;
+extern struct AUDIO_STATS audio_summary_stats;
+
+typedef struct session_t session_t;
 
 extern DECODER_RENDERER_CALLBACKS ss4s_dec_callbacks;
 
+/**
+ * Set decoder capabilities for this session, like reference frame invalidation support.
+ */
+DECODER_RENDERER_CALLBACKS *session_video_callbacks_prepare(session_t *session);
+
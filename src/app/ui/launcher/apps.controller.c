@@ -9,6 +9,7 @@
 #include "ui/streaming/streaming.controller.h"
 
 #include "coverloader.h"
+#include "apps_diff.h"
 #include "backend/apploader/apploader.h"
 #include <errors.h>
 #include <assert.h>
@@ -19,6 +20,7 @@
 
 #include "util/user_event.h"
 #include "util/i18n.h"
+#include "logging.h"
 #include "pair.dialog.h"
 #include "ui/common/progress_dialog.h"
 
@@ -36,7 +38,10 @@ static bool on_event(lv_fragment_t *self, int code, void *userdata);
 
 static void host_info_cb(int result, const char *error, const uuidstr_t *uuid, void *userdata);
 
-static void send_wol_cb(int result, const char *error, const uuidstr_t *uuid, void *userdata);
+static void send_wol_cb(int result, const char *error, const uuidstr_t *uuid, Uint32 ready_ms,
+                        void *userdata);
+
+static void on_hosts_changed(const pcmanager_changes_t *changes, void *userdata);
 
 static void on_host_updated(const uuidstr_t *uuid, void *userdata);
 
@@ -80,6 +85,10 @@ static void appload_loaded(apploader_list_t *apps, void *userdata);
 
 static void appload_errored(int code, const char *error, void *userdata);
 
+static void appload_unchanged(void *userdata);
+
+static void launch_default_app(apps_fragment_t *fragment);
+
 static void quit_dialog_cb(lv_event_t *event);
 
 static void actions_click_cb(lv_event_t *event);
@@ -104,16 +113,6 @@ static void app_detail_click_cb(lv_event_t *event);
 
 static void set_actions(apps_fragment_t *controller, const char **labels, const action_cb_t *callbacks);
 
-/**
- *
- * @param old_list
- * @param new_list
- * @param num_changes number of changes. It will be assigned to -1 if the whole dataset has been changed.
- * @return Allocated array of changes. It should be freed by caller.
- */
-static lv_gridview_data_change_t *apps_list_detect_change(const apploader_list_t *old_list,
-                                                          const apploader_list_t *new_list, int *num_changes);
-
 static void show_progress(apps_fragment_t *fragment);
 
 static void show_ok(apps_fragment_t *fragment);
@@ -128,8 +127,7 @@ const static lv_gridview_adapter_t apps_adapter = {
         .bind_view = adapter_bind_view,
 };
 const static pcmanager_listener_t pc_listeners = {
-        .updated = on_host_updated,
-        .removed = on_host_removed,
+        .changed = on_hosts_changed,
 };
 
 const lv_fragment_class_t apps_controller_class = {
@@ -156,11 +154,11 @@ static void apps_controller_ctor(lv_fragment_t *self, void *args) {
     controller->apploader_cb.start = appload_started;
     controller->apploader_cb.data = appload_loaded;
     controller->apploader_cb.error = appload_errored;
+    controller->apploader_cb.unchanged = appload_unchanged;
     apps_fragment_arg_t *arg = args;
     controller->global = arg->global;
     controller->uuid = arg->host;
     controller->def_app = arg->def_app;
-    controller->node = pcmanager_node(pcmanager, &controller->uuid);
     controller->apploader = apploader_create(arg->global, &controller->uuid, &controller->apploader_cb, controller);
 
     appitem_style_init(&controller->appitem_style);
@@ -250,11 +248,19 @@ static void on_view_created(lv_fragment_t *self, lv_obj_t *view) {
 
     update_grid_config(controller);
     lv_obj_set_user_data(controller->applist, controller);
+    if (controller->apploader_apps != NULL) {
+        // Loader only passes changed lists, so a recreated view needs the current one
+        lv_gridview_set_data_advanced(controller->applist, controller->apploader_apps, NULL, -1);
+    }
 
     const SERVER_STATE *state = pcmanager_state(pcmanager, &controller->uuid);
-    if (state->code != SERVER_STATE_QUERYING) {
+    const pclist_t *node = pcmanager_node(pcmanager, &controller->uuid);
+    // Hosts restored from snapshot are querying, but nothing has been sent to them yet
+    bool stale = node != NULL && node->stale;
+    if (state->code != SERVER_STATE_QUERYING || stale) {
         pcmanager_request_update(pcmanager, &controller->uuid, host_info_cb, controller);
-        if (state->code == SERVER_STATE_AVAILABLE) {
+        // Cached apps will be shown even if the host hasn't responded yet
+        if (state->code == SERVER_STATE_AVAILABLE || (stale && node->server->paired)) {
             apploader_load(controller->apploader);
         }
     }
@@ -309,6 +315,9 @@ static bool on_event(lv_fragment_t *self, int code, void *userdata) {
             ui_userevent_t *event = userdata;
             if (uuidstr_t_equals_t(&controller->uuid, event->data1)) {
                 controller->show_hidden_apps = true;
+                if (controller->apploader_apps != NULL) {
+                    lv_gridview_set_data_advanced(controller->applist, controller->apploader_apps, NULL, -1);
+                }
                 apploader_load(controller->apploader);
             }
             free(event->data1);
@@ -320,6 +329,23 @@ static bool on_event(lv_fragment_t *self, int code, void *userdata) {
     return false;
 }
 
+static void on_hosts_changed(const pcmanager_changes_t *changes, void *userdata) {
+    apps_fragment_t *controller = (apps_fragment_t *) userdata;
+    for (size_t i = 0; i < changes->num_removed; i++) {
+        if (uuidstr_t_equals_t(&controller->uuid, &changes->removed[i])) {
+            // Controller is deleted, nothing else should be done
+            on_host_removed(&changes->removed[i], controller);
+            return;
+        }
+    }
+    for (size_t i = 0; i < changes->num_updated; i++) {
+        if (uuidstr_t_equals_t(&controller->uuid, &changes->updated[i])) {
+            on_host_updated(&changes->updated[i], controller);
+            return;
+        }
+    }
+}
+
 static void on_host_updated(const uuidstr_t *uuid, void *userdata) {
     apps_fragment_t *controller = (apps_fragment_t *) userdata;
     if (controller != current_instance) { return; }
@@ -335,7 +361,6 @@ static void on_host_updated(const uuidstr_t *uuid, void *userdata) {
 static void on_host_removed(const uuidstr_t *uuid, void *userdata) {
     apps_fragment_t *controller = (apps_fragment_t *) userdata;
     if (!uuidstr_t_equals_t(&controller->uuid, uuid)) { return; }
-    controller->node = NULL;
     lv_fragment_del((lv_fragment_t *) controller);
 }
 
@@ -346,8 +371,12 @@ static void host_info_cb(int result, const char *error, const uuidstr_t *uuid, v
     lv_btnmatrix_clear_btn_ctrl_all(controller->actions, LV_BTNMATRIX_CTRL_DISABLED);
 }
 
-static void send_wol_cb(int result, const char *error, const uuidstr_t *uuid, void *userdata) {
+static void send_wol_cb(int result, const char *error, const uuidstr_t *uuid, Uint32 ready_ms,
+                        void *userdata) {
     apps_fragment_t *controller = (apps_fragment_t *) userdata;
+    if (result == GS_OK) {
+        commons_log_info("Apps", "Host woke up in %u ms", ready_ms);
+    }
     if (controller != current_instance) { return; }
     if (!controller->base.managed->obj_created) { return; }
     lv_btnmatrix_clear_btn_ctrl_all(controller->actions, LV_BTNMATRIX_CTRL_DISABLED);
@@ -367,6 +396,13 @@ static void update_view_state(apps_fragment_t *controller) {
     switch (state->code) {
         case SERVER_STATE_NONE:
         case SERVER_STATE_QUERYING: {
+            if (controller->apploader_apps) {
+                // showing cached apps of the last known state while the host is being asked
+                if (lv_obj_has_flag(controller->applist, LV_OBJ_FLAG_HIDDEN)) {
+                    show_ok(controller);
+                }
+                break;
+            }
             // waiting to load server info
             show_progress(controller);
             break;
@@ -376,6 +412,10 @@ static void update_view_state(apps_fragment_t *controller) {
                 case APPLOADER_STATE_LOADING: {
                     // is loading apps
                     if (controller->apploader_apps) {
+                        // showing cached apps while the host is being asked
+                        if (lv_obj_has_flag(controller->applist, LV_OBJ_FLAG_HIDDEN)) {
+                            show_ok(controller);
+                        }
                         break;
                     }
                     show_progress(controller);
@@ -393,6 +433,13 @@ static void update_view_state(apps_fragment_t *controller) {
                     break;
                 }
                 case APPLOADER_STATE_IDLE: {
+                    // Nodes are replaced on every change, so it's looked up each time
+                    const pclist_t *node = pcmanager_node(pcmanager, &controller->uuid);
+                    if (!controller->apploader_apps && node != NULL && node->stale) {
+                        // waiting for host to respond
+                        show_progress(controller);
+                        break;
+                    }
                     // has apps
                     show_ok(controller);
                     break;
@@ -485,7 +532,11 @@ static void appload_loaded(apploader_list_t *apps, void *userdata) {
         return;
     }
     int num_changes = -1;
-    lv_gridview_data_change_t *changes = apps_list_detect_change(fragment->apploader_apps, apps, &num_changes);
+    // Only items within the displayed range are compared, hidden apps at the end may not be shown
+    lv_obj_t *applist = fragment->applist;
+    lv_gridview_data_change_t *changes = apps_list_diff(fragment->apploader_apps,
+                                                        adapter_item_count(applist, fragment->apploader_apps),
+                                                        apps, adapter_item_count(applist, apps), &num_changes);
     if (num_changes != 0) {
         lv_gridview_focus(fragment->applist, -1);
     }
@@ -496,20 +547,7 @@ static void appload_loaded(apploader_list_t *apps, void *userdata) {
     apploader_list_free(fragment->apploader_apps);
     fragment->apploader_apps = apps;
     update_view_state(fragment);
-
-    if (fragment->def_app > 0 && !fragment->def_app_launched) {
-        fragment->def_app_launched = true;
-        const apploader_item_t *app = NULL;
-        for (int i = 0; i < apps->count; ++i) {
-            if (apps->items[i].base.id == fragment->def_app) {
-                app = &apps->items[i];
-                break;
-            }
-        }
-        if (app != NULL) {
-            launcher_launch_game(fragment, app);
-        }
-    }
+    launch_default_app(fragment);
 }
 
 static void appload_errored(int code, const char *error, void *userdata) {
@@ -519,6 +557,29 @@ static void appload_errored(int code, const char *error, void *userdata) {
     update_view_state(fragment);
 }
 
+static void appload_unchanged(void *userdata) {
+    apps_fragment_t *fragment = userdata;
+    if (!fragment->base.managed->obj_created || fragment->base.managed->destroying_obj) {
+        return;
+    }
+    update_view_state(fragment);
+    launch_default_app(fragment);
+}
+
+static void launch_default_app(apps_fragment_t *fragment) {
+    // Cached list may be outdated, wait for the host to confirm
+    if (fragment->def_app <= 0 || fragment->def_app_launched || fragment->apploader_apps == NULL ||
+        apploader_state(fragment->apploader) != APPLOADER_STATE_IDLE ||
+        pcmanager_state(pcmanager, &fragment->uuid)->code != SERVER_STATE_AVAILABLE) {
+        return;
+    }
+    fragment->def_app_launched = true;
+    const apploader_item_t *app = apploader_list_item_by_id(fragment->apploader_apps, fragment->def_app);
+    if (app != NULL) {
+        launcher_launch_game(fragment, app);
+    }
+}
+
 static void appitem_bind(apps_fragment_t *controller, lv_obj_t *item, apploader_item_t *app) {
     appitem_viewholder_t *holder = lv_obj_get_user_data(item);
 
@@ -526,8 +587,9 @@ static void appitem_bind(apps_fragment_t *controller, lv_obj_t *item, apploader_
                         controller->col_width, controller->col_height);
     lv_label_set_text(holder->title, app->base.name);
 
-    assert(controller->node);
-    int current_id = pcmanager_node_current_app(controller->node);
+    const pclist_t *node = pcmanager_node(pcmanager, &controller->uuid);
+    assert(node);
+    int current_id = pcmanager_node_current_app(node);
     if (current_id == app->base.id) {
         lv_obj_clear_flag(holder->play_indicator, LV_OBJ_FLAG_HIDDEN);
     } else {
@@ -593,7 +655,11 @@ static void launcher_toggle_fav(apps_fragment_t *controller, const apploader_ite
 
 static void launcher_toggle_hidden(apps_fragment_t *controller, const apploader_item_t *app) {
     pcmanager_set_app_hidden(pcmanager, &controller->uuid, app->base.id, !app->hidden);
-    controller->show_hidden_apps = true;
+    if (!controller->show_hidden_apps) {
+        // Displayed range changes, so the next list can't be compared with the current one
+        controller->show_hidden_apps = true;
+        lv_gridview_set_data_advanced(controller->applist, controller->apploader_apps, NULL, -1);
+    }
     apploader_load(controller->apploader);
 }
 
@@ -789,26 +855,3 @@ static void set_actions(apps_fragment_t *controller, const char **labels, const
     lv_obj_set_style_min_width(controller->actions, LV_PCT(20 * num_actions), 0);
     lv_obj_set_user_data(controller->actions, (void *) callbacks);
 }
-
-
-static lv_gridview_data_change_t *apps_list_detect_change(const apploader_list_t *old_list,
-                                                          const apploader_list_t *new_list, int *num_changes) {
-    if (old_list == NULL && new_list == NULL) {
-        *num_changes = 0;
-        return NULL;
-    } else if ((old_list != NULL) != (new_list != NULL)) {
-        *num_changes = -1;
-        return NULL;
-    } else if (old_list->count != new_list->count) {
-        *num_changes = -1;
-        return NULL;
-    }
-    for (int i = 0; i < old_list->count; i++) {
-        if (old_list->items[i].base.id != new_list->items[i].base.id) {
-            *num_changes = -1;
-            return NULL;
-        }
-    }
-    *num_changes = 0;
-    return NULL;
-}
\ No newline at end of file
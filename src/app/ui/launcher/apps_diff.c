@@ -0,0 +1,151 @@
+#include "apps_diff.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL_stdinc.h>
+
+typedef enum diff_op_t {
+    DIFF_OP_KEEP,
+    DIFF_OP_UPDATE,
+    DIFF_OP_REMOVE,
+    DIFF_OP_INSERT,
+} diff_op_t;
+
+static int diff_edit_script(const apploader_item_t *a, int n, const apploader_item_t *b, int m, diff_op_t *ops);
+
+static bool item_content_equals(const apploader_item_t *a, const apploader_item_t *b);
+
+lv_gridview_data_change_t *apps_list_diff(const apploader_list_t *old_list, int old_count,
+                                          const apploader_list_t *new_list, int new_count, int *num_changes) {
+    if (old_list == NULL && new_list == NULL) {
+        *num_changes = 0;
+        return NULL;
+    } else if ((old_list != NULL) != (new_list != NULL)) {
+        *num_changes = -1;
+        return NULL;
+    }
+    diff_op_t *ops = malloc((old_count + new_count + 1) * sizeof(diff_op_t));
+    int num_ops = diff_edit_script(old_list->items, old_count, new_list->items, new_count, ops);
+    if (num_ops < 0) {
+        free(ops);
+        *num_changes = -1;
+        return NULL;
+    }
+
+    lv_gridview_data_change_t *changes = NULL;
+    int count = 0, pos = 0;
+    for (int i = 0; i < num_ops; i++) {
+        if (ops[i] == DIFF_OP_KEEP) {
+            pos++;
+            continue;
+        }
+        lv_gridview_data_change_t *change = count > 0 ? &changes[count - 1] : NULL;
+        // Adjacent edits are merged, as removed items are consecutive in old list and inserted ones in new list
+        if (change == NULL || change->start + change->add_count != pos) {
+            changes = realloc(changes, (count + 1) * sizeof(lv_gridview_data_change_t));
+            change = &changes[count++];
+            memset(change, 0, sizeof(lv_gridview_data_change_t));
+            change->start = pos;
+        }
+        switch (ops[i]) {
+            case DIFF_OP_UPDATE:
+                change->remove_count++;
+                change->add_count++;
+                pos++;
+                break;
+            case DIFF_OP_REMOVE:
+                change->remove_count++;
+                break;
+            case DIFF_OP_INSERT:
+                change->add_count++;
+                pos++;
+                break;
+            default:
+                break;
+        }
+    }
+    free(ops);
+    *num_changes = count;
+    return changes;
+}
+
+/**
+ * Myers' O((N+M)D) difference algorithm, matching items by id.
+ *
+ * @param ops Edit script, should have space for n + m operations
+ * @return Number of operations, or -1 if more than APPS_DIFF_MAX_EDITS edits are needed
+ */
+static int diff_edit_script(const apploader_item_t *a, int n, const apploader_item_t *b, int m, diff_op_t *ops) {
+    int max_d = SDL_min(n + m, APPS_DIFF_MAX_EDITS);
+    int width = 2 * max_d + 3, offset = max_d + 1;
+    // Furthest x reached on each diagonal k = x - y, saved after each round to trace the path back
+    int *v = calloc(width, sizeof(int));
+    int *trace = malloc((size_t) (max_d + 1) * width * sizeof(int));
+    int found_d = -1;
+    for (int d = 0; d <= max_d && found_d < 0; d++) {
+        for (int k = -d; k <= d; k += 2) {
+            int x;
+            if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) {
+                x = v[offset + k + 1];
+            } else {
+                x = v[offset + k - 1] + 1;
+            }
+            int y = x - k;
+            while (x < n && y < m && a[x].base.id == b[y].base.id) {
+                x++;
+                y++;
+            }
+            v[offset + k] = x;
+            if (x >= n && y >= m) {
+                found_d = d;
+                break;
+            }
+        }
+        memcpy(trace + (size_t) d * width, v, width * sizeof(int));
+    }
+    free(v);
+    if (found_d < 0) {
+        free(trace);
+        return -1;
+    }
+
+    // Walk back from the end, filling operations from the tail
+    int num_ops = 0, x = n, y = m;
+    diff_op_t *tail = ops + n + m;
+    for (int d = found_d; d > 0; d--) {
+        const int *prev = trace + (size_t) (d - 1) * width;
+        int k = x - y;
+        int prev_k;
+        if (k == -d || (k != d && prev[offset + k - 1] < prev[offset + k + 1])) {
+            prev_k = k + 1;
+        } else {
+            prev_k = k - 1;
+        }
+        int prev_x = prev[offset + prev_k], prev_y = prev_x - prev_k;
+        while (x > prev_x && y > prev_y) {
+            x--;
+            y--;
+            *(--tail) = item_content_equals(&a[x], &b[y]) ? DIFF_OP_KEEP : DIFF_OP_UPDATE;
+            num_ops++;
+        }
+        *(--tail) = x == prev_x ? DIFF_OP_INSERT : DIFF_OP_REMOVE;
+        num_ops++;
+        x = prev_x;
+        y = prev_y;
+    }
+    while (x > 0 && y > 0) {
+        x--;
+        y--;
+        *(--tail) = item_content_equals(&a[x], &b[y]) ? DIFF_OP_KEEP : DIFF_OP_UPDATE;
+        num_ops++;
+    }
+    free(trace);
+    memmove(ops, tail, num_ops * sizeof(diff_op_t));
+    return num_ops;
+}
+
+static bool item_content_equals(const apploader_item_t *a, const apploader_item_t *b) {
+    return a->base.hdr == b->base.hdr && a->fav == b->fav && a->hidden == b->hidden &&
+           strcmp(a->base.name, b->base.name) == 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "backend/apploader/apploader.h"
+#include "lv_gridview.h"
+
+/* Lists differing more than this are reloaded as a whole, rebinding everything is cheaper by then */
+#define APPS_DIFF_MAX_EDITS 128
+
+/**
+ * Find changes turning the first old_count items of old_list into the first new_count items of new_list.
+ *
+ * Apps are matched by id, and changes are applied in order, each starting from the result of previous ones. Apps
+ * moved to another position are removed and inserted again, apps with different name or flags are updated in place.
+ *
+ * @param num_changes Number of changes. It will be assigned to -1 if the whole dataset has been changed.
+ * @return Allocated array of changes. It should be freed by caller.
+ */
+lv_gridview_data_change_t *apps_list_diff(const apploader_list_t *old_list, int old_count,
+                                          const apploader_list_t *new_list, int new_count, int *num_changes);
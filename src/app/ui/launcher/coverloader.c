@@ -381,14 +381,18 @@ static bool coverloader_fetch(coverloader_req_t *req) {
         return NULL;
     }
 #endif
-    const pclist_t *node = pcmanager_node(pcmanager, &req->server_id);
+    const pclist_snapshot_t *servers = pcmanager_servers_acquire(pcmanager);
+    const pclist_t *node = pcmanager_servers_find(servers, &req->server_id);
     if (!node) {
+        pcmanager_servers_release(servers);
         return false;
     }
     char path[4096];
     coverloader_cache_item_path(path, req);
     GS_CLIENT client = coverloader_gs_client(req->loader);
-    if (gs_download_cover(client, node->server, req->id, path) != GS_OK) {
+    int ret = gs_download_cover(client, node->server, req->id, path);
+    pcmanager_servers_release(servers);
+    if (ret != GS_OK) {
         return false;
     }
     return coverloader_filecache_get(req);
@@ -30,11 +30,9 @@ static void launcher_view_destroy(lv_fragment_t *self, lv_obj_t *view);
 
 static bool launcher_event_cb(lv_fragment_t *self, int code, void *userdata);
 
-static void on_pc_added(const uuidstr_t *uuid, void *userdata);
+static void on_pc_changed(const pcmanager_changes_t *changes, void *userdata);
 
-static void on_pc_updated(const uuidstr_t *uuid, void *userdata);
-
-static void on_pc_removed(const uuidstr_t *uuid, void *userdata);
+static void pc_item_remove(launcher_fragment_t *controller, const uuidstr_t *uuid);
 
 static void update_pclist(launcher_fragment_t *controller);
 
@@ -87,9 +85,7 @@ const lv_fragment_class_t launcher_controller_class = {
 };
 
 static const pcmanager_listener_t pcmanager_callbacks = {
-        .added = on_pc_added,
-        .updated = on_pc_updated,
-        .removed = on_pc_removed,
+        .changed = on_pc_changed,
 };
 
 static launcher_fragment_t *current_instance = NULL;
@@ -172,25 +168,42 @@ static void launcher_view_init(lv_fragment_t *self, lv_obj_t *view) {
 
     populate_selected_host(fragment);
 
-    for (const pclist_t *cur = pcmanager_servers(pcmanager); cur != NULL; cur = cur->next) {
+    // Selecting may change hosts, hold the snapshot while iterating
+    const pclist_snapshot_t *servers = pcmanager_servers_acquire(pcmanager);
+    const uuidstr_t *selected = NULL;
+    for (size_t i = 0; i < servers->count; i++) {
+        const pclist_t *cur = servers->nodes[i];
         if (cur->selected) {
+            selected = &cur->id;
             select_pc(fragment, &cur->id, true);
             if (fragment->first_created) {
                 fragment->detail_opened = true;
             }
-            continue;
+            break;
         }
-        pcmanager_request_update(pcmanager, &cur->id, NULL, NULL);
     }
+    // Selected host is updated by apps page
+    pcmanager_refresh(pcmanager, selected);
+    pcmanager_servers_release(servers);
     fragment->pane_initialized = true;
     set_detail_opened(fragment, fragment->detail_opened);
-    pcmanager_auto_discovery_start(pcmanager);
+    // On launch, it's started after the first frame
+    if (fragment->global->startup_finished) {
+        pcmanager_auto_discovery_start(pcmanager);
+    }
 
     lv_obj_set_style_transition(fragment->detail, &fragment->tr_nav, 0);
     lv_obj_set_style_transition(fragment->detail, &fragment->tr_detail, LV_STATE_USER_1);
     current_instance = fragment;
 
     if (fragment->first_created) {
+        servers = pcmanager_servers(pcmanager);
+        int hosts = (int) servers->count, restored = 0;
+        for (size_t i = 0; i < servers->count; i++) {
+            restored += servers->nodes[i]->stale ? 1 : 0;
+        }
+        commons_log_info("Launcher", "Interactive at %u ms, %d of %d hosts restored before any response",
+                         SDL_GetTicks(), restored, hosts);
         if (!app_decoder_or_embedded_present(fragment->global)) {
             show_decoder_error();
         }
@@ -226,30 +239,36 @@ static bool launcher_event_cb(lv_fragment_t *self, int code, void *userdata) {
     return false;
 }
 
-void on_pc_added(const uuidstr_t *uuid, void *userdata) {
-    launcher_fragment_t *controller = userdata;
-    const pclist_t *node = pcmanager_node(pcmanager, uuid);
-    if (node == NULL) { return; }
-    pclist_item_create(controller, node);
-
-    populate_selected_host(controller);
-}
-
-void on_pc_updated(const uuidstr_t *uuid, void *userdata) {
+static void on_pc_changed(const pcmanager_changes_t *changes, void *userdata) {
     launcher_fragment_t *controller = userdata;
+    for (size_t i = 0; i < changes->num_removed; i++) {
+        pc_item_remove(controller, &changes->removed[i]);
+    }
+    for (size_t i = 0; i < changes->num_added; i++) {
+        const pclist_t *node = pcmanager_node(pcmanager, &changes->added[i]);
+        if (node == NULL) { continue; }
+        pclist_item_create(controller, node);
+    }
+    if (changes->num_added > 0) {
+        populate_selected_host(controller);
+    }
+    if (changes->num_updated == 0) {
+        return;
+    }
+    // Refresh icons of all updated hosts in one pass
     for (uint16_t i = 0, j = lv_obj_get_child_cnt(controller->pclist); i < j; i++) {
         lv_obj_t *child = lv_obj_get_child(controller->pclist, i);
         const uuidstr_t *item_id = (const uuidstr_t *) lv_obj_get_user_data(child);
-        if (!uuidstr_t_equals_t(uuid, item_id)) { continue; }
-        const pclist_t *node = pcmanager_node(pcmanager, item_id);
-        const char *icon = server_item_icon(node);
-        lv_btn_set_icon(child, icon);
-        break;
+        for (size_t k = 0; k < changes->num_updated; k++) {
+            if (!uuidstr_t_equals_t(&changes->updated[k], item_id)) { continue; }
+            const pclist_t *node = pcmanager_node(pcmanager, item_id);
+            lv_btn_set_icon(child, server_item_icon(node));
+            break;
+        }
     }
 }
 
-void on_pc_removed(const uuidstr_t *uuid, void *userdata) {
-    launcher_fragment_t *controller = userdata;
+static void pc_item_remove(launcher_fragment_t *controller, const uuidstr_t *uuid) {
     for (uint16_t i = 0, j = lv_obj_get_child_cnt(controller->pclist); i < j; i++) {
         lv_obj_t *child = lv_obj_get_child(controller->pclist, i);
         const uuidstr_t *item_id = (const uuidstr_t *) lv_obj_get_user_data(child);
@@ -307,7 +326,9 @@ static void select_pc(launcher_fragment_t *controller, const uuidstr_t *uuid, bo
 
 static void update_pclist(launcher_fragment_t *controller) {
     lv_obj_clean(controller->pclist);
-    for (const pclist_t *cur = pcmanager_servers(pcmanager); cur != NULL; cur = cur->next) {
+    const pclist_snapshot_t *servers = pcmanager_servers(pcmanager);
+    for (size_t i = 0; i < servers->count; i++) {
+        const pclist_t *cur = servers->nodes[i];
         lv_obj_t *pcitem = pclist_item_create(controller, cur);
         pcitem_set_selected(pcitem, cur->selected);
     }
@@ -451,6 +472,8 @@ static void set_detail_opened(launcher_fragment_t *controller, bool opened) {
 
 static void open_manual_add(lv_event_t *event) {
     LV_UNUSED(event);
+    // User is looking for a host, so don't wait for the slow query interval
+    pcmanager_auto_discovery_rescan(pcmanager);
     lv_fragment_t *fragment = lv_fragment_create(&add_dialog_class, NULL);
     lv_obj_t *msgbox = lv_fragment_create_obj(fragment, NULL);
     lv_obj_add_event_cb(msgbox, ui_cb_destroy_fragment, LV_EVENT_DELETE, fragment);
@@ -505,12 +528,10 @@ static void populate_selected_host(launcher_fragment_t *controller) {
         uuidstr_is_empty(&controller->launch_params->default_host_uuid)) {
         return;
     }
-    for (const pclist_t *cur = pcmanager_servers(pcmanager); cur != NULL; cur = cur->next) {
-        if (uuidstr_t_equals_t(&cur->id, &controller->launch_params->default_host_uuid)) {
-            commons_log_info("UI", "Host %s was selected", cur->server->hostname);
-            pcmanager_select(pcmanager, &cur->id);
-            controller->def_host_selected = true;
-            break;
-        }
+    const pclist_t *node = pcmanager_node(pcmanager, &controller->launch_params->default_host_uuid);
+    if (node != NULL) {
+        commons_log_info("UI", "Host %s was selected", node->server->hostname);
+        pcmanager_select(pcmanager, &node->id);
+        controller->def_host_selected = true;
     }
 }
\ No newline at end of file
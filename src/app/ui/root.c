@@ -48,15 +48,28 @@ static void session_error();
 
 static void session_error_dialog_cb(lv_event_t *event);
 
+static void ui_frame_rendered(lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px);
+
 void app_ui_init(app_ui_t *ui, app_t *app) {
+    startup_trace_t *trace = &app->startup_trace;
     ui->app = app;
+    startup_trace_begin(trace, "window");
     ui->window = app_ui_create_window(ui);
+    startup_trace_end(trace);
     lv_log_register_print_cb(commons_lv_log);
+    startup_trace_begin(trace, "lvgl");
     lv_init();
+    startup_trace_end(trace);
+    startup_trace_begin(trace, "img_decoder");
     ui->img_decoder = lv_sdl_img_decoder_init(IMG_INIT_JPG | IMG_INIT_PNG);
+    startup_trace_end(trace);
+    startup_trace_begin(trace, "fonts");
     app_font_init(&ui->fonts, ui->dpi);
+    startup_trace_end(trace);
     lv_memset_00(&ui->theme, sizeof(lv_theme_t));
+    startup_trace_begin(trace, "theme");
     lv_theme_moonlight_init(&ui->theme, &ui->fonts, app);
+    startup_trace_end(trace);
 }
 
 void app_ui_deinit(app_ui_t *ui) {
@@ -76,6 +89,9 @@ void app_ui_open(app_ui_t *ui, const app_launch_params_t *params) {
         ui->window = app_ui_create_window(ui);
     }
     lv_disp_drv_t *driver = lv_app_disp_drv_create(ui->window, ui->dpi);
+    if (!ui->app->startup_finished) {
+        driver->monitor_cb = ui_frame_rendered;
+    }
     lv_disp_t *disp = lv_disp_drv_register(driver);
     disp->bg_color = lv_color_make(0, 0, 0);
     disp->bg_opa = 0;
@@ -103,6 +119,7 @@ void app_ui_open(app_ui_t *ui, const app_launch_params_t *params) {
     SDL_SetAssertionHandler(app_assertion_handler_ui, ui->app);
 
     app_set_keep_awake(ui->app, false);
+    app_power_update(ui->app);
 }
 
 void app_ui_close(app_ui_t *ui) {
@@ -125,6 +142,7 @@ void app_ui_close(app_ui_t *ui) {
     ui->disp = NULL;
     SDL_DestroyWindow(ui->window);
     ui->window = NULL;
+    app_power_update(ui->app);
 }
 
 bool app_ui_is_opened(const app_ui_t *ui) {
@@ -347,3 +365,11 @@ static void session_error_dialog_cb(lv_event_t *event) {
     lv_obj_t *dialog = lv_event_get_current_target(event);
     lv_msgbox_close_async(dialog);
 }
+
+static void ui_frame_rendered(lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px) {
+    (void) time;
+    (void) px;
+    disp_drv->monitor_cb = NULL;
+    // Let this frame be presented first
+    app_bus_post(global, (bus_actionfunc) app_startup_finished, global);
+}
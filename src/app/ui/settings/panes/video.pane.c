@@ -127,6 +127,18 @@ static lv_obj_t *create_obj(lv_fragment_t *self, lv_obj_t *container) {
     lv_obj_set_style_text_color(hdr_more, lv_theme_get_color_primary(hdr_more), 0);
     lv_obj_add_flag(hdr_more, LV_OBJ_FLAG_CLICKABLE);
 
+    lv_obj_t *rfi_checkbox = pref_checkbox(view, locstr("Fast frame loss recovery"), &app_configuration->rfi, false);
+    lv_obj_t *rfi_hint = pref_desc_label(view, NULL, false);
+    if (app_is_decoder_rfi_supported(app)) {
+        lv_obj_clear_state(rfi_checkbox, LV_STATE_DISABLED);
+        lv_label_set_text(rfi_hint, locstr("Recover from lost frames without waiting for a full keyframe. "
+                                           "Turn off if picture gets corrupted after network hiccups."));
+    } else {
+        lv_obj_add_state(rfi_checkbox, LV_STATE_DISABLED);
+        lv_label_set_text_fmt(rfi_hint, locstr("%s decoder couldn't recover from lost frames this way."),
+                              SS4S_ModuleInfoGetName(app->ss4s.selection.video_module));
+    }
+
     lv_obj_add_event_cb(vdec_dropdown, module_changed_cb, LV_EVENT_VALUE_CHANGED, controller);
     lv_obj_add_event_cb(hevc_checkbox, hdr_state_update_cb, LV_EVENT_VALUE_CHANGED, controller);
     lv_obj_add_event_cb(av1_checkbox, hdr_state_update_cb, LV_EVENT_VALUE_CHANGED, controller);
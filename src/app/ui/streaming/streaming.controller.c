@@ -80,6 +80,20 @@ bool streaming_refresh_stats() {
                           SS4S_ModuleInfoGetId(app->ss4s.selection.video_module), vdec_stream_info.format);
     lv_label_set_text_fmt(controller->stats_items.audio, "%s (%s)",
                           SS4S_ModuleInfoGetId(app->ss4s.selection.audio_module), audio_stream_info.format);
+    const struct AUDIO_STATS *audio_stats = &audio_summary_stats;
+    if (audio_stats->lostFrames) {
+        lv_label_set_text_fmt(controller->stats_items.audio_loss, "%u (%u concealed, %u FEC)",
+                              audio_stats->lostFrames, audio_stats->concealedFrames, audio_stats->fecFrames);
+    } else {
+        lv_label_set_text(controller->stats_items.audio_loss, "-");
+    }
+    if (audio_stats->targetMs > 0) {
+        lv_label_set_text_fmt(controller->stats_items.audio_buffer, "%.0f ms (target %.0f ms, %u underruns, "
+                                                                    "drift %.0f ppm)", audio_stats->queuedMs,
+                              audio_stats->targetMs, audio_stats->underruns, audio_stats->driftPpm);
+    } else {
+        lv_label_set_text(controller->stats_items.audio_buffer, "-");
+    }
     lv_label_set_text_fmt(controller->stats_items.rtt, "%d ms (var. %d ms)", dst->rtt, dst->rttVariance);
     lv_label_set_text_fmt(controller->stats_items.net_fps, "%.2f FPS", dst->receivedFps);
 
@@ -104,6 +118,19 @@ bool streaming_refresh_stats() {
         lv_label_set_text_fmt(controller->stats_items.host_latency, "-");
         lv_label_set_text_fmt(controller->stats_items.vdec_latency, "-");
     }
+    uint32_t recoveries = dst->rfiRecoveries + dst->idrRecoveries;
+    if (recoveries) {
+        lv_label_set_text_fmt(controller->stats_items.recovery, "%u RFI, %u IDR (avg %u ms, max %u ms)",
+                              dst->rfiRecoveries, dst->idrRecoveries, dst->totalRecoveryTime / recoveries,
+                              dst->maxRecoveryTime);
+    } else {
+        lv_label_set_text(controller->stats_items.recovery, "-");
+    }
+    if (app->session != NULL) {
+        char startup[512];
+        session_startup_summary(app->session, startup, sizeof(startup));
+        lv_label_set_text(controller->stats_items.startup, startup);
+    }
     return true;
 }
 
@@ -24,11 +24,15 @@ typedef struct {
         lv_obj_t *resolution;
         lv_obj_t *decoder;
         lv_obj_t *audio;
+        lv_obj_t *audio_loss;
+        lv_obj_t *audio_buffer;
         lv_obj_t *rtt;
         lv_obj_t *net_fps;
         lv_obj_t *drop_rate;
         lv_obj_t *host_latency;
         lv_obj_t *vdec_latency;
+        lv_obj_t *recovery;
+        lv_obj_t *startup;
     } stats_items;
     lv_obj_t *stats_pin;
     lv_obj_t *notice, *notice_label;
@@ -128,6 +128,11 @@ lv_obj_t *streaming_scene_create(lv_fragment_t *self, lv_obj_t *parent) {
     controller->stats_items.drop_rate = stat_label(stats, "Network frame drop");
     controller->stats_items.host_latency = stat_label(stats, "Host processing latency");
     controller->stats_items.vdec_latency = stat_label(stats, "Decoder latency");
+    controller->stats_items.recovery = stat_label(stats, "Frame loss recovery");
+    controller->stats_items.audio_loss = stat_label(stats, "Audio frame loss");
+    controller->stats_items.audio_buffer = stat_label(stats, "Audio buffer");
+    controller->stats_items.startup = stat_label(stats, "Startup");
+    lv_obj_set_style_text_align(controller->stats_items.startup, LV_TEXT_ALIGN_RIGHT, 0);
 
 
     lv_obj_add_flag(overlay, LV_OBJ_FLAG_HIDDEN);
@@ -1,12 +1,34 @@
 #include "font.h"
+#include "font_cache.h"
+#include "path.h"
 #include "ui/config.h"
 #include "i18n.h"
 #include "res.h"
+#include "logging.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL_timer.h>
 
 #include <fontconfig/fontconfig.h>
 
+#define FONT_CACHE_FILE "fonts.bin"
+
+enum {
+    FONT_FILE_MAIN,
+    FONT_FILE_FALLBACK,
+};
+
+static bool fonts_resolve(char **files);
+
+static uint32_t fonts_cache_key(FcConfig *config, const char *locale, const char *fallback_family);
+
+static bool fonts_resolve_fc(FcConfig *config, const char *locale, const char *fallback_family, char **files);
 
-static bool fontset_load_fc(app_fontset_t *set, FcPattern *font);
+static char *font_match_file(FcConfig *config, FcPattern *pattern);
+
+static bool fontset_load_file(app_fontset_t *set, const char *file);
 
 static bool fontset_load_mem(app_fontset_t *set, const char *name, const void *mem, size_t size);
 
@@ -22,97 +44,171 @@ int app_font_init(app_fonts_t *fonts, int dpi) {
     if (!fontset_load_mem(&iconfonts, "MaterialIcons", res_mat_iconfont_data, res_mat_iconfont_size)) {
         return -1;
     }
-    //does not necessarily have to be a specific name.  You could put anything here and Fontconfig WILL find a font for you
-    FcPattern *pattern = FcNameParse((const FcChar8 *) FONT_FAMILY);
-    if (!pattern) {
+    if (!fonts->resolved && app_font_resolve(fonts) != 0) {
+        fontset_destroy_fonts(&iconfonts);
+        return -1;
+    }
+    char **files = fonts->files;
+    if (files[FONT_FILE_MAIN] == NULL || !fontset_load_file(&fontset, files[FONT_FILE_MAIN])) {
+        font_cache_files_free(files, APP_FONT_FILES);
         fontset_destroy_fonts(&iconfonts);
         return -1;
     }
+    if (files[FONT_FILE_FALLBACK] != NULL) {
+        fontset.fallback = calloc(1, sizeof(app_fontset_t));
+        fontset.fallback->small_size = fontset.small_size;
+        fontset.fallback->normal_size = fontset.normal_size;
+        fontset.fallback->large_size = fontset.large_size;
+        if (fontset_load_file(fontset.fallback, files[FONT_FILE_FALLBACK])) {
+            fontset.normal->fallback = fontset.fallback->normal;
+            fontset.large->fallback = fontset.fallback->large;
+            fontset.small->fallback = fontset.fallback->small;
+        } else {
+            free(fontset.fallback);
+            fontset.fallback = NULL;
+        }
+    }
+    font_cache_files_free(files, APP_FONT_FILES);
+    fonts->fonts = fontset;
+    fonts->icons = iconfonts;
+    return 0;
+}
 
-    FcConfigSubstitute(NULL, pattern, FcMatchPattern);
-    FcDefaultSubstitute(pattern);
+int app_font_resolve(app_fonts_t *fonts) {
+    fonts->resolved = fonts_resolve(fonts->files);
+    return fonts->resolved ? 0 : -1;
+}
 
-    FcResult result;
+void app_font_deinit(app_fonts_t *fonts) {
+    fontset_destroy_fonts(&fonts->fonts);
+    fontset_destroy_fonts(&fonts->icons);
+}
 
-    FcPattern *font = FcFontMatch(NULL, pattern, &result);
-    if (font == NULL) {
-        return -1;
+/**
+ * Find font files with fontconfig, or take them from the cache if locale, families and font directories haven't
+ * changed since last launch. Scanning font directories takes hundreds of milliseconds on some devices.
+ */
+static bool fonts_resolve(char **files) {
+    Uint32 start = SDL_GetTicks();
+    const char *locale = NULL, *fallback_family = NULL;
+#ifdef FONT_FAMILY_FALLBACK
+    const i18n_entry_t *loc_entry = i18n_entry(i18n_locale());
+    if (loc_entry != NULL) {
+        locale = loc_entry->locale;
     }
-    if (!fontset_load_fc(&fontset, font)) {
-        return -1;
+    fallback_family = (loc_entry && loc_entry->font) ? loc_entry->font : FONT_FAMILY_FALLBACK;
+#endif
+    // Only parses the configuration, font directories are scanned when they're actually needed
+    FcConfig *config = FcInitLoadConfig();
+    if (config == NULL) {
+        return false;
     }
-    if (font) {
-        FcPatternDestroy(font);
-        font = NULL;
+    uint32_t key = fonts_cache_key(config, locale, fallback_family);
+    char *cache_dir = path_cache();
+    char *cache_path = path_join(cache_dir, FONT_CACHE_FILE);
+    free(cache_dir);
+
+    bool resolved = true;
+    if (font_cache_load(cache_path, key, files, APP_FONT_FILES) == 0) {
+        commons_log_info("Font", "Resolved fonts from cache in %u ms", SDL_GetTicks() - start);
+    } else if (fonts_resolve_fc(config, locale, fallback_family, files)) {
+        commons_log_info("Font", "Resolved fonts with fontconfig in %u ms", SDL_GetTicks() - start);
+        font_cache_save(cache_path, key, files, APP_FONT_FILES);
+    } else {
+        resolved = false;
+    }
+    free(cache_path);
+    FcConfigDestroy(config);
+    return resolved;
+}
+
+static uint32_t fonts_cache_key(FcConfig *config, const char *locale, const char *fallback_family) {
+    char version[16];
+    SDL_snprintf(version, sizeof(version), "%d", FcGetVersion());
+    uint32_t key = font_cache_key_add_str(FONT_CACHE_KEY_INIT, version);
+    key = font_cache_key_add_str(key, locale);
+    key = font_cache_key_add_str(key, FONT_FAMILY);
+    key = font_cache_key_add_str(key, fallback_family);
+    FcStrList *list = FcConfigGetConfigFiles(config);
+    FcChar8 *path;
+    while ((path = FcStrListNext(list)) != NULL) {
+        key = font_cache_key_add_path(key, (const char *) path);
+    }
+    FcStrListDone(list);
+    list = FcConfigGetFontDirs(config);
+    while ((path = FcStrListNext(list)) != NULL) {
+        key = font_cache_key_add_path(key, (const char *) path);
     }
+    FcStrListDone(list);
+    return key;
+}
+
+static bool fonts_resolve_fc(FcConfig *config, const char *locale, const char *fallback_family, char **files) {
+    files[FONT_FILE_MAIN] = NULL;
+    files[FONT_FILE_FALLBACK] = NULL;
+    if (!FcConfigBuildFonts(config)) {
+        return false;
+    }
+    //does not necessarily have to be a specific name.  You could put anything here and Fontconfig WILL find a font for you
+    FcPattern *pattern = FcNameParse((const FcChar8 *) FONT_FAMILY);
+    if (!pattern) {
+        return false;
+    }
+    files[FONT_FILE_MAIN] = font_match_file(config, pattern);
     FcPatternDestroy(pattern);
-    pattern = NULL;
-#ifdef FONT_FAMILY_FALLBACK
-    const i18n_entry_t *loc_entry = i18n_entry(i18n_locale());
-    pattern = FcNameParse((const FcChar8 *) ((loc_entry && loc_entry->font) ? loc_entry->font : FONT_FAMILY_FALLBACK));
+    if (files[FONT_FILE_MAIN] == NULL) {
+        return false;
+    }
+    if (fallback_family == NULL) {
+        return true;
+    }
+    pattern = FcNameParse((const FcChar8 *) fallback_family);
     if (pattern != NULL) {
         FcLangSet *ls = FcLangSetCreate();
-        if (loc_entry) {
-            FcLangSetAdd(ls, (const FcChar8 *) loc_entry->locale);
+        if (locale) {
+            FcLangSetAdd(ls, (const FcChar8 *) locale);
             FcPatternAddLangSet(pattern, FC_LANG, ls);
         }
-
-        FcConfigSubstitute(NULL, pattern, FcMatchPattern);
-        FcDefaultSubstitute(pattern);
-
-        font = FcFontMatch(NULL, pattern, &result);
-        if (font != NULL) {
-            fontset.fallback = calloc(1, sizeof(app_fontset_t));
-            fontset.fallback->small_size = fontset.small_size;
-            fontset.fallback->normal_size = fontset.normal_size;
-            fontset.fallback->large_size = fontset.large_size;
-            if (fontset_load_fc(fontset.fallback, font)) {
-                fontset.normal->fallback = fontset.fallback->normal;
-                fontset.large->fallback = fontset.fallback->large;
-                fontset.small->fallback = fontset.fallback->small;
-            } else {
-                free(fontset.fallback);
-                fontset.fallback = NULL;
-            }
-            FcPatternDestroy(font);
-            font = NULL;
-        }
+        files[FONT_FILE_FALLBACK] = font_match_file(config, pattern);
         FcLangSetDestroy(ls);
         FcPatternDestroy(pattern);
-        pattern = NULL;
     }
-#endif
-    fonts->fonts = fontset;
-    fonts->icons = iconfonts;
-    return 0;
+    return true;
 }
 
-void app_font_deinit(app_fonts_t *fonts) {
-    fontset_destroy_fonts(&fonts->fonts);
-    fontset_destroy_fonts(&fonts->icons);
-}
+static char *font_match_file(FcConfig *config, FcPattern *pattern) {
+    FcConfigSubstitute(config, pattern, FcMatchPattern);
+    FcDefaultSubstitute(pattern);
 
-static bool fontset_load_fc(app_fontset_t *set, FcPattern *font) {
+    FcResult result;
+    FcPattern *font = FcFontMatch(config, pattern, &result);
+    if (font == NULL) {
+        return NULL;
+    }
     //The pointer stored in 'file' is tied to 'font'; therefore, when 'font' is freed, this pointer is freed automatically.
-    //If you want to return the filename of the selected font, pass a buffer and copy the file name into that buffer
     FcChar8 *file = NULL;
-
+    char *ret = NULL;
     if (FcPatternGetString(font, FC_FILE, 0, &file) == FcResultMatch) {
-        lv_ft_info_t ft_info = {.name=(char *) file, .style = FT_FONT_STYLE_NORMAL, .weight = set->normal_size};
-        if (lv_ft_font_init(&ft_info)) {
-            set->normal = ft_info.font;
-        }
-        lv_ft_info_t ft_info_lg = {.name=(char *) file, .style = FT_FONT_STYLE_NORMAL, .weight = set->large_size};
-        if (lv_ft_font_init(&ft_info_lg)) {
-            set->large = ft_info_lg.font;
-        }
-        lv_ft_info_t ft_info_sm = {.name=(char *) file, .style = FT_FONT_STYLE_NORMAL, .weight = set->small_size};
-        if (lv_ft_font_init(&ft_info_sm)) {
-            set->small = ft_info_sm.font;
-        }
-        return true;
+        ret = strdup((const char *) file);
     }
-    return false;
+    FcPatternDestroy(font);
+    return ret;
+}
+
+static bool fontset_load_file(app_fontset_t *set, const char *file) {
+    lv_ft_info_t ft_info = {.name = file, .style = FT_FONT_STYLE_NORMAL, .weight = set->normal_size};
+    if (lv_ft_font_init(&ft_info)) {
+        set->normal = ft_info.font;
+    }
+    lv_ft_info_t ft_info_lg = {.name = file, .style = FT_FONT_STYLE_NORMAL, .weight = set->large_size};
+    if (lv_ft_font_init(&ft_info_lg)) {
+        set->large = ft_info_lg.font;
+    }
+    lv_ft_info_t ft_info_sm = {.name = file, .style = FT_FONT_STYLE_NORMAL, .weight = set->small_size};
+    if (lv_ft_font_init(&ft_info_sm)) {
+        set->small = ft_info_sm.font;
+    }
+    return true;
 }
 
 static bool fontset_load_mem(app_fontset_t *set, const char *name, const void *mem, size_t size) {
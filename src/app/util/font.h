@@ -1,7 +1,11 @@
 #pragma once
 
+#include <stdbool.h>
+
 #include "lvgl.h"
 
+#define APP_FONT_FILES 2
+
 typedef struct app_fontset_t {
     int small_size;
     int normal_size;
@@ -15,8 +19,21 @@ typedef struct app_fontset_t {
 typedef struct app_fonts_t {
     app_fontset_t fonts;
     app_fontset_t icons;
+    /* Font files found by app_font_resolve, released by app_font_init */
+    char *files[APP_FONT_FILES];
+    bool resolved;
 } app_fonts_t;
 
+/**
+ * Find font files for current locale. It doesn't touch lvgl, so it can run on another thread before app_font_init.
+ *
+ * @return 0 on success
+ */
+int app_font_resolve(app_fonts_t *fonts);
+
+/**
+ * Load fonts, resolving font files first if app_font_resolve hasn't been called.
+ */
 int app_font_init(app_fonts_t *fonts, int dpi);
 
 void app_font_deinit(app_fonts_t *fonts);
@@ -0,0 +1,171 @@
+#include "font_cache.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <SDL_stdinc.h>
+
+#include "path.h"
+#include "logging.h"
+
+#define CACHE_MAGIC "MLFC"
+#define CACHE_VERSION 1
+#define CACHE_MAX_PATH 4096
+/* Font directories are rarely nested deeper than family/style */
+#define KEY_MAX_DEPTH 4
+
+static uint32_t key_add_bytes(uint32_t key, const void *data, size_t len);
+
+static uint32_t key_add_path_depth(uint32_t key, const char *path, int depth);
+
+static bool write_u32(FILE *fp, uint32_t value);
+
+static bool read_u32(FILE *fp, uint32_t *value);
+
+uint32_t font_cache_key_add_str(uint32_t key, const char *value) {
+    if (value == NULL) {
+        value = "";
+    }
+    // Includes the terminator, so values can't run into the next one
+    return key_add_bytes(key, value, strlen(value) + 1);
+}
+
+uint32_t font_cache_key_add_path(uint32_t key, const char *path) {
+    return key_add_path_depth(key, path, 0);
+}
+
+int font_cache_save(const char *path, uint32_t key, char *const *files, size_t count) {
+    size_t tmp_len = strlen(path) + 5;
+    char *tmp_path = malloc(tmp_len);
+    SDL_snprintf(tmp_path, tmp_len, "%s.tmp", path);
+    int ret = 0;
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        ret = errno;
+        goto finish;
+    }
+    bool ok = fwrite(CACHE_MAGIC, 1, 4, fp) == 4 && write_u32(fp, CACHE_VERSION) && write_u32(fp, key) &&
+              write_u32(fp, count);
+    for (size_t i = 0; ok && i < count; i++) {
+        uint32_t len = files[i] != NULL ? strlen(files[i]) : 0;
+        ok = write_u32(fp, len) && (len == 0 || fwrite(files[i], 1, len, fp) == len);
+    }
+    if (!ok) {
+        ret = errno != 0 ? errno : EIO;
+    }
+    if (fclose(fp) != 0 && ret == 0) {
+        ret = errno;
+    }
+    if (ret == 0 && rename(tmp_path, path) != 0) {
+        ret = errno;
+    }
+    finish:
+    if (ret != 0) {
+        commons_log_warn("Font", "Failed to save font cache: %s", strerror(ret));
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    return ret;
+}
+
+int font_cache_load(const char *path, uint32_t key, char **files, size_t count) {
+    memset(files, 0, count * sizeof(char *));
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+    char magic[4];
+    uint32_t version = 0, saved_key = 0, saved_count = 0;
+    bool ok = fread(magic, 1, 4, fp) == 4 && memcmp(magic, CACHE_MAGIC, 4) == 0 && read_u32(fp, &version) &&
+              version == CACHE_VERSION && read_u32(fp, &saved_key) && saved_key == key &&
+              read_u32(fp, &saved_count) && saved_count == count;
+    for (size_t i = 0; ok && i < count; i++) {
+        uint32_t len;
+        ok = read_u32(fp, &len) && len < CACHE_MAX_PATH;
+        if (!ok || len == 0) {
+            continue;
+        }
+        files[i] = calloc(len + 1, 1);
+        ok = fread(files[i], 1, len, fp) == len && access(files[i], R_OK) == 0;
+    }
+    ok = ok && fgetc(fp) == EOF;
+    fclose(fp);
+    if (!ok) {
+        font_cache_files_free(files, count);
+        return -1;
+    }
+    return 0;
+}
+
+void font_cache_files_free(char **files, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(files[i]);
+        files[i] = NULL;
+    }
+}
+
+static uint32_t key_add_bytes(uint32_t key, const void *data, size_t len) {
+    /* FNV-1a */
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        key ^= bytes[i];
+        key *= 16777619u;
+    }
+    return key;
+}
+
+static uint32_t key_add_path_depth(uint32_t key, const char *path, int depth) {
+    key = font_cache_key_add_str(key, path);
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return key;
+    }
+    int64_t mtime = (int64_t) st.st_mtime;
+    key = key_add_bytes(key, &mtime, sizeof(mtime));
+    if (!S_ISDIR(st.st_mode) || depth >= KEY_MAX_DEPTH) {
+        return key;
+    }
+    DIR *d = opendir(path);
+    if (d == NULL) {
+        return key;
+    }
+    // Order of entries is stable as long as the directory is not modified, and modification changes its mtime anyway
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+#ifdef _DIRENT_HAVE_D_TYPE
+        if (ent->d_type != DT_DIR && ent->d_type != DT_UNKNOWN && ent->d_type != DT_LNK) {
+            continue;
+        }
+#endif
+        char *child = path_join(path, ent->d_name);
+        if (stat(child, &st) == 0 && S_ISDIR(st.st_mode)) {
+            key = key_add_path_depth(key, child, depth + 1);
+        }
+        free(child);
+    }
+    closedir(d);
+    return key;
+}
+
+static bool write_u32(FILE *fp, uint32_t value) {
+    unsigned char bytes[4] = {value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24};
+    return fwrite(bytes, 1, sizeof(bytes), fp) == sizeof(bytes);
+}
+
+static bool read_u32(FILE *fp, uint32_t *value) {
+    unsigned char bytes[4];
+    if (fread(bytes, 1, sizeof(bytes), fp) != sizeof(bytes)) {
+        return false;
+    }
+    *value = (uint32_t) bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+    return true;
+}
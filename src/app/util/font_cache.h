@@ -0,0 +1,36 @@
+/**
+ * @file font_cache.h
+ *
+ * Font files resolved by fontconfig, saved on disk so later launches don't have to scan font directories.
+ *
+ * Cached files are only valid for the key they were saved with. Key should cover everything that affects font
+ * matching: fontconfig version, locale, requested families, and modification time of font directories.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FONT_CACHE_KEY_INIT 2166136261u
+
+uint32_t font_cache_key_add_str(uint32_t key, const char *value);
+
+/**
+ * Add path and modification time of the file or directory. Subdirectories are added as well, so installing or
+ * removing fonts anywhere in a font directory changes the key. Missing paths are added by path only.
+ */
+uint32_t font_cache_key_add_path(uint32_t key, const char *path);
+
+/**
+ * @param files Resolved file paths, can contain NULL for fonts not found
+ * @return 0 on success
+ */
+int font_cache_save(const char *path, uint32_t key, char *const *files, size_t count);
+
+/**
+ * @param files Receives exactly count paths, which should be freed with font_cache_files_free
+ * @return 0 on success, or -1 if cache is missing, invalid, saved with another key, or any file doesn't exist anymore
+ */
+int font_cache_load(const char *path, uint32_t key, char **files, size_t count);
+
+void font_cache_files_free(char **files, size_t count);
@@ -0,0 +1,129 @@
+#include "init_graph.h"
+
+#include <stdlib.h>
+
+#include <SDL_assert.h>
+#include <SDL_mutex.h>
+
+#include "executor.h"
+#include "logging.h"
+
+typedef struct graph_run_t {
+    const init_step_t *steps;
+    void *context;
+    const startup_trace_t *trace;
+    SDL_mutex *lock;
+    SDL_cond *cond;
+    uint32_t done;
+    int result;
+    /* Timing of steps run on the executor */
+    Uint64 start_us[INIT_GRAPH_MAX_STEPS], duration_us[INIT_GRAPH_MAX_STEPS];
+} graph_run_t;
+
+typedef struct graph_task_t {
+    graph_run_t *run;
+    size_t index;
+} graph_task_t;
+
+static bool step_ready(const init_step_t *step, uint32_t started, uint32_t done, size_t index);
+
+static int task_run(graph_task_t *task);
+
+static void task_finalize(graph_task_t *task, int result);
+
+int init_graph_run(const init_step_t *steps, size_t count, executor_t *executor, void *context,
+                   startup_trace_t *trace) {
+    SDL_assert_release(count <= INIT_GRAPH_MAX_STEPS);
+    graph_run_t run = {.steps = steps, .context = context, .trace = trace};
+    run.lock = SDL_CreateMutex();
+    run.cond = SDL_CreateCond();
+    const uint32_t all = count == INIT_GRAPH_MAX_STEPS ? UINT32_MAX : INIT_STEP_DEP(count) - 1;
+    uint32_t started = 0, background = 0;
+
+    SDL_LockMutex(run.lock);
+    while (run.done != all) {
+        uint32_t running = started & ~run.done;
+        if (run.result != 0) {
+            if (running == 0) {
+                break;
+            }
+            SDL_CondWait(run.cond, run.lock);
+            continue;
+        }
+        // Hand out background steps first, so they run while main thread steps are running
+        for (size_t i = 0; executor != NULL && i < count; i++) {
+            if (steps[i].main_thread || !step_ready(&steps[i], started, run.done, i)) {
+                continue;
+            }
+            started |= INIT_STEP_DEP(i);
+            background |= INIT_STEP_DEP(i);
+            graph_task_t *task = malloc(sizeof(graph_task_t));
+            task->run = &run;
+            task->index = i;
+            executor_submit(executor, (executor_action_cb) task_run, (executor_cleanup_cb) task_finalize, task);
+        }
+        size_t main_step = count;
+        for (size_t i = 0; i < count; i++) {
+            if ((steps[i].main_thread || executor == NULL) && step_ready(&steps[i], started, run.done, i)) {
+                main_step = i;
+                break;
+            }
+        }
+        if (main_step < count) {
+            started |= INIT_STEP_DEP(main_step);
+            SDL_UnlockMutex(run.lock);
+            startup_trace_begin(trace, steps[main_step].name);
+            int result = steps[main_step].run(context);
+            startup_trace_end(trace);
+            SDL_LockMutex(run.lock);
+            run.done |= INIT_STEP_DEP(main_step);
+            if (result != 0 && run.result == 0) {
+                commons_log_error("Init", "Step %s failed: %d", steps[main_step].name, result);
+                run.result = result;
+            }
+        } else if (started & ~run.done) {
+            SDL_CondWait(run.cond, run.lock);
+        } else {
+            commons_log_error("Init", "Steps 0x%x can't run because of their dependencies",
+                              (unsigned int) (all & ~started));
+            run.result = -1;
+        }
+    }
+    SDL_UnlockMutex(run.lock);
+
+    for (size_t i = 0; i < count; i++) {
+        if (background & INIT_STEP_DEP(i)) {
+            startup_trace_add(trace, steps[i].name, run.start_us[i], run.duration_us[i], 1);
+        }
+    }
+    SDL_DestroyCond(run.cond);
+    SDL_DestroyMutex(run.lock);
+    return run.result;
+}
+
+static bool step_ready(const init_step_t *step, uint32_t started, uint32_t done, size_t index) {
+    return !(started & INIT_STEP_DEP(index)) && (step->deps & ~done) == 0;
+}
+
+static int task_run(graph_task_t *task) {
+    graph_run_t *run = task->run;
+    const init_step_t *step = &run->steps[task->index];
+    Uint64 start = startup_trace_now_us(run->trace);
+    int result = step->run(run->context);
+    run->start_us[task->index] = start;
+    run->duration_us[task->index] = startup_trace_now_us(run->trace) - start;
+    return result;
+}
+
+static void task_finalize(graph_task_t *task, int result) {
+    graph_run_t *run = task->run;
+    SDL_LockMutex(run->lock);
+    run->done |= INIT_STEP_DEP(task->index);
+    if (result != 0 && run->result == 0) {
+        commons_log_error("Init", "Step %s failed: %d", run->steps[task->index].name, result);
+        run->result = result;
+    }
+    SDL_CondSignal(run->cond);
+    SDL_UnlockMutex(run->lock);
+    free(task);
+}
@@ -0,0 +1,41 @@
+/**
+ * @file init_graph.h
+ *
+ * Runs initialization steps as soon as the steps they depend on are done. Independent steps run in parallel on an
+ * executor, while steps that must stay on the main thread (SDL video, lvgl...) run on the calling thread meanwhile.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "startup_trace.h"
+
+typedef struct executor_t executor_t;
+
+#define INIT_GRAPH_MAX_STEPS 32
+
+#define INIT_STEP_DEP(index) (1u << (index))
+
+typedef int (*init_step_fn)(void *context);
+
+typedef struct init_step_t {
+    const char *name;
+    init_step_fn run;
+    /* Bit mask of INIT_STEP_DEP of steps that must be done before this one */
+    uint32_t deps;
+    /* Run on the calling thread instead of the executor */
+    bool main_thread;
+} init_step_t;
+
+/**
+ * Returns when all steps are done. After a step fails, no more steps are started, and the ones already running are
+ * waited for.
+ *
+ * @param executor Executor to run steps on, or NULL to run all steps one by one on the calling thread
+ * @param trace Duration of each step is added to it
+ * @return 0, or result of the first failed step. -1 if some steps can never run because of their dependencies.
+ */
+int init_graph_run(const init_step_t *steps, size_t count, executor_t *executor, void *context,
+                   startup_trace_t *trace);
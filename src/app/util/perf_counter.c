@@ -0,0 +1,12 @@
+#include "perf_counter.h"
+
+#include <SDL_timer.h>
+
+Uint64 perf_counter_to_us(Uint64 counter) {
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    return counter / freq * 1000000ULL + counter % freq * 1000000ULL / freq;
+}
+
+Uint64 perf_counter_now_us() {
+    return perf_counter_to_us(SDL_GetPerformanceCounter());
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <SDL_stdinc.h>
+
+/**
+ * Convert a difference of SDL_GetPerformanceCounter() values to microseconds, without overflowing on high frequency
+ * counters.
+ */
+Uint64 perf_counter_to_us(Uint64 counter);
+
+/**
+ * @return Current value of the performance counter in microseconds, with an unspecified origin
+ */
+Uint64 perf_counter_now_us();
@@ -0,0 +1,119 @@
+#include "startup_trace.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL_timer.h>
+
+#include "perf_counter.h"
+
+#include "logging.h"
+
+static void write_json_string(FILE *fp, const char *value);
+
+void startup_trace_init(startup_trace_t *trace) {
+    memset(trace, 0, sizeof(*trace));
+    trace->origin = SDL_GetPerformanceCounter();
+}
+
+void startup_trace_begin(startup_trace_t *trace, const char *name) {
+    if (trace->depth >= STARTUP_TRACE_MAX_DEPTH) {
+        // Keep counting, so begin and end calls still match
+        trace->depth++;
+        return;
+    }
+    int index = -1;
+    if (trace->count < STARTUP_TRACE_MAX_EVENTS) {
+        index = (int) trace->count++;
+        startup_trace_event_t *event = &trace->events[index];
+        event->name = name;
+        event->depth = trace->depth;
+        event->thread = 0;
+        event->start_us = startup_trace_now_us(trace);
+        event->duration_us = 0;
+    }
+    trace->stack[trace->depth++] = index;
+}
+
+void startup_trace_end(startup_trace_t *trace) {
+    if (trace->depth <= 0) {
+        return;
+    }
+    trace->depth--;
+    if (trace->depth >= STARTUP_TRACE_MAX_DEPTH) {
+        return;
+    }
+    int index = trace->stack[trace->depth];
+    if (index < 0) {
+        return;
+    }
+    startup_trace_event_t *event = &trace->events[index];
+    event->duration_us = startup_trace_now_us(trace) - event->start_us;
+}
+
+Uint64 startup_trace_now_us(const startup_trace_t *trace) {
+    return perf_counter_to_us(SDL_GetPerformanceCounter() - trace->origin);
+}
+
+void startup_trace_add(startup_trace_t *trace, const char *name, Uint64 start_us, Uint64 duration_us, int thread) {
+    if (trace->count >= STARTUP_TRACE_MAX_EVENTS) {
+        return;
+    }
+    startup_trace_event_t *event = &trace->events[trace->count++];
+    event->name = name;
+    event->depth = SDL_min(trace->depth, STARTUP_TRACE_MAX_DEPTH);
+    event->thread = thread;
+    event->start_us = start_us;
+    event->duration_us = duration_us;
+}
+
+const startup_trace_event_t *startup_trace_find(const startup_trace_t *trace, const char *name) {
+    for (size_t i = 0; i < trace->count; i++) {
+        if (strcmp(trace->events[i].name, name) == 0) {
+            return &trace->events[i];
+        }
+    }
+    return NULL;
+}
+
+void startup_trace_log(const startup_trace_t *trace) {
+    for (size_t i = 0; i < trace->count; i++) {
+        const startup_trace_event_t *event = &trace->events[i];
+        commons_log_info("Startup", "%*s%s: %u.%03u ms%s", event->depth * 2, "", event->name,
+                         (unsigned int) (event->duration_us / 1000), (unsigned int) (event->duration_us % 1000),
+                         event->thread != 0 ? " (background)" : "");
+    }
+}
+
+int startup_trace_write_json(const startup_trace_t *trace, const char *path) {
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        return errno;
+    }
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", fp);
+    for (size_t i = 0; i < trace->count; i++) {
+        const startup_trace_event_t *event = &trace->events[i];
+        fputs(i > 0 ? ",\n{\"name\":" : "\n{\"name\":", fp);
+        write_json_string(fp, event->name);
+        fprintf(fp, ",\"cat\":\"startup\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu}",
+                event->thread + 1, (unsigned long long) event->start_us, (unsigned long long) event->duration_us);
+    }
+    fputs("\n]}\n", fp);
+    int ret = ferror(fp) ? EIO : 0;
+    if (fclose(fp) != 0 && ret == 0) {
+        ret = errno;
+    }
+    return ret;
+}
+
+static void write_json_string(FILE *fp, const char *value) {
+    fputc('"', fp);
+    for (const char *p = value; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', fp);
+        }
+        fputc(*p, fp);
+    }
+    fputc('"', fp);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file startup_trace.h
+ *
+ * Timestamps of startup phases and their nested sub-phases. Summary goes to the log, and the full trace can be saved
+ * in Chrome trace format, to be opened with chrome://tracing or Perfetto.
+ *
+ * Phases are expected to begin and end on the main thread. Work done on other threads is timed there with
+ * startup_trace_now_us, and added afterwards with startup_trace_add.
+ */
+#pragma once
+
+#include <stddef.h>
+
+#include <SDL_stdinc.h>
+
+#define STARTUP_TRACE_MAX_EVENTS 64
+#define STARTUP_TRACE_MAX_DEPTH 8
+
+typedef struct startup_trace_event_t {
+    /* Should be a string literal, it's not copied */
+    const char *name;
+    int depth;
+    /* 0 for the main thread */
+    int thread;
+    /* Microseconds since startup_trace_init */
+    Uint64 start_us, duration_us;
+} startup_trace_event_t;
+
+typedef struct startup_trace_t {
+    Uint64 origin;
+    startup_trace_event_t events[STARTUP_TRACE_MAX_EVENTS];
+    size_t count;
+    /* Indices of phases not ended yet, -1 if the phase didn't fit in events */
+    int stack[STARTUP_TRACE_MAX_DEPTH];
+    int depth;
+} startup_trace_t;
+
+void startup_trace_init(startup_trace_t *trace);
+
+void startup_trace_begin(startup_trace_t *trace, const char *name);
+
+/**
+ * End the innermost phase not ended yet.
+ */
+void startup_trace_end(startup_trace_t *trace);
+
+/**
+ * Can be called from any thread.
+ *
+ * @return Microseconds since startup_trace_init
+ */
+Uint64 startup_trace_now_us(const startup_trace_t *trace);
+
+/**
+ * Add a phase timed elsewhere, nested in the current phase.
+ *
+ * @param thread Thread it ran on, only used to tell threads apart in the trace file
+ */
+void startup_trace_add(startup_trace_t *trace, const char *name, Uint64 start_us, Uint64 duration_us, int thread);
+
+/**
+ * @return First phase with this name, or NULL if not traced
+ */
+const startup_trace_event_t *startup_trace_find(const startup_trace_t *trace, const char *name);
+
+/**
+ * Write duration of each ended phase to the log, indented by nesting level.
+ */
+void startup_trace_log(const startup_trace_t *trace);
+
+/**
+ * @return 0 on success
+ */
+int startup_trace_write_json(const startup_trace_t *trace, const char *path);
@@ -0,0 +1,112 @@
+#include "unity.h"
+#include "backend/apploader/apploader_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_UUID "8c7fa7d4-54b1-4b8d-9a0f-0c1f2e3d4b5a"
+
+static char cache_dir[] = "/tmp/test_apploader_cache_XXXXXX";
+static char cache_file[256];
+static APP_LIST *apps;
+
+static APP_LIST *app_new(int id, const char *name, int hdr, APP_LIST *next);
+
+void setUp(void) {
+    TEST_ASSERT_NOT_NULL(mkdtemp(cache_dir));
+    snprintf(cache_file, sizeof(cache_file), "%s/applist-%s.bin", cache_dir, TEST_UUID);
+    apps = app_new(1, "Desktop", 0, app_new(2, "Steam Big Picture", 1, app_new(3, "Cyberpunk 2077", 1, NULL)));
+}
+
+void tearDown(void) {
+    apploader_cache_free(apps);
+    remove(cache_file);
+    rmdir(cache_dir);
+    strcpy(cache_dir, "/tmp/test_apploader_cache_XXXXXX");
+}
+
+void test_hash() {
+    uint32_t hash = apploader_cache_hash(apps);
+    TEST_ASSERT_EQUAL(hash, apploader_cache_hash(apps));
+
+    apps->next->hdr = 0;
+    TEST_ASSERT_NOT_EQUAL(hash, apploader_cache_hash(apps));
+    apps->next->hdr = 1;
+
+    // Moving characters between names is a change
+    APP_LIST *a = app_new(1, "ab", 0, app_new(2, "c", 0, NULL));
+    APP_LIST *b = app_new(1, "a", 0, app_new(2, "bc", 0, NULL));
+    TEST_ASSERT_NOT_EQUAL(apploader_cache_hash(a), apploader_cache_hash(b));
+    apploader_cache_free(a);
+    apploader_cache_free(b);
+}
+
+void test_save_load() {
+    uint32_t hash = apploader_cache_hash(apps), loaded_hash = 0;
+    TEST_ASSERT_NULL(apploader_cache_load(cache_dir, TEST_UUID, &loaded_hash));
+    TEST_ASSERT_EQUAL(0, apploader_cache_save(cache_dir, TEST_UUID, apps, hash));
+
+    APP_LIST *loaded = apploader_cache_load(cache_dir, TEST_UUID, &loaded_hash);
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL(hash, loaded_hash);
+    const APP_LIST *expected = apps, *actual = loaded;
+    for (; expected != NULL && actual != NULL; expected = expected->next, actual = actual->next) {
+        TEST_ASSERT_EQUAL(expected->id, actual->id);
+        TEST_ASSERT_EQUAL(expected->hdr, actual->hdr);
+        TEST_ASSERT_EQUAL_STRING(expected->name, actual->name);
+    }
+    TEST_ASSERT_NULL(expected);
+    TEST_ASSERT_NULL(actual);
+    apploader_cache_free(loaded);
+}
+
+void test_corrupted() {
+    TEST_ASSERT_EQUAL(0, apploader_cache_save(cache_dir, TEST_UUID, apps, apploader_cache_hash(apps)));
+    FILE *fp = fopen(cache_file, "r+b");
+    TEST_ASSERT_NOT_NULL(fp);
+    fseek(fp, -3, SEEK_END);
+    fputc('X', fp);
+    fclose(fp);
+    uint32_t hash = 0;
+    TEST_ASSERT_NULL(apploader_cache_load(cache_dir, TEST_UUID, &hash));
+
+    TEST_ASSERT_EQUAL(0, apploader_cache_save(cache_dir, TEST_UUID, apps, apploader_cache_hash(apps)));
+    TEST_ASSERT_EQUAL(0, truncate(cache_file, 30));
+    TEST_ASSERT_NULL(apploader_cache_load(cache_dir, TEST_UUID, &hash));
+}
+
+void test_large_list() {
+    APP_LIST *large = NULL;
+    char name[32];
+    for (int i = 0; i < 2000; i++) {
+        snprintf(name, sizeof(name), "Game %d", i);
+        large = app_new(i, name, i % 2, large);
+    }
+    uint32_t hash = apploader_cache_hash(large), loaded_hash = 0;
+    TEST_ASSERT_EQUAL(0, apploader_cache_save(cache_dir, TEST_UUID, large, hash));
+    APP_LIST *loaded = apploader_cache_load(cache_dir, TEST_UUID, &loaded_hash);
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL(hash, apploader_cache_hash(loaded));
+    apploader_cache_free(loaded);
+    apploader_cache_free(large);
+}
+
+static APP_LIST *app_new(int id, const char *name, int hdr, APP_LIST *next) {
+    APP_LIST *app = calloc(1, sizeof(APP_LIST));
+    app->id = id;
+    app->name = strdup(name);
+    app->hdr = hdr;
+    app->next = next;
+    return app;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_hash);
+    RUN_TEST(test_save_load);
+    RUN_TEST(test_corrupted);
+    RUN_TEST(test_large_list);
+    return UNITY_END();
+}
@@ -0,0 +1,54 @@
+/**
+ * @file dns_sd.h
+ *
+ * Stand-in of the DNS-SD client API, covering what discovery/impl/dnssd.c uses. Requests are sent over UDP to a
+ * responder on loopback, which is implemented by the test.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <sys/socket.h>
+
+#define kDNSServiceErr_NoError 0
+#define kDNSServiceErr_Unknown (-65537)
+
+#define kDNSServiceFlagsAdd 0x2
+
+#define kDNSServiceProtocol_IPv4 0x01
+
+typedef struct _DNSServiceRef_t *DNSServiceRef;
+typedef uint32_t DNSServiceFlags;
+typedef uint32_t DNSServiceProtocol;
+typedef int32_t DNSServiceErrorType;
+
+typedef void (*DNSServiceBrowseReply)(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                                      DNSServiceErrorType errorCode, const char *serviceName, const char *regtype,
+                                      const char *replyDomain, void *context);
+
+typedef void (*DNSServiceResolveReply)(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                                       DNSServiceErrorType errorCode, const char *fullname, const char *hosttarget,
+                                       uint16_t port, uint16_t txtLen, const unsigned char *txtRecord,
+                                       void *context);
+
+typedef void (*DNSServiceGetAddrInfoReply)(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                                           DNSServiceErrorType errorCode, const char *hostname,
+                                           const struct sockaddr *address, uint32_t ttl, void *context);
+
+DNSServiceErrorType DNSServiceBrowse(DNSServiceRef *sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                                     const char *regtype, const char *domain, DNSServiceBrowseReply callBack,
+                                     void *context);
+
+DNSServiceErrorType DNSServiceResolve(DNSServiceRef *sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                                      const char *name, const char *regtype, const char *domain,
+                                      DNSServiceResolveReply callBack, void *context);
+
+DNSServiceErrorType DNSServiceGetAddrInfo(DNSServiceRef *sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                                          DNSServiceProtocol protocol, const char *hostname,
+                                          DNSServiceGetAddrInfoReply callBack, void *context);
+
+int DNSServiceRefSockFD(DNSServiceRef sdRef);
+
+DNSServiceErrorType DNSServiceProcessResult(DNSServiceRef sdRef);
+
+void DNSServiceRefDeallocate(DNSServiceRef sdRef);
@@ -0,0 +1,346 @@
+#include "unity.h"
+#include "backend/pcmanager/discovery/impl/impl.h"
+
+#include <dns_sd.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <SDL2/SDL.h>
+
+#define HOSTS_COUNT 5
+#define MAX_PENDING 64
+/* Well below the resolve timeout of dnssd.c, so a host found within it wasn't held up by the stale one */
+#define SLOW_DELAY 1000
+
+typedef enum fake_kind_t {
+    FAKE_BROWSE,
+    FAKE_RESOLVE,
+    FAKE_ADDRINFO,
+} fake_kind_t;
+
+/* Both requests to the responder and its answers */
+typedef struct fake_message_t {
+    int kind;
+    char name[64];
+    uint16_t port;
+    struct in_addr addr;
+} fake_message_t;
+
+struct _DNSServiceRef_t {
+    int fd;
+    fake_kind_t kind;
+    void *callback;
+    void *context;
+};
+
+/* Stand-in of a GameStream host announcing itself over mDNS */
+typedef struct fake_host_t {
+    const char *service, *target, *ip;
+    uint16_t port;
+    Uint32 resolve_delay, addr_delay;
+    /* Never answers address lookup */
+    bool stale;
+    /* Ticks since discovery started, 0 if not found yet */
+    Uint32 found_at;
+} fake_host_t;
+
+typedef struct fake_answer_t {
+    Uint32 due;
+    struct sockaddr_in dest;
+    fake_message_t message;
+} fake_answer_t;
+
+static fake_host_t hosts[HOSTS_COUNT] = {
+        {.service = "DESKTOP-A", .target = "desktop-a.local", .ip = "10.0.0.1", .port = 47989},
+        {.service = "SLOW", .target = "slow.local", .ip = "10.0.0.2", .port = 47989, .resolve_delay = SLOW_DELAY},
+        {.service = "STALE", .target = "stale.local", .ip = "10.0.0.3", .port = 47989, .stale = true},
+        {.service = "DESKTOP-B", .target = "desktop-b.local", .ip = "10.0.0.4", .port = 48010, .addr_delay = 100},
+        {.service = "DESKTOP-C", .target = "desktop-c.local", .ip = "10.0.0.5", .port = 47989, .resolve_delay = 50},
+};
+
+static int responder_fd;
+static struct sockaddr_in responder_addr;
+static SDL_atomic_t responder_running;
+static SDL_mutex *found_lock;
+static SDL_sem *found_sem;
+static Uint32 discovery_start;
+static int unexpected_count;
+
+static int responder_run(void *arg);
+
+static void responder_answer(const fake_message_t *request, const struct sockaddr_in *from, fake_answer_t *pending,
+                             size_t *pending_count);
+
+static fake_host_t *host_find(const char *service);
+
+static DNSServiceErrorType fake_request(DNSServiceRef *sdRef, fake_kind_t kind, const char *name, void *callback,
+                                        void *context);
+
+void setUp(void) {
+    responder_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    TEST_ASSERT_TRUE(responder_fd >= 0);
+    responder_addr = (struct sockaddr_in) {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    TEST_ASSERT_EQUAL(0, bind(responder_fd, (struct sockaddr *) &responder_addr, sizeof(responder_addr)));
+    socklen_t addr_len = sizeof(responder_addr);
+    TEST_ASSERT_EQUAL(0, getsockname(responder_fd, (struct sockaddr *) &responder_addr, &addr_len));
+    SDL_AtomicSet(&responder_running, 1);
+    found_lock = SDL_CreateMutex();
+    found_sem = SDL_CreateSemaphore(0);
+    unexpected_count = 0;
+    for (int i = 0; i < HOSTS_COUNT; i++) {
+        hosts[i].found_at = 0;
+    }
+}
+
+void tearDown(void) {
+    close(responder_fd);
+    SDL_DestroySemaphore(found_sem);
+    SDL_DestroyMutex(found_lock);
+}
+
+void test_resolve_all_hosts() {
+    SDL_Thread *responder = SDL_CreateThread(responder_run, "responder", NULL);
+    discovery_task_t task = {.discovery = NULL, .lock = SDL_CreateMutex()};
+    discovery_start = SDL_GetTicks();
+    SDL_Thread *worker = SDL_CreateThread((SDL_ThreadFunction) discovery_worker, "discovery", &task);
+
+    // Guards against hanging only, every host but the stale one answers long before
+    for (int i = 0; i < HOSTS_COUNT - 1; i++) {
+        if (SDL_SemWaitTimeout(found_sem, 10000) != 0) {
+            break;
+        }
+    }
+    discovery_worker_stop(&task);
+    int worker_result = -1;
+    SDL_WaitThread(worker, &worker_result);
+    SDL_AtomicSet(&responder_running, 0);
+    SDL_WaitThread(responder, NULL);
+    SDL_DestroyMutex(task.lock);
+
+    TEST_ASSERT_EQUAL(0, worker_result);
+    TEST_ASSERT_EQUAL(0, unexpected_count);
+    for (int i = 0; i < HOSTS_COUNT; i++) {
+        const fake_host_t *host = &hosts[i];
+        if (host->stale) {
+            TEST_ASSERT_EQUAL_MESSAGE(0, host->found_at, host->service);
+            continue;
+        }
+        TEST_ASSERT_NOT_EQUAL_MESSAGE(0, host->found_at, host->service);
+    }
+    // Resolved as each host answers, neither the slow nor the stale host holds up the others
+    const fake_host_t *slow = host_find("SLOW");
+    for (int i = 0; i < HOSTS_COUNT; i++) {
+        if (&hosts[i] != slow && !hosts[i].stale) {
+            TEST_ASSERT_TRUE_MESSAGE(hosts[i].found_at < slow->found_at, hosts[i].service);
+        }
+    }
+    TEST_ASSERT_TRUE(slow->found_at < SLOW_DELAY * 2);
+}
+
+void discovery_discovered(struct discovery_t *discovery, const sockaddr_t *addr) {
+    (void) discovery;
+    // Called on the discovery thread, so results are checked by the test afterwards
+    char ip[64] = "";
+    sockaddr_get_ip_str(addr, ip, sizeof(ip));
+    uint16_t port = sockaddr_get_port(addr);
+    SDL_LockMutex(found_lock);
+    fake_host_t *found = NULL;
+    for (int i = 0; i < HOSTS_COUNT; i++) {
+        if (strcmp(hosts[i].ip, ip) == 0 && hosts[i].port == port) {
+            found = &hosts[i];
+        }
+    }
+    bool first = found != NULL && found->found_at == 0;
+    if (found == NULL) {
+        unexpected_count++;
+    } else if (first) {
+        // Never 0, so it tells found and not found apart
+        found->found_at = SDL_GetTicks() - discovery_start + 1;
+    }
+    SDL_UnlockMutex(found_lock);
+    if (first) {
+        SDL_SemPost(found_sem);
+    }
+}
+
+DNSServiceErrorType DNSServiceBrowse(DNSServiceRef *sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                                     const char *regtype, const char *domain, DNSServiceBrowseReply callBack,
+                                     void *context) {
+    (void) flags;
+    (void) interfaceIndex;
+    (void) domain;
+    return fake_request(sdRef, FAKE_BROWSE, regtype, callBack, context);
+}
+
+DNSServiceErrorType DNSServiceResolve(DNSServiceRef *sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                                      const char *name, const char *regtype, const char *domain,
+                                      DNSServiceResolveReply callBack, void *context) {
+    (void) flags;
+    (void) interfaceIndex;
+    (void) regtype;
+    (void) domain;
+    return fake_request(sdRef, FAKE_RESOLVE, name, callBack, context);
+}
+
+DNSServiceErrorType DNSServiceGetAddrInfo(DNSServiceRef *sdRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+                                          DNSServiceProtocol protocol, const char *hostname,
+                                          DNSServiceGetAddrInfoReply callBack, void *context) {
+    (void) flags;
+    (void) interfaceIndex;
+    if (protocol != kDNSServiceProtocol_IPv4) {
+        return kDNSServiceErr_Unknown;
+    }
+    return fake_request(sdRef, FAKE_ADDRINFO, hostname, callBack, context);
+}
+
+int DNSServiceRefSockFD(DNSServiceRef sdRef) {
+    return sdRef->fd;
+}
+
+DNSServiceErrorType DNSServiceProcessResult(DNSServiceRef sdRef) {
+    fake_message_t answer;
+    if (recv(sdRef->fd, &answer, sizeof(answer), 0) != sizeof(answer) || answer.kind != (int) sdRef->kind) {
+        return kDNSServiceErr_Unknown;
+    }
+    switch (sdRef->kind) {
+        case FAKE_BROWSE: {
+            DNSServiceBrowseReply callback = sdRef->callback;
+            callback(sdRef, kDNSServiceFlagsAdd, 1, kDNSServiceErr_NoError, answer.name, "_nvstream._tcp.", "local.",
+                     sdRef->context);
+            break;
+        }
+        case FAKE_RESOLVE: {
+            DNSServiceResolveReply callback = sdRef->callback;
+            callback(sdRef, 0, 1, kDNSServiceErr_NoError, "", answer.name, htons(answer.port), 0, NULL,
+                     sdRef->context);
+            break;
+        }
+        case FAKE_ADDRINFO: {
+            DNSServiceGetAddrInfoReply callback = sdRef->callback;
+            struct sockaddr_in address = {.sin_family = AF_INET, .sin_addr = answer.addr};
+            callback(sdRef, kDNSServiceFlagsAdd, 1, kDNSServiceErr_NoError, answer.name,
+                     (const struct sockaddr *) &address, 120, sdRef->context);
+            break;
+        }
+    }
+    return kDNSServiceErr_NoError;
+}
+
+void DNSServiceRefDeallocate(DNSServiceRef sdRef) {
+    close(sdRef->fd);
+    free(sdRef);
+}
+
+/**
+ * Answers requests after the delay of the host, without holding up answers to other requests meanwhile.
+ */
+static int responder_run(void *arg) {
+    (void) arg;
+    fake_answer_t pending[MAX_PENDING];
+    size_t pending_count = 0;
+    while (SDL_AtomicGet(&responder_running)) {
+        Uint32 now = SDL_GetTicks();
+        int wait = 50;
+        for (size_t i = 0; i < pending_count;) {
+            fake_answer_t *answer = &pending[i];
+            if (SDL_TICKS_PASSED(now, answer->due)) {
+                sendto(responder_fd, &answer->message, sizeof(answer->message), 0,
+                       (const struct sockaddr *) &answer->dest, sizeof(answer->dest));
+                *answer = pending[--pending_count];
+                continue;
+            }
+            wait = SDL_min(wait, (int) (answer->due - now));
+            i++;
+        }
+        struct pollfd pfd = {.fd = responder_fd, .events = POLLIN};
+        if (poll(&pfd, 1, wait) <= 0) {
+            continue;
+        }
+        fake_message_t request;
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        if (recvfrom(responder_fd, &request, sizeof(request), 0, (struct sockaddr *) &from, &from_len) ==
+            sizeof(request)) {
+            responder_answer(&request, &from, pending, &pending_count);
+        }
+    }
+    return 0;
+}
+
+static void responder_answer(const fake_message_t *request, const struct sockaddr_in *from, fake_answer_t *pending,
+                             size_t *pending_count) {
+    Uint32 now = SDL_GetTicks();
+    for (int i = 0; i < HOSTS_COUNT && *pending_count < MAX_PENDING; i++) {
+        const fake_host_t *host = &hosts[i];
+        fake_answer_t answer = {.dest = *from, .message = {.kind = request->kind}};
+        switch (request->kind) {
+            case FAKE_BROWSE:
+                answer.due = now;
+                snprintf(answer.message.name, sizeof(answer.message.name), "%s", host->service);
+                break;
+            case FAKE_RESOLVE:
+                if (strcmp(request->name, host->service) != 0) {
+                    continue;
+                }
+                answer.due = now + host->resolve_delay;
+                snprintf(answer.message.name, sizeof(answer.message.name), "%s", host->target);
+                answer.message.port = host->port;
+                break;
+            case FAKE_ADDRINFO:
+                if (strcmp(request->name, host->target) != 0 || host->stale) {
+                    continue;
+                }
+                answer.due = now + host->addr_delay;
+                snprintf(answer.message.name, sizeof(answer.message.name), "%s", host->target);
+                inet_pton(AF_INET, host->ip, &answer.message.addr);
+                break;
+            default:
+                continue;
+        }
+        pending[(*pending_count)++] = answer;
+    }
+}
+
+static fake_host_t *host_find(const char *service) {
+    for (int i = 0; i < HOSTS_COUNT; i++) {
+        if (strcmp(hosts[i].service, service) == 0) {
+            return &hosts[i];
+        }
+    }
+    return NULL;
+}
+
+static DNSServiceErrorType fake_request(DNSServiceRef *sdRef, fake_kind_t kind, const char *name, void *callback,
+                                        void *context) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return kDNSServiceErr_Unknown;
+    }
+    struct sockaddr_in local = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    fake_message_t request = {.kind = kind};
+    snprintf(request.name, sizeof(request.name), "%s", name);
+    if (bind(fd, (struct sockaddr *) &local, sizeof(local)) != 0 ||
+        sendto(fd, &request, sizeof(request), 0, (const struct sockaddr *) &responder_addr,
+               sizeof(responder_addr)) != sizeof(request)) {
+        close(fd);
+        return kDNSServiceErr_Unknown;
+    }
+    DNSServiceRef ref = calloc(1, sizeof(struct _DNSServiceRef_t));
+    ref->fd = fd;
+    ref->kind = kind;
+    ref->callback = callback;
+    ref->context = context;
+    *sdRef = ref;
+    return kDNSServiceErr_NoError;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_resolve_all_hosts);
+    return UNITY_END();
+}
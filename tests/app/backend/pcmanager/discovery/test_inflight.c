@@ -0,0 +1,139 @@
+#include "unity.h"
+#include "backend/pcmanager/discovery/inflight.h"
+
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <SDL2/SDL.h>
+
+#define HOSTS_COUNT 5
+#define RESOLVE_TIMEOUT 400
+
+/* Stand-in of mDNS responders. Host 3 never answers. */
+typedef struct host_t {
+    int fds[2];
+    bool resolved, timed_out;
+    /* Posted once the resolve operation is closed */
+    SDL_sem *closed;
+} host_t;
+
+/* Hosts answer in this order, each after the one before is done */
+static const int answer_order[HOSTS_COUNT - 1] = {1, 4, 2, 0};
+static host_t hosts[HOSTS_COUNT];
+static int browse_fds[2];
+static discovery_inflight_t inflight;
+static int finished_order[HOSTS_COUNT];
+static int finished_count;
+
+static int responder(void *arg);
+
+static bool browse_process(void *handle);
+
+static void browse_close(void *handle, bool timed_out);
+
+static bool resolve_process(host_t *host);
+
+static void resolve_close(host_t *host, bool timed_out);
+
+void setUp(void) {
+    for (int i = 0; i < HOSTS_COUNT; i++) {
+        hosts[i] = (host_t) {.closed = SDL_CreateSemaphore(0)};
+        TEST_ASSERT_EQUAL(0, socketpair(AF_UNIX, SOCK_DGRAM, 0, hosts[i].fds));
+    }
+    TEST_ASSERT_EQUAL(0, socketpair(AF_UNIX, SOCK_DGRAM, 0, browse_fds));
+    finished_count = 0;
+    discovery_inflight_init(&inflight);
+}
+
+void tearDown(void) {
+    discovery_inflight_deinit(&inflight);
+    for (int i = 0; i < HOSTS_COUNT; i++) {
+        close(hosts[i].fds[0]);
+        close(hosts[i].fds[1]);
+        SDL_DestroySemaphore(hosts[i].closed);
+    }
+    close(browse_fds[0]);
+    close(browse_fds[1]);
+}
+
+void test_concurrent_resolves() {
+    discovery_inflight_add(&inflight, browse_fds[0], 0, browse_process, browse_close, NULL);
+    SDL_Thread *thread = SDL_CreateThread(responder, "responder", NULL);
+    // Guards against hanging only, the stale responder times out long before
+    Uint32 start = SDL_GetTicks();
+    while (finished_count < HOSTS_COUNT && !SDL_TICKS_PASSED(SDL_GetTicks(), start + 10000)) {
+        TEST_ASSERT_TRUE(discovery_inflight_poll(&inflight, 100) >= 1);
+    }
+    int responder_result = -1;
+    SDL_WaitThread(thread, &responder_result);
+    TEST_ASSERT_EQUAL(0, responder_result);
+
+    TEST_ASSERT_EQUAL(HOSTS_COUNT, finished_count);
+    // Results arrive as each responder answers, regardless of announcement order
+    int resolved_order[HOSTS_COUNT], resolved_count = 0;
+    for (int i = 0; i < finished_count; i++) {
+        if (!hosts[finished_order[i]].timed_out) {
+            resolved_order[resolved_count++] = finished_order[i];
+        }
+    }
+    TEST_ASSERT_EQUAL(HOSTS_COUNT - 1, resolved_count);
+    TEST_ASSERT_EQUAL_INT_ARRAY(answer_order, resolved_order, HOSTS_COUNT - 1);
+    for (int i = 0; i < HOSTS_COUNT; i++) {
+        TEST_ASSERT_EQUAL(i != 3, hosts[i].resolved);
+        TEST_ASSERT_EQUAL(i == 3, hosts[i].timed_out);
+    }
+    // Browse operation has no deadline
+    TEST_ASSERT_EQUAL(1, inflight.count);
+}
+
+static int responder(void *arg) {
+    (void) arg;
+    for (int i = 0; i < HOSTS_COUNT; i++) {
+        send(browse_fds[1], &i, sizeof(i), 0);
+    }
+    for (int i = 0; i < HOSTS_COUNT - 1; i++) {
+        host_t *host = &hosts[answer_order[i]];
+        char answer = 1;
+        send(host->fds[1], &answer, sizeof(answer), 0);
+        // Next answer only after this one is handled, so the order doesn't depend on timing
+        if (SDL_SemWaitTimeout(host->closed, 10000) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static bool browse_process(void *handle) {
+    (void) handle;
+    int index;
+    if (recv(browse_fds[0], &index, sizeof(index), 0) != sizeof(index)) {
+        return true;
+    }
+    discovery_inflight_add(&inflight, hosts[index].fds[0], RESOLVE_TIMEOUT,
+                           (discovery_inflight_process_fn) resolve_process,
+                           (discovery_inflight_close_fn) resolve_close, &hosts[index]);
+    return false;
+}
+
+static void browse_close(void *handle, bool timed_out) {
+    (void) handle;
+    (void) timed_out;
+}
+
+static bool resolve_process(host_t *host) {
+    char answer;
+    host->resolved = recv(host->fds[0], &answer, sizeof(answer), 0) == sizeof(answer);
+    return true;
+}
+
+static void resolve_close(host_t *host, bool timed_out) {
+    host->timed_out = timed_out;
+    finished_order[finished_count++] = (int) (host - hosts);
+    SDL_SemPost(host->closed);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_concurrent_resolves);
+    return UNITY_END();
+}
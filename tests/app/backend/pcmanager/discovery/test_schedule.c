@@ -0,0 +1,83 @@
+#include "unity.h"
+#include "backend/pcmanager/discovery/schedule.h"
+
+#define INITIAL_INTERVAL 1000
+#define STEADY_INTERVAL 60000
+/* mdns_listen wakes up at least once per receive timeout */
+#define WAKEUP_INTERVAL 1000
+
+static discovery_schedule_t schedule;
+/* Mock clock, starts close to wrap around to cover tick overflow */
+static Uint32 now;
+
+static unsigned int run_idle(Uint32 duration, Uint32 *query_times, unsigned int max_queries);
+
+void setUp(void) {
+    now = 0xFFFFFFFF - 100000;
+    discovery_schedule_init(&schedule, INITIAL_INTERVAL, STEADY_INTERVAL, now);
+}
+
+void tearDown(void) {
+}
+
+void test_backoff() {
+    Uint32 start = now;
+    Uint32 times[16];
+    unsigned int queries = run_idle(10 * 60 * 1000, times, 16);
+
+    static const Uint32 expected[] = {0, 1, 3, 7, 15, 31, 63, 123, 183};
+    for (size_t i = 0; i < sizeof(expected) / sizeof(Uint32); i++) {
+        TEST_ASSERT_EQUAL(expected[i] * 1000, times[i] - start);
+    }
+    // Fixed 10 seconds interval would have sent 60 queries
+    TEST_ASSERT_EQUAL(15, queries);
+    TEST_ASSERT_EQUAL(queries, schedule.queries);
+    TEST_ASSERT_EQUAL(600, schedule.wakeups);
+}
+
+void test_reset() {
+    Uint32 times[16];
+    run_idle(5 * 60 * 1000, times, 16);
+    TEST_ASSERT_TRUE(discovery_schedule_remaining(&schedule, now) > INITIAL_INTERVAL * 2);
+
+    discovery_schedule_reset(&schedule, now);
+    TEST_ASSERT_EQUAL(0, discovery_schedule_remaining(&schedule, now));
+    Uint32 start = now;
+    unsigned int queries = run_idle(8 * 1000, times, 16);
+    // Fast pace again: right away, then after 1 s, 2 s and 4 s
+    TEST_ASSERT_EQUAL(4, queries);
+    TEST_ASSERT_EQUAL(0, times[0] - start);
+    TEST_ASSERT_EQUAL(1000, times[1] - start);
+    TEST_ASSERT_EQUAL(3000, times[2] - start);
+    TEST_ASSERT_EQUAL(7000, times[3] - start);
+}
+
+void test_late_wakeup() {
+    TEST_ASSERT_TRUE(discovery_schedule_due(&schedule, now));
+    // Wakeup much later than scheduled, e.g. device was suspended
+    now += 30000;
+    TEST_ASSERT_TRUE(discovery_schedule_due(&schedule, now));
+    TEST_ASSERT_FALSE(discovery_schedule_due(&schedule, now + 1000));
+    TEST_ASSERT_TRUE(discovery_schedule_due(&schedule, now + 2000));
+}
+
+static unsigned int run_idle(Uint32 duration, Uint32 *query_times, unsigned int max_queries) {
+    unsigned int queries = 0;
+    for (Uint32 elapsed = 0; elapsed < duration; elapsed += WAKEUP_INTERVAL, now += WAKEUP_INTERVAL) {
+        if (discovery_schedule_due(&schedule, now)) {
+            if (queries < max_queries) {
+                query_times[queries] = now;
+            }
+            queries++;
+        }
+    }
+    return queries;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_backoff);
+    RUN_TEST(test_reset);
+    RUN_TEST(test_late_wakeup);
+    return UNITY_END();
+}
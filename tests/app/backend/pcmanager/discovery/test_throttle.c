@@ -1,10 +1,19 @@
 #include "unity.h"
 #include "backend/pcmanager/discovery/throttle.h"
 
+#include <stdio.h>
 #include <SDL2/SDL_timer.h>
+#include <SDL2/SDL_thread.h>
+
+#define SCALE_HOSTS 5000
 
 static discovery_throttle_t throttle;
 static int counter = 0;
+static int lock_held = 0;
+
+static sockaddr_t *host_addr(int index);
+
+static int try_lock_throttle(void *arg);
 
 void callback(const sockaddr_t *addr, void *user_data) {
     (void) addr;
@@ -12,8 +21,20 @@ void callback(const sockaddr_t *addr, void *user_data) {
     counter++;
 }
 
+void callback_check_lock(const sockaddr_t *addr, void *user_data) {
+    (void) addr;
+    (void) user_data;
+    // Lock is recursive, so try it from another thread
+    SDL_Thread *thread = SDL_CreateThread(try_lock_throttle, "trylock", NULL);
+    int locked = -1;
+    SDL_WaitThread(thread, &locked);
+    lock_held |= !locked;
+    counter++;
+}
+
 void setUp(void) {
     counter = 0;
+    lock_held = 0;
     discovery_throttle_init(&throttle, callback, NULL);
 }
 
@@ -35,8 +56,99 @@ void test_discovery_throttle(void) {
     sockaddr_free(addr);
 }
 
+void test_different_ttl(void) {
+    sockaddr_t *short_lived = host_addr(1), *long_lived = host_addr(2);
+    discovery_throttle_on_discovered(&throttle, short_lived, 30);
+    discovery_throttle_on_discovered(&throttle, long_lived, 500);
+    TEST_ASSERT_EQUAL(2, counter);
+    SDL_Delay(100);
+    discovery_throttle_on_discovered(&throttle, short_lived, 30);
+    discovery_throttle_on_discovered(&throttle, long_lived, 500);
+    TEST_ASSERT_EQUAL(3, counter);
+    TEST_ASSERT_EQUAL(2, throttle.count);
+    sockaddr_free(short_lived);
+    sockaddr_free(long_lived);
+}
+
+void test_same_address_different_port(void) {
+    sockaddr_t *addr = host_addr(1);
+    discovery_throttle_on_discovered(&throttle, addr, 1000);
+    sockaddr_set_port(addr, 47990);
+    discovery_throttle_on_discovered(&throttle, addr, 1000);
+    TEST_ASSERT_EQUAL(2, counter);
+    sockaddr_free(addr);
+}
+
+void test_scale(void) {
+    sockaddr_t *addrs[SCALE_HOSTS];
+    for (int i = 0; i < SCALE_HOSTS; i++) {
+        addrs[i] = host_addr(i);
+    }
+    // Each host answers several times, as it does for every query
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < SCALE_HOSTS; i++) {
+            discovery_throttle_on_discovered(&throttle, addrs[i], 10000);
+        }
+    }
+    TEST_ASSERT_EQUAL(SCALE_HOSTS, counter);
+    TEST_ASSERT_EQUAL(SCALE_HOSTS, throttle.count);
+    for (int i = 0; i < SCALE_HOSTS; i++) {
+        sockaddr_free(addrs[i]);
+    }
+}
+
+void test_scale_expiry(void) {
+    sockaddr_t *addrs[SCALE_HOSTS];
+    for (int i = 0; i < SCALE_HOSTS; i++) {
+        addrs[i] = host_addr(i);
+        // Spread expiry over several wheel slots
+        discovery_throttle_on_discovered(&throttle, addrs[i], 200 + (i % 10) * 20);
+    }
+    TEST_ASSERT_EQUAL(SCALE_HOSTS, throttle.count);
+    SDL_Delay(500);
+    discovery_throttle_on_discovered(&throttle, addrs[0], 10000);
+    // All others are evicted on the way
+    TEST_ASSERT_EQUAL(1, throttle.count);
+    TEST_ASSERT_EQUAL(SCALE_HOSTS + 1, counter);
+    for (int i = 0; i < SCALE_HOSTS; i++) {
+        sockaddr_free(addrs[i]);
+    }
+}
+
+void test_callback_outside_lock(void) {
+    throttle.callback = callback_check_lock;
+    sockaddr_t *addr = host_addr(1);
+    discovery_throttle_on_discovered(&throttle, addr, 1000);
+    TEST_ASSERT_EQUAL(1, counter);
+    TEST_ASSERT_EQUAL(0, lock_held);
+    sockaddr_free(addr);
+}
+
+static sockaddr_t *host_addr(int index) {
+    char ip[32];
+    snprintf(ip, sizeof(ip), "10.%d.%d.%d", index / 65536, (index / 256) % 256, index % 256);
+    sockaddr_t *addr = sockaddr_new();
+    sockaddr_set_ip_str(addr, AF_INET, ip);
+    sockaddr_set_port(addr, 47989);
+    return addr;
+}
+
+static int try_lock_throttle(void *arg) {
+    (void) arg;
+    if (SDL_TryLockMutex(throttle.lock) != 0) {
+        return 0;
+    }
+    SDL_UnlockMutex(throttle.lock);
+    return 1;
+}
+
 int main() {
     UNITY_BEGIN();
     RUN_TEST(test_discovery_throttle);
+    RUN_TEST(test_different_ttl);
+    RUN_TEST(test_same_address_different_port);
+    RUN_TEST(test_scale);
+    RUN_TEST(test_scale_expiry);
+    RUN_TEST(test_callback_outside_lock);
     return UNITY_END();
-}
\ No newline at end of file
+}
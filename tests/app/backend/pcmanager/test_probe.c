@@ -0,0 +1,119 @@
+#include "unity.h"
+#include "backend/pcmanager/probe.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define PROBE_DEADLINE 500
+
+static int listen_local(int backlog, uint16_t *port);
+
+static uint16_t closed_port();
+
+void setUp(void) {
+
+}
+
+void tearDown(void) {
+
+}
+
+void test_reachable() {
+    uint16_t port;
+    int server = listen_local(8, &port);
+    host_probe_t probe = {.host = "127.0.0.1", .port = port, .deadline = PROBE_DEADLINE};
+    TEST_ASSERT_EQUAL(1, host_probe_run(&probe, 1));
+    TEST_ASSERT_EQUAL(0, probe.error);
+    TEST_ASSERT_TRUE(probe.elapsed < PROBE_DEADLINE);
+    close(server);
+}
+
+void test_refused() {
+    host_probe_t probe = {.host = "127.0.0.1", .port = closed_port(), .deadline = PROBE_DEADLINE};
+    TEST_ASSERT_EQUAL(0, host_probe_run(&probe, 1));
+    TEST_ASSERT_EQUAL(ECONNREFUSED, probe.error);
+    TEST_ASSERT_TRUE(probe.elapsed < PROBE_DEADLINE);
+}
+
+void test_unresolvable() {
+    host_probe_t probe = {.host = "host.invalid", .port = 47989, .deadline = PROBE_DEADLINE};
+    TEST_ASSERT_EQUAL(0, host_probe_run(&probe, 1));
+    TEST_ASSERT_NOT_EQUAL(0, probe.error);
+}
+
+void test_mixed_hosts_in_parallel() {
+    // Stand-ins for online hosts, hosts with GameStream stopped, and one never answering
+    uint16_t ports[4];
+    int servers[4];
+    for (int i = 0; i < 4; i++) {
+        servers[i] = listen_local(8, &ports[i]);
+    }
+    uint16_t stalled_port;
+    int stalled = listen_local(0, &stalled_port);
+    // Fill the accept queue, so further connections are never answered
+    int fillers[4];
+    for (int i = 0; i < 4; i++) {
+        struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(stalled_port)};
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        fillers[i] = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        connect(fillers[i], (struct sockaddr *) &addr, sizeof(addr));
+    }
+
+    host_probe_t probes[7] = {
+            {.host = "127.0.0.1", .port = ports[0], .deadline = PROBE_DEADLINE},
+            {.host = "127.0.0.1", .port = closed_port(), .deadline = PROBE_DEADLINE},
+            {.host = "127.0.0.1", .port = ports[1], .deadline = PROBE_DEADLINE},
+            {.host = "127.0.0.1", .port = stalled_port, .deadline = 200},
+            {.host = "127.0.0.1", .port = ports[2], .deadline = PROBE_DEADLINE},
+            {.host = "127.0.0.1", .port = ports[3], .deadline = PROBE_DEADLINE},
+            {.host = "127.0.0.1", .port = stalled_port, .deadline = 300},
+    };
+    int reachable = host_probe_run(probes, 7);
+    TEST_ASSERT_TRUE(reachable >= 4);
+    TEST_ASSERT_EQUAL(0, probes[0].error);
+    TEST_ASSERT_EQUAL(ECONNREFUSED, probes[1].error);
+    TEST_ASSERT_EQUAL(0, probes[2].error);
+    TEST_ASSERT_EQUAL(0, probes[4].error);
+    TEST_ASSERT_EQUAL(0, probes[5].error);
+    // Stalled host may still be accepted on some kernels, otherwise it times out
+    TEST_ASSERT_TRUE(probes[3].error == 0 || probes[3].error == ETIMEDOUT);
+    TEST_ASSERT_TRUE(probes[6].error == 0 || probes[6].error == ETIMEDOUT);
+
+    for (int i = 0; i < 4; i++) {
+        close(fillers[i]);
+        close(servers[i]);
+    }
+    close(stalled);
+}
+
+static int listen_local(int backlog, uint16_t *port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    TEST_ASSERT_TRUE(fd >= 0);
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = 0};
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    TEST_ASSERT_EQUAL(0, bind(fd, (struct sockaddr *) &addr, sizeof(addr)));
+    TEST_ASSERT_EQUAL(0, listen(fd, backlog));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (struct sockaddr *) &addr, &len);
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+static uint16_t closed_port() {
+    uint16_t port;
+    int fd = listen_local(1, &port);
+    close(fd);
+    return port;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_reachable);
+    RUN_TEST(test_refused);
+    RUN_TEST(test_unresolvable);
+    RUN_TEST(test_mixed_hosts_in_parallel);
+    return UNITY_END();
+}
@@ -0,0 +1,207 @@
+#include "unity.h"
+#include "backend/pcmanager/registry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#define STRESS_READERS 4
+#define STRESS_DURATION_MS 1500
+#define STRESS_MAX_HOSTS 64
+
+static pcregistry_t registry;
+static SDL_atomic_t nodes_alive, servers_alive;
+static SDL_atomic_t stop;
+
+static pclist_t *node_new(int id);
+
+static pclist_t *node_move(const pclist_t *node, int address_id);
+
+static SERVER_DATA *server_new(int id);
+
+static void node_free(pclist_t *node);
+
+static void server_free(SERVER_DATA *server);
+
+static int stress_reader(void *arg);
+
+void setUp(void) {
+    SDL_AtomicSet(&nodes_alive, 0);
+    SDL_AtomicSet(&servers_alive, 0);
+    SDL_AtomicSet(&stop, 0);
+    pcregistry_init(&registry);
+}
+
+void tearDown(void) {
+    pcregistry_deinit(&registry, (pcregistry_free_fn) node_free);
+    TEST_ASSERT_EQUAL(0, SDL_AtomicGet(&nodes_alive));
+    TEST_ASSERT_EQUAL(0, SDL_AtomicGet(&servers_alive));
+}
+
+void test_lookup() {
+    pclist_t *nodes[20];
+    for (int i = 0; i < 20; i++) {
+        nodes[i] = node_new(i);
+        pcregistry_add(&registry, nodes[i]);
+    }
+    const pclist_snapshot_t *snapshot = pcregistry_acquire(&registry);
+    TEST_ASSERT_EQUAL(20, snapshot->count);
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT_EQUAL_PTR(nodes[i], snapshot->nodes[i]);
+        TEST_ASSERT_EQUAL_PTR(nodes[i], pcregistry_find_by_uuid(snapshot, &nodes[i]->id));
+        TEST_ASSERT_EQUAL_PTR(nodes[i], pcregistry_find_by_address(snapshot, nodes[i]->server->serverInfo.address));
+    }
+    TEST_ASSERT_NULL(pcregistry_find_by_address(snapshot, "192.168.1.1"));
+    pcregistry_release(snapshot);
+
+    pcregistry_remove(&registry, nodes[5], (pcregistry_free_fn) node_free);
+    snapshot = pcregistry_acquire(&registry);
+    TEST_ASSERT_EQUAL(19, snapshot->count);
+    TEST_ASSERT_EQUAL_PTR(nodes[6], snapshot->nodes[5]);
+    TEST_ASSERT_NULL(pcregistry_find_by_address(snapshot, "10.0.0.5"));
+    TEST_ASSERT_EQUAL_PTR(nodes[19], pcregistry_find_by_address(snapshot, "10.0.0.19"));
+    pcregistry_release(snapshot);
+}
+
+void test_retired_after_release() {
+    pclist_t *node = node_new(1);
+    pcregistry_add(&registry, node);
+    const pclist_snapshot_t *old = pcregistry_acquire(&registry);
+
+    // Replace the node with one at another address, while the old snapshot is still held
+    pclist_t *replacement = node_move(node, 2);
+    pcregistry_replace(&registry, &node, &replacement, 1, (pcregistry_free_fn) node_free);
+    TEST_ASSERT_EQUAL(2, SDL_AtomicGet(&servers_alive));
+
+    const pclist_snapshot_t *current = pcregistry_acquire(&registry);
+    TEST_ASSERT_EQUAL(1, current->count);
+    TEST_ASSERT_NULL(pcregistry_find_by_address(current, "10.0.0.1"));
+    TEST_ASSERT_EQUAL_PTR(replacement, pcregistry_find_by_address(current, "10.0.0.2"));
+    TEST_ASSERT_EQUAL_PTR(replacement, pcregistry_find_by_uuid(current, &node->id));
+    TEST_ASSERT_EQUAL_PTR(node, pcregistry_find_by_uuid(old, &node->id));
+
+    pcregistry_remove(&registry, replacement, (pcregistry_free_fn) node_free);
+    TEST_ASSERT_EQUAL(2, SDL_AtomicGet(&nodes_alive));
+
+    // Newer snapshot is released first, nothing can be freed while the oldest is held
+    pcregistry_release(current);
+    TEST_ASSERT_EQUAL(2, SDL_AtomicGet(&nodes_alive));
+    TEST_ASSERT_EQUAL(2, SDL_AtomicGet(&servers_alive));
+    pcregistry_release(old);
+    TEST_ASSERT_EQUAL(0, SDL_AtomicGet(&nodes_alive));
+    TEST_ASSERT_EQUAL(0, SDL_AtomicGet(&servers_alive));
+}
+
+void test_concurrent_readers_writer() {
+    SDL_Thread *readers[STRESS_READERS];
+    int reads[STRESS_READERS] = {0};
+    for (int i = 0; i < STRESS_READERS; i++) {
+        readers[i] = SDL_CreateThread(stress_reader, "reader", &reads[i]);
+        TEST_ASSERT_NOT_NULL(readers[i]);
+    }
+    srand(42);
+    int next_id = 0, writes = 0;
+    Uint32 deadline = SDL_GetTicks() + STRESS_DURATION_MS;
+    while (!SDL_TICKS_PASSED(SDL_GetTicks(), deadline)) {
+        const pclist_snapshot_t *current = pcregistry_peek(&registry);
+        int op = rand() % 3;
+        if (current->count == 0 || (op == 0 && current->count < STRESS_MAX_HOSTS)) {
+            pcregistry_add(&registry, node_new(next_id++));
+        } else if (op == 1) {
+            pcregistry_remove(&registry, current->nodes[rand() % current->count], (pcregistry_free_fn) node_free);
+        } else {
+            // Move the host to another address
+            pclist_t *node = current->nodes[rand() % current->count];
+            pclist_t *replacement = node_move(node, next_id++);
+            pcregistry_replace(&registry, &node, &replacement, 1, (pcregistry_free_fn) node_free);
+        }
+        writes++;
+    }
+    SDL_AtomicSet(&stop, 1);
+    int total_reads = 0;
+    for (int i = 0; i < STRESS_READERS; i++) {
+        int status = -1;
+        SDL_WaitThread(readers[i], &status);
+        TEST_ASSERT_EQUAL(0, status);
+        total_reads += reads[i];
+    }
+    TEST_ASSERT_TRUE(writes > 0);
+    TEST_ASSERT_TRUE(total_reads > 0);
+}
+
+static int stress_reader(void *arg) {
+    int *reads = arg;
+    while (!SDL_AtomicGet(&stop)) {
+        const pclist_snapshot_t *snapshot = pcregistry_acquire(&registry);
+        for (size_t i = 0; i < snapshot->count; i++) {
+            const pclist_t *node = snapshot->nodes[i];
+            if (pcregistry_find_by_uuid(snapshot, &node->id) != node) {
+                pcregistry_release(snapshot);
+                return 1;
+            }
+            // Node may be replaced at any time, but the one read must stay intact until release
+            const SERVER_DATA *server = node->server;
+            if (server == NULL || strncmp(server->serverInfo.address, "10.", 3) != 0) {
+                pcregistry_release(snapshot);
+                return 2;
+            }
+        }
+        pcregistry_release(snapshot);
+        (*reads)++;
+    }
+    return 0;
+}
+
+static pclist_t *node_new(int id) {
+    pclist_t *node = calloc(1, sizeof(pclist_t));
+    char uuid[40];
+    snprintf(uuid, sizeof(uuid), "00000000-0000-0000-0000-%012d", id);
+    uuidstr_fromstr(&node->id, uuid);
+    node->server = server_new(id);
+    SDL_AtomicIncRef(&nodes_alive);
+    return node;
+}
+
+/**
+ * Copy of the node with server at another address, like pclist does for host updates.
+ */
+static pclist_t *node_move(const pclist_t *node, int address_id) {
+    pclist_t *moved = calloc(1, sizeof(pclist_t));
+    moved->id = node->id;
+    moved->server = server_new(address_id);
+    SDL_AtomicIncRef(&nodes_alive);
+    return moved;
+}
+
+static SERVER_DATA *server_new(int id) {
+    SERVER_DATA *server = calloc(1, sizeof(SERVER_DATA));
+    char address[32];
+    snprintf(address, sizeof(address), "10.0.%d.%d", id / 256, id % 256);
+    server->serverInfo.address = strdup(address);
+    SDL_AtomicIncRef(&servers_alive);
+    return server;
+}
+
+static void node_free(pclist_t *node) {
+    server_free(node->server);
+    free(node);
+    SDL_AtomicDecRef(&nodes_alive);
+}
+
+static void server_free(SERVER_DATA *server) {
+    // Poison it, so readers of a freed server would fail even without sanitizers
+    free((void *) server->serverInfo.address);
+    memset(server, 0, sizeof(SERVER_DATA));
+    free(server);
+    SDL_AtomicDecRef(&servers_alive);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_lookup);
+    RUN_TEST(test_retired_after_release);
+    RUN_TEST(test_concurrent_readers_writer);
+    return UNITY_END();
+}
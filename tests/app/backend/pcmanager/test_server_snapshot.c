@@ -0,0 +1,219 @@
+#include "unity.h"
+#include "backend/pcmanager/server_snapshot.h"
+#include "backend/pcmanager/priv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TEST_UUID "8c7fa7d4-54b1-4b8d-9a0f-0c1f2e3d4b5a"
+
+static char conf_dir[] = "/tmp/test_server_snapshot_XXXXXX";
+static SERVER_DATA *server;
+
+static void queue_wait_idle(server_snapshot_queue_t *queue);
+
+void setUp(void) {
+    TEST_ASSERT_NOT_NULL(mkdtemp(conf_dir));
+    server = serverdata_new();
+    server->uuid = strdup(TEST_UUID);
+    server->mac = strdup("00:11:22:33:44:55");
+    server->hostname = strdup("DESKTOP");
+    server->gpuType = strdup("GeForce RTX 3080");
+    server->gsVersion = strdup("3.23.0.74");
+    server->serverInfo.address = strdup("192.168.1.100");
+    server->serverInfo.serverInfoAppVersion = strdup("7.1.431.-1");
+    server->httpsPort = 47984;
+    server->extPort = 47989;
+    server->paired = true;
+    server->supportsHdr = true;
+    server->currentGame = 881448767;
+    server->serverMajorVersion = 7;
+    server->serverInfo.serverCodecModeSupport = 0x30F03;
+    PDISPLAY_MODE *tail = &server->modes;
+    for (int i = 0; i < 3; i++) {
+        PDISPLAY_MODE mode = calloc(1, sizeof(DISPLAY_MODE));
+        mode->width = 1920 * (i + 1);
+        mode->height = 1080 * (i + 1);
+        mode->refresh = 60;
+        *tail = mode;
+        tail = &mode->next;
+    }
+}
+
+void tearDown(void) {
+    serverdata_free(server);
+    server_snapshot_remove(conf_dir, TEST_UUID);
+    rmdir(conf_dir);
+    strcpy(conf_dir, "/tmp/test_server_snapshot_XXXXXX");
+}
+
+void test_roundtrip() {
+    unsigned char *buf = NULL;
+    size_t len = 0;
+    uint32_t hash = 0;
+    TEST_ASSERT_EQUAL(0, server_snapshot_encode(server, &buf, &len, &hash));
+    SERVER_DATA *decoded = server_snapshot_decode(buf, len);
+    TEST_ASSERT_NOT_NULL(decoded);
+    TEST_ASSERT_EQUAL_STRING(server->uuid, decoded->uuid);
+    TEST_ASSERT_EQUAL_STRING(server->hostname, decoded->hostname);
+    TEST_ASSERT_EQUAL_STRING(server->gsVersion, decoded->gsVersion);
+    TEST_ASSERT_EQUAL_STRING(server->serverInfo.address, decoded->serverInfo.address);
+    TEST_ASSERT_NULL(decoded->serverInfo.serverInfoGfeVersion);
+    TEST_ASSERT_EQUAL(server->httpsPort, decoded->httpsPort);
+    TEST_ASSERT_EQUAL(server->extPort, decoded->extPort);
+    TEST_ASSERT_TRUE(decoded->paired);
+    TEST_ASSERT_TRUE(decoded->supportsHdr);
+    TEST_ASSERT_FALSE(decoded->supports4K);
+    TEST_ASSERT_EQUAL(server->currentGame, decoded->currentGame);
+    TEST_ASSERT_EQUAL(server->serverInfo.serverCodecModeSupport, decoded->serverInfo.serverCodecModeSupport);
+    int modes = 0;
+    for (const DISPLAY_MODE *mode = decoded->modes; mode != NULL; mode = mode->next) {
+        TEST_ASSERT_EQUAL(1080 * (modes + 1), mode->height);
+        modes++;
+    }
+    TEST_ASSERT_EQUAL(3, modes);
+
+    unsigned char *buf2 = NULL;
+    size_t len2 = 0;
+    uint32_t hash2 = 0;
+    TEST_ASSERT_EQUAL(0, server_snapshot_encode(decoded, &buf2, &len2, &hash2));
+    TEST_ASSERT_EQUAL(hash, hash2);
+    free(buf2);
+    serverdata_free(decoded);
+    free(buf);
+}
+
+void test_corrupted() {
+    unsigned char *buf = NULL;
+    size_t len = 0;
+    TEST_ASSERT_EQUAL(0, server_snapshot_encode(server, &buf, &len, NULL));
+    for (size_t i = 0; i < len; i++) {
+        TEST_ASSERT_NULL(server_snapshot_decode(buf, i));
+    }
+    buf[len / 2] ^= 0x01;
+    TEST_ASSERT_NULL(server_snapshot_decode(buf, len));
+    free(buf);
+}
+
+void test_save_load() {
+    TEST_ASSERT_NULL(server_snapshot_load(conf_dir, TEST_UUID, NULL));
+
+    uint32_t saved_hash = 0;
+    TEST_ASSERT_EQUAL(0, server_snapshot_save(conf_dir, server, &saved_hash));
+    TEST_ASSERT_NOT_EQUAL(0, saved_hash);
+
+    uint32_t loaded_hash = 0;
+    SERVER_DATA *loaded = server_snapshot_load(conf_dir, TEST_UUID, &loaded_hash);
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL(saved_hash, loaded_hash);
+    TEST_ASSERT_EQUAL(server->currentGame, loaded->currentGame);
+    serverdata_free(loaded);
+
+    // Not written again if nothing changed
+    server_snapshot_remove(conf_dir, TEST_UUID);
+    TEST_ASSERT_EQUAL(0, server_snapshot_save(conf_dir, server, &saved_hash));
+    TEST_ASSERT_NULL(server_snapshot_load(conf_dir, TEST_UUID, NULL));
+
+    server->currentGame = 0;
+    TEST_ASSERT_EQUAL(0, server_snapshot_save(conf_dir, server, &saved_hash));
+    loaded = server_snapshot_load(conf_dir, TEST_UUID, NULL);
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL(0, loaded->currentGame);
+    serverdata_free(loaded);
+
+    // Other hosts have no snapshot
+    TEST_ASSERT_NULL(server_snapshot_load(conf_dir, "00000000-0000-0000-0000-000000000000", NULL));
+}
+
+void test_queue() {
+    executor_t *executor = executor_create("test-snapshot", 2);
+    server_snapshot_queue_t queue;
+    server_snapshot_queue_init(&queue, executor, conf_dir);
+    for (int i = 1; i <= 50; i++) {
+        server->currentGame = i;
+        server_snapshot_queue_save(&queue, server);
+    }
+    server_snapshot_queue_deinit(&queue);
+    executor_destroy(executor);
+
+    // Only the latest change counts, no matter how many were still queued
+    SERVER_DATA *loaded = server_snapshot_load(conf_dir, TEST_UUID, NULL);
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL(50, loaded->currentGame);
+    serverdata_free(loaded);
+}
+
+void test_queue_unchanged() {
+    uint32_t hash = 0;
+    TEST_ASSERT_EQUAL(0, server_snapshot_save(conf_dir, server, &hash));
+    server_snapshot_remove(conf_dir, TEST_UUID);
+
+    executor_t *executor = executor_create("test-snapshot", 2);
+    server_snapshot_queue_t queue;
+    server_snapshot_queue_init(&queue, executor, conf_dir);
+    // Same content as the loaded snapshot isn't written again
+    server_snapshot_queue_set_saved(&queue, TEST_UUID, hash);
+    server_snapshot_queue_save(&queue, server);
+    server_snapshot_queue_deinit(&queue);
+    executor_destroy(executor);
+
+    TEST_ASSERT_NULL(server_snapshot_load(conf_dir, TEST_UUID, NULL));
+}
+
+void test_queue_retry_failed() {
+    char missing_dir[sizeof(conf_dir) + 8];
+    snprintf(missing_dir, sizeof(missing_dir), "%s/later", conf_dir);
+    executor_t *executor = executor_create("test-snapshot", 2);
+    server_snapshot_queue_t queue;
+    server_snapshot_queue_init(&queue, executor, missing_dir);
+    server_snapshot_queue_save(&queue, server);
+    queue_wait_idle(&queue);
+    TEST_ASSERT_NULL(server_snapshot_load(missing_dir, TEST_UUID, NULL));
+
+    // Failed write doesn't count as saved, so the same content is written again
+    TEST_ASSERT_EQUAL(0, mkdir(missing_dir, 0700));
+    server_snapshot_queue_save(&queue, server);
+    server_snapshot_queue_deinit(&queue);
+    executor_destroy(executor);
+
+    SERVER_DATA *loaded = server_snapshot_load(missing_dir, TEST_UUID, NULL);
+    TEST_ASSERT_NOT_NULL(loaded);
+    serverdata_free(loaded);
+    server_snapshot_remove(missing_dir, TEST_UUID);
+    rmdir(missing_dir);
+}
+
+void test_queue_remove() {
+    executor_t *executor = executor_create("test-snapshot", 2);
+    server_snapshot_queue_t queue;
+    server_snapshot_queue_init(&queue, executor, conf_dir);
+    server_snapshot_queue_save(&queue, server);
+    server_snapshot_queue_remove(&queue, TEST_UUID);
+    server_snapshot_queue_deinit(&queue);
+    executor_destroy(executor);
+
+    TEST_ASSERT_NULL(server_snapshot_load(conf_dir, TEST_UUID, NULL));
+}
+
+static void queue_wait_idle(server_snapshot_queue_t *queue) {
+    SDL_LockMutex(queue->lock);
+    while (queue->writing) {
+        SDL_CondWait(queue->idle, queue->lock);
+    }
+    SDL_UnlockMutex(queue->lock);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_roundtrip);
+    RUN_TEST(test_corrupted);
+    RUN_TEST(test_save_load);
+    RUN_TEST(test_queue);
+    RUN_TEST(test_queue_unchanged);
+    RUN_TEST(test_queue_retry_failed);
+    RUN_TEST(test_queue_remove);
+    return UNITY_END();
+}
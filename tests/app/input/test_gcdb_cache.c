@@ -0,0 +1,143 @@
+#include "unity.h"
+#include "input/gcdb_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef FIXTURES_PATH_PREFIX
+#define FIXTURES_PATH_PREFIX "./"
+#endif
+
+#define SAMPLE_PATH FIXTURES_PATH_PREFIX "gamecontrollerdb_sample.txt"
+
+#define LARGE_MAPPINGS_PER_PLATFORM 2000
+
+static char dir[] = "/tmp/test_gcdb_cache_XXXXXX";
+static char cache_path[256], extra_path[256], large_path[256];
+
+static char *read_file(const char *path);
+
+static int count_lines(const char *content, const char *needle);
+
+static void write_file(const char *path, const char *content);
+
+void setUp(void) {
+    TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+    snprintf(cache_path, sizeof(cache_path), "%s/gamecontrollerdb_cache.txt", dir);
+    snprintf(extra_path, sizeof(extra_path), "%s/gamecontrollerdb_extra.txt", dir);
+    snprintf(large_path, sizeof(large_path), "%s/gamecontrollerdb_large.txt", dir);
+}
+
+void tearDown(void) {
+    remove(cache_path);
+    remove(extra_path);
+    remove(large_path);
+    rmdir(dir);
+    strcpy(dir, "/tmp/test_gcdb_cache_XXXXXX");
+}
+
+void test_filter_platform() {
+    const char *sources[] = {SAMPLE_PATH};
+    gcdb_cache_stats_t stats;
+    TEST_ASSERT_EQUAL(1, gcdb_cache_update(cache_path, sources, 1, "Linux", &stats));
+    TEST_ASSERT_EQUAL(7, stats.lines);
+    TEST_ASSERT_EQUAL(3, stats.kept);
+    TEST_ASSERT_EQUAL(1, stats.duplicates);
+
+    char *cache = read_file(cache_path);
+    TEST_ASSERT_EQUAL(0, count_lines(cache, "platform:Windows"));
+    TEST_ASSERT_EQUAL(0, count_lines(cache, "platform:Mac OS X"));
+    TEST_ASSERT_EQUAL(1, count_lines(cache, "PS4 Controller"));
+    // Last mapping of the same GUID wins
+    TEST_ASSERT_EQUAL(1, count_lines(cache, "030000005e0400008e02000010010000,"));
+    TEST_ASSERT_EQUAL(1, count_lines(cache, "Xbox 360 Controller (newer)"));
+    // Mappings without platform are kept
+    TEST_ASSERT_EQUAL(1, count_lines(cache, "xinput,"));
+    TEST_ASSERT_EQUAL(strlen(cache), stats.cache_bytes);
+    free(cache);
+}
+
+void test_up_to_date() {
+    const char *sources[] = {SAMPLE_PATH, extra_path};
+    TEST_ASSERT_EQUAL(1, gcdb_cache_update(cache_path, sources, 2, "Linux", NULL));
+    TEST_ASSERT_EQUAL(0, gcdb_cache_update(cache_path, sources, 2, "Linux", NULL));
+    // Other platform
+    TEST_ASSERT_EQUAL(1, gcdb_cache_update(cache_path, sources, 2, "Windows", NULL));
+    TEST_ASSERT_EQUAL(0, gcdb_cache_update(cache_path, sources, 2, "Windows", NULL));
+
+    // Extra db appears, and overrides the main one
+    write_file(extra_path, "050000004c050000c405000000010000,PS4 Controller (extra),a:b0,b:b1,platform:Windows,\n");
+    TEST_ASSERT_EQUAL(1, gcdb_cache_update(cache_path, sources, 2, "Windows", NULL));
+    char *cache = read_file(cache_path);
+    TEST_ASSERT_EQUAL(1, count_lines(cache, "PS4 Controller (extra)"));
+    free(cache);
+    TEST_ASSERT_EQUAL(0, gcdb_cache_update(cache_path, sources, 2, "Windows", NULL));
+}
+
+void test_unwritable() {
+    char bad_path[300];
+    snprintf(bad_path, sizeof(bad_path), "%s/missing/gamecontrollerdb_cache.txt", dir);
+    const char *sources[] = {SAMPLE_PATH};
+    TEST_ASSERT_EQUAL(-1, gcdb_cache_update(bad_path, sources, 1, "Linux", NULL));
+}
+
+void test_large() {
+    static const char *platforms[] = {"Windows", "Mac OS X", "Linux", "Android", "iOS"};
+    FILE *fp = fopen(large_path, "w");
+    TEST_ASSERT_NOT_NULL(fp);
+    for (int p = 0; p < 5; p++) {
+        for (int i = 0; i < LARGE_MAPPINGS_PER_PLATFORM; i++) {
+            fprintf(fp, "03000000%08x%016x,Gamepad %d,a:b0,b:b1,back:b6,dpdown:h0.4,dpleft:h0.8,dpright:h0.2,"
+                        "dpup:h0.1,leftshoulder:b4,leftx:a0,lefty:a1,rightshoulder:b5,rightx:a3,righty:a4,start:b7,"
+                        "x:b2,y:b3,platform:%s,\n", p, i, i, platforms[p]);
+        }
+    }
+    fclose(fp);
+
+    const char *sources[] = {large_path};
+    gcdb_cache_stats_t stats;
+    TEST_ASSERT_EQUAL(1, gcdb_cache_update(cache_path, sources, 1, "Linux", &stats));
+    // Unchanged sources don't rebuild the cache
+    TEST_ASSERT_EQUAL(0, gcdb_cache_update(cache_path, sources, 1, "Linux", NULL));
+    TEST_ASSERT_EQUAL(5 * LARGE_MAPPINGS_PER_PLATFORM, stats.lines);
+    TEST_ASSERT_EQUAL(LARGE_MAPPINGS_PER_PLATFORM, stats.kept);
+    TEST_ASSERT_TRUE(stats.cache_bytes * 4 < stats.source_bytes);
+}
+
+static char *read_file(const char *path) {
+    FILE *fp = fopen(path, "r");
+    TEST_ASSERT_NOT_NULL(fp);
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *buf = calloc(1, len + 1);
+    fread(buf, 1, len, fp);
+    fclose(fp);
+    return buf;
+}
+
+static int count_lines(const char *content, const char *needle) {
+    int count = 0;
+    for (const char *p = strstr(content, needle); p != NULL; p = strstr(p + 1, needle)) {
+        count++;
+    }
+    return count;
+}
+
+static void write_file(const char *path, const char *content) {
+    FILE *fp = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(fp);
+    fputs(content, fp);
+    fclose(fp);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_filter_platform);
+    RUN_TEST(test_up_to_date);
+    RUN_TEST(test_unwritable);
+    RUN_TEST(test_large);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+#include "unity.h"
+#include "stream/audio/audio_decoder.h"
+
+#include <math.h>
+#include <string.h>
+
+#define SAMPLE_RATE 48000
+#define CHANNELS 2
+#define PACKETS 400
+#define MAX_PACKET_SIZE 1400
+
+typedef struct packet_set_t {
+    OPUS_MULTISTREAM_CONFIGURATION config;
+    unsigned char packets[PACKETS][MAX_PACKET_SIZE];
+    int sizes[PACKETS];
+} packet_set_t;
+
+/* CELT only low delay packets, like GameStream hosts send. They never carry FEC data. */
+static packet_set_t celt = {
+        .config = {
+                .sampleRate = SAMPLE_RATE,
+                .channelCount = CHANNELS,
+                .streams = 1,
+                .coupledStreams = 1,
+                .samplesPerFrame = 240,
+                .mapping = {0, 1},
+        },
+};
+
+/* SILK packets with in-band FEC */
+static packet_set_t silk = {
+        .config = {
+                .sampleRate = SAMPLE_RATE,
+                .channelCount = CHANNELS,
+                .streams = 1,
+                .coupledStreams = 1,
+                .samplesPerFrame = 960,
+                .mapping = {0, 1},
+        },
+};
+
+static audio_decoder_t decoder;
+static int output_samples;
+
+static int encode_all(packet_set_t *set, int application, bool fec);
+
+static void on_output(const int16_t *pcm, int samples, void *userdata) {
+    (void) pcm;
+    (void) userdata;
+    output_samples += samples;
+}
+
+static void feed_all(const packet_set_t *set, const bool *drop) {
+    TEST_ASSERT_EQUAL(0, audio_decoder_init(&decoder, &set->config));
+    for (int i = 0; i < PACKETS; i++) {
+        if (drop[i]) {
+            audio_decoder_feed(&decoder, NULL, 0, on_output, NULL);
+        } else {
+            audio_decoder_feed(&decoder, set->packets[i], set->sizes[i], on_output, NULL);
+        }
+    }
+}
+
+void setUp(void) {
+    output_samples = 0;
+}
+
+void tearDown(void) {
+    audio_decoder_deinit(&decoder);
+}
+
+void test_no_loss() {
+    bool drop[PACKETS] = {false};
+    feed_all(&celt, drop);
+    TEST_ASSERT_EQUAL(PACKETS * celt.config.samplesPerFrame, output_samples);
+    TEST_ASSERT_EQUAL(PACKETS, decoder.stats.decoded_frames);
+    TEST_ASSERT_EQUAL(0, decoder.stats.lost_frames);
+}
+
+void test_random_loss() {
+    bool drop[PACKETS] = {false};
+    int dropped = 0;
+    for (int i = 7; i < PACKETS - 1; i += 10) {
+        drop[i] = true;
+        dropped++;
+    }
+    feed_all(&celt, drop);
+    // Every lost frame must be filled, so the output keeps its timing
+    TEST_ASSERT_EQUAL(PACKETS * celt.config.samplesPerFrame, output_samples);
+    TEST_ASSERT_EQUAL(dropped, decoder.stats.lost_frames);
+    // No FEC data in CELT packets, so it's all concealment
+    TEST_ASSERT_EQUAL(0, decoder.stats.fec_frames);
+    TEST_ASSERT_EQUAL(dropped, decoder.stats.concealed_frames);
+}
+
+void test_random_loss_fec() {
+    bool drop[PACKETS] = {false};
+    int dropped = 0;
+    for (int i = 7; i < PACKETS - 1; i += 10) {
+        drop[i] = true;
+        dropped++;
+    }
+    feed_all(&silk, drop);
+    TEST_ASSERT_EQUAL(PACKETS * silk.config.samplesPerFrame, output_samples);
+    TEST_ASSERT_EQUAL(dropped, decoder.stats.lost_frames);
+    TEST_ASSERT_EQUAL(dropped, decoder.stats.fec_frames + decoder.stats.concealed_frames);
+    TEST_ASSERT_TRUE(decoder.stats.fec_frames > 0);
+}
+
+void test_burst_loss() {
+    bool drop[PACKETS] = {false};
+    drop[100] = drop[101] = drop[102] = true;
+    feed_all(&silk, drop);
+    TEST_ASSERT_EQUAL(PACKETS * silk.config.samplesPerFrame, output_samples);
+    TEST_ASSERT_EQUAL(3, decoder.stats.lost_frames);
+    // Only the last lost frame can be rebuilt from the packet after the burst
+    TEST_ASSERT_TRUE(decoder.stats.concealed_frames >= 2);
+    TEST_ASSERT_TRUE(decoder.stats.fec_frames <= 1);
+}
+
+static int encode_all(packet_set_t *set, int application, bool fec) {
+    int rc;
+    const OPUS_MULTISTREAM_CONFIGURATION *config = &set->config;
+    OpusMSEncoder *encoder = opus_multistream_encoder_create(SAMPLE_RATE, CHANNELS, config->streams,
+                                                             config->coupledStreams, config->mapping, application,
+                                                             &rc);
+    if (rc != OPUS_OK) {
+        return rc;
+    }
+    if (fec) {
+        opus_multistream_encoder_ctl(encoder, OPUS_SET_INBAND_FEC(1));
+        opus_multistream_encoder_ctl(encoder, OPUS_SET_PACKET_LOSS_PERC(20));
+        opus_multistream_encoder_ctl(encoder, OPUS_SET_BITRATE(32000));
+    }
+    opus_int16 pcm[960 * CHANNELS];
+    int frame_size = config->samplesPerFrame;
+    for (int i = 0; i < PACKETS; i++) {
+        for (int s = 0; s < frame_size; s++) {
+            double t = (double) (i * frame_size + s) / SAMPLE_RATE;
+            pcm[s * CHANNELS] = pcm[s * CHANNELS + 1] = (opus_int16) (sin(2 * M_PI * 440 * t) * 8000);
+        }
+        set->sizes[i] = opus_multistream_encode(encoder, pcm, frame_size, set->packets[i], MAX_PACKET_SIZE);
+        if (set->sizes[i] < 0) {
+            rc = set->sizes[i];
+            break;
+        }
+    }
+    opus_multistream_encoder_destroy(encoder);
+    return rc;
+}
+
+int main() {
+    if (encode_all(&celt, OPUS_APPLICATION_RESTRICTED_LOWDELAY, false) != OPUS_OK ||
+        encode_all(&silk, OPUS_APPLICATION_VOIP, true) != OPUS_OK) {
+        return 1;
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_no_loss);
+    RUN_TEST(test_random_loss);
+    RUN_TEST(test_random_loss_fec);
+    RUN_TEST(test_burst_loss);
+    return UNITY_END();
+}
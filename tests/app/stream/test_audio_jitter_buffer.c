@@ -0,0 +1,121 @@
+#include <stdlib.h>
+
+#include "unity.h"
+#include "stream/audio/audio_jitter_buffer.h"
+
+#define SAMPLE_RATE 48000
+#define CHANNELS 2
+#define FRAME_SIZE 240
+#define FRAME_US 5000
+
+static audio_jitter_buffer_t buffer;
+static int16_t frame[FRAME_SIZE * CHANNELS];
+static int16_t out[(FRAME_SIZE + FRAME_SIZE / 16) * CHANNELS];
+
+typedef struct simulation_t {
+    uint64_t interval_us;
+    /* Each frame is delayed randomly by up to this much */
+    uint64_t jitter_us;
+    /* Frames sent after stall_at_us are delayed by stall_us, and then arrive all at once */
+    uint64_t stall_at_us, stall_us;
+    uint64_t duration_us;
+    int max_queued;
+    uint32_t late_underruns;
+} simulation_t;
+
+/**
+ * Feed frames with given arrival pattern, while pulling at the pace of the played out samples.
+ */
+static void simulate(simulation_t *sim) {
+    uint64_t sent = 0, next_push = 0, next_pull = 0;
+    sim->max_queued = 0;
+    sim->late_underruns = 0;
+    srand(42);
+    while (next_push < sim->duration_us || next_pull < sim->duration_us) {
+        if (next_push <= next_pull) {
+            audio_jitter_buffer_push(&buffer, frame, FRAME_SIZE, next_push);
+            sent += sim->interval_us;
+            uint64_t arrival = sent + (sim->jitter_us ? (uint64_t) rand() % sim->jitter_us : 0);
+            if (sim->stall_us && sent >= sim->stall_at_us && sent < sim->stall_at_us + sim->stall_us) {
+                arrival = sim->stall_at_us + sim->stall_us;
+            }
+            // Packets are reordered by RTP queue, so frames never arrive earlier than the previous one
+            next_push = SDL_max(next_push, arrival);
+        } else {
+            uint32_t underruns = buffer.stats.underruns;
+            int samples = audio_jitter_buffer_pull(&buffer, out, next_pull);
+            TEST_ASSERT_TRUE(samples > 0 && samples <= FRAME_SIZE + FRAME_SIZE / 16);
+            if (next_pull > sim->duration_us / 2) {
+                sim->late_underruns += buffer.stats.underruns - underruns;
+            }
+            sim->max_queued = SDL_max(sim->max_queued, buffer.count);
+            next_pull += (uint64_t) samples * 1000000 / SAMPLE_RATE;
+        }
+    }
+}
+
+void setUp(void) {
+    TEST_ASSERT_EQUAL(0, audio_jitter_buffer_init(&buffer, SAMPLE_RATE, CHANNELS, FRAME_SIZE));
+    for (int i = 0; i < FRAME_SIZE * CHANNELS; i++) {
+        frame[i] = (int16_t) (i * 100);
+    }
+}
+
+void tearDown(void) {
+    audio_jitter_buffer_deinit(&buffer);
+}
+
+void test_steady_arrival() {
+    simulation_t sim = {.interval_us = FRAME_US, .duration_us = 30000000};
+    simulate(&sim);
+    TEST_ASSERT_EQUAL(0, buffer.stats.underruns);
+    TEST_ASSERT_EQUAL(0, buffer.stats.overflows);
+    TEST_ASSERT_TRUE(sim.max_queued <= 4);
+    TEST_ASSERT_TRUE(audio_jitter_buffer_queued_ms(&buffer) <= 15);
+}
+
+void test_jittery_arrival() {
+    // Frames delayed by up to 20 ms, target has to grow to cover that
+    simulation_t sim = {.interval_us = FRAME_US, .jitter_us = 20000, .duration_us = 60000000};
+    simulate(&sim);
+    TEST_ASSERT_TRUE(buffer.stats.underruns < 10);
+    TEST_ASSERT_EQUAL(0, sim.late_underruns);
+    TEST_ASSERT_TRUE(sim.max_queued <= 8);
+}
+
+void test_stall_recovery() {
+    simulation_t sim = {.interval_us = FRAME_US, .stall_at_us = 10000000, .stall_us = 60000,
+            .duration_us = 60000000};
+    simulate(&sim);
+    TEST_ASSERT_EQUAL(1, buffer.stats.underruns);
+    TEST_ASSERT_EQUAL(0, buffer.stats.overflows);
+    // Frames arrived in a burst after the stall should have been compressed away
+    TEST_ASSERT_TRUE(audio_jitter_buffer_queued_ms(&buffer) <= 15);
+}
+
+void test_fast_host_clock() {
+    // Host sends 0.1% faster than we play, queue must not grow unbounded
+    simulation_t sim = {.interval_us = FRAME_US - 5, .duration_us = 120000000};
+    simulate(&sim);
+    TEST_ASSERT_EQUAL(0, buffer.stats.overflows);
+    TEST_ASSERT_TRUE(sim.max_queued <= 6);
+    TEST_ASSERT_TRUE(buffer.stats.stretched_frames > 0);
+    TEST_ASSERT_FLOAT_WITHIN(250, 1000, buffer.stats.drift_ppm);
+}
+
+void test_slow_host_clock() {
+    simulation_t sim = {.interval_us = FRAME_US + 5, .duration_us = 120000000};
+    simulate(&sim);
+    TEST_ASSERT_EQUAL(0, sim.late_underruns);
+    TEST_ASSERT_FLOAT_WITHIN(250, -1000, buffer.stats.drift_ppm);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_steady_arrival);
+    RUN_TEST(test_jittery_arrival);
+    RUN_TEST(test_stall_recovery);
+    RUN_TEST(test_fast_host_clock);
+    RUN_TEST(test_slow_host_clock);
+    return UNITY_END();
+}
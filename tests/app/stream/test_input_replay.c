@@ -0,0 +1,253 @@
+#include "unity.h"
+#include "app.h"
+#include "stream/session_priv.h"
+#include "stream/input/session_input_record.h"
+#include "uuidstr.h"
+
+#include <Limelight.h>
+
+static app_settings_t settings;
+static app_input_t app_input;
+static session_t session;
+static char record_path[128];
+
+static struct {
+    int keyboard;
+    int text;
+    int mouse_move;
+    int mouse_position;
+    int mouse_button;
+    int scroll;
+    int controller;
+    int controller_arrival;
+    int controller_motion;
+    int controller_touch;
+    int touch;
+} packets;
+
+static void record_event(session_input_recorder_t *recorder, SDL_Event *event);
+
+void setUp(void) {
+    SDL_zero(packets);
+    SDL_zero(app_input);
+    SDL_zero(session);
+    settings_initialize(&settings, strdup("/tmp"));
+    app_configuration = &settings;
+    session.display_width = 1920;
+    session.display_height = 1080;
+    session.config.stick_deadzone = 7;
+    session.config.vmouse_speed = 1200;
+    session.config.vmouse_accel = 1.5f;
+    session_input_init(&session.input, &session, &app_input, &session.config);
+    uuidstr_t uuid;
+    uuidstr_random(&uuid);
+    snprintf(record_path, sizeof(record_path), "/tmp/moonlight-input-%s.bin", (char *) &uuid);
+}
+
+void tearDown(void) {
+    session_input_deinit(&session.input);
+    remove(record_path);
+    free(settings.conf_dir);
+    settings_clear(&settings);
+    app_configuration = NULL;
+}
+
+void test_record_replay() {
+    session_input_recorder_t *recorder = session_input_recorder_open(record_path);
+    TEST_ASSERT_NOT_NULL(recorder);
+    SDL_Event event;
+
+    for (int i = 0; i < 26; i++) {
+        SDL_zero(event);
+        event.key.keysym.scancode = SDL_SCANCODE_A + i;
+        event.key.state = SDL_PRESSED;
+        event.type = SDL_KEYDOWN;
+        record_event(recorder, &event);
+        event.key.state = SDL_RELEASED;
+        event.type = SDL_KEYUP;
+        record_event(recorder, &event);
+    }
+
+    for (int i = 0; i < 500; i++) {
+        SDL_zero(event);
+        event.type = SDL_MOUSEMOTION;
+        event.motion.x = i;
+        event.motion.y = i / 2;
+        event.motion.xrel = 1;
+        record_event(recorder, &event);
+    }
+
+    SDL_zero(event);
+    event.type = SDL_MOUSEWHEEL;
+    event.wheel.y = 1;
+    record_event(recorder, &event);
+
+    SDL_zero(event);
+    event.type = SDL_CONTROLLERDEVICEADDED;
+    event.cdevice.which = 3;
+    record_event(recorder, &event);
+
+    for (int i = 0; i < 200; i++) {
+        SDL_zero(event);
+        event.type = SDL_CONTROLLERAXISMOTION;
+        event.caxis.which = 3;
+        event.caxis.axis = SDL_CONTROLLER_AXIS_LEFTX;
+        event.caxis.value = (Sint16) (i * 150);
+        record_event(recorder, &event);
+    }
+
+    SDL_zero(event);
+    event.type = SDL_CONTROLLERBUTTONDOWN;
+    event.cbutton.which = 3;
+    event.cbutton.button = SDL_CONTROLLER_BUTTON_A;
+    event.cbutton.state = SDL_PRESSED;
+    record_event(recorder, &event);
+    event.type = SDL_CONTROLLERBUTTONUP;
+    event.cbutton.state = SDL_RELEASED;
+    record_event(recorder, &event);
+
+    SDL_zero(event);
+    event.type = SDL_FINGERDOWN;
+    event.tfinger.x = 0.5f;
+    event.tfinger.y = 0.5f;
+    record_event(recorder, &event);
+
+    session_input_recorder_close(recorder);
+
+    session_input_replay_stats_t stats;
+    TEST_ASSERT_EQUAL(0, session_input_replay(&session.input, record_path, false, &stats));
+    session_input_replay_stats_log(&stats);
+
+    TEST_ASSERT_EQUAL(52 + 500 + 1 + 1 + 200 + 2 + 1, stats.events);
+    TEST_ASSERT_EQUAL(52, stats.handlers[STREAM_INPUT_HANDLER_KEY].events);
+    TEST_ASSERT_EQUAL(500, stats.handlers[STREAM_INPUT_HANDLER_MMOTION].events);
+    TEST_ASSERT_EQUAL(200, stats.handlers[STREAM_INPUT_HANDLER_CAXIS].events);
+
+    TEST_ASSERT_EQUAL(52, packets.keyboard);
+    TEST_ASSERT_EQUAL(500, packets.mouse_move + packets.mouse_position);
+    TEST_ASSERT_EQUAL(1, packets.scroll);
+    TEST_ASSERT_EQUAL(1, packets.controller_arrival);
+    TEST_ASSERT_EQUAL(200 + 2, packets.controller);
+    TEST_ASSERT_EQUAL(1, packets.touch);
+}
+
+void test_replay_realtime() {
+    session_input_recorder_t *recorder = session_input_recorder_open(record_path);
+    TEST_ASSERT_NOT_NULL(recorder);
+    SDL_Event event;
+    for (int i = 0; i < 20; i++) {
+        SDL_zero(event);
+        event.type = SDL_MOUSEMOTION;
+        event.motion.xrel = 1;
+        record_event(recorder, &event);
+        SDL_Delay(2);
+    }
+    session_input_recorder_close(recorder);
+
+    session_input_replay_stats_t stats;
+    TEST_ASSERT_EQUAL(0, session_input_replay(&session.input, record_path, true, &stats));
+    session_input_replay_stats_log(&stats);
+    TEST_ASSERT_EQUAL(20, stats.events);
+    // Recorded events were at least 2ms apart
+    TEST_ASSERT_GREATER_OR_EQUAL(19 * 2000, stats.elapsed_us);
+}
+
+void test_replay_invalid_file() {
+    FILE *fp = fopen(record_path, "wb");
+    fputs("not a recording", fp);
+    fclose(fp);
+    session_input_replay_stats_t stats;
+    TEST_ASSERT_NOT_EQUAL(0, session_input_replay(&session.input, record_path, false, &stats));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_record_replay);
+    RUN_TEST(test_replay_realtime);
+    RUN_TEST(test_replay_invalid_file);
+    return UNITY_END();
+}
+
+static void record_event(session_input_recorder_t *recorder, SDL_Event *event) {
+    event->common.timestamp = SDL_GetTicks();
+    session_input_recorder_write(recorder, event);
+}
+
+int LiSendKeyboardEvent(short keyCode, char keyAction, char modifiers) {
+    packets.keyboard++;
+    return 0;
+}
+
+int LiSendUtf8TextEvent(const char *text, unsigned int length) {
+    packets.text++;
+    return 0;
+}
+
+int LiSendMouseMoveEvent(short deltaX, short deltaY) {
+    packets.mouse_move++;
+    return 0;
+}
+
+int LiSendMousePositionEvent(short x, short y, short referenceWidth, short referenceHeight) {
+    packets.mouse_position++;
+    return 0;
+}
+
+int LiSendMouseButtonEvent(char action, int button) {
+    packets.mouse_button++;
+    return 0;
+}
+
+int LiSendScrollEvent(signed char scrollClicks) {
+    packets.scroll++;
+    return 0;
+}
+
+int LiSendHScrollEvent(signed char scrollClicks) {
+    packets.scroll++;
+    return 0;
+}
+
+int LiSendHighResScrollEvent(short scrollAmount) {
+    packets.scroll++;
+    return 0;
+}
+
+int LiSendHighResHScrollEvent(short scrollAmount) {
+    packets.scroll++;
+    return 0;
+}
+
+int LiSendMultiControllerEvent(short controllerNumber, short activeGamepadMask, int buttonFlags,
+                               unsigned char leftTrigger, unsigned char rightTrigger, short leftStickX,
+                               short leftStickY, short rightStickX, short rightStickY) {
+    packets.controller++;
+    return 0;
+}
+
+int LiSendControllerArrivalEvent(uint8_t controllerNumber, uint16_t activeGamepadMask, uint8_t type,
+                                 uint32_t supportedButtonFlags, uint16_t capabilities) {
+    packets.controller_arrival++;
+    return 0;
+}
+
+int LiSendControllerMotionEvent(uint8_t controllerNumber, uint8_t motionType, float x, float y, float z) {
+    packets.controller_motion++;
+    return 0;
+}
+
+int LiSendControllerTouchEvent(uint8_t controllerNumber, uint8_t eventType, uint32_t pointerId, float x, float y,
+                               float pressure) {
+    packets.controller_touch++;
+    return 0;
+}
+
+int LiSendTouchEvent(uint8_t eventType, uint32_t pointerId, float x, float y, float pressureOrDistance,
+                     float contactAreaMajor, float contactAreaMinor, uint16_t rotation) {
+    packets.touch++;
+    return 0;
+}
+
+uint32_t LiGetHostFeatureFlags(void) {
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "unity.h"
+#include "stream/input/session_keys.h"
+
+static session_input_keys_t keys;
+static int released[SESSION_KEYS_MAX];
+static int released_count;
+
+static void on_release(short keyCode, void *userdata) {
+    (void) userdata;
+    released[released_count++] = keyCode;
+}
+
+void setUp(void) {
+    session_input_keys_reset(&keys);
+    released_count = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_press_release() {
+    TEST_ASSERT_TRUE(session_input_keys_press(&keys, 0x41));
+    TEST_ASSERT_FALSE(session_input_keys_press(&keys, 0x41));
+    TEST_ASSERT_TRUE(session_input_keys_is_down(&keys, 0x41));
+    TEST_ASSERT_FALSE(session_input_keys_is_down(&keys, 0x42));
+    TEST_ASSERT_EQUAL(1, keys.count);
+    TEST_ASSERT_TRUE(session_input_keys_release(&keys, 0x41));
+    TEST_ASSERT_FALSE(session_input_keys_release(&keys, 0x41));
+    TEST_ASSERT_EQUAL(0, keys.count);
+    TEST_ASSERT_FALSE(session_input_keys_press(&keys, -1));
+    TEST_ASSERT_FALSE(session_input_keys_press(&keys, SESSION_KEYS_MAX));
+}
+
+void test_rollover() {
+    for (short code = 0; code < SESSION_KEYS_MAX; code++) {
+        session_input_keys_press(&keys, code);
+    }
+    TEST_ASSERT_EQUAL(SESSION_KEYS_MAX, keys.count);
+    for (short code = 0; code < SESSION_KEYS_MAX; code += 2) {
+        session_input_keys_release(&keys, code);
+    }
+    TEST_ASSERT_EQUAL(SESSION_KEYS_MAX / 2, keys.count);
+    TEST_ASSERT_EQUAL(SESSION_KEYS_MAX, keys.peak);
+}
+
+void test_release_all() {
+    session_input_keys_press(&keys, 0x10);
+    session_input_keys_press(&keys, 0x41);
+    session_input_keys_press(&keys, 0xFE);
+    session_input_keys_release_all(&keys, on_release, NULL);
+    TEST_ASSERT_EQUAL(0, keys.count);
+    TEST_ASSERT_EQUAL(3, released_count);
+    TEST_ASSERT_EQUAL(0x10, released[0]);
+    TEST_ASSERT_EQUAL(0x41, released[1]);
+    TEST_ASSERT_EQUAL(0xFE, released[2]);
+    TEST_ASSERT_FALSE(session_input_keys_is_down(&keys, 0x41));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_press_release);
+    RUN_TEST(test_rollover);
+    RUN_TEST(test_release_all);
+    return UNITY_END();
+}
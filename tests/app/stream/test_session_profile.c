@@ -0,0 +1,103 @@
+#include "unity.h"
+#include "stream/session_profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_UUID "00000000-0000-0000-0000-000000000000"
+
+static session_profile_t profile;
+static char conf_dir[] = "/tmp/test_session_profile_XXXXXX";
+
+static int count_history_lines();
+
+void setUp(void) {
+    TEST_ASSERT_NOT_NULL(mkdtemp(conf_dir));
+    session_profile_init(&profile);
+}
+
+void tearDown(void) {
+    session_profile_deinit(&profile);
+    char path[256];
+    snprintf(path, sizeof(path), "%s/startup-%s.log", conf_dir, TEST_UUID);
+    remove(path);
+    rmdir(conf_dir);
+    strcpy(conf_dir, "/tmp/test_session_profile_XXXXXX");
+}
+
+void test_spans() {
+    int launch = session_profile_begin(&profile, "Launch app");
+    int stage = session_profile_begin(&profile, "RTSP handshake");
+    session_profile_end(&profile, stage);
+    TEST_ASSERT_FALSE(session_profile_complete(&profile));
+    session_profile_end(&profile, launch);
+    session_profile_mark(&profile, "Connection started");
+    session_profile_first_frame(&profile);
+    TEST_ASSERT_TRUE(session_profile_complete(&profile));
+    TEST_ASSERT_EQUAL(3, profile.count);
+    TEST_ASSERT_TRUE(profile.spans[0].end_ms >= profile.spans[1].end_ms);
+
+    char buf[256];
+    session_profile_format(&profile, buf, sizeof(buf));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "\nLaunch app: "));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "\nRTSP handshake: "));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "\nConnection started: at "));
+
+    char small[8];
+    TEST_ASSERT_EQUAL(7, session_profile_format(&profile, small, sizeof(small)));
+}
+
+void test_too_many_spans() {
+    for (int i = 0; i < SESSION_PROFILE_MAX_SPANS; i++) {
+        TEST_ASSERT_EQUAL(i, session_profile_begin(&profile, "Span"));
+    }
+    TEST_ASSERT_EQUAL(-1, session_profile_begin(&profile, "Span"));
+    session_profile_end(&profile, -1);
+}
+
+void test_history_rolling() {
+    TEST_ASSERT_NOT_EQUAL(0, session_profile_history_load(&profile, conf_dir, TEST_UUID));
+    TEST_ASSERT_EQUAL(0, profile.history.count);
+
+    session_profile_end(&profile, session_profile_begin(&profile, "Launch app"));
+    profile.first_frame_ms = 1000;
+    for (int i = 0; i < SESSION_PROFILE_HISTORY_SIZE + 5; i++) {
+        TEST_ASSERT_EQUAL(0, session_profile_history_save(&profile, conf_dir, TEST_UUID));
+    }
+    TEST_ASSERT_EQUAL(SESSION_PROFILE_HISTORY_SIZE, count_history_lines());
+
+    profile.first_frame_ms = 3000;
+    TEST_ASSERT_EQUAL(0, session_profile_history_save(&profile, conf_dir, TEST_UUID));
+    TEST_ASSERT_EQUAL(SESSION_PROFILE_HISTORY_SIZE, count_history_lines());
+
+    TEST_ASSERT_EQUAL(0, session_profile_history_load(&profile, conf_dir, TEST_UUID));
+    TEST_ASSERT_EQUAL(SESSION_PROFILE_HISTORY_SIZE, profile.history.count);
+    TEST_ASSERT_EQUAL(1000, profile.history.min_total_ms);
+    TEST_ASSERT_EQUAL((1000 * (SESSION_PROFILE_HISTORY_SIZE - 1) + 3000) / SESSION_PROFILE_HISTORY_SIZE,
+                      profile.history.avg_total_ms);
+}
+
+static int count_history_lines() {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/startup-%s.log", conf_dir, TEST_UUID);
+    FILE *fp = fopen(path, "r");
+    TEST_ASSERT_NOT_NULL(fp);
+    int lines = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        TEST_ASSERT_NOT_NULL(strstr(line, "\tLaunch app="));
+        lines++;
+    }
+    fclose(fp);
+    return lines;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_spans);
+    RUN_TEST(test_too_many_spans);
+    RUN_TEST(test_history_rolling);
+    return UNITY_END();
+}
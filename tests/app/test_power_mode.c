@@ -0,0 +1,154 @@
+#include "unity.h"
+#include "app.h"
+#include "uuidstr.h"
+#include "backend/backend_root.h"
+
+#include <stdio.h>
+
+#if __linux__
+
+#include <errno.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+static int argc = 1;
+static char *argv[] = {"moonlight"};
+app_t app;
+
+/* Stand-in of an executor thread, idle until released */
+typedef struct background_thread_t {
+    SDL_sem *started, *release;
+    int tid;
+} background_thread_t;
+
+static void run_loop(Uint32 duration);
+
+static int background_thread_run(background_thread_t *thread);
+
+int initSettings(app_settings_t *settings) {
+    char *path = malloc(128);
+    uuidstr_t uuid;
+    uuidstr_random(&uuid);
+    snprintf(path, 128, "/tmp/moonlight-test-%s", (char *) &uuid);
+    settings_initialize(settings, path);
+    return 0;
+}
+
+void setUp(void) {
+    app_init(&app, initSettings, argc, argv);
+}
+
+void tearDown(void) {
+    app.running = false;
+    app_deinit(&app);
+}
+
+void test_not_streaming() {
+    app_ui_open(&app.ui, NULL);
+    run_loop(100);
+    // No session, closing UI alone doesn't change anything
+    app_ui_close(&app.ui);
+    TEST_ASSERT_FALSE(app.power.streaming);
+}
+
+void test_pause_and_restore() {
+    app_ui_open(&app.ui, NULL);
+    run_loop(100);
+    app_ui_close(&app.ui);
+    pcmanager_auto_discovery_start(pcmanager);
+
+    app_power_set_streaming(&app, true);
+    TEST_ASSERT_TRUE(app.power.streaming);
+    TEST_ASSERT_TRUE(app.power.discovery_paused);
+    TEST_ASSERT_FALSE(pcmanager_auto_discovery_running(pcmanager));
+    run_loop(100);
+    TEST_ASSERT_TRUE(app.power.parked_loops > 0);
+
+    app_power_set_streaming(&app, false);
+    TEST_ASSERT_FALSE(app.power.streaming);
+    TEST_ASSERT_TRUE(pcmanager_auto_discovery_running(pcmanager));
+    TEST_ASSERT_EQUAL(0, app.power.threads_count);
+}
+
+void test_no_discovery_after_quit() {
+    pcmanager_auto_discovery_start(pcmanager);
+    app_power_set_streaming(&app, true);
+    TEST_ASSERT_TRUE(app.power.discovery_paused);
+
+    // Leaving power mode while quitting, discovery shouldn't come back
+    app.running = false;
+    app_power_set_streaming(&app, false);
+    TEST_ASSERT_FALSE(app.power.discovery_paused);
+    TEST_ASSERT_FALSE(pcmanager_auto_discovery_running(pcmanager));
+}
+
+void test_background_threads_lowered() {
+#if __linux__
+    background_thread_t background = {.started = SDL_CreateSemaphore(0), .release = SDL_CreateSemaphore(0)};
+    SDL_Thread *thread = SDL_CreateThread((SDL_ThreadFunction) background_thread_run, BACKEND_EXECUTOR_NAME,
+                                          &background);
+    TEST_ASSERT_NOT_NULL(thread);
+    SDL_SemWait(background.started);
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, background.tid);
+    TEST_ASSERT_EQUAL(0, errno);
+
+    int policy = sched_getscheduler(background.tid);
+
+    app_power_set_streaming(&app, true);
+    const app_power_thread_t *lowered = NULL;
+    for (size_t i = 0; i < app.power.threads_count; i++) {
+        if (app.power.threads[i].tid == background.tid) {
+            lowered = &app.power.threads[i];
+        }
+    }
+    TEST_ASSERT_NOT_NULL(lowered);
+    if (lowered->batch) {
+        // Unprivileged, as on webOS, where the nice value couldn't be restored
+        TEST_ASSERT_EQUAL(SCHED_BATCH, sched_getscheduler(background.tid));
+    } else {
+        TEST_ASSERT_TRUE(getpriority(PRIO_PROCESS, background.tid) > nice);
+    }
+    app_power_set_streaming(&app, false);
+    int restored = getpriority(PRIO_PROCESS, background.tid);
+    int restored_policy = sched_getscheduler(background.tid);
+
+    SDL_SemPost(background.release);
+    SDL_WaitThread(thread, NULL);
+    SDL_DestroySemaphore(background.release);
+    SDL_DestroySemaphore(background.started);
+    TEST_ASSERT_EQUAL(nice, restored);
+    TEST_ASSERT_EQUAL(policy, restored_policy);
+#else
+    TEST_IGNORE_MESSAGE("Thread priority is only changed on Linux");
+#endif
+}
+
+static void run_loop(Uint32 duration) {
+    Uint32 start = SDL_GetTicks();
+    while (!SDL_TICKS_PASSED(SDL_GetTicks(), start + duration)) {
+        app_run_loop(&app);
+    }
+}
+
+static int background_thread_run(background_thread_t *thread) {
+#if __linux__
+    thread->tid = (int) syscall(SYS_gettid);
+#endif
+    SDL_SemPost(thread->started);
+    SDL_SemWait(thread->release);
+    return 0;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_not_streaming);
+    RUN_TEST(test_pause_and_restore);
+    RUN_TEST(test_no_discovery_after_quit);
+    RUN_TEST(test_background_threads_lowered);
+    return UNITY_END();
+}
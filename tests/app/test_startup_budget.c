@@ -0,0 +1,70 @@
+#include "unity.h"
+#include "app.h"
+#include "uuidstr.h"
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct phase_budget_t {
+    const char *name;
+    /* Generous enough for a shared CI runner, the point is to catch phases becoming much slower */
+    unsigned int max_ms;
+} phase_budget_t;
+
+static const phase_budget_t budgets[] = {
+        {"app_init",         3000},
+        {"settings_load",    200},
+        {"os_info_get",      200},
+        {"ss4s_modules",     500},
+        {"ss4s_init",        1000},
+        {"locale",           100},
+        {"backend_init",     500},
+        {"known_hosts_load", 200},
+        {"known_hosts_add",  100},
+        {"sdl_video",        1000},
+        {"input_init",       500},
+        {"font_resolve",     1000},
+        {"ui_init",          1500},
+        {"fonts",            1000},
+        {"ss4s_post_init",   500},
+};
+
+static int argc = 1;
+static char *argv[] = {"moonlight"};
+app_t app;
+
+int initSettings(app_settings_t *settings) {
+    char *path = malloc(128);
+    uuidstr_t uuid;
+    uuidstr_random(&uuid);
+    snprintf(path, 128, "/tmp/moonlight-test-%s", (char *) &uuid);
+    settings_initialize(settings, path);
+    return 0;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_startup_budget() {
+    TEST_ASSERT_EQUAL(0, app_init(&app, initSettings, argc, argv));
+    const startup_trace_t *trace = &app.startup_trace;
+    // Every phase has ended
+    TEST_ASSERT_EQUAL(0, trace->depth);
+    for (size_t i = 0; i < sizeof(budgets) / sizeof(phase_budget_t); i++) {
+        const startup_trace_event_t *event = startup_trace_find(trace, budgets[i].name);
+        TEST_ASSERT_NOT_NULL_MESSAGE(event, budgets[i].name);
+        unsigned int elapsed_ms = (unsigned int) (event->duration_us / 1000);
+        TEST_ASSERT_TRUE_MESSAGE(elapsed_ms <= budgets[i].max_ms, budgets[i].name);
+    }
+    app.running = false;
+    app_deinit(&app);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_startup_budget);
+    return UNITY_END();
+}
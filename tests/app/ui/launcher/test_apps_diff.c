@@ -0,0 +1,237 @@
+#include "unity.h"
+#include "ui/launcher/apps_diff.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static apploader_list_t *list_new(const int *ids, int count);
+
+static void assert_diff_applies(const apploader_list_t *old_list, const apploader_list_t *new_list,
+                                const lv_gridview_data_change_t *changes, int num_changes);
+
+static int diff(const apploader_list_t *old_list, const apploader_list_t *new_list,
+                lv_gridview_data_change_t **changes);
+
+void setUp(void) {
+    srand(42);
+}
+
+void tearDown(void) {
+
+}
+
+void test_unchanged() {
+    int ids[] = {1, 2, 3, 4};
+    apploader_list_t *a = list_new(ids, 4), *b = list_new(ids, 4);
+    lv_gridview_data_change_t *changes = NULL;
+    TEST_ASSERT_EQUAL(0, diff(a, b, &changes));
+    TEST_ASSERT_NULL(changes);
+    apploader_list_free(a);
+    apploader_list_free(b);
+}
+
+void test_null_lists() {
+    int ids[] = {1};
+    apploader_list_t *a = list_new(ids, 1);
+    int num_changes = 0;
+    TEST_ASSERT_NULL(apps_list_diff(NULL, 0, NULL, 0, &num_changes));
+    TEST_ASSERT_EQUAL(0, num_changes);
+    TEST_ASSERT_NULL(apps_list_diff(NULL, 0, a, 1, &num_changes));
+    TEST_ASSERT_EQUAL(-1, num_changes);
+    apploader_list_free(a);
+}
+
+void test_insert_remove() {
+    int old_ids[] = {1, 2, 3, 4, 5};
+    int new_ids[] = {1, 3, 4, 6, 5};
+    apploader_list_t *a = list_new(old_ids, 5), *b = list_new(new_ids, 5);
+    lv_gridview_data_change_t *changes = NULL;
+    int num_changes = diff(a, b, &changes);
+    TEST_ASSERT_EQUAL(2, num_changes);
+    TEST_ASSERT_EQUAL(1, changes[0].start);
+    TEST_ASSERT_EQUAL(1, changes[0].remove_count);
+    TEST_ASSERT_EQUAL(0, changes[0].add_count);
+    TEST_ASSERT_EQUAL(3, changes[1].start);
+    TEST_ASSERT_EQUAL(0, changes[1].remove_count);
+    TEST_ASSERT_EQUAL(1, changes[1].add_count);
+    assert_diff_applies(a, b, changes, num_changes);
+    free(changes);
+    apploader_list_free(a);
+    apploader_list_free(b);
+}
+
+void test_update_in_place() {
+    int ids[] = {1, 2, 3};
+    apploader_list_t *a = list_new(ids, 3), *b = list_new(ids, 3);
+    b->items[1].fav = true;
+    lv_gridview_data_change_t *changes = NULL;
+    int num_changes = diff(a, b, &changes);
+    TEST_ASSERT_EQUAL(1, num_changes);
+    TEST_ASSERT_EQUAL(1, changes[0].start);
+    TEST_ASSERT_EQUAL(1, changes[0].remove_count);
+    TEST_ASSERT_EQUAL(1, changes[0].add_count);
+    free(changes);
+    apploader_list_free(a);
+    apploader_list_free(b);
+}
+
+void test_move_to_front() {
+    // Favorited app moves to the top
+    int old_ids[] = {1, 2, 3, 4, 5, 6};
+    int new_ids[] = {5, 1, 2, 3, 4, 6};
+    apploader_list_t *a = list_new(old_ids, 6), *b = list_new(new_ids, 6);
+    lv_gridview_data_change_t *changes = NULL;
+    int num_changes = diff(a, b, &changes);
+    TEST_ASSERT_EQUAL(2, num_changes);
+    assert_diff_applies(a, b, changes, num_changes);
+    free(changes);
+    apploader_list_free(a);
+    apploader_list_free(b);
+}
+
+void test_reversed() {
+    int old_ids[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    int new_ids[] = {8, 7, 6, 5, 4, 3, 2, 1};
+    apploader_list_t *a = list_new(old_ids, 8), *b = list_new(new_ids, 8);
+    lv_gridview_data_change_t *changes = NULL;
+    int num_changes = diff(a, b, &changes);
+    TEST_ASSERT_TRUE(num_changes > 0);
+    assert_diff_applies(a, b, changes, num_changes);
+    free(changes);
+    apploader_list_free(a);
+    apploader_list_free(b);
+}
+
+void test_random_reorderings() {
+    for (int round = 0; round < 200; round++) {
+        int old_count = rand() % 40, new_count = rand() % 40;
+        int old_ids[40], new_ids[40];
+        for (int i = 0; i < old_count; i++) {
+            old_ids[i] = rand() % 50;
+        }
+        for (int i = 0; i < new_count; i++) {
+            new_ids[i] = rand() % 50;
+        }
+        apploader_list_t *a = list_new(old_ids, old_count), *b = list_new(new_ids, new_count);
+        lv_gridview_data_change_t *changes = NULL;
+        int num_changes = diff(a, b, &changes);
+        TEST_ASSERT_TRUE(num_changes >= 0);
+        assert_diff_applies(a, b, changes, num_changes);
+        free(changes);
+        apploader_list_free(a);
+        apploader_list_free(b);
+    }
+}
+
+void test_large_list() {
+    int count = 1275;
+    int *old_ids = malloc(count * sizeof(int)), *new_ids = malloc((count + 1) * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        old_ids[i] = i;
+    }
+    // One app added in the middle, one removed near the end
+    memcpy(new_ids, old_ids, 600 * sizeof(int));
+    new_ids[600] = 10000;
+    memcpy(new_ids + 601, old_ids + 600, 600 * sizeof(int));
+    memcpy(new_ids + 1201, old_ids + 1201, (count - 1201) * sizeof(int));
+    apploader_list_t *a = list_new(old_ids, count), *b = list_new(new_ids, count);
+    lv_gridview_data_change_t *changes = NULL;
+    int num_changes = diff(a, b, &changes);
+    TEST_ASSERT_EQUAL(2, num_changes);
+    assert_diff_applies(a, b, changes, num_changes);
+    free(changes);
+    apploader_list_free(b);
+
+    // Shuffled list is too different, and will be reloaded as a whole
+    for (int i = count - 1; i > 0; i--) {
+        int j = rand() % (i + 1), tmp = new_ids[i];
+        new_ids[i] = new_ids[j];
+        new_ids[j] = tmp;
+    }
+    b = list_new(new_ids, count);
+    TEST_ASSERT_EQUAL(-1, diff(a, b, &changes));
+    TEST_ASSERT_NULL(changes);
+    apploader_list_free(a);
+    apploader_list_free(b);
+    free(old_ids);
+    free(new_ids);
+}
+
+void test_displayed_range() {
+    // Changes after the displayed range (e.g. hidden apps) are not reported
+    int old_ids[] = {1, 2, 3, 4};
+    int new_ids[] = {1, 2, 4, 3};
+    apploader_list_t *a = list_new(old_ids, 4), *b = list_new(new_ids, 4);
+    int num_changes = -1;
+    lv_gridview_data_change_t *changes = apps_list_diff(a, 2, b, 2, &num_changes);
+    TEST_ASSERT_EQUAL(0, num_changes);
+    free(changes);
+    apploader_list_free(a);
+    apploader_list_free(b);
+}
+
+static int diff(const apploader_list_t *old_list, const apploader_list_t *new_list,
+                lv_gridview_data_change_t **changes) {
+    int num_changes = 0;
+    *changes = apps_list_diff(old_list, (int) old_list->count, new_list, (int) new_list->count, &num_changes);
+    return num_changes;
+}
+
+/**
+ * Apply changes to ids of old list, with inserted items taken from new list, and check the result.
+ */
+static void assert_diff_applies(const apploader_list_t *old_list, const apploader_list_t *new_list,
+                                const lv_gridview_data_change_t *changes, int num_changes) {
+    int capacity = (int) (old_list->count + new_list->count) + 1;
+    int *ids = malloc(capacity * sizeof(int));
+    int len = (int) old_list->count;
+    for (int i = 0; i < len; i++) {
+        ids[i] = old_list->items[i].base.id;
+    }
+    for (int i = 0; i < num_changes; i++) {
+        const lv_gridview_data_change_t *change = &changes[i];
+        TEST_ASSERT_TRUE(change->start >= 0 && change->start + change->remove_count <= len);
+        TEST_ASSERT_TRUE(change->remove_count > 0 || change->add_count > 0);
+        memmove(ids + change->start + change->add_count, ids + change->start + change->remove_count,
+                (len - change->start - change->remove_count) * sizeof(int));
+        len += change->add_count - change->remove_count;
+        for (int j = 0; j < change->add_count; j++) {
+            ids[change->start + j] = new_list->items[change->start + j].base.id;
+        }
+    }
+    TEST_ASSERT_EQUAL(new_list->count, len);
+    for (int i = 0; i < len; i++) {
+        TEST_ASSERT_EQUAL(new_list->items[i].base.id, ids[i]);
+    }
+    free(ids);
+}
+
+static apploader_list_t *list_new(const int *ids, int count) {
+    apploader_list_t *list = malloc(sizeof(apploader_list_t) + count * sizeof(apploader_item_t));
+    list->count = count;
+    list->items = (apploader_item_t *) ((void *) list + sizeof(apploader_list_t));
+    for (int i = 0; i < count; i++) {
+        apploader_item_t *item = &list->items[i];
+        memset(item, 0, sizeof(apploader_item_t));
+        char name[32];
+        snprintf(name, sizeof(name), "App %d", ids[i]);
+        item->base.id = ids[i];
+        item->base.name = strdup(name);
+    }
+    return list;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_unchanged);
+    RUN_TEST(test_null_lists);
+    RUN_TEST(test_insert_remove);
+    RUN_TEST(test_update_in_place);
+    RUN_TEST(test_move_to_front);
+    RUN_TEST(test_reversed);
+    RUN_TEST(test_random_reorderings);
+    RUN_TEST(test_large_list);
+    RUN_TEST(test_displayed_range);
+    return UNITY_END();
+}
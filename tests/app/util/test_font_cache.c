@@ -0,0 +1,110 @@
+#include "unity.h"
+#include "util/font_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+static char dir[] = "/tmp/test_font_cache_XXXXXX";
+static char fonts_dir[256], font_file[256], sub_dir[256], cache_file[256];
+
+void setUp(void) {
+    TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+    snprintf(fonts_dir, sizeof(fonts_dir), "%s/fonts", dir);
+    snprintf(font_file, sizeof(font_file), "%s/fonts/DejaVuSans.ttf", dir);
+    snprintf(sub_dir, sizeof(sub_dir), "%s/fonts/noto", dir);
+    snprintf(cache_file, sizeof(cache_file), "%s/fonts.bin", dir);
+    TEST_ASSERT_EQUAL(0, mkdir(fonts_dir, 0755));
+    FILE *fp = fopen(font_file, "w");
+    TEST_ASSERT_NOT_NULL(fp);
+    fclose(fp);
+}
+
+void tearDown(void) {
+    remove(cache_file);
+    remove(font_file);
+    rmdir(sub_dir);
+    rmdir(fonts_dir);
+    rmdir(dir);
+    strcpy(dir, "/tmp/test_font_cache_XXXXXX");
+}
+
+void test_key() {
+    uint32_t key = font_cache_key_add_str(font_cache_key_add_str(FONT_CACHE_KEY_INIT, "en"), "Dejavu Sans");
+    TEST_ASSERT_EQUAL(key, font_cache_key_add_str(font_cache_key_add_str(FONT_CACHE_KEY_INIT, "en"), "Dejavu Sans"));
+    TEST_ASSERT_NOT_EQUAL(key,
+                          font_cache_key_add_str(font_cache_key_add_str(FONT_CACHE_KEY_INIT, "ja"), "Dejavu Sans"));
+    // Moving characters between values is a change
+    TEST_ASSERT_NOT_EQUAL(font_cache_key_add_str(font_cache_key_add_str(FONT_CACHE_KEY_INIT, "ab"), "c"),
+                          font_cache_key_add_str(font_cache_key_add_str(FONT_CACHE_KEY_INIT, "a"), "bc"));
+}
+
+void test_key_dir_changed() {
+    uint32_t key = font_cache_key_add_path(FONT_CACHE_KEY_INIT, fonts_dir);
+    TEST_ASSERT_EQUAL(key, font_cache_key_add_path(FONT_CACHE_KEY_INIT, fonts_dir));
+
+    struct stat st;
+    TEST_ASSERT_EQUAL(0, stat(fonts_dir, &st));
+    struct utimbuf times = {.actime = st.st_atime, .modtime = st.st_mtime - 100};
+    TEST_ASSERT_EQUAL(0, utime(fonts_dir, &times));
+    uint32_t touched = font_cache_key_add_path(FONT_CACHE_KEY_INIT, fonts_dir);
+    TEST_ASSERT_NOT_EQUAL(key, touched);
+
+    // Font installed in a subdirectory, even if the parent keeps its modification time
+    TEST_ASSERT_EQUAL(0, mkdir(sub_dir, 0755));
+    TEST_ASSERT_EQUAL(0, utime(fonts_dir, &times));
+    TEST_ASSERT_NOT_EQUAL(touched, font_cache_key_add_path(FONT_CACHE_KEY_INIT, fonts_dir));
+}
+
+void test_save_load() {
+    char *files[2] = {font_file, NULL};
+    char *loaded[2];
+    TEST_ASSERT_EQUAL(-1, font_cache_load(cache_file, 1234, loaded, 2));
+    TEST_ASSERT_EQUAL(0, font_cache_save(cache_file, 1234, files, 2));
+
+    TEST_ASSERT_EQUAL(0, font_cache_load(cache_file, 1234, loaded, 2));
+    TEST_ASSERT_EQUAL_STRING(font_file, loaded[0]);
+    TEST_ASSERT_NULL(loaded[1]);
+    font_cache_files_free(loaded, 2);
+}
+
+void test_load_mismatch() {
+    char *files[2] = {font_file, font_file};
+    char *loaded[2];
+    TEST_ASSERT_EQUAL(0, font_cache_save(cache_file, 1234, files, 2));
+    TEST_ASSERT_EQUAL(-1, font_cache_load(cache_file, 4321, loaded, 2));
+    TEST_ASSERT_NULL(loaded[0]);
+    TEST_ASSERT_NULL(loaded[1]);
+    TEST_ASSERT_EQUAL(-1, font_cache_load(cache_file, 1234, loaded, 1));
+}
+
+void test_load_file_removed() {
+    char *files[2] = {font_file, NULL};
+    char *loaded[2];
+    TEST_ASSERT_EQUAL(0, font_cache_save(cache_file, 1234, files, 2));
+    remove(font_file);
+    TEST_ASSERT_EQUAL(-1, font_cache_load(cache_file, 1234, loaded, 2));
+    TEST_ASSERT_NULL(loaded[0]);
+}
+
+void test_load_truncated() {
+    char *files[2] = {font_file, NULL};
+    char *loaded[2];
+    TEST_ASSERT_EQUAL(0, font_cache_save(cache_file, 1234, files, 2));
+    TEST_ASSERT_EQUAL(0, truncate(cache_file, 20));
+    TEST_ASSERT_EQUAL(-1, font_cache_load(cache_file, 1234, loaded, 2));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_key);
+    RUN_TEST(test_key_dir_changed);
+    RUN_TEST(test_save_load);
+    RUN_TEST(test_load_mismatch);
+    RUN_TEST(test_load_file_removed);
+    RUN_TEST(test_load_truncated);
+    return UNITY_END();
+}
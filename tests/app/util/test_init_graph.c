@@ -0,0 +1,169 @@
+#include "unity.h"
+#include "util/init_graph.h"
+#include "executor.h"
+
+#include <SDL_atomic.h>
+#include <SDL_timer.h>
+
+/* Roughly the startup graph: a few I/O bound steps in background, then main thread steps depending on them */
+#define STEP_DELAY 50
+
+enum {
+    STEP_A,
+    STEP_B,
+    STEP_C,
+    STEP_D,
+    STEP_MAIN_1,
+    STEP_MAIN_2,
+    STEP_COUNT,
+};
+
+typedef struct test_context_t {
+    SDL_atomic_t sequence;
+    int order[STEP_COUNT];
+    int fail_step;
+    Uint32 delay;
+} test_context_t;
+
+static test_context_t ctx;
+static startup_trace_t trace;
+static executor_t *executor;
+
+static int step_run(test_context_t *context, int index);
+
+static int step_a(void *context);
+
+static int step_b(void *context);
+
+static int step_c(void *context);
+
+static int step_d(void *context);
+
+static int step_main_1(void *context);
+
+static int step_main_2(void *context);
+
+static const init_step_t steps[STEP_COUNT] = {
+        [STEP_A] = {"a", step_a, 0, false},
+        [STEP_B] = {"b", step_b, 0, false},
+        [STEP_C] = {"c", step_c, INIT_STEP_DEP(STEP_A), false},
+        [STEP_D] = {"d", step_d, 0, false},
+        [STEP_MAIN_1] = {"main_1", step_main_1, 0, true},
+        [STEP_MAIN_2] = {"main_2", step_main_2, INIT_STEP_DEP(STEP_MAIN_1) | INIT_STEP_DEP(STEP_B) |
+                                                INIT_STEP_DEP(STEP_C), true},
+};
+
+void setUp(void) {
+    SDL_memset(&ctx, 0, sizeof(ctx));
+    ctx.fail_step = -1;
+    ctx.delay = 0;
+    startup_trace_init(&trace);
+    executor = executor_create("test-init", 4);
+}
+
+void tearDown(void) {
+    executor_destroy(executor);
+}
+
+void test_dependency_order(void) {
+    TEST_ASSERT_EQUAL(0, init_graph_run(steps, STEP_COUNT, executor, &ctx, &trace));
+    for (int i = 0; i < STEP_COUNT; i++) {
+        TEST_ASSERT_TRUE(ctx.order[i] > 0);
+    }
+    TEST_ASSERT_TRUE(ctx.order[STEP_C] > ctx.order[STEP_A]);
+    TEST_ASSERT_TRUE(ctx.order[STEP_MAIN_2] > ctx.order[STEP_MAIN_1]);
+    TEST_ASSERT_TRUE(ctx.order[STEP_MAIN_2] > ctx.order[STEP_B]);
+    TEST_ASSERT_TRUE(ctx.order[STEP_MAIN_2] > ctx.order[STEP_C]);
+
+    // Every step is in the trace, background ones are marked as such
+    const startup_trace_event_t *event = startup_trace_find(&trace, "c");
+    TEST_ASSERT_NOT_NULL(event);
+    TEST_ASSERT_EQUAL(1, event->thread);
+    event = startup_trace_find(&trace, "main_2");
+    TEST_ASSERT_NOT_NULL(event);
+    TEST_ASSERT_EQUAL(0, event->thread);
+}
+
+void test_sequential(void) {
+    TEST_ASSERT_EQUAL(0, init_graph_run(steps, STEP_COUNT, NULL, &ctx, &trace));
+    TEST_ASSERT_TRUE(ctx.order[STEP_C] > ctx.order[STEP_A]);
+    TEST_ASSERT_TRUE(ctx.order[STEP_MAIN_2] > ctx.order[STEP_C]);
+    TEST_ASSERT_EQUAL(0, startup_trace_find(&trace, "c")->thread);
+}
+
+void test_failure_stops_dependents(void) {
+    ctx.fail_step = STEP_A;
+    TEST_ASSERT_EQUAL(STEP_A + 100, init_graph_run(steps, STEP_COUNT, executor, &ctx, &trace));
+    TEST_ASSERT_EQUAL(0, ctx.order[STEP_C]);
+    TEST_ASSERT_EQUAL(0, ctx.order[STEP_MAIN_2]);
+}
+
+void test_unsatisfiable(void) {
+    const init_step_t cycle[] = {
+            {"x", step_a, INIT_STEP_DEP(1), false},
+            {"y", step_b, INIT_STEP_DEP(0), true},
+            {"z", step_d, 0, false},
+    };
+    TEST_ASSERT_EQUAL(-1, init_graph_run(cycle, 3, executor, &ctx, &trace));
+    TEST_ASSERT_EQUAL(0, ctx.order[STEP_A]);
+    TEST_ASSERT_EQUAL(0, ctx.order[STEP_B]);
+}
+
+void test_parallel_speedup(void) {
+    ctx.delay = STEP_DELAY;
+    Uint32 start = SDL_GetTicks();
+    TEST_ASSERT_EQUAL(0, init_graph_run(steps, STEP_COUNT, NULL, &ctx, &trace));
+    Uint32 sequential = SDL_GetTicks() - start;
+
+    SDL_memset(&ctx.order, 0, sizeof(ctx.order));
+    startup_trace_init(&trace);
+    start = SDL_GetTicks();
+    TEST_ASSERT_EQUAL(0, init_graph_run(steps, STEP_COUNT, executor, &ctx, &trace));
+    Uint32 parallel = SDL_GetTicks() - start;
+
+    TEST_ASSERT_TRUE(sequential >= STEP_COUNT * STEP_DELAY);
+    // Critical path is a -> c -> main_2, loose bound as the runner may be busy
+    TEST_ASSERT_TRUE(parallel < sequential);
+}
+
+static int step_run(test_context_t *context, int index) {
+    if (context->delay > 0) {
+        SDL_Delay(context->delay);
+    }
+    context->order[index] = SDL_AtomicAdd(&context->sequence, 1) + 1;
+    return index == context->fail_step ? index + 100 : 0;
+}
+
+static int step_a(void *context) {
+    return step_run(context, STEP_A);
+}
+
+static int step_b(void *context) {
+    return step_run(context, STEP_B);
+}
+
+static int step_c(void *context) {
+    return step_run(context, STEP_C);
+}
+
+static int step_d(void *context) {
+    return step_run(context, STEP_D);
+}
+
+static int step_main_1(void *context) {
+    return step_run(context, STEP_MAIN_1);
+}
+
+static int step_main_2(void *context) {
+    return step_run(context, STEP_MAIN_2);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_dependency_order);
+    RUN_TEST(test_sequential);
+    RUN_TEST(test_failure_stops_dependents);
+    RUN_TEST(test_unsatisfiable);
+    RUN_TEST(test_parallel_speedup);
+    return UNITY_END();
+}
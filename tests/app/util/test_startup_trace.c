@@ -0,0 +1,106 @@
+#include "unity.h"
+#include "util/startup_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <SDL_timer.h>
+
+static startup_trace_t trace;
+static char json_path[] = "/tmp/test_startup_trace_XXXXXX";
+
+static char *read_file(const char *path);
+
+void setUp(void) {
+    startup_trace_init(&trace);
+}
+
+void tearDown(void) {
+}
+
+void test_nested() {
+    startup_trace_begin(&trace, "app_init");
+    startup_trace_begin(&trace, "backend_init");
+    startup_trace_begin(&trace, "known_hosts_load");
+    SDL_Delay(20);
+    startup_trace_end(&trace);
+    startup_trace_end(&trace);
+    startup_trace_begin(&trace, "ui_init");
+    SDL_Delay(10);
+    startup_trace_end(&trace);
+    startup_trace_end(&trace);
+
+    TEST_ASSERT_EQUAL(4, trace.count);
+    TEST_ASSERT_EQUAL(0, trace.depth);
+    const startup_trace_event_t *app_init = startup_trace_find(&trace, "app_init");
+    const startup_trace_event_t *backend_init = startup_trace_find(&trace, "backend_init");
+    const startup_trace_event_t *known_hosts = startup_trace_find(&trace, "known_hosts_load");
+    const startup_trace_event_t *ui_init = startup_trace_find(&trace, "ui_init");
+    TEST_ASSERT_EQUAL(0, app_init->depth);
+    TEST_ASSERT_EQUAL(1, backend_init->depth);
+    TEST_ASSERT_EQUAL(2, known_hosts->depth);
+    TEST_ASSERT_EQUAL(1, ui_init->depth);
+
+    TEST_ASSERT_TRUE(known_hosts->duration_us >= 20000);
+    TEST_ASSERT_TRUE(backend_init->duration_us >= known_hosts->duration_us);
+    TEST_ASSERT_TRUE(ui_init->start_us >= backend_init->start_us + backend_init->duration_us);
+    TEST_ASSERT_TRUE(app_init->duration_us >= backend_init->duration_us + ui_init->duration_us);
+    TEST_ASSERT_NULL(startup_trace_find(&trace, "fonts"));
+}
+
+void test_overflow() {
+    for (int i = 0; i < STARTUP_TRACE_MAX_DEPTH + 2; i++) {
+        startup_trace_begin(&trace, "nested");
+    }
+    for (int i = 0; i < STARTUP_TRACE_MAX_DEPTH + 2; i++) {
+        startup_trace_end(&trace);
+    }
+    TEST_ASSERT_EQUAL(STARTUP_TRACE_MAX_DEPTH, trace.count);
+    TEST_ASSERT_EQUAL(0, trace.depth);
+
+    for (int i = 0; i < STARTUP_TRACE_MAX_EVENTS; i++) {
+        startup_trace_begin(&trace, "sequential");
+        startup_trace_end(&trace);
+    }
+    TEST_ASSERT_EQUAL(STARTUP_TRACE_MAX_EVENTS, trace.count);
+    // Unbalanced end is ignored
+    startup_trace_end(&trace);
+    TEST_ASSERT_EQUAL(0, trace.depth);
+}
+
+void test_write_json() {
+    startup_trace_begin(&trace, "app_init");
+    startup_trace_begin(&trace, "say \"hi\"");
+    startup_trace_end(&trace);
+    startup_trace_end(&trace);
+
+    int fd = mkstemp(json_path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    close(fd);
+    TEST_ASSERT_EQUAL(0, startup_trace_write_json(&trace, json_path));
+    char *json = read_file(json_path);
+    remove(json_path);
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"traceEvents\":["));
+    TEST_ASSERT_NOT_NULL(strstr(json, "{\"name\":\"app_init\",\"cat\":\"startup\",\"ph\":\"X\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"name\":\"say \\\"hi\\\"\""));
+    free(json);
+}
+
+static char *read_file(const char *path) {
+    FILE *fp = fopen(path, "r");
+    TEST_ASSERT_NOT_NULL(fp);
+    char *buf = calloc(1, 4096);
+    fread(buf, 1, 4095, fp);
+    fclose(fp);
+    return buf;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_nested);
+    RUN_TEST(test_overflow);
+    RUN_TEST(test_write_json);
+    return UNITY_END();
+}
@@ -0,0 +1,96 @@
+#include "unity.h"
+#include "libgamestream/mkcert.h"
+#include "libgamestream/errors.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Generous enough for a shared CI runner or a slow TV SoC, the point is to catch generation becoming much slower */
+#define GENERATE_BUDGET_MS 20000
+
+static char dir[64];
+static char cert_path[128], key_path[128];
+
+static char *read_file(const char *path);
+
+static bool file_exists(const char *path);
+
+void setUp(void) {
+    strncpy(dir, "/tmp/moonlight-mkcert-XXXXXX", sizeof(dir));
+    TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+    snprintf(cert_path, sizeof(cert_path), "%s/client.pem", dir);
+    snprintf(key_path, sizeof(key_path), "%s/key.pem", dir);
+}
+
+void tearDown(void) {
+    remove(cert_path);
+    remove(key_path);
+    rmdir(dir);
+}
+
+void test_generate(void) {
+    TEST_ASSERT_EQUAL(GS_OK, mkcert_generate(cert_path, key_path));
+
+    char *cert = read_file(cert_path), *key = read_file(key_path);
+    TEST_ASSERT_NOT_NULL(strstr(cert, "-----BEGIN CERTIFICATE-----"));
+    TEST_ASSERT_NOT_NULL(strstr(key, "PRIVATE KEY-----"));
+    free(cert);
+    free(key);
+
+    // Written through temporary files
+    char tmp_path[160];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cert_path);
+    TEST_ASSERT_FALSE(file_exists(tmp_path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", key_path);
+    TEST_ASSERT_FALSE(file_exists(tmp_path));
+}
+
+void test_generate_budget(void) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_ASSERT_EQUAL(GS_OK, mkcert_generate(cert_path, key_path));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long elapsed_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+    char message[64];
+    snprintf(message, sizeof(message), "Generation took %ld ms", elapsed_ms);
+    TEST_ASSERT_TRUE_MESSAGE(elapsed_ms <= GENERATE_BUDGET_MS, message);
+}
+
+void test_generate_unwritable(void) {
+    char bad_cert_path[160], bad_key_path[160];
+    snprintf(bad_cert_path, sizeof(bad_cert_path), "%s/missing/client.pem", dir);
+    snprintf(bad_key_path, sizeof(bad_key_path), "%s/missing/key.pem", dir);
+    TEST_ASSERT_EQUAL(GS_IO_ERROR, mkcert_generate(bad_cert_path, bad_key_path));
+    TEST_ASSERT_FALSE(file_exists(bad_cert_path));
+    TEST_ASSERT_FALSE(file_exists(bad_key_path));
+}
+
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "r");
+    TEST_ASSERT_NOT_NULL(f);
+    char *buf = calloc(1, 8192);
+    fread(buf, 1, 8191, f);
+    fclose(f);
+    return buf;
+}
+
+static bool file_exists(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+    fclose(f);
+    return true;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_generate);
+    RUN_TEST(test_generate_budget);
+    RUN_TEST(test_generate_unwritable);
+    return UNITY_END();
+}